@@ -10,8 +10,49 @@
 #include "hal_7seg.h"
 #include "msp430.h"
 
+/*Every segment must be on exactly one of HAL_7SEG_PORTS*/
+#define HAL_7SEG_ON_PORT( ucPort, ucIndex, seg )    + ( HAL_7SEG_SEGMENT_##seg##_PORT == ( ucPort ) )
+#define HAL_7SEG_CHECK_SEGMENT( seg )                                               \
+    typedef char hal7segCheckSegment##seg[ ( 0 HAL_7SEG_PORTS( HAL_7SEG_ON_PORT, seg ) ) == 1 ? 1 : -1 ]
+HAL_7SEG_CHECK_SEGMENT( A );
+HAL_7SEG_CHECK_SEGMENT( B );
+HAL_7SEG_CHECK_SEGMENT( C );
+HAL_7SEG_CHECK_SEGMENT( D );
+HAL_7SEG_CHECK_SEGMENT( E );
+HAL_7SEG_CHECK_SEGMENT( F );
+HAL_7SEG_CHECK_SEGMENT( G );
+
+/*Port masks of a glyph from its segments, resolved at compile time*/
+#define HAL_7SEG_SET( ucPort, ucIndex, ucSegments )     HAL_7SEG_PORT_PINS( ucPort, 0x7F & ~( ucSegments ) ),
+#define HAL_7SEG_CLEAR( ucPort, ucIndex, ucSegments )   HAL_7SEG_PORT_PINS( ucPort, ( ucSegments ) ),
+#define HAL_7SEG_GLYPH( ucSegments )                                                \
+    { { HAL_7SEG_PORTS( HAL_7SEG_SET, ucSegments ) },                               \
+      { HAL_7SEG_PORTS( HAL_7SEG_CLEAR, ucSegments ) } }
+
+const hal_7seg_glyph_t pxHAL7SEGGlyphs[HAL_7SEG_NUM_GLYPHS] = {
+    HAL_7SEG_GLYPH( 0x3F ),     // 0
+    HAL_7SEG_GLYPH( 0x06 ),     // 1
+    HAL_7SEG_GLYPH( 0x5B ),     // 2
+    HAL_7SEG_GLYPH( 0x4F ),     // 3
+    HAL_7SEG_GLYPH( 0x66 ),     // 4
+    HAL_7SEG_GLYPH( 0x6D ),     // 5
+    HAL_7SEG_GLYPH( 0x7D ),     // 6
+    HAL_7SEG_GLYPH( 0x07 ),     // 7
+    HAL_7SEG_GLYPH( 0x7F ),     // 8
+    HAL_7SEG_GLYPH( 0x67 ),     // 9
+    HAL_7SEG_GLYPH( 0x77 ),     // A
+    HAL_7SEG_GLYPH( 0x7C ),     // b
+    HAL_7SEG_GLYPH( 0x39 ),     // C
+    HAL_7SEG_GLYPH( 0x5E ),     // d
+    HAL_7SEG_GLYPH( 0x79 ),     // E
+    HAL_7SEG_GLYPH( 0x71 ),     // F
+    HAL_7SEG_GLYPH( 0x00 ),     // blank
+    HAL_7SEG_GLYPH( 0x40 ),     // minus
+    HAL_7SEG_GLYPH( 0x49 )      // error
+};
+
 void vHAL7SEGInit(){
-    /*Init segment a*/
+    /*Init displays and segments*/
     HAL_7SEG_DISPLAY_1_DIR |=   HAL_7SEG_DISPLAY_1_MASK;
     HAL_7SEG_DISPLAY_2_DIR |=   HAL_7SEG_DISPLAY_2_MASK;
     HAL_7SEG_SEGMENT_A_DIR |=   HAL_7SEG_SEGMENT_A_MASK;
@@ -24,103 +65,17 @@ void vHAL7SEGInit(){
 }
 
 uint8_t vHAL7SEGWriteDigit(uint8_t digit){
-    switch(digit){
-        case 0:
-            HAL_7SEG_SEGMENT_A_ON;
-            HAL_7SEG_SEGMENT_B_ON;
-            HAL_7SEG_SEGMENT_C_ON;
-            HAL_7SEG_SEGMENT_D_ON;
-            HAL_7SEG_SEGMENT_E_ON;
-            HAL_7SEG_SEGMENT_F_ON;
-            HAL_7SEG_SEGMENT_G_OFF;
-            break;
-        case 1:
-            HAL_7SEG_SEGMENT_A_OFF;
-            HAL_7SEG_SEGMENT_B_ON;
-            HAL_7SEG_SEGMENT_C_ON;
-            HAL_7SEG_SEGMENT_D_OFF;
-            HAL_7SEG_SEGMENT_E_OFF;
-            HAL_7SEG_SEGMENT_F_OFF;
-            HAL_7SEG_SEGMENT_G_OFF;
-            break;
-        case 2:
-            HAL_7SEG_SEGMENT_A_ON;
-            HAL_7SEG_SEGMENT_B_ON;
-            HAL_7SEG_SEGMENT_C_OFF;
-            HAL_7SEG_SEGMENT_D_ON;
-            HAL_7SEG_SEGMENT_E_ON;
-            HAL_7SEG_SEGMENT_F_OFF;
-            HAL_7SEG_SEGMENT_G_ON;
-            break;
-        case 3:
-            HAL_7SEG_SEGMENT_A_ON;
-            HAL_7SEG_SEGMENT_B_ON;
-            HAL_7SEG_SEGMENT_C_ON;
-            HAL_7SEG_SEGMENT_D_ON;
-            HAL_7SEG_SEGMENT_E_OFF;
-            HAL_7SEG_SEGMENT_F_OFF;
-            HAL_7SEG_SEGMENT_G_ON;
-            break;
-        case 4:
-            HAL_7SEG_SEGMENT_A_OFF;
-            HAL_7SEG_SEGMENT_B_ON;
-            HAL_7SEG_SEGMENT_C_ON;
-            HAL_7SEG_SEGMENT_D_OFF;
-            HAL_7SEG_SEGMENT_E_OFF;
-            HAL_7SEG_SEGMENT_F_ON;
-            HAL_7SEG_SEGMENT_G_ON;
-            break;
-        case 5:
-            HAL_7SEG_SEGMENT_A_ON;
-            HAL_7SEG_SEGMENT_B_OFF;
-            HAL_7SEG_SEGMENT_C_ON;
-            HAL_7SEG_SEGMENT_D_ON;
-            HAL_7SEG_SEGMENT_E_OFF;
-            HAL_7SEG_SEGMENT_F_ON;
-            HAL_7SEG_SEGMENT_G_ON;
-            break;
-        case 6:
-            HAL_7SEG_SEGMENT_A_ON;
-            HAL_7SEG_SEGMENT_B_OFF;
-            HAL_7SEG_SEGMENT_C_ON;
-            HAL_7SEG_SEGMENT_D_ON;
-            HAL_7SEG_SEGMENT_E_ON;
-            HAL_7SEG_SEGMENT_F_ON;
-            HAL_7SEG_SEGMENT_G_ON;
-            break;
-        case 7:
-            HAL_7SEG_SEGMENT_A_ON;
-            HAL_7SEG_SEGMENT_B_ON;
-            HAL_7SEG_SEGMENT_C_ON;
-            HAL_7SEG_SEGMENT_D_OFF;
-            HAL_7SEG_SEGMENT_E_OFF;
-            HAL_7SEG_SEGMENT_F_OFF;
-            HAL_7SEG_SEGMENT_G_OFF;
-            break;
-        case 8:
-            HAL_7SEG_SEGMENT_A_ON;
-            HAL_7SEG_SEGMENT_B_ON;
-            HAL_7SEG_SEGMENT_C_ON;
-            HAL_7SEG_SEGMENT_D_ON;
-            HAL_7SEG_SEGMENT_E_ON;
-            HAL_7SEG_SEGMENT_F_ON;
-            HAL_7SEG_SEGMENT_G_ON;
-            break;
-        case 9:
-            HAL_7SEG_SEGMENT_A_ON;
-            HAL_7SEG_SEGMENT_B_ON;
-            HAL_7SEG_SEGMENT_C_ON;
-            HAL_7SEG_SEGMENT_D_OFF;
-            HAL_7SEG_SEGMENT_E_OFF;
-            HAL_7SEG_SEGMENT_F_ON;
-            HAL_7SEG_SEGMENT_G_ON;
-            break;
-        default:
-            return 1;
+    if(digit > 9){
+        return 1;
     }
+    HAL_7SEG_WRITE_GLYPH(digit);
     return 0;
 }
 
-
-
-
+uint8_t ucHAL7SEGWriteGlyph(uint8_t glyph){
+    if(glyph >= HAL_7SEG_NUM_GLYPHS){
+        return 1;
+    }
+    HAL_7SEG_WRITE_GLYPH(glyph);
+    return 0;
+}
@@ -25,30 +25,53 @@
 #define HAL_7SEG_SEGMENT_F_MASK          0x01
 #define HAL_7SEG_SEGMENT_G_MASK          0x04
 
+/*Port of each segment*/
+#define HAL_7SEG_SEGMENT_A_PORT          3
+#define HAL_7SEG_SEGMENT_B_PORT          4
+#define HAL_7SEG_SEGMENT_C_PORT          2
+#define HAL_7SEG_SEGMENT_D_PORT          8
+#define HAL_7SEG_SEGMENT_E_PORT          2
+#define HAL_7SEG_SEGMENT_F_PORT          4
+#define HAL_7SEG_SEGMENT_G_PORT          8
+
+/*Ports carrying segments, X( port, index )*/
+#define HAL_7SEG_PORTS( X, xArg )       \
+    X( 2, 0, xArg )                     \
+    X( 3, 1, xArg )                     \
+    X( 4, 2, xArg )                     \
+    X( 8, 3, xArg )
+#define HAL_7SEG_NUM_PORTS               4
+
+/*Output and direction register of port n*/
+#define HAL_7SEG_OUT( ucPort )          HAL_7SEG_OUT_( ucPort )
+#define HAL_7SEG_OUT_( ucPort )         P##ucPort##OUT
+#define HAL_7SEG_DIR( ucPort )          HAL_7SEG_DIR_( ucPort )
+#define HAL_7SEG_DIR_( ucPort )         P##ucPort##DIR
+
 /*Displays  direction registers*/
 #define HAL_7SEG_DISPLAY_1_DIR          P6DIR
 #define HAL_7SEG_DISPLAY_2_DIR          P7DIR
 /*Segments direction registers*/
-#define HAL_7SEG_SEGMENT_A_DIR          P3DIR
-#define HAL_7SEG_SEGMENT_B_DIR          P4DIR
-#define HAL_7SEG_SEGMENT_C_DIR          P2DIR
-#define HAL_7SEG_SEGMENT_D_DIR          P8DIR
-#define HAL_7SEG_SEGMENT_E_DIR          P2DIR
-#define HAL_7SEG_SEGMENT_F_DIR          P4DIR
-#define HAL_7SEG_SEGMENT_G_DIR          P8DIR
+#define HAL_7SEG_SEGMENT_A_DIR          HAL_7SEG_DIR( HAL_7SEG_SEGMENT_A_PORT )
+#define HAL_7SEG_SEGMENT_B_DIR          HAL_7SEG_DIR( HAL_7SEG_SEGMENT_B_PORT )
+#define HAL_7SEG_SEGMENT_C_DIR          HAL_7SEG_DIR( HAL_7SEG_SEGMENT_C_PORT )
+#define HAL_7SEG_SEGMENT_D_DIR          HAL_7SEG_DIR( HAL_7SEG_SEGMENT_D_PORT )
+#define HAL_7SEG_SEGMENT_E_DIR          HAL_7SEG_DIR( HAL_7SEG_SEGMENT_E_PORT )
+#define HAL_7SEG_SEGMENT_F_DIR          HAL_7SEG_DIR( HAL_7SEG_SEGMENT_F_PORT )
+#define HAL_7SEG_SEGMENT_G_DIR          HAL_7SEG_DIR( HAL_7SEG_SEGMENT_G_PORT )
 
 
 /*Displays  direction registers*/
 #define HAL_7SEG_DISPLAY_1_OUT          P6OUT
 #define HAL_7SEG_DISPLAY_2_OUT          P7OUT
 /*Segments output registers*/
-#define HAL_7SEG_SEGMENT_A_OUT          P3OUT
-#define HAL_7SEG_SEGMENT_B_OUT          P4OUT
-#define HAL_7SEG_SEGMENT_C_OUT          P2OUT
-#define HAL_7SEG_SEGMENT_D_OUT          P8OUT
-#define HAL_7SEG_SEGMENT_E_OUT          P2OUT
-#define HAL_7SEG_SEGMENT_F_OUT          P4OUT
-#define HAL_7SEG_SEGMENT_G_OUT          P8OUT
+#define HAL_7SEG_SEGMENT_A_OUT          HAL_7SEG_OUT( HAL_7SEG_SEGMENT_A_PORT )
+#define HAL_7SEG_SEGMENT_B_OUT          HAL_7SEG_OUT( HAL_7SEG_SEGMENT_B_PORT )
+#define HAL_7SEG_SEGMENT_C_OUT          HAL_7SEG_OUT( HAL_7SEG_SEGMENT_C_PORT )
+#define HAL_7SEG_SEGMENT_D_OUT          HAL_7SEG_OUT( HAL_7SEG_SEGMENT_D_PORT )
+#define HAL_7SEG_SEGMENT_E_OUT          HAL_7SEG_OUT( HAL_7SEG_SEGMENT_E_PORT )
+#define HAL_7SEG_SEGMENT_F_OUT          HAL_7SEG_OUT( HAL_7SEG_SEGMENT_F_PORT )
+#define HAL_7SEG_SEGMENT_G_OUT          HAL_7SEG_OUT( HAL_7SEG_SEGMENT_G_PORT )
 
 #define HAL_7SEG_SEGMENT_A_ON  HAL_7SEG_SEGMENT_A_OUT &=~ HAL_7SEG_SEGMENT_A_MASK
 #define HAL_7SEG_SEGMENT_B_ON  HAL_7SEG_SEGMENT_B_OUT &=~ HAL_7SEG_SEGMENT_B_MASK
@@ -75,6 +98,50 @@
 
 
 
+/*Segments of a glyph, bit 0 = a .. bit 6 = g*/
+#define HAL_7SEG_BIT_A                  0x01
+#define HAL_7SEG_BIT_B                  0x02
+#define HAL_7SEG_BIT_C                  0x04
+#define HAL_7SEG_BIT_D                  0x08
+#define HAL_7SEG_BIT_E                  0x10
+#define HAL_7SEG_BIT_F                  0x20
+#define HAL_7SEG_BIT_G                  0x40
+
+/*Pins of port n that carry the segments in ucSegments*/
+#define HAL_7SEG_SEGMENT_PINS( ucPort, ucSegments, seg )                            \
+    ( ( HAL_7SEG_SEGMENT_##seg##_PORT == ( ucPort ) ) &&                            \
+      ( ( ucSegments ) & HAL_7SEG_BIT_##seg ) ? HAL_7SEG_SEGMENT_##seg##_MASK : 0 )
+#define HAL_7SEG_PORT_PINS( ucPort, ucSegments )                                    \
+    ( HAL_7SEG_SEGMENT_PINS( ucPort, ucSegments, A ) |                              \
+      HAL_7SEG_SEGMENT_PINS( ucPort, ucSegments, B ) |                              \
+      HAL_7SEG_SEGMENT_PINS( ucPort, ucSegments, C ) |                              \
+      HAL_7SEG_SEGMENT_PINS( ucPort, ucSegments, D ) |                              \
+      HAL_7SEG_SEGMENT_PINS( ucPort, ucSegments, E ) |                              \
+      HAL_7SEG_SEGMENT_PINS( ucPort, ucSegments, F ) |                              \
+      HAL_7SEG_SEGMENT_PINS( ucPort, ucSegments, G ) )
+
+/*Glyphs: 0x0 - 0xF, then*/
+#define HAL_7SEG_GLYPH_BLANK            16
+#define HAL_7SEG_GLYPH_MINUS            17
+#define HAL_7SEG_GLYPH_ERROR            18      // a, d and g
+#define HAL_7SEG_NUM_GLYPHS             19
+
+/*Port masks of a glyph, segments are lit by a low pin*/
+typedef struct{
+    uint8_t pucSet[HAL_7SEG_NUM_PORTS];         // pins of dark segments
+    uint8_t pucClear[HAL_7SEG_NUM_PORTS];       // pins of lit segments
+}hal_7seg_glyph_t;
+
+extern const hal_7seg_glyph_t pxHAL7SEGGlyphs[HAL_7SEG_NUM_GLYPHS];
+
+/*Put a glyph on the segments, one write per port; no range check*/
+#define HAL_7SEG_WRITE_PORT( ucPort, ucIndex, pxGlyph )                             \
+    HAL_7SEG_OUT( ucPort ) = ( HAL_7SEG_OUT( ucPort ) | ( pxGlyph )->pucSet[ ucIndex ] ) \
+                             & ~( pxGlyph )->pucClear[ ucIndex ];
+#define HAL_7SEG_WRITE_GLYPH( ucGlyph )                                             \
+    do{ const hal_7seg_glyph_t *pxHAL7SEGGlyph = &pxHAL7SEGGlyphs[ ucGlyph ];       \
+        HAL_7SEG_PORTS( HAL_7SEG_WRITE_PORT, pxHAL7SEGGlyph ) }while( 0 )
+
 typedef enum{
     HAL_DISPLAY_1 = 0,
     HAL_DISPLAY_2 = 1
@@ -83,6 +150,8 @@ typedef enum{
 void        vHAL7SEGInit();
 /*Write digit to previously enabled display*/
 uint8_t     vHAL7SEGWriteDigit(uint8_t digit);
+/*Write any glyph to previously enabled display*/
+uint8_t     ucHAL7SEGWriteGlyph(uint8_t glyph);
 
 
 #endif /* ETF5529_HAL_HAL_7SEG_H_ */
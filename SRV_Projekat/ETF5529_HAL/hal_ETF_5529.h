@@ -13,6 +13,9 @@ in order to use MSP-EXP430F5438 HAL.
 #include "hal_board.h"
 #include "hal_led.h"
 #include "hal_7seg.h"
+#include "hal_mpy.h"
+#include "hal_crc.h"
+#include "hal_flash.h"
 #include "../drivers/MSP430F5xx_6xx/pmm.h"
 #include "../drivers/MSP430F5xx_6xx/ucs.h"
 
@@ -0,0 +1,33 @@
+/**
+ * @file    hal_crc.h
+ * @brief   CRC16 API
+ *
+ * CRC-16/CCITT (polynomial 0x1021, MSB first, no reflection, no final XOR)
+ * backed by the CRC16 peripheral where available. The table driven
+ * software version produces bit-identical results and is used on the host
+ * build; it is always available for comparison.
+ *
+ * A CRC over several buffers is computed by passing the result of one call
+ * as the seed of the next. The check value of "123456789" with seed
+ * halCRC16_SEED is 0x29B1.
+ */
+
+#ifndef HAL_CRC_H
+#define HAL_CRC_H
+
+#include <stdint.h>
+
+/* Initial value for a new CRC */
+#define halCRC16_SEED           ( 0xFFFF )
+
+/* Bytes processed per interrupt-disabled section by the peripheral version */
+#define halCRC16_CHUNK          ( 16 )
+
+/* CRC of usLength bytes, hardware accelerated when available */
+uint16_t    usHALCRC16( const uint8_t *pucData, uint16_t usLength, uint16_t usSeed );
+/* Software implementation of usHALCRC16 */
+uint16_t    usHALCRC16Soft( const uint8_t *pucData, uint16_t usLength, uint16_t usSeed );
+/* Add a single byte to a running CRC (software, ISR friendly) */
+uint16_t    usHALCRC16Byte( uint16_t usCrc, uint8_t ucByte );
+
+#endif /* HAL_CRC_H */
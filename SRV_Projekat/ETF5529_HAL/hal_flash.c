@@ -0,0 +1,209 @@
+/**
+ * @file    hal_flash.c
+ * @brief   Flash segment erase and write
+ *
+ * A segment erase is started by a dummy write into the segment with ERASE
+ * set, words are programmed one by one with WRT set. The controller is
+ * unlocked only for the duration of one erase or one word.
+ *
+ * An erase started from RAM does not hold the CPU. vHALFlashEraseLive()
+ * waits for it in RAM with SYSRIVECT set, so interrupts are taken through
+ * pusLiveVectors[] at the top of RAM (RAMVECT in lnk_msp430f5529.cmd);
+ * the entries without a handler point to prvLiveDefer(). The vectors in
+ * pxLiveSingle[] lose their request there, see hal_flash.h.
+ */
+
+#include "hal_flash.h"
+
+#if defined( __MSP430__ )
+#include "msp430.h"
+#endif
+
+#if defined( __MSP430_HAS_FLASH__ )
+
+void vHALFlashErase( void *pvSegment, uint16_t usSize )
+{
+    uint16_t usState = __get_interrupt_state();
+    volatile uint16_t *pusSegment;
+
+    /* Start of the segment; segments are aligned to their size */
+    pusSegment = ( volatile uint16_t * ) ( ( uintptr_t ) pvSegment & ~( uintptr_t ) ( usSize - 1 ) );
+
+    __disable_interrupt();
+    while( FCTL3 & BUSY );
+    FCTL3 = FWKEY;                      /* Clear LOCK */
+    FCTL1 = FWKEY | ERASE;
+    *pusSegment = 0;                    /* Dummy write starts the erase */
+    while( FCTL3 & BUSY );
+    FCTL1 = FWKEY;
+    FCTL3 = FWKEY | LOCK;
+    __set_interrupt_state( usState );
+}
+
+void vHALFlashWrite( void *pvDest, const void *pvSource, uint16_t usLength )
+{
+    uint16_t usState = __get_interrupt_state();
+    volatile uint16_t *pusDest = ( volatile uint16_t * ) pvDest;
+    const uint16_t *pusSource = ( const uint16_t * ) pvSource;
+
+    for( usLength >>= 1; usLength > 0; usLength-- )
+    {
+        __disable_interrupt();
+        while( FCTL3 & BUSY );
+        FCTL3 = FWKEY;
+        FCTL1 = FWKEY | WRT;
+        *pusDest++ = *pusSource++;
+        while( FCTL3 & BUSY );
+        FCTL1 = FWKEY;
+        FCTL3 = FWKEY | LOCK;
+        /* Pending interrupts are taken between the words */
+        __set_interrupt_state( usState );
+    }
+}
+
+static uint16_t pusLiveVectors[ halFLASH_VECTORS ] __attribute__ ( ( section( ".ramvect" ) ) );
+static uint8_t ucLiveReady;
+
+/* Single-source vectors, their flag is cleared when the request is taken */
+static const struct
+{
+    uint8_t                 ucVector;
+    volatile unsigned int   *pusEnable;     /* As declared by msp430.h */
+    uint16_t                usEnable;
+} pxLiveSingle[] =
+{
+    { TIMER0_A0_VECTOR, &TA0CCTL0, CCIE },
+    { TIMER1_A0_VECTOR, &TA1CCTL0, CCIE },
+    { TIMER2_A0_VECTOR, &TA2CCTL0, CCIE },
+    { TIMER0_B0_VECTOR, &TB0CCTL0, CCIE },
+    { WDT_VECTOR,       &SFRIE1,   WDTIE }
+};
+
+/* Unhandled interrupt: leave it pending and return with interrupts disabled */
+static void __attribute__ ( ( interrupt, ramfunc ) ) prvLiveDefer( void )
+{
+    __bic_SR_register_on_exit( GIE );
+}
+
+static void prvLiveInit( void )
+{
+    uint8_t ucVector;
+
+    for( ucVector = 0; ucVector < halFLASH_VECTORS; ucVector++ )
+    {
+        pusLiveVectors[ ucVector ] = ( uint16_t ) ( uintptr_t ) prvLiveDefer;
+    }
+    ucLiveReady = 1;
+}
+
+void vHALFlashSetLiveHandler( uint8_t ucVector, void ( *pvHandler )( void ) )
+{
+    if( ucLiveReady == 0 )
+    {
+        prvLiveInit();
+    }
+    pusLiveVectors[ ucVector ] = ( uint16_t ) ( uintptr_t ) pvHandler;
+}
+
+/* True if an enabled single-source vector has no handler */
+static uint8_t prvLiveLoses( void )
+{
+    uint8_t ucEntry;
+
+    for( ucEntry = 0; ucEntry < sizeof( pxLiveSingle ) / sizeof( pxLiveSingle[ 0 ] ); ucEntry++ )
+    {
+        if( ( *pxLiveSingle[ ucEntry ].pusEnable & pxLiveSingle[ ucEntry ].usEnable ) &&
+            ( pusLiveVectors[ pxLiveSingle[ ucEntry ].ucVector ] == ( uint16_t ) ( uintptr_t ) prvLiveDefer ) )
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+void __attribute__ ( ( ramfunc ) ) vHALFlashEraseLive( void *pvSegment, uint16_t usSize )
+{
+    uint16_t usState = __get_interrupt_state();
+    volatile uint16_t *pusSegment;
+
+    pusSegment = ( volatile uint16_t * ) ( ( uintptr_t ) pvSegment & ~( uintptr_t ) ( usSize - 1 ) );
+
+    __disable_interrupt();
+    if( ucLiveReady == 0 )
+    {
+        prvLiveInit();                  /* Before the erase, the code is in flash */
+    }
+    if( prvLiveLoses() )
+    {
+        vHALFlashErase( pvSegment, usSize );
+        __set_interrupt_state( usState );
+        return;
+    }
+    while( FCTL3 & BUSY );
+    SYSCTL |= SYSRIVECT;
+    FCTL3 = FWKEY;
+    FCTL1 = FWKEY | ERASE;
+    *pusSegment = 0;                    /* Dummy write starts the erase */
+    __enable_interrupt();
+    while( FCTL3 & BUSY );              /* RAM only until the erase is done */
+    __disable_interrupt();
+    FCTL1 = FWKEY;
+    FCTL3 = FWKEY | LOCK;
+    SYSCTL &= ~SYSRIVECT;
+    __set_interrupt_state( usState );
+}
+
+#else /* Host build, flash is RAM */
+
+uint32_t ulHALFlashPowerBudget;
+
+/* Count one word operation, true if the power fails during it */
+static int prvPowerFails( void )
+{
+    return ( ulHALFlashPowerBudget != 0 ) && ( --ulHALFlashPowerBudget == 0 );
+}
+
+void vHALFlashErase( void *pvSegment, uint16_t usSize )
+{
+    uint16_t *pusSegment = ( uint16_t * ) ( ( uintptr_t ) pvSegment & ~( uintptr_t ) ( usSize - 1 ) );
+
+    for( usSize >>= 1; usSize > 0; usSize-- )
+    {
+        if( prvPowerFails() )
+        {
+            *pusSegment |= 0x00FF;
+            vHALFlashPowerFail();
+        }
+        *pusSegment++ = halFLASH_ERASED;
+    }
+}
+
+void vHALFlashSetLiveHandler( uint8_t ucVector, void ( *pvHandler )( void ) )
+{
+    ( void ) ucVector;
+    ( void ) pvHandler;
+}
+
+/* No controller to wait for, the erase is the same */
+void vHALFlashEraseLive( void *pvSegment, uint16_t usSize )
+{
+    vHALFlashErase( pvSegment, usSize );
+}
+
+void vHALFlashWrite( void *pvDest, const void *pvSource, uint16_t usLength )
+{
+    uint16_t *pusDest = ( uint16_t * ) pvDest;
+    const uint16_t *pusSource = ( const uint16_t * ) pvSource;
+
+    for( usLength >>= 1; usLength > 0; usLength-- )
+    {
+        if( prvPowerFails() )
+        {
+            *pusDest &= *pusSource | 0xFF00;
+            vHALFlashPowerFail();
+        }
+        *pusDest++ &= *pusSource++;
+    }
+}
+
+#endif /* __MSP430_HAS_FLASH__ */
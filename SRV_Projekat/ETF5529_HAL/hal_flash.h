@@ -0,0 +1,71 @@
+/**
+ * @file    hal_flash.h
+ * @brief   Flash segment erase and write
+ *
+ * Erases and programs the flash through the flash controller. Code in
+ * flash cannot run while the controller works: the CPU is held for a word
+ * write (about 85 us) and for an erase started from flash (up to 32 ms).
+ * vHALFlashWrite() disables interrupts for one word at a time, so they are
+ * taken between the words. vHALFlashErase() runs with interrupts disabled
+ * throughout; vHALFlashEraseLive() runs from RAM and keeps them enabled
+ * with the vectors taken from a RAM table, whose handlers must be in RAM
+ * as well. Both are meant for rare writes of configuration or log data,
+ * not for the sampling path.
+ *
+ * Main flash segments are 512 bytes, information memory segments 128
+ * bytes. INFOA is protected by LOCKA and is not written by this API.
+ *
+ * On the host build flash is ordinary memory: an erase fills the segment
+ * with 0xFF and a write ANDs the data in, as programming can only clear
+ * bits. A power failure can be simulated there: once ulHALFlashPowerBudget
+ * word operations have been done, the word being erased or programmed is
+ * left half done, the rest of the call is not carried out and
+ * vHALFlashPowerFail() is called; it must not return.
+ */
+
+#ifndef HAL_FLASH_H
+#define HAL_FLASH_H
+
+#include <stdint.h>
+
+/* Segment sizes in bytes */
+#define halFLASH_MAIN_SEGMENT   ( 512 )
+#define halFLASH_INFO_SEGMENT   ( 128 )
+/* Value of an erased word */
+#define halFLASH_ERASED         ( 0xFFFF )
+
+/* Erase the usSize byte segment containing pvSegment, usSize is one of the above */
+void        vHALFlashErase( void *pvSegment, uint16_t usSize );
+/* Program usLength bytes (even, word aligned) of erased flash */
+void        vHALFlashWrite( void *pvDest, const void *pvSource, uint16_t usLength );
+
+/* Entries of the RAM vector table, indexed by the vector numbers of msp430.h */
+#define halFLASH_VECTORS        ( 64 )
+
+/**
+ * @brief Handler of vector ucVector while vHALFlashEraseLive() waits
+ *
+ * pvHandler must be an interrupt function placed in RAM that neither
+ * reads nor calls anything in flash. A vector without a handler ends the
+ * live part of the erase: interrupts are disabled until it is done and the
+ * request is then taken by its own handler.
+ *
+ * That holds only where the flag stays set when the request is taken:
+ * vectors with an IV register, ports and USCI. The single-source vectors
+ * of CCR0 of TA0, TA1, TA2 and TB0 and of the WDT interval timer clear
+ * their flag on entry, so such a request would be lost. With one of them
+ * enabled and no handler set, vHALFlashEraseLive() keeps interrupts
+ * disabled for the whole erase, as vHALFlashErase() does.
+ */
+void        vHALFlashSetLiveHandler( uint8_t ucVector, void ( *pvHandler )( void ) );
+/* Erase as vHALFlashErase(), with interrupts enabled while the controller works */
+void        vHALFlashEraseLive( void *pvSegment, uint16_t usSize );
+
+#if !defined( __MSP430__ )
+/* Word operations left before a simulated power failure, 0 never fails */
+extern uint32_t ulHALFlashPowerBudget;
+/* Provided by the host program */
+void        vHALFlashPowerFail( void );
+#endif
+
+#endif /* HAL_FLASH_H */
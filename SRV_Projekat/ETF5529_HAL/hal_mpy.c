@@ -0,0 +1,140 @@
+/**
+ * @file    hal_mpy.c
+ * @brief   MPY32 DSP primitives
+ *
+ * 16x16 operations are started by writing MPYS (signed multiply) or MAC
+ * (unsigned multiply-accumulate) followed by OP2; their result in
+ * RESLO/RESHI can be read by the next instruction. MAC adds the product to
+ * RESLO/RESHI, which may be written first to preload the accumulator, and
+ * leaves the carry in SUMEXT. A 32-bit first operand is written to
+ * MPY32L/MPY32H (MPYS32L/MPYS32H signed); writing OP2 then starts a 32x16
+ * multiply, writing OP2L/OP2H a 32x32 one. Their results in RES0..RES3 are
+ * complete 7 cycles after the last operand word is written.
+ */
+
+#include "hal_mpy.h"
+
+#if defined( __MSP430__ )
+#include "msp430.h"
+#endif
+
+#if defined( __MSP430_HAS_MPY32__ )
+
+/* Enter / leave a section where the multiplier may be used */
+#define prvMPY_ENTER()      uint16_t usState = __get_interrupt_state(); __disable_interrupt()
+#define prvMPY_LEAVE()      __set_interrupt_state( usState )
+
+#define prvMPY_RESULT32()   ( ( uint32_t ) RESLO | ( ( uint32_t ) RESHI << 16 ) )
+
+void vHALMPYScaleQ15( int16_t *psBlock, uint16_t usLength, int16_t sGain )
+{
+    uint16_t usChunk;
+    int32_t lResult;
+
+    while( usLength > 0 )
+    {
+        usChunk = ( usLength > halMPY_CHUNK ) ? halMPY_CHUNK : usLength;
+        usLength -= usChunk;
+        {
+            prvMPY_ENTER();
+
+            /* MPYS keeps its value, so only OP2 is written per sample */
+            MPYS = sGain;
+            do
+            {
+                OP2 = *psBlock;
+                lResult = ( int32_t ) prvMPY_RESULT32();
+                *psBlock++ = ( int16_t ) ( lResult >> 15 );
+            } while( --usChunk > 0 );
+
+            prvMPY_LEAVE();
+        }
+    }
+}
+
+uint32_t ulHALMPYMacU( uint32_t ulAcc, uint16_t usA, uint16_t usB, uint16_t *pusCarry )
+{
+    uint32_t ulResult;
+    prvMPY_ENTER();
+
+    RESLO = ( uint16_t ) ulAcc;
+    RESHI = ( uint16_t ) ( ulAcc >> 16 );
+    MAC = usA;
+    OP2 = usB;
+    ulResult = prvMPY_RESULT32();
+    *pusCarry += SUMEXT;
+
+    prvMPY_LEAVE();
+    return ulResult;
+}
+
+int32_t lHALMPYMulS32x16( int32_t lA, int16_t sB, uint8_t ucShift )
+{
+    uint32_t ulLow;
+    uint16_t usHigh;
+    prvMPY_ENTER();
+
+    MPYS32L = ( uint16_t ) lA;
+    MPYS32H = ( uint16_t ) ( ( uint32_t ) lA >> 16 );
+    OP2 = sB;
+    __delay_cycles( 7 );
+    ulLow = ( uint32_t ) RES0 | ( ( uint32_t ) RES1 << 16 );
+    usHigh = RES2;
+
+    prvMPY_LEAVE();
+    if( ucShift == 0 )
+    {
+        return ( int32_t ) ulLow;
+    }
+    return ( int32_t ) ( ( ulLow >> ucShift ) | ( ( uint32_t ) usHigh << ( 32 - ucShift ) ) );
+}
+
+uint32_t ulHALMPYMulHighU32( uint32_t ulA, uint32_t ulB )
+{
+    uint32_t ulHigh;
+    prvMPY_ENTER();
+
+    MPY32L = ( uint16_t ) ulA;
+    MPY32H = ( uint16_t ) ( ulA >> 16 );
+    OP2L = ( uint16_t ) ulB;
+    OP2H = ( uint16_t ) ( ulB >> 16 );
+    __delay_cycles( 7 );
+    ulHigh = ( uint32_t ) RES2 | ( ( uint32_t ) RES3 << 16 );
+
+    prvMPY_LEAVE();
+    return ulHigh;
+}
+
+#else /* Portable fallback */
+
+void vHALMPYScaleQ15( int16_t *psBlock, uint16_t usLength, int16_t sGain )
+{
+    while( usLength-- > 0 )
+    {
+        *psBlock = ( int16_t ) ( ( ( int32_t ) *psBlock * sGain ) >> 15 );
+        psBlock++;
+    }
+}
+
+uint32_t ulHALMPYMacU( uint32_t ulAcc, uint16_t usA, uint16_t usB, uint16_t *pusCarry )
+{
+    uint32_t ulResult = ulAcc + ( uint32_t ) usA * usB;
+
+    if( ulResult < ulAcc )
+    {
+        ( *pusCarry )++;
+    }
+    return ulResult;
+}
+
+int32_t lHALMPYMulS32x16( int32_t lA, int16_t sB, uint8_t ucShift )
+{
+    return ( int32_t ) ( ( ( int64_t ) lA * sB ) >> ucShift );
+}
+
+uint32_t ulHALMPYMulHighU32( uint32_t ulA, uint32_t ulB )
+{
+    return ( uint32_t ) ( ( ( uint64_t ) ulA * ulB ) >> 32 );
+}
+
+#endif /* __MSP430_HAS_MPY32__ */
@@ -0,0 +1,43 @@
+/**
+ * @file    hal_mpy.h
+ * @brief   MPY32 DSP primitives
+ *
+ * Multiply, multiply-accumulate and block helpers for the signal path:
+ * Q15 block scaling (calibration), an unsigned MAC with carry (statistics),
+ * a scaled 32x16 product (Goertzel resonators) and the high word of a 32x32
+ * product (decimal formatting).
+ * On MSP430 devices with the MPY32 peripheral they drive the multiplier
+ * directly; everywhere else (host builds) a portable C implementation with
+ * the same results is used.
+ *
+ * Interrupt safety: the multiplier holds state between writing the operands
+ * and reading the result, and an accumulation keeps it across several
+ * operations. Every primitive therefore runs its multiplier sequence with
+ * interrupts disabled, restoring the previous interrupt state afterwards,
+ * and long blocks are split into chunks of halMPY_CHUNK samples so interrupt
+ * latency stays bounded. No multiplier state is kept with interrupts
+ * enabled, so the primitives may be called from tasks and from ISRs, and
+ * they cannot corrupt (or be corrupted by) compiler generated multiplies,
+ * which the compiler protects in the same way.
+ *
+ * Results are bit-identical to the C fallback.
+ */
+
+#ifndef HAL_MPY_H
+#define HAL_MPY_H
+
+#include <stdint.h>
+
+/* Samples processed per interrupt-disabled section in block functions */
+#define halMPY_CHUNK            ( 8 )
+
+/* psBlock[ i ] = ( psBlock[ i ] * sGain ) >> 15, in place */
+void        vHALMPYScaleQ15( int16_t *psBlock, uint16_t usLength, int16_t sGain );
+/* ulAcc + usA * usB, unsigned; the carry out of bit 31 is added to *pusCarry */
+uint32_t    ulHALMPYMacU( uint32_t ulAcc, uint16_t usA, uint16_t usB, uint16_t *pusCarry );
+/* ( lA * sB ) >> ucShift, ucShift 0 .. 16, truncated to 32 bits */
+int32_t     lHALMPYMulS32x16( int32_t lA, int16_t sB, uint8_t ucShift );
+/* ( ulA * ulB ) >> 32, the high word of the unsigned 64-bit product */
+uint32_t    ulHALMPYMulHighU32( uint32_t ulA, uint32_t ulB );
+
+#endif /* HAL_MPY_H */
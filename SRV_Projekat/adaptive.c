@@ -0,0 +1,58 @@
+/**
+ * @file adaptive.c
+ * @brief Activity driven sampling rate
+ */
+
+#include "adaptive.h"
+#include "app_config.h"
+
+void vAdaptiveInit( Adaptive_t *pxAdaptive )
+{
+    pxAdaptive->usLast = 0;
+    pxAdaptive->ucLevel = appADAPTIVE_LEVELS - 1;
+    pxAdaptive->ucQuiet = 0;
+    pxAdaptive->ucSkip = 0;
+    pxAdaptive->xStarted = false;
+}
+
+bool xAdaptiveAdd( Adaptive_t *pxAdaptive, uint16_t usSample, uint8_t ucBaseLevel )
+{
+    uint16_t usDelta;
+
+    usDelta = ( usSample > pxAdaptive->usLast ) ?
+              usSample - pxAdaptive->usLast :
+              pxAdaptive->usLast - usSample;
+
+    if( ( pxAdaptive->xStarted == false ) || ( usDelta > appADAPTIVE_THRESHOLD ) )
+    {
+        /* Fast attack */
+        pxAdaptive->ucLevel = 0;
+        pxAdaptive->ucQuiet = 0;
+    }
+    else
+    {
+        if( pxAdaptive->ucSkip > 0 )
+        {
+            pxAdaptive->ucSkip--;
+            return false;
+        }
+        /* Slow release */
+        if( ( ++pxAdaptive->ucQuiet >= appADAPTIVE_HOLD ) &&
+            ( pxAdaptive->ucLevel < appADAPTIVE_LEVELS - 1 ) )
+        {
+            pxAdaptive->ucLevel++;
+            pxAdaptive->ucQuiet = 0;
+        }
+    }
+
+    pxAdaptive->xStarted = true;
+    pxAdaptive->usLast = usSample;
+    pxAdaptive->ucSkip = ( pxAdaptive->ucLevel > ucBaseLevel ) ?
+                         ( uint8_t ) ( ( 1U << ( pxAdaptive->ucLevel - ucBaseLevel ) ) - 1U ) : 0;
+    return true;
+}
+
+void vAdaptiveRebase( Adaptive_t *pxAdaptive )
+{
+    pxAdaptive->ucSkip = 0;
+}
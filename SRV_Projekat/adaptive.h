@@ -0,0 +1,49 @@
+/**
+ * @file adaptive.h
+ * @brief Activity driven sampling rate
+ *
+ * @details
+ * Every channel has a rate level: at level L it is sampled every
+ * appADAPTIVE_MIN_PERIOD_MS << L. The ADC runs at the base level, the
+ * fastest level of all channels, and slower channels keep only every
+ * 2^( L - base ) th sequence.
+ *
+ * A change of more than appADAPTIVE_THRESHOLD between a sample and the last
+ * kept sample of the channel - checked on every sequence, kept or not -
+ * moves the channel to level 0 at once. After appADAPTIVE_HOLD quiet kept
+ * samples it slows down by one level, up to appADAPTIVE_LEVELS - 1.
+ */
+
+#ifndef ADAPTIVE_H
+#define ADAPTIVE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @brief State of one channel
+ */
+typedef struct{
+    uint16_t usLast;        // last kept sample
+    uint8_t  ucLevel;
+    uint8_t  ucQuiet;       // quiet kept samples at this level
+    uint8_t  ucSkip;        // sequences to drop before the next kept one
+    bool     xStarted;      // false until the first sample was kept
+}Adaptive_t;
+
+/* Start at the slowest level; the next sample is kept */
+void vAdaptiveInit( Adaptive_t *pxAdaptive );
+
+/**
+ * @brief Process the channel's sample of one sequence
+ *
+ * @param ucBaseLevel   level the ADC currently runs at
+ *
+ * @return true if the sample is kept
+ */
+bool xAdaptiveAdd( Adaptive_t *pxAdaptive, uint16_t usSample, uint8_t ucBaseLevel );
+
+/* Resynchronise after the base level changed: the next sample is kept */
+void vAdaptiveRebase( Adaptive_t *pxAdaptive );
+
+#endif /* ADAPTIVE_H */
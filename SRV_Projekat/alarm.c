@@ -0,0 +1,40 @@
+/**
+ * @file alarm.c
+ * @brief Threshold alarms with hysteresis
+ */
+
+#include "alarm.h"
+
+bool xAlarmUpdate( const AlarmLimits_t *pxLimits, AlarmState_t *pxState, uint16_t usValue )
+{
+    AlarmState_t xNew = *pxState;
+
+    if( pxLimits->xEnabled == false )
+    {
+        return false;
+    }
+
+    if( usValue > pxLimits->usHigh )
+    {
+        xNew = ALARM_HIGH;
+    }
+    else if( usValue < pxLimits->usLow )
+    {
+        xNew = ALARM_LOW;
+    }
+    else if( ( xNew == ALARM_HIGH ) && ( ( uint32_t ) usValue + pxLimits->usHysteresis < pxLimits->usHigh ) )
+    {
+        xNew = ALARM_NORMAL;
+    }
+    else if( ( xNew == ALARM_LOW ) && ( usValue > ( uint32_t ) pxLimits->usLow + pxLimits->usHysteresis ) )
+    {
+        xNew = ALARM_NORMAL;
+    }
+
+    if( xNew == *pxState )
+    {
+        return false;
+    }
+    *pxState = xNew;
+    return true;
+}
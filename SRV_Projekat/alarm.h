@@ -0,0 +1,41 @@
+/**
+ * @file alarm.h
+ * @brief Threshold alarms with hysteresis
+ *
+ * @details
+ * A channel is in the high alarm while its value is above usHigh and leaves
+ * it once the value drops below usHigh - usHysteresis; the low alarm works
+ * the same way around usLow. A value may move straight from one alarm to
+ * the other. Limits are in the unit of the values checked.
+ */
+
+#ifndef ALARM_H
+#define ALARM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef enum{
+    ALARM_NORMAL,
+    ALARM_LOW,
+    ALARM_HIGH
+}AlarmState_t;
+
+/**
+ * @brief Limits of one channel, xEnabled false for channels without alarm
+ */
+typedef struct{
+    uint16_t usLow;
+    uint16_t usHigh;
+    uint16_t usHysteresis;
+    bool     xEnabled;
+}AlarmLimits_t;
+
+/**
+ * @brief Evaluate one value
+ *
+ * @return true if *pxState changed
+ */
+bool xAlarmUpdate( const AlarmLimits_t *pxLimits, AlarmState_t *pxState, uint16_t usValue );
+
+#endif /* ALARM_H */
@@ -0,0 +1,380 @@
+/**
+ * @file app_config.h
+ * @brief Declarative configuration of the acquisition pipeline
+ *
+ * @details
+ * Everything that shapes the pipeline - which ADC inputs are sampled, how
+ * often, how samples are reduced, how they are printed and how large the
+ * queues between the stages are - is declared here. The rest of the
+ * application only expands these declarations: the channel list is an
+ * X-macro that is unrolled at compile time into the ADC12 sequence set-up,
+ * the ISR read-out and the per-channel state arrays, so no channel table is
+ * walked at run time.
+ *
+ * The checks at the end of the file reject configurations whose buffers
+ * cannot absorb the worst-case burst at the configured rates.
+ */
+
+#ifndef APP_CONFIG_H
+#define APP_CONFIG_H
+
+#include "FreeRTOS.h"
+
+/*----------------------------------------------------------------------------
+ * Channels
+ *
+ * X( index, ADC12 input, P6SEL pin, period )
+ *  index       - channel index; the channel number shown to the user is
+ *                index + 1
+ *  ADC12 input - ADC12INCH_x value written to ADC12MCTLx
+ *  P6SEL pin   - analog function select bit on port 6, 0 for internal inputs
+ *  period      - sampling period in ms (rategroup.h); channels due on the
+ *                same tick are converted in one ADC12 sequence
+ *
+ * Internal inputs (temperature sensor, AVcc / 2; sensors.h) follow the
+ * external ones. They are converted in sequences of their own, on the
+ * first tick no external channel is due after the reference has settled,
+ * and are not captured.
+ *--------------------------------------------------------------------------*/
+#define appCHANNELS( X )                                \
+    X( 0, ADC12INCH_0,  BIT0, 1000 )                    \
+    X( 1, ADC12INCH_1,  BIT1, 1000 )                    \
+    X( 2, ADC12INCH_10, 0,    5000 )                    \
+    X( 3, ADC12INCH_11, 0,    5000 )
+
+/*----------------------------------------------------------------------------
+ * Rates and filtering
+ *--------------------------------------------------------------------------*/
+/* Resolution of every channel after reset: 9, 10, 12 or oversampled 14, 16
+   bit (resolution.h); the deadband and activity thresholds are in LSB of it */
+#define appSAMPLE_BITS              ( 9 )
+/* Statistics mode: summary window of 2^appSTATS_WINDOW_LOG2 samples */
+#define appSTATS_WINDOW_LOG2        ( 4 )
+/* Deadband mode: report when a sample moves by more than appDEADBAND LSB,
+   heartbeat after appDEADBAND_MAX_SILENT suppressed samples */
+#define appDEADBAND                 ( 2 )
+#define appDEADBAND_MAX_SILENT      ( 30 )
+
+/*----------------------------------------------------------------------------
+ * Calibration (calibration.h)
+ *
+ * The gain and offset from the device TLV are applied to every conversion.
+ * 'k' measures a user calibration point: the first press averages the
+ * lowest selected channel while it is fed the input that should read
+ * appCAL_LOW_CODE, the second one while it is fed appCAL_HIGH_CODE.
+ *--------------------------------------------------------------------------*/
+/* ADC reference: 0 for AVcc, 1500, 2000 or 2500 mV for the internal REF */
+#define appADC_VREF_MV              ( 0 )
+#define appCAL_LOW_CODE             ( 410 )
+#define appCAL_HIGH_CODE            ( 3686 )
+/* Conversions averaged per calibration point, log2 */
+#define appCAL_AVERAGE_LOG2         ( 6 )
+/* Time the correction kernel at start-up (usCalibrationCycles in main.c) */
+#define appCAL_BENCHMARK            ( 0 )
+/* Internal sensors use the internal reference; AVcc reads up to twice it */
+#if appADC_VREF_MV == 0
+#define appSENSOR_VREF_MV           ( 2500 )
+#else
+#define appSENSOR_VREF_MV           appADC_VREF_MV
+#endif
+
+/*----------------------------------------------------------------------------
+ * Alarms (alarm.h)
+ *
+ * X( channel index, low, high, hysteresis, LED )
+ * Every conversion of a listed channel is checked, whether it is displayed
+ * or not. Limits are in corrected 12-bit LSB for external inputs, in 0.1 K
+ * and mV for the sensors. While one of its channels is in alarm the LED
+ * (hal_led.h) blinks code 1 for a low alarm and code 2 for a high one, a
+ * high alarm winning over a low one.
+ *--------------------------------------------------------------------------*/
+#define appALARMS( X )                                  \
+    X( 0, 200,  3900, 40, LED3 )                        \
+    X( 1, 200,  3900, 40, LED3 )                        \
+    X( 2, 2732, 3432, 20, LED4 )                        \
+    X( 3, 3000, 3600, 50, LED4 )
+
+/*----------------------------------------------------------------------------
+ * LED patterns (pattern.h)
+ *
+ * The tick hook advances both LEDs every appPATTERN_STEP_MS. Without an
+ * alarm the heartbeat LED pulses twice a second and the activity LED
+ * flashes for every line or frame sent.
+ *--------------------------------------------------------------------------*/
+#define appPATTERN_STEP_MS          ( 100 )
+#define appLED_HEARTBEAT            LED3
+#define appLED_ACTIVITY             LED4
+
+/*----------------------------------------------------------------------------
+ * 7-segment display (display.h)
+ *
+ * Shows one channel: external inputs in percent of full scale, the
+ * temperature in degC and AVcc in 0.1 V. 'v' selects the next channel,
+ * 'V' the next brightness level.
+ *--------------------------------------------------------------------------*/
+/* Channel shown at start-up, index + 1; 0 leaves the display blank */
+#define appDISPLAY_CHANNEL          ( 1 )
+/* Digit slots per second, each of the two digits gets every other slot */
+#define appDISPLAY_SLOT_HZ          ( 200 )
+/* Brightness steps, duty cycle = level / appDISPLAY_LEVELS */
+#define appDISPLAY_LEVELS           ( 8 )
+#define appDISPLAY_LEVEL            ( 4 )
+/*
+ * MCLK cycles a refresh - both TA1 interrupts - may take. The benchmark
+ * measures it at start-up and 'q' reports it; over the budget the display
+ * is stopped and the rest of the firmware runs without it.
+ */
+#define appDISPLAY_BUDGET_CYCLES    ( 250 )
+#define appDISPLAY_BENCHMARK        ( 1 )
+
+/*----------------------------------------------------------------------------
+ * Flash logger (log.h)
+ *
+ * Every conversion is also logged to a ring of flash segments at the start
+ * of FLASH2; lnk_msp430f5529.cmd keeps this area (LOG) free of code. No
+ * code in flash runs while a segment is erased, ISRs included, so the
+ * logger only starts an erase when no conversion is due for its duration.
+ * Every sampling period must exceed appLOG_ERASE_MS + appLOG_RETRY_MS;
+ * channels of different periods or phases can still close the gaps, 'q'
+ * reports the erases done and the attempts refused ('E').
+ *--------------------------------------------------------------------------*/
+#define appLOG_START                ( 0x10000UL )
+#define appLOG_SEGMENTS             ( 64 )
+/* Payload of a block, 4-bit deltas: 2 to 8 samples per 2 bytes of flash */
+#define appLOG_PAYLOAD_BYTES        ( 48 )
+/* Longest segment erase, with margin (data sheet 32 ms) */
+#define appLOG_ERASE_MS             ( 35 )
+/* Wait before looking for a window again */
+#define appLOG_RETRY_MS             ( 10 )
+
+/*----------------------------------------------------------------------------
+ * Adaptive rate mode (adaptive.h)
+ *
+ * A channel at level L is sampled every appADAPTIVE_MIN_PERIOD_MS << L.
+ * A change of more than appADAPTIVE_THRESHOLD LSB selects level 0, after
+ * appADAPTIVE_HOLD quiet samples the channel slows down by one level.
+ *--------------------------------------------------------------------------*/
+#define appADAPTIVE_MIN_PERIOD_MS   ( 125 )
+#define appADAPTIVE_LEVELS          ( 5 )
+#define appADAPTIVE_THRESHOLD       ( 4 )
+#define appADAPTIVE_HOLD            ( 8 )
+
+/*----------------------------------------------------------------------------
+ * Capture (oscilloscope) mode
+ *--------------------------------------------------------------------------*/
+/* ADC sequence rate while capturing, paced by Timer B0 */
+#define appCAPTURE_RATE_HZ          ( 10000UL )
+/* Sets (one raw sample per channel) held in the capture buffer */
+#define appCAPTURE_DEPTH            ( 512 )
+/* Sets kept from before the trigger */
+#define appCAPTURE_PRETRIGGER       ( 128 )
+/* Trigger: channel index, condition (CaptureTrigger_t) and 12-bit level */
+#define appCAPTURE_TRIGGER_CHANNEL  ( 0 )
+#define appCAPTURE_TRIGGER          CAPTURE_RISING_EDGE
+#define appCAPTURE_TRIGGER_LEVEL    ( 2048 )
+/* Sets per binary data frame during the dump */
+#define appCAPTURE_SETS_PER_FRAME   ( 16 )
+/* RAM reserved for the capture buffer */
+#define appCAPTURE_RAM_BUDGET       ( 2048 )
+
+/*----------------------------------------------------------------------------
+ * Spectral mode
+ *
+ * Blocks are taken with the capture buffer at appSPECTRUM_RATE_HZ and the
+ * amplitude of every frequency in appSPECTRUM_BINS( X ), X( Hz ), is
+ * reported per selected channel.
+ *--------------------------------------------------------------------------*/
+#define appSPECTRUM_RATE_HZ         ( 1000UL )
+/* Block of 2^appSPECTRUM_BLOCK_LOG2 sets, the whole capture buffer */
+#define appSPECTRUM_BLOCK_LOG2      ( 9 )
+#define appSPECTRUM_BINS( X )       X( 50 ) X( 100 ) X( 150 )
+
+/*----------------------------------------------------------------------------
+ * Output
+ *--------------------------------------------------------------------------*/
+/* Print the difference to the previous sample of the channel */
+#define appFORMAT_DIFFERENCE        ( 0 )
+/* Print the sample value itself */
+#define appFORMAT_ABSOLUTE          ( 1 )
+
+#define appOUTPUT_FORMAT            appFORMAT_DIFFERENCE
+/* Append the sample time " ttttt.ss" (tick.sub-tick, timestamp.h) to every line */
+#define appOUTPUT_TIMESTAMP         ( 1 )
+/* Longest output line, 16-bit samples: "c: -xxxxx ttttt.ss\n\r" */
+#if appOUTPUT_TIMESTAMP
+#define appLINE_MAX_BYTES           ( 20 )
+#else
+#define appLINE_MAX_BYTES           ( 11 )
+#endif
+
+/* One rate for the whole link: the log dump ('L') shares the line with the
+   live records and the commands, so it is not switched to a faster rate of
+   its own - the host would have to follow in step, and a missed switch
+   would cut it off. A faster dump means raising this value; the bandwidth
+   checks below and the receive buffer kept during a flash erase follow it. */
+#define appUART_BAUD                ( 9600UL )
+/* Share of the UART the stream mode may fill before it aggregates samples */
+#define appUART_LOAD_PERCENT        ( 80 )
+
+/* Flow control (flow.h): XON/XOFF in both directions, and RTS/CTS on two
+   spare port 1 pins, both active low. CTS must be able to interrupt. */
+#define appUART_XONXOFF             ( 1 )
+#define appUART_RTSCTS              ( 0 )
+#define appUART_RTS_BIT             ( BIT3 )
+#define appUART_CTS_BIT             ( BIT2 )
+/* Receive queue fill at which the host is stopped and let go again */
+#define appUART_RX_STOP             ( appCHAR_QUEUE_LENGTH - 4 )
+#define appUART_RX_RESUME           ( 2 )
+
+/*----------------------------------------------------------------------------
+ * Buffers and tasks
+ *--------------------------------------------------------------------------*/
+/* Number of sample periods the acquisition task may fall behind the ISR */
+#define appADC_MAX_LAG_PERIODS      ( 5 )
+
+#define appADC_QUEUE_LENGTH         ( 10 )
+#define appCHAR_QUEUE_LENGTH        ( 10 )
+#define appMESSAGE_QUEUE_LENGTH     ( 10 )
+/* Control lane of the UART transmitter: command responses and alarms */
+#define appCONTROL_QUEUE_LENGTH     ( 4 )
+#define appCOMMAND_QUEUE_LENGTH     ( 4 )
+#define appLOG_QUEUE_LENGTH         ( 8 )
+
+/* Overflow policy of each producer (StagePolicy_t, stage.h). The ADC
+   sequence and the records made from it are sent as one group each, so
+   decimation and dropping keep the channels of a sequence together. */
+#define appADC_POLICY               STAGE_DROP_OLDEST
+#define appCHAR_POLICY              STAGE_DROP_NEWEST
+#define appMESSAGE_POLICY           STAGE_DECIMATE
+#define appCONTROL_POLICY           STAGE_DROP_NEWEST
+#define appLOG_POLICY               STAGE_DROP_OLDEST
+/* STAGE_DECIMATE keeps 1 of appSTAGE_DECIMATION groups while degraded */
+#define appSTAGE_DECIMATION         ( 2 )
+
+#define appTASK1_PRIO               ( 1 )
+#define appTASK2_PRIO               ( 2 )
+#define appTASK3_PRIO               ( 3 )
+#define appLOG_PRIO                 ( 1 )
+
+#define appTASK1_STACK              ( configMINIMAL_STACK_SIZE )
+#define appTASK2_STACK              ( configMINIMAL_STACK_SIZE )
+#define appTASK3_STACK              ( configMINIMAL_STACK_SIZE )
+#define appLOG_STACK                ( configMINIMAL_STACK_SIZE )
+
+/*----------------------------------------------------------------------------
+ * Derived values - do not edit below this line
+ *--------------------------------------------------------------------------*/
+#define appCOUNT_CHANNEL( ucIndex, usInput, ucPin, usPeriodMs )     + 1
+#define appCOUNT_EXTERNAL( ucIndex, usInput, ucPin, usPeriodMs )    + ( ( ucPin ) != 0 )
+#define appINTERNAL_BIT( ucIndex, usInput, ucPin, usPeriodMs )      | ( ( ucPin ) ? 0U : 1U << ( ucIndex ) )
+#define appPIN_OF_CHANNEL( ucIndex, usInput, ucPin, usPeriodMs )    | ( ucPin )
+#define appLINES_OF_CHANNEL( ucIndex, usInput, ucPin, usPeriodMs )  + 1000000UL / ( usPeriodMs )
+
+#define appNUM_CHANNELS             ( 0 appCHANNELS( appCOUNT_CHANNEL ) )
+#define appALL_CHANNELS_MASK        ( ( 1U << appNUM_CHANNELS ) - 1U )
+/* External inputs come first and are the ones captured */
+#define appNUM_EXTERNAL             ( 0 appCHANNELS( appCOUNT_EXTERNAL ) )
+#define appINTERNAL_MASK            ( 0U appCHANNELS( appINTERNAL_BIT ) )
+#define appEXTERNAL_MASK            ( appALL_CHANNELS_MASK & ~appINTERNAL_MASK )
+/* Longest ADC sequence, external and internal channels are never mixed */
+#define appSEQUENCE_MAX             ( appNUM_EXTERNAL > appNUM_CHANNELS - appNUM_EXTERNAL ? \
+                                      appNUM_EXTERNAL : appNUM_CHANNELS - appNUM_EXTERNAL )
+#define appP6SEL_MASK               ( 0 appCHANNELS( appPIN_OF_CHANNEL ) )
+/* Samples of all channels together per 1000 s */
+#define appLINES_PER_KS             ( 0 appCHANNELS( appLINES_OF_CHANNEL ) )
+
+/* ADC12MCTLx reference select of the external inputs, REF voltage */
+#if appADC_VREF_MV == 0
+#define appADC_SREF                 ADC12SREF_0
+#else
+#define appADC_SREF                 ADC12SREF_1
+#endif
+#define appREF_VSEL                 ( appSENSOR_VREF_MV == 1500 ? REFVSEL_0 :   \
+                                      appSENSOR_VREF_MV == 2000 ? REFVSEL_1 : REFVSEL_2 )
+
+#define appCAPTURE_TIMER_PERIOD     ( configCPU_CLOCK_HZ / appCAPTURE_RATE_HZ - 1UL )
+#define appCAPTURE_PERIOD_US        ( 1000000UL / appCAPTURE_RATE_HZ )
+#define appSPECTRUM_TIMER_PERIOD    ( configCPU_CLOCK_HZ / appSPECTRUM_RATE_HZ - 1UL )
+
+/* TA1 (ACLK) ticks per display slot */
+#define appDISPLAY_PERIOD           ( configLFXT_CLOCK_HZ / appDISPLAY_SLOT_HZ )
+
+/* USCI_A1 from SMCLK (= MCLK): UCBRx = N, UCBRSx = round( frac( N ) * 8 ) */
+#define appUART_BRW                 ( configCPU_CLOCK_HZ / appUART_BAUD )
+#define appUART_BRS                 ( ( ( configCPU_CLOCK_HZ * 16UL / appUART_BAUD ) \
+                                        - appUART_BRW * 16UL + 1UL ) / 2UL )
+
+/*----------------------------------------------------------------------------
+ * Compile-time checks
+ *--------------------------------------------------------------------------*/
+#define appSTATIC_ASSERT( xExpr, xName )    typedef char xName[ ( xExpr ) ? 1 : -1 ]
+
+/* ADC12 has 16 conversion memories */
+appSTATIC_ASSERT( appNUM_CHANNELS >= 1 && appNUM_CHANNELS <= 16, appCheckChannelCount );
+appSTATIC_ASSERT( appNUM_EXTERNAL >= 1 && appEXTERNAL_MASK == ( 1U << appNUM_EXTERNAL ) - 1U,
+                  appCheckExternalFirst );
+/* ISR must be able to post a full sequence for every period Task1 may lag */
+appSTATIC_ASSERT( appADC_QUEUE_LENGTH >= appSEQUENCE_MAX * appADC_MAX_LAG_PERIODS,
+                  appCheckADCQueueCoversBurst );
+/* One sequence worth of output must fit while Task3 is still transmitting */
+appSTATIC_ASSERT( appMESSAGE_QUEUE_LENGTH >= appSEQUENCE_MAX, appCheckMessageQueueCoversBurst );
+appSTATIC_ASSERT( appSTAGE_DECIMATION >= 1, appCheckStageDecimation );
+appSTATIC_ASSERT( appUART_LOAD_PERCENT > 0 && appUART_LOAD_PERCENT <= 100, appCheckUARTLoad );
+/* Statistics window must not overflow the 32-bit sum (statsMAX_WINDOW_LOG2) */
+appSTATIC_ASSERT( appSTATS_WINDOW_LOG2 <= 8, appCheckStatsWindow );
+/* Capture buffer must fit its RAM budget and leave room for post-trigger sets */
+appSTATIC_ASSERT( (unsigned long) appCAPTURE_DEPTH * appNUM_EXTERNAL * 2UL <= appCAPTURE_RAM_BUDGET,
+                  appCheckCaptureRAM );
+appSTATIC_ASSERT( appCAPTURE_PRETRIGGER < appCAPTURE_DEPTH, appCheckCapturePreTrigger );
+/* Capture timer period must fit the 16-bit Timer B0 */
+appSTATIC_ASSERT( appCAPTURE_TIMER_PERIOD > 0 && appCAPTURE_TIMER_PERIOD <= 0xFFFFUL,
+                  appCheckCaptureRate );
+appSTATIC_ASSERT( appSPECTRUM_TIMER_PERIOD > 0 && appSPECTRUM_TIMER_PERIOD <= 0xFFFFUL,
+                  appCheckSpectrumRate );
+/* Every channel period must be representable in 16-bit ticks and leave an
+   erase window that a retry of the log finds open */
+#define appCHECK_PERIOD( ucIndex, usInput, ucPin, usPeriodMs )                  \
+    appSTATIC_ASSERT( pdMS_TO_TICKS( usPeriodMs ) > 0 &&                        \
+                      pdMS_TO_TICKS( usPeriodMs ) <= 0xFFFFUL &&                \
+                      ( usPeriodMs ) > appLOG_ERASE_MS + appLOG_RETRY_MS, appCheckPeriod##ucIndex );
+appCHANNELS( appCHECK_PERIOD )
+/* Adaptive periods must be representable in ticks, the UART must keep up at
+   the fastest one and the skip count of a channel must fit 8 bits */
+appSTATIC_ASSERT( pdMS_TO_TICKS( appADAPTIVE_MIN_PERIOD_MS ) > 0 &&
+                  pdMS_TO_TICKS( (unsigned long) appADAPTIVE_MIN_PERIOD_MS << ( appADAPTIVE_LEVELS - 1 ) )
+                  <= 0xFFFFUL, appCheckAdaptivePeriods );
+appSTATIC_ASSERT( (unsigned long) appLINE_MAX_BYTES * appNUM_CHANNELS * 10UL * 1000UL
+                  <= appUART_BAUD * appADAPTIVE_MIN_PERIOD_MS, appCheckAdaptiveUART );
+appSTATIC_ASSERT( appADAPTIVE_LEVELS >= 1 && appADAPTIVE_LEVELS <= 8, appCheckAdaptiveLevels );
+/* Alarms must name existing channels and leave room for the hysteresis */
+#define appCHECK_ALARM( ucIndex, usLow, usHigh, usHysteresis, ucLed )           \
+    appSTATIC_ASSERT( ( ucIndex ) < appNUM_CHANNELS && ( usLow ) < ( usHigh ) &&  \
+                      ( usHysteresis ) < ( usHigh ) - ( usLow ), appCheckAlarm##ucIndex );
+appALARMS( appCHECK_ALARM )
+appSTATIC_ASSERT( appADC_VREF_MV == 0 || appADC_VREF_MV == 1500 || appADC_VREF_MV == 2000 ||
+                  appADC_VREF_MV == 2500, appCheckADCReference );
+/* Calibration points must be distinct codes; the average keeps 4 fraction
+   bits (calibrationPOINT_SHIFT) and its sum must fit 32 bits */
+appSTATIC_ASSERT( appCAL_LOW_CODE < appCAL_HIGH_CODE && appCAL_HIGH_CODE <= 4095,
+                  appCheckCalibrationPoints );
+appSTATIC_ASSERT( appCAL_AVERAGE_LOG2 >= 4 && appCAL_AVERAGE_LOG2 <= 16, appCheckCalibrationAverage );
+/* The log must be whole segments inside LOG of lnk_msp430f5529.cmd (0x10000 -
+   0x17FFF), a block must fit a segment and count its samples in 8 bits */
+appSTATIC_ASSERT( appLOG_START % 512UL == 0 && appLOG_START >= 0x10000UL && appLOG_SEGMENTS >= 2 &&
+                  appLOG_START + appLOG_SEGMENTS * 512UL <= 0x18000UL, appCheckLogArea );
+appSTATIC_ASSERT( appLOG_PAYLOAD_BYTES % 2 == 0 && appLOG_PAYLOAD_BYTES <= 126, appCheckLogPayload );
+/* An erase and a retry must fit between two conversions at the fastest
+   adaptive rate; the external channels share that period and its phase */
+appSTATIC_ASSERT( appLOG_ERASE_MS + appLOG_RETRY_MS < appADAPTIVE_MIN_PERIOD_MS, appCheckLogWindow );
+/* A pattern step must be representable in 16-bit ticks */
+appSTATIC_ASSERT( pdMS_TO_TICKS( appPATTERN_STEP_MS ) > 0 &&
+                  pdMS_TO_TICKS( appPATTERN_STEP_MS ) <= 0xFFFFUL, appCheckPatternStep );
+/* Every brightness level must be a distinct CCR1 value */
+appSTATIC_ASSERT( appDISPLAY_PERIOD >= appDISPLAY_LEVELS && appDISPLAY_PERIOD <= 0xFFFFUL &&
+                  appDISPLAY_LEVEL <= appDISPLAY_LEVELS, appCheckDisplayTiming );
+appSTATIC_ASSERT( appDISPLAY_CHANNEL <= appNUM_CHANNELS, appCheckDisplayChannel );
+/* The host is let go below the stop level, which leaves room in the queue */
+appSTATIC_ASSERT( appUART_RX_RESUME < appUART_RX_STOP && appUART_RX_STOP < appCHAR_QUEUE_LENGTH,
+                  appCheckFlowLevels );
+
+#endif /* APP_CONFIG_H */
@@ -0,0 +1,263 @@
+/**
+ * @file calibration.c
+ * @brief ADC12 gain and offset correction
+ *
+ * The block scaler computes ( a * b ) >> 15 on signed 16-bit values, so a
+ * gain of up to 2.0 is passed as Q14 and the conversions as 4 x raw (below
+ * 2^14). The product is then twice the corrected value and its spare bit
+ * rounds the result.
+ */
+
+#include "calibration.h"
+#include "app_config.h"
+#include "hal_mpy.h"
+#include "hal_crc.h"
+#include "hal_flash.h"
+
+#include "msp430.h"
+
+/* Word offsets of the device TLV entries (F5529 data sheet, device descriptors) */
+#define calADC_GAIN             ( 0 )
+#define calADC_OFFSET           ( 1 )
+#define calADC_WORDS            ( 2 )
+#define calREF_15V              ( 0 )
+#define calREF_20V              ( 1 )
+#define calREF_25V              ( 2 )
+#define calREF_WORDS            ( 3 )
+
+#define calGAIN_ONE             ( 32768U )
+/* Accepted gains, 0.5 .. just below 2.0 so the Q14 gain fits 16 bits */
+#define calGAIN_MIN             ( 16384U )
+#define calGAIN_MAX             ( 65534U )
+
+/**
+ * @brief User calibration, kept at the start of information memory D
+ */
+typedef struct{
+    uint16_t usMagic;
+    uint16_t usGain;
+    int16_t  sOffset;
+    uint16_t usCrc;         // CRC16 of the fields above
+}CalibrationUser_t;
+
+#define calUSER_MAGIC           ( 0xCA1B )
+#define calUSER_RECORD          ( ( const CalibrationUser_t * ) 0x1800 )    // INFOD
+
+static uint16_t usGain = calGAIN_ONE;
+static int16_t sOffset;
+static CalibrationSource_t xSource = CALIBRATION_NONE;
+/* Factors in the form the kernel uses */
+static int16_t sGainQ14 = calGAIN_ONE / 2;
+static int16_t sBias = 1;       // 2 x offset + 1
+
+static void prvSet( uint16_t usNewGain, int16_t sNewOffset, CalibrationSource_t xNewSource )
+{
+    uint16_t usState = __get_interrupt_state();
+
+    /* The ADC ISR must not see a gain without its offset */
+    __disable_interrupt();
+    usGain = usNewGain;
+    sOffset = sNewOffset;
+    xSource = xNewSource;
+    sGainQ14 = ( int16_t ) ( ( usNewGain + 1U ) >> 1 );
+    sBias = ( int16_t ) ( 2 * sNewOffset + 1 );
+    __set_interrupt_state( usState );
+}
+
+static uint16_t prvUserCrc( const CalibrationUser_t *pxUser )
+{
+    return usHALCRC16( ( const uint8_t * ) pxUser, sizeof( CalibrationUser_t ) - sizeof( uint16_t ),
+                       halCRC16_SEED );
+}
+
+static void prvLoadTLV( void )
+{
+    const uint16_t *pusADC;
+    uint8_t ucWords;
+    uint32_t ulGain;
+#if appADC_VREF_MV != 0
+    const uint16_t *pusREF;
+    uint8_t ucREFWords;
+#endif
+
+    pusADC = pusCalibrationTLV( TLV_ADC12CAL, &ucWords );
+    if( ( pusADC == 0 ) || ( ucWords < calADC_WORDS ) )
+    {
+        prvSet( calGAIN_ONE, 0, CALIBRATION_NONE );
+        return;
+    }
+    ulGain = pusADC[ calADC_GAIN ];
+
+#if appADC_VREF_MV != 0
+    pusREF = pusCalibrationTLV( TLV_REFCAL, &ucREFWords );
+    if( ( pusREF != 0 ) && ( ucREFWords >= calREF_WORDS ) )
+    {
+        ulGain = ( ulGain * pusREF[ appADC_VREF_MV == 1500 ? calREF_15V :
+                                    appADC_VREF_MV == 2000 ? calREF_20V : calREF_25V ]
+                   + calGAIN_ONE / 2 ) >> 15;
+    }
+#endif
+    if( ulGain > calGAIN_MAX )
+    {
+        ulGain = calGAIN_MAX;
+    }
+    prvSet( ( uint16_t ) ulGain, ( int16_t ) pusADC[ calADC_OFFSET ], CALIBRATION_TLV );
+}
+
+const uint16_t *pusCalibrationTLV( uint8_t ucTag, uint8_t *pucWords )
+{
+    const uint8_t *pucEntry = ( const uint8_t * ) TLV_START;
+
+    /* Entries are tag, length in bytes, data; lengths are even */
+    while( ( pucEntry < ( const uint8_t * ) TLV_END ) && ( pucEntry[ 0 ] != TLV_TAGEND ) )
+    {
+        if( pucEntry[ 0 ] == ucTag )
+        {
+            *pucWords = pucEntry[ 1 ] >> 1;
+            return ( const uint16_t * ) &pucEntry[ 2 ];
+        }
+        pucEntry += 2 + pucEntry[ 1 ];
+    }
+    return 0;
+}
+
+void vCalibrationInit( void )
+{
+    const CalibrationUser_t *pxUser = calUSER_RECORD;
+
+    if( ( pxUser->usMagic == calUSER_MAGIC ) && ( pxUser->usCrc == prvUserCrc( pxUser ) ) )
+    {
+        prvSet( pxUser->usGain, pxUser->sOffset, CALIBRATION_USER );
+    }
+    else
+    {
+        prvLoadTLV();
+    }
+}
+
+void vCalibrationApply( uint16_t *pusBlock, uint8_t ucLength )
+{
+    int16_t *psBlock = ( int16_t * ) pusBlock;
+    int16_t sValue;
+    uint8_t ucIndex;
+
+    for( ucIndex = 0; ucIndex < ucLength; ucIndex++ )
+    {
+        psBlock[ ucIndex ] = ( int16_t ) ( pusBlock[ ucIndex ] << 2 );
+    }
+    vHALMPYScaleQ15( psBlock, ucLength, sGainQ14 );
+    for( ucIndex = 0; ucIndex < ucLength; ucIndex++ )
+    {
+        sValue = psBlock[ ucIndex ] + sBias;
+        if( sValue < 0 )
+        {
+            sValue = 0;
+        }
+        sValue >>= 1;
+        if( sValue > calibrationMAX_CODE )
+        {
+            sValue = calibrationMAX_CODE;
+        }
+        pusBlock[ ucIndex ] = ( uint16_t ) sValue;
+    }
+}
+
+/**
+ * @brief lNumerator / lDenominator rounded to nearest, lDenominator > 0
+ */
+static int32_t prvDivRound( int32_t lNumerator, int32_t lDenominator )
+{
+    if( lNumerator < 0 )
+    {
+        return -( ( -lNumerator + lDenominator / 2 ) / lDenominator );
+    }
+    return ( lNumerator + lDenominator / 2 ) / lDenominator;
+}
+
+bool xCalibrationSetUser( uint16_t usLow, uint16_t usHigh )
+{
+    CalibrationUser_t xUser;
+    int32_t lSpan = ( int32_t ) usHigh - usLow;
+    const int32_t lCodeSpan = appCAL_HIGH_CODE - appCAL_LOW_CODE;
+    uint32_t ulRatio;
+    uint32_t ulGain;
+    int32_t lOffset;
+
+    if( lSpan <= 0 )
+    {
+        return false;
+    }
+
+    /* The points were read through the active correction c = g * raw + o;
+       r = c * span / measured span + ( r_low - c_low * span / measured span )
+       gives gain g * ratio and offset r_low + ( o - c_low ) * ratio */
+    ulRatio = ( uint32_t ) prvDivRound( lCodeSpan << ( 15 + calibrationPOINT_SHIFT ), lSpan );
+    if( ulRatio > 0xFFFFUL )
+    {
+        return false;
+    }
+    ulGain = ( ( uint32_t ) usGain * ulRatio + calGAIN_ONE / 2 ) >> 15;
+    lOffset = appCAL_LOW_CODE
+              + prvDivRound( lCodeSpan * ( ( ( int32_t ) sOffset << calibrationPOINT_SHIFT ) - usLow ),
+                             lSpan );
+    if( ( ulGain < calGAIN_MIN ) || ( ulGain > calGAIN_MAX ) ||
+        ( lOffset < -calibrationMAX_CODE ) || ( lOffset > calibrationMAX_CODE ) )
+    {
+        return false;
+    }
+
+    xUser.usMagic = calUSER_MAGIC;
+    xUser.usGain = ( uint16_t ) ulGain;
+    xUser.sOffset = ( int16_t ) lOffset;
+    xUser.usCrc = prvUserCrc( &xUser );
+    vHALFlashErase( ( void * ) calUSER_RECORD, halFLASH_INFO_SEGMENT );
+    vHALFlashWrite( ( void * ) calUSER_RECORD, &xUser, sizeof( xUser ) );
+
+    prvSet( xUser.usGain, xUser.sOffset, CALIBRATION_USER );
+    return true;
+}
+
+void vCalibrationClearUser( void )
+{
+    vHALFlashErase( ( void * ) calUSER_RECORD, halFLASH_INFO_SEGMENT );
+    prvLoadTLV();
+}
+
+uint16_t usCalibrationGain( void )
+{
+    return usGain;
+}
+
+int16_t sCalibrationOffset( void )
+{
+    return sOffset;
+}
+
+CalibrationSource_t xCalibrationSource( void )
+{
+    return xSource;
+}
+
+uint16_t usCalibrationBenchmark( void )
+{
+    uint16_t pusBlock[ calibrationBENCH_LENGTH ];
+    uint16_t usStart;
+    uint16_t usEmpty;
+    uint16_t usTime;
+    uint8_t ucIndex;
+
+    for( ucIndex = 0; ucIndex < calibrationBENCH_LENGTH; ucIndex++ )
+    {
+        pusBlock[ ucIndex ] = ucIndex * ( calibrationMAX_CODE / calibrationBENCH_LENGTH );
+    }
+
+    TB0CTL = TBSSEL_2 | TBCLR | MC_2;               // SMCLK (= MCLK), continuous
+    usStart = TB0R;
+    usEmpty = TB0R - usStart;                       // cost of the timer reads
+    usStart = TB0R;
+    vCalibrationApply( pusBlock, calibrationBENCH_LENGTH );
+    usTime = TB0R - usStart;
+    TB0CTL = 0;
+
+    return usTime - usEmpty;
+}
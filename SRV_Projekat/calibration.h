@@ -0,0 +1,92 @@
+/**
+ * @file calibration.h
+ * @brief ADC12 gain and offset correction
+ *
+ * @details
+ * Every conversion is corrected as
+ *
+ *     value = raw * gain + offset,    clamped to 0 .. 4095
+ *
+ * with the gain in Q15 (32768 = 1.0) and the offset in LSB. At start-up the
+ * factors come from the device TLV: the ADC12 gain and offset and, when the
+ * ADC uses the internal reference (appADC_VREF_MV), the factor of that
+ * reference folded into the gain. A user two-point calibration stored in
+ * information memory D replaces them when present.
+ *
+ * The correction is applied in place to a block of conversions with the
+ * MPY32 block scaler (hal_mpy.h), so the ISR pays one multiplier set-up per
+ * block.
+ */
+
+#ifndef CALIBRATION_H
+#define CALIBRATION_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Full scale of a corrected conversion */
+#define calibrationMAX_CODE     ( 4095 )
+/* Fraction bits of the user calibration points */
+#define calibrationPOINT_SHIFT  ( 4 )
+
+/**
+ * @brief Source of the active correction
+ */
+typedef enum{
+    CALIBRATION_NONE,       // no TLV data, identity
+    CALIBRATION_TLV,        // device calibration
+    CALIBRATION_USER        // two-point calibration from information memory
+}CalibrationSource_t;
+
+/**
+ * @brief Load the correction: user calibration if valid, TLV otherwise
+ */
+void vCalibrationInit( void );
+
+/**
+ * @brief Correct ucLength raw 12-bit conversions in place
+ *
+ * Safe to call from the ADC ISR.
+ */
+void vCalibrationApply( uint16_t *pusBlock, uint8_t ucLength );
+
+/**
+ * @brief Derive and store a user calibration from two measured points
+ *
+ * usLow and usHigh are the corrected readings, in LSB << calibrationPOINT_SHIFT,
+ * of the inputs that should read appCAL_LOW_CODE and appCAL_HIGH_CODE. The new
+ * correction includes the one active while they were measured. Erases and
+ * programs information memory D, which stalls the CPU for up to 32 ms.
+ *
+ * @return false if the points give a gain outside 0.5 .. 2.0; nothing is stored
+ */
+bool xCalibrationSetUser( uint16_t usLow, uint16_t usHigh );
+
+/**
+ * @brief Erase the user calibration and return to the TLV factors
+ */
+void vCalibrationClearUser( void );
+
+/* Active gain (Q15) and offset (LSB) */
+uint16_t usCalibrationGain( void );
+int16_t sCalibrationOffset( void );
+CalibrationSource_t xCalibrationSource( void );
+
+/**
+ * @brief Find a TLV entry
+ *
+ * @param pucWords set to the number of 16-bit words in the entry
+ * @return the entry data, 0 if the tag is not present
+ */
+const uint16_t *pusCalibrationTLV( uint8_t ucTag, uint8_t *pucWords );
+
+/**
+ * @brief MCLK cycles vCalibrationApply() takes for a block of
+ *        calibrationBENCH_LENGTH conversions, measured with Timer B0
+ *
+ * Only for use before the scheduler starts, while Timer B0 is free.
+ */
+#define calibrationBENCH_LENGTH ( 16 )
+uint16_t usCalibrationBenchmark( void );
+
+#endif /* CALIBRATION_H */
@@ -0,0 +1,178 @@
+/**
+ * @file capture.c
+ * @brief Pre-trigger capture buffer (oscilloscope mode)
+ */
+
+#include "capture.h"
+
+static uint16_t pusBuffer[ appCAPTURE_DEPTH ][ appNUM_EXTERNAL ];
+
+static volatile CaptureState_t xState = CAPTURE_IDLE;
+
+/* Next set to be written, also the oldest set once the buffer is full */
+static uint16_t usWrite;
+/* Sets written since arming, saturates at usPreTrigger + 1 */
+static uint16_t usFilled;
+/* Sets still to record after the trigger */
+static uint16_t usRemaining;
+static uint16_t usPreTrigger;
+static uint16_t usLevel;
+static uint16_t usPrevious;
+static uint32_t ulTriggerTime;
+static uint8_t ucChannel;
+static CaptureTrigger_t xTrigger;
+
+bool xCaptureArm( uint8_t ucTriggerChannel, CaptureTrigger_t xTriggerType, uint16_t usTriggerLevel,
+                  uint16_t usPreTriggerSets )
+{
+    if( ( xState != CAPTURE_IDLE ) || ( ucTriggerChannel >= appNUM_EXTERNAL ) ||
+        ( usPreTriggerSets >= appCAPTURE_DEPTH ) )
+    {
+        return false;
+    }
+
+    usWrite = 0;
+    usFilled = 0;
+    usPreTrigger = usPreTriggerSets;
+    usLevel = usTriggerLevel;
+    ucChannel = ucTriggerChannel;
+    xTrigger = xTriggerType;
+
+    /* The ISR only looks at the buffer once the state is ARMED */
+    xState = CAPTURE_ARMED;
+    return true;
+}
+
+static bool prvTriggered( uint16_t usSample )
+{
+    switch( xTrigger )
+    {
+        case CAPTURE_RISING_EDGE:
+            return ( usPrevious < usLevel ) && ( usSample >= usLevel );
+        case CAPTURE_FALLING_EDGE:
+            return ( usPrevious >= usLevel ) && ( usSample < usLevel );
+        case CAPTURE_ABOVE:
+            return usSample >= usLevel;
+        case CAPTURE_BELOW:
+        default:
+            return usSample < usLevel;
+    }
+}
+
+bool xCaptureAddSet( const uint16_t *pusSet, uint32_t ulTimestamp )
+{
+    uint8_t ucIndex;
+    uint16_t usSample = pusSet[ ucChannel ];
+
+    if( ( xState != CAPTURE_ARMED ) && ( xState != CAPTURE_TRIGGERED ) )
+    {
+        return false;
+    }
+
+    for( ucIndex = 0; ucIndex < appNUM_EXTERNAL; ucIndex++ )
+    {
+        pusBuffer[ usWrite ][ ucIndex ] = pusSet[ ucIndex ];
+    }
+    if( ++usWrite == appCAPTURE_DEPTH )
+    {
+        usWrite = 0;
+    }
+
+    if( xState == CAPTURE_ARMED )
+    {
+        /* The trigger is only evaluated once the pre-trigger history is
+        complete and a previous sample exists for edge detection */
+        if( usFilled <= usPreTrigger )
+        {
+            usFilled++;
+            usPrevious = usSample;
+            return false;
+        }
+        if( prvTriggered( usSample ) == false )
+        {
+            usPrevious = usSample;
+            return false;
+        }
+        xState = CAPTURE_TRIGGERED;
+        ulTriggerTime = ulTimestamp;
+        /* The trigger set itself is the first post-trigger set */
+        usRemaining = appCAPTURE_DEPTH - usPreTrigger;
+    }
+
+    if( --usRemaining == 0 )
+    {
+        xState = CAPTURE_DONE;
+        return true;
+    }
+    return false;
+}
+
+CaptureState_t xCaptureGetState( void )
+{
+    return xState;
+}
+
+uint16_t usCaptureGetPreTrigger( void )
+{
+    return usPreTrigger;
+}
+
+uint32_t ulCaptureGetTriggerTime( void )
+{
+    return ulTriggerTime;
+}
+
+uint16_t usCaptureGetSample( uint16_t usSet, uint8_t ucChannel )
+{
+    usSet += usWrite;
+    if( usSet >= appCAPTURE_DEPTH )
+    {
+        usSet -= appCAPTURE_DEPTH;
+    }
+    return pusBuffer[ usSet ][ ucChannel ];
+}
+
+uint8_t ucCapturePack( uint8_t *pucOut, uint16_t usFirstSet, uint8_t ucSets )
+{
+    uint16_t usSet = usWrite + usFirstSet;
+    uint8_t ucIndex;
+    uint8_t ucLength = 0;
+    uint16_t usSample;
+    bool xHalf = false;
+
+    if( usSet >= appCAPTURE_DEPTH )
+    {
+        usSet -= appCAPTURE_DEPTH;
+    }
+
+    while( ucSets-- > 0 )
+    {
+        for( ucIndex = 0; ucIndex < appNUM_EXTERNAL; ucIndex++ )
+        {
+            usSample = pusBuffer[ usSet ][ ucIndex ] & 0x0FFF;
+            if( xHalf == false )
+            {
+                /* aaaaaaaa aaaa.... */
+                pucOut[ ucLength++ ] = ( uint8_t ) ( usSample >> 4 );
+                pucOut[ ucLength++ ] = ( uint8_t ) ( usSample << 4 );
+            }
+            else
+            {
+                /* ....bbbb bbbbbbbb */
+                pucOut[ ucLength - 1 ] |= ( uint8_t ) ( usSample >> 8 );
+                pucOut[ ucLength++ ] = ( uint8_t ) usSample;
+            }
+            xHalf = !xHalf;
+        }
+        if( ++usSet == appCAPTURE_DEPTH )
+        {
+            usSet = 0;
+        }
+    }
+    return ucLength;
+}
+
+void vCaptureRelease( void )
+{
+    xState = CAPTURE_IDLE;
+}
@@ -0,0 +1,88 @@
+/**
+ * @file capture.h
+ * @brief Pre-trigger capture buffer (oscilloscope mode)
+ *
+ * @details
+ * While armed, every ADC sequence (one sample per configured channel) is
+ * written into a circular buffer of appCAPTURE_DEPTH sets. Once at least
+ * the pre-trigger number of sets has been recorded, each new sample of the
+ * trigger channel is tested against the trigger condition; after it fires,
+ * recording continues until the buffer holds the requested pre-trigger
+ * history followed by the post-trigger samples, and the buffer is frozen
+ * until it has been read out and released.
+ *
+ * xCaptureAddSet() is meant to be called from the ADC ISR; all other
+ * functions from task level.
+ */
+
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "app_config.h"
+
+typedef enum{
+    CAPTURE_RISING_EDGE,    // trigger channel crosses the level upwards
+    CAPTURE_FALLING_EDGE,   // trigger channel crosses the level downwards
+    CAPTURE_ABOVE,          // trigger channel is at or above the level
+    CAPTURE_BELOW           // trigger channel is below the level
+}CaptureTrigger_t;
+
+typedef enum{
+    CAPTURE_IDLE,           // buffer free
+    CAPTURE_ARMED,          // filling pre-trigger history, waiting for trigger
+    CAPTURE_TRIGGERED,      // recording post-trigger samples
+    CAPTURE_DONE            // frozen, waiting for read-out
+}CaptureState_t;
+
+/**
+ * @brief Start a new capture
+ *
+ * @param ucChannel     trigger channel index (0 based)
+ * @param usLevel       trigger level in raw 12-bit ADC units
+ * @param usPreTrigger  sets kept before the trigger, less than appCAPTURE_DEPTH
+ *
+ * @return false if a capture is already in progress or not yet released
+ */
+bool xCaptureArm( uint8_t ucChannel, CaptureTrigger_t xTrigger, uint16_t usLevel, uint16_t usPreTrigger );
+
+/**
+ * @brief Add one ADC sequence, one sample of every external channel
+ *
+ * @param ulTimestamp   time of the sequence (timestamp.h)
+ *
+ * @return true when this set completed the capture
+ */
+bool xCaptureAddSet( const uint16_t *pusSet, uint32_t ulTimestamp );
+
+/* Current state */
+CaptureState_t xCaptureGetState( void );
+
+/* Pre-trigger length of the current capture */
+uint16_t usCaptureGetPreTrigger( void );
+
+/* Timestamp of the set that fired the trigger */
+uint32_t ulCaptureGetTriggerTime( void );
+
+/* Raw sample of chronological set usSet (0 = oldest) of a frozen capture */
+uint16_t usCaptureGetSample( uint16_t usSet, uint8_t ucChannel );
+
+/**
+ * @brief Pack sets of a frozen capture for transmission
+ *
+ * Writes ucSets sets starting at chronological set usFirstSet (0 = oldest)
+ * as 12-bit samples, two samples in three bytes, channel order within a
+ * set. An odd final sample takes two bytes.
+ *
+ * @return number of bytes written, at most captureBYTES_FOR_SETS( ucSets )
+ */
+uint8_t ucCapturePack( uint8_t *pucOut, uint16_t usFirstSet, uint8_t ucSets );
+
+/* Free the buffer for the next capture */
+void vCaptureRelease( void );
+
+#define captureBYTES_FOR_SETS( ucSets )     ( ( ( ucSets ) * appNUM_EXTERNAL * 3 + 1 ) / 2 )
+
+#endif /* CAPTURE_H */
@@ -0,0 +1,42 @@
+/**
+ * @file deadband.c
+ * @brief Report-by-exception filter
+ */
+
+#include "deadband.h"
+
+void vDeadbandInit( Deadband_t *pxDeadband )
+{
+    pxDeadband->usLastReported = 0;
+    pxDeadband->usSilent = 0;
+    pxDeadband->xReported = false;
+}
+
+DeadbandResult_t xDeadbandCheck( Deadband_t *pxDeadband, uint16_t usSample,
+                                 uint16_t usDeadband, uint16_t usMaxSilent )
+{
+    DeadbandResult_t xResult;
+    uint16_t usDistance;
+
+    usDistance = ( usSample > pxDeadband->usLastReported ) ?
+                 usSample - pxDeadband->usLastReported :
+                 pxDeadband->usLastReported - usSample;
+
+    if( ( pxDeadband->xReported == false ) || ( usDistance > usDeadband ) )
+    {
+        xResult = DEADBAND_REPORT;
+    }
+    else if( ++pxDeadband->usSilent >= usMaxSilent )
+    {
+        xResult = DEADBAND_HEARTBEAT;
+    }
+    else
+    {
+        return DEADBAND_SUPPRESS;
+    }
+
+    pxDeadband->usLastReported = usSample;
+    pxDeadband->usSilent = 0;
+    pxDeadband->xReported = true;
+    return xResult;
+}
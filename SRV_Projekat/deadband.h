@@ -0,0 +1,46 @@
+/**
+ * @file deadband.h
+ * @brief Report-by-exception filter
+ *
+ * @details
+ * Decides per sample whether a channel has to be reported: a sample is
+ * reported when it differs from the last reported value by more than the
+ * deadband. When nothing was reported for usMaxSilent consecutive samples,
+ * a heartbeat is requested instead so the receiver can tell a quiet
+ * channel from a dead link.
+ */
+
+#ifndef DEADBAND_H
+#define DEADBAND_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef enum{
+    DEADBAND_SUPPRESS,      // within the deadband, nothing to send
+    DEADBAND_REPORT,        // moved by more than the deadband
+    DEADBAND_HEARTBEAT      // silent for too long, send as liveness record
+}DeadbandResult_t;
+
+/**
+ * @brief State of one channel
+ */
+typedef struct{
+    uint16_t usLastReported;
+    uint16_t usSilent;
+    bool     xReported;     // false until the first sample was reported
+}Deadband_t;
+
+/* Forget the last reported value; the next sample is always reported */
+void vDeadbandInit( Deadband_t *pxDeadband );
+
+/**
+ * @brief Classify one sample
+ *
+ * When the result is not DEADBAND_SUPPRESS the sample becomes the new
+ * reference value and the silence counter restarts.
+ */
+DeadbandResult_t xDeadbandCheck( Deadband_t *pxDeadband, uint16_t usSample,
+                                 uint16_t usDeadband, uint16_t usMaxSilent );
+
+#endif /* DEADBAND_H */
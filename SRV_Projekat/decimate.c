@@ -0,0 +1,51 @@
+/**
+ * @file decimate.c
+ * @brief Output rate reduction to fit the UART byte budget
+ */
+
+#include "decimate.h"
+
+uint8_t ucDecimateRatio( uint32_t ulBytesPerKs, uint32_t ulBaud, uint8_t ucLoadPercent )
+{
+    /* Bytes per 1000 s: produced at ratio 1 and available for lines */
+    uint32_t ulNeeded = ulBytesPerKs;
+    uint32_t ulCapacity = ulBaud * ucLoadPercent;
+    uint32_t ulRatio;
+
+    if( ulCapacity == 0 )
+    {
+        return decimateMAX_RATIO;
+    }
+    ulRatio = ( ulNeeded + ulCapacity - 1 ) / ulCapacity;
+    if( ulRatio == 0 )
+    {
+        return 1;
+    }
+    return ( ulRatio > decimateMAX_RATIO ) ? decimateMAX_RATIO : ( uint8_t ) ulRatio;
+}
+
+void vDecimateInit( Decimator_t *pxDecimator )
+{
+    pxDecimator->ulSum = 0;
+    pxDecimator->ucCount = 0;
+}
+
+bool xDecimateAdd( Decimator_t *pxDecimator, uint16_t usSample, uint8_t ucRatio, uint16_t *pusOut )
+{
+    if( ucRatio <= 1 )
+    {
+        *pusOut = usSample;
+        return true;
+    }
+
+    pxDecimator->ulSum += usSample;
+    if( ++pxDecimator->ucCount < ucRatio )
+    {
+        return false;
+    }
+
+    /* Rounded mean */
+    *pusOut = ( uint16_t ) ( ( pxDecimator->ulSum + pxDecimator->ucCount / 2 ) / pxDecimator->ucCount );
+    vDecimateInit( pxDecimator );
+    return true;
+}
@@ -0,0 +1,53 @@
+/**
+ * @file decimate.h
+ * @brief Output rate reduction to fit the UART byte budget
+ *
+ * @details
+ * ucDecimateRatio() compares the bytes the stream mode would produce with
+ * what the UART can carry and returns the smallest ratio N for which every
+ * channel can be sent as one line per N of its samples. The aggregator then
+ * replaces each N samples of a channel by their mean, which unlike plain
+ * decimation also attenuates content above the reduced rate.
+ */
+
+#ifndef DECIMATE_H
+#define DECIMATE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Largest ratio the aggregator supports */
+#define decimateMAX_RATIO       ( 255 )
+
+/**
+ * @brief State of one channel
+ */
+typedef struct{
+    uint32_t ulSum;
+    uint8_t  ucCount;
+}Decimator_t;
+
+/**
+ * @brief Ratio needed to fit the UART
+ *
+ * @param ulBytesPerKs  bytes of all sent lines per 1000 s at ratio 1
+ * @param ulBaud        UART baud rate, 10 bits per byte
+ * @param ucLoadPercent share of the UART available to sample lines
+ *
+ * @return 1 if no reduction is needed, at most decimateMAX_RATIO
+ */
+uint8_t ucDecimateRatio( uint32_t ulBytesPerKs, uint32_t ulBaud, uint8_t ucLoadPercent );
+
+/* Discard a partially aggregated block */
+void vDecimateInit( Decimator_t *pxDecimator );
+
+/**
+ * @brief Add one sample
+ *
+ * @param pusOut    mean of the last ucRatio samples, written when complete
+ *
+ * @return true when a block of ucRatio samples was completed
+ */
+bool xDecimateAdd( Decimator_t *pxDecimator, uint16_t usSample, uint8_t ucRatio, uint16_t *pusOut );
+
+#endif /* DECIMATE_H */
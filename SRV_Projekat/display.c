@@ -0,0 +1,151 @@
+/**
+ * @file display.c
+ * @brief Multiplexed two-digit 7-segment display
+ */
+
+#include "display.h"
+#include "app_config.h"
+#include "hal_7seg.h"
+
+#include "msp430.h"
+
+/* Glyph of the left and the right digit */
+static volatile uint8_t pucShown[2];
+/* Digit of the current slot, 0 left */
+static uint8_t ucDigit;
+static volatile uint8_t ucLevel;
+
+void vDisplayInit( void )
+{
+    vHAL7SEGInit();
+    HAL_7SEG_DISPLAY_1_OFF;
+    HAL_7SEG_DISPLAY_2_OFF;
+    vDisplayBlank();
+
+    TA1CCR0 = appDISPLAY_PERIOD - 1;
+    vDisplaySetLevel( appDISPLAY_LEVEL );
+    TA1CCTL0 = CCIE;
+    TA1CCTL1 = CCIE;
+    TA1CTL = TASSEL_1 | MC_1 | TACLR;               // ACLK, up mode
+}
+
+void vDisplaySetLevel( uint8_t ucNewLevel )
+{
+    if( ucNewLevel > appDISPLAY_LEVELS )
+    {
+        ucNewLevel = appDISPLAY_LEVELS;
+    }
+    // At the full level CCR1 is past CCR0 and never matches
+    TA1CCR1 = ( uint16_t ) ( ( ( uint32_t ) appDISPLAY_PERIOD * ucNewLevel ) / appDISPLAY_LEVELS );
+    ucLevel = ucNewLevel;
+}
+
+uint8_t ucDisplayGetLevel( void )
+{
+    return ucLevel;
+}
+
+void vDisplayNumber( int16_t sValue )
+{
+    uint8_t ucTens;
+    uint8_t ucUnits;
+
+    if( ( sValue < -9 ) || ( sValue > 99 ) )
+    {
+        ucTens = HAL_7SEG_GLYPH_ERROR;
+        ucUnits = HAL_7SEG_GLYPH_ERROR;
+    }
+    else if( sValue < 0 )
+    {
+        ucTens = HAL_7SEG_GLYPH_MINUS;
+        ucUnits = ( uint8_t ) -sValue;
+    }
+    else
+    {
+        ucTens = ( sValue < 10 ) ? HAL_7SEG_GLYPH_BLANK : ( uint8_t ) ( sValue / 10 );
+        ucUnits = ( uint8_t ) ( sValue % 10 );
+    }
+    pucShown[ 0 ] = ucTens;
+    pucShown[ 1 ] = ucUnits;
+}
+
+void vDisplayBlank( void )
+{
+    pucShown[ 0 ] = HAL_7SEG_GLYPH_BLANK;
+    pucShown[ 1 ] = HAL_7SEG_GLYPH_BLANK;
+}
+
+void vDisplaySlotStart( void )
+{
+    uint8_t ucGlyph;
+
+    HAL_7SEG_DISPLAY_1_OFF;
+    HAL_7SEG_DISPLAY_2_OFF;
+    ucDigit ^= 1;
+    if( ucLevel == 0 )
+    {
+        return;
+    }
+
+    ucGlyph = pucShown[ ucDigit ];
+    HAL_7SEG_WRITE_GLYPH( ucGlyph );
+    if( ucDigit == 0 )
+    {
+        HAL_7SEG_DISPLAY_1_ON;
+    }
+    else
+    {
+        HAL_7SEG_DISPLAY_2_ON;
+    }
+}
+
+void vDisplaySlotEnd( void )
+{
+    HAL_7SEG_DISPLAY_1_OFF;
+    HAL_7SEG_DISPLAY_2_OFF;
+}
+
+uint16_t usDisplayBenchmark( void )
+{
+    uint8_t ucSaved = ucLevel;
+    uint16_t usTA1CTL = TA1CTL;
+    uint16_t usStart;
+    uint16_t usEmpty;
+    uint16_t usTime;
+
+    ucLevel = appDISPLAY_LEVELS;                    // the full path
+    TA1CTL = usTA1CTL & ~MC_3;                      // TA1 held, its flags are raised by hand
+    TA1CCTL0 &= ~CCIFG;
+    TA1CCTL1 &= ~CCIFG;
+    TB0CTL = TBSSEL_2 | TBCLR | MC_2;               // SMCLK (= MCLK), continuous
+
+    // Interrupts open with nothing pending: cost of the window itself
+    usStart = TB0R;
+    __enable_interrupt();
+    __no_operation();
+    __disable_interrupt();
+    usEmpty = TB0R - usStart;
+
+    // Both slot interrupts taken, entry, TA1IV and RETI included
+    TA1CCTL0 |= CCIFG;
+    TA1CCTL1 |= CCIFG;
+    usStart = TB0R;
+    __enable_interrupt();
+    __no_operation();
+    __disable_interrupt();
+    usTime = TB0R - usStart;
+
+    TB0CTL = 0;
+    ucLevel = ucSaved;
+    TA1CTL = usTA1CTL;
+
+    return usTime - usEmpty;
+}
+
+void vDisplayStop( void )
+{
+    TA1CTL = 0;
+    TA1CCTL0 = 0;
+    TA1CCTL1 = 0;
+    vDisplaySlotEnd();
+}
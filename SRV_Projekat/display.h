@@ -0,0 +1,64 @@
+/**
+ * @file display.h
+ * @brief Multiplexed two-digit 7-segment display
+ *
+ * @details
+ * TA1 runs from ACLK in up mode and divides time into slots of
+ * 1 / appDISPLAY_SLOT_HZ; the digits take turns, one per slot. At the
+ * start of a slot (CCR0) vDisplaySlotStart() blanks the previous digit,
+ * puts the glyph of the next one on the segment ports and lights it; at
+ * CCR1 vDisplaySlotEnd() blanks it again, so CCR1 sets the brightness.
+ *
+ * The segment pins are spread over several ports; the glyph table of the
+ * HAL (hal_7seg.h) holds the bits of every glyph per port, so a refresh is
+ * one write per segment port and one per digit enable.
+ *
+ * The slot functions are meant to be called from the TA1 ISRs, the others
+ * from task level.
+ */
+
+#ifndef DISPLAY_H
+#define DISPLAY_H
+
+#include <stdint.h>
+
+/**
+ * @brief Configure the pins and start TA1
+ *
+ * The display starts blank at appDISPLAY_LEVEL.
+ */
+void vDisplayInit( void );
+
+/* Brightness 0 (off) .. appDISPLAY_LEVELS (always on) */
+void vDisplaySetLevel( uint8_t ucLevel );
+uint8_t ucDisplayGetLevel( void );
+
+/**
+ * @brief Show a number, -9 .. 99; other values show two error glyphs
+ */
+void vDisplayNumber( int16_t sValue );
+
+void vDisplayBlank( void );
+
+/* TA1 CCR0 and CCR1 handlers */
+void vDisplaySlotStart( void );
+void vDisplaySlotEnd( void );
+
+/**
+ * @brief MCLK cycles of one refresh, timed with TB0
+ *
+ * Raises the CCR0 and CCR1 flags and opens interrupts, so the count covers
+ * both TA1 ISRs with their entry, TA1IV read and RETI. Before the scheduler
+ * starts and with every other interrupt source disabled: TB0 belongs to the
+ * capture timer and any other pending request would be counted.
+ */
+uint16_t usDisplayBenchmark( void );
+
+/**
+ * @brief Stop TA1 and turn both digits off
+ *
+ * For a refresh over its budget; the display stays dark until reset.
+ */
+void vDisplayStop( void );
+
+#endif /* DISPLAY_H */
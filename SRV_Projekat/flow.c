@@ -0,0 +1,44 @@
+/**
+ * @file flow.c
+ * @brief UART flow control, XON/XOFF and RTS/CTS
+ */
+
+#include "flow.h"
+
+void vFlowInit( Flow_t *pxFlow, uint8_t ucLow, uint8_t ucHigh )
+{
+    pxFlow->ucLow = ucLow;
+    pxFlow->ucHigh = ucHigh;
+    pxFlow->xPaused = false;
+    pxFlow->xStopped = false;
+}
+
+bool xFlowReceive( Flow_t *pxFlow, char cReceived )
+{
+    switch( cReceived )
+    {
+    case flowXOFF:
+        pxFlow->xPaused = true;
+        return true;
+    case flowXON:
+        pxFlow->xPaused = false;
+        return true;
+    default:
+        return false;
+    }
+}
+
+char cFlowLevel( Flow_t *pxFlow, uint8_t ucWaiting )
+{
+    if( ( pxFlow->xStopped == false ) && ( ucWaiting >= pxFlow->ucHigh ) )
+    {
+        pxFlow->xStopped = true;
+        return flowXOFF;
+    }
+    if( ( pxFlow->xStopped == true ) && ( ucWaiting <= pxFlow->ucLow ) )
+    {
+        pxFlow->xStopped = false;
+        return flowXON;
+    }
+    return 0;
+}
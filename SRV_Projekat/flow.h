@@ -0,0 +1,56 @@
+/**
+ * @file flow.h
+ * @brief UART flow control, XON/XOFF and RTS/CTS
+ *
+ * @details
+ * Transmit: an XOFF from the host pauses the transmitter after the byte in
+ * progress and an XON resumes it; with RTS/CTS the CTS input does the
+ * same. Bytes already queued stay queued, so only the TX task waits.
+ *
+ * Receive: once the receive queue holds ucHigh characters the host is
+ * asked to stop (XOFF and/or RTS deasserted), and to continue once it has
+ * drained to ucLow. The gap between ucHigh and the queue length must take
+ * what the host still sends before it reacts.
+ *
+ * XON and XOFF are filtered out of the received characters. Capture
+ * frames are binary and may contain both values, so a host using XON/XOFF
+ * must not strip them from its input (IXON off) or use RTS/CTS instead.
+ */
+
+#ifndef FLOW_H
+#define FLOW_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define flowXON                 ( 0x11 )
+#define flowXOFF                ( 0x13 )
+
+/**
+ * @brief State of one link
+ */
+typedef struct{
+    uint8_t ucLow;
+    uint8_t ucHigh;
+    bool    xPaused;        // XOFF received, transmitter paused
+    bool    xStopped;       // host asked to stop sending
+}Flow_t;
+
+void vFlowInit( Flow_t *pxFlow, uint8_t ucLow, uint8_t ucHigh );
+
+/**
+ * @brief Check a received character for XON/XOFF
+ *
+ * @return true if cReceived was XON or XOFF and is consumed
+ */
+bool xFlowReceive( Flow_t *pxFlow, char cReceived );
+
+/**
+ * @brief Follow the fill level of the receive queue
+ *
+ * @return flowXOFF when the host has to stop, flowXON when it may continue,
+ *         0 otherwise
+ */
+char cFlowLevel( Flow_t *pxFlow, uint8_t ucWaiting );
+
+#endif /* FLOW_H */
@@ -0,0 +1,173 @@
+/**
+ * @file fmt.c
+ * @brief Division-free integer formatting
+ *
+ * Quotients by 10 are computed as ( x * ceil( 2^k / 10 ) ) >> k, which is
+ * exact over the whole input range for the constants used below:
+ *  - 16-bit: ( x * 0xCCCD ) >> 19, a 16x16 multiply
+ *  - 32-bit: ( x * 0xCCCCCCCD ) >> 35, a 32x32 multiply
+ * 32-bit values are only reduced this way until they fit in 16 bits, after
+ * which the cheaper 16-bit step is used for the remaining digits.
+ *
+ * The 32-bit step takes the high word of the product from the MPY32
+ * (ulHALMPYMulHighU32()); written as a uint64_t multiply in C the compiler
+ * would call its 64x64 multiply routine instead.
+ */
+
+#include "fmt.h"
+#include "hal_mpy.h"
+
+static const char pcHexDigits[ 16 ] = "0123456789ABCDEF";
+
+static inline uint16_t prvDiv10U16( uint16_t usValue )
+{
+    return ( uint16_t ) ( ( ( uint32_t ) usValue * 0xCCCDUL ) >> 19 );
+}
+
+static inline uint32_t prvDiv10U32( uint32_t ulValue )
+{
+    return ulHALMPYMulHighU32( ulValue, 0xCCCCCCCDUL ) >> 3;
+}
+
+/**
+ * @brief Write the decimal digits of ulValue, least significant first
+ *
+ * @return number of digits, at least 1
+ */
+static uint8_t prvDigitsReversed( char *pcRev, uint32_t ulValue )
+{
+    uint8_t ucCount = 0;
+    uint32_t ulQuotient;
+    uint16_t usValue;
+    uint16_t usQuotient;
+
+    while( ulValue > 0xFFFFUL )
+    {
+        ulQuotient = prvDiv10U32( ulValue );
+        pcRev[ ucCount++ ] = ( char ) ( '0' + ( uint8_t ) ( ulValue - ulQuotient * 10UL ) );
+        ulValue = ulQuotient;
+    }
+
+    usValue = ( uint16_t ) ulValue;
+    do
+    {
+        usQuotient = prvDiv10U16( usValue );
+        pcRev[ ucCount++ ] = ( char ) ( '0' + ( uint8_t ) ( usValue - usQuotient * 10U ) );
+        usValue = usQuotient;
+    } while( usValue != 0 );
+
+    return ucCount;
+}
+
+/**
+ * @brief Copy ucCount reversed digits to pcBuf in reading order
+ */
+static uint8_t prvEmitReversed( char *pcBuf, const char *pcRev, uint8_t ucCount )
+{
+    uint8_t ucIndex;
+
+    for( ucIndex = 0; ucIndex < ucCount; ucIndex++ )
+    {
+        pcBuf[ ucIndex ] = pcRev[ ucCount - 1 - ucIndex ];
+    }
+    return ucCount;
+}
+
+uint8_t ucFmtU16( char *pcBuf, uint16_t usValue )
+{
+    char pcRev[ fmtMAX_U16 ];
+
+    return prvEmitReversed( pcBuf, pcRev, prvDigitsReversed( pcRev, usValue ) );
+}
+
+uint8_t ucFmtU32( char *pcBuf, uint32_t ulValue )
+{
+    char pcRev[ fmtMAX_U32 ];
+
+    return prvEmitReversed( pcBuf, pcRev, prvDigitsReversed( pcRev, ulValue ) );
+}
+
+uint8_t ucFmtU16Pad( char *pcBuf, uint16_t usValue, uint8_t ucWidth )
+{
+    char pcRev[ fmtMAX_U16 ];
+    uint8_t ucCount = prvDigitsReversed( pcRev, usValue );
+    uint8_t ucPad = 0;
+
+    while( ucCount + ucPad < ucWidth )
+    {
+        pcBuf[ ucPad++ ] = '0';
+    }
+    return ucPad + prvEmitReversed( &pcBuf[ ucPad ], pcRev, ucCount );
+}
+
+uint8_t ucFmtS16( char *pcBuf, int16_t sValue )
+{
+    if( sValue < 0 )
+    {
+        pcBuf[ 0 ] = '-';
+        /* Negate in unsigned arithmetic so -32768 is handled */
+        return 1 + ucFmtU16( &pcBuf[ 1 ], ( uint16_t ) ( 0U - ( uint16_t ) sValue ) );
+    }
+    return ucFmtU16( pcBuf, ( uint16_t ) sValue );
+}
+
+uint8_t ucFmtS32( char *pcBuf, int32_t lValue )
+{
+    if( lValue < 0 )
+    {
+        pcBuf[ 0 ] = '-';
+        return 1 + ucFmtU32( &pcBuf[ 1 ], 0UL - ( uint32_t ) lValue );
+    }
+    return ucFmtU32( pcBuf, ( uint32_t ) lValue );
+}
+
+uint8_t ucFmtHex16( char *pcBuf, uint16_t usValue )
+{
+    pcBuf[ 0 ] = pcHexDigits[ ( usValue >> 12 ) & 0x0F ];
+    pcBuf[ 1 ] = pcHexDigits[ ( usValue >> 8 ) & 0x0F ];
+    pcBuf[ 2 ] = pcHexDigits[ ( usValue >> 4 ) & 0x0F ];
+    pcBuf[ 3 ] = pcHexDigits[ usValue & 0x0F ];
+    return fmtMAX_HEX16;
+}
+
+uint8_t ucFmtHex32( char *pcBuf, uint32_t ulValue )
+{
+    ucFmtHex16( pcBuf, ( uint16_t ) ( ulValue >> 16 ) );
+    ucFmtHex16( &pcBuf[ 4 ], ( uint16_t ) ulValue );
+    return fmtMAX_HEX32;
+}
+
+uint8_t ucFmtFixed( char *pcBuf, int32_t lValue, uint8_t ucDecimals )
+{
+    char pcRev[ fmtMAX_U32 + 1 ];
+    uint32_t ulMagnitude;
+    uint8_t ucCount;
+    uint8_t ucLength = 0;
+
+    if( lValue < 0 )
+    {
+        pcBuf[ ucLength++ ] = '-';
+        ulMagnitude = 0UL - ( uint32_t ) lValue;
+    }
+    else
+    {
+        ulMagnitude = ( uint32_t ) lValue;
+    }
+
+    /* Pad with leading zeros so there is at least one integer digit */
+    ucCount = prvDigitsReversed( pcRev, ulMagnitude );
+    while( ucCount <= ucDecimals )
+    {
+        pcRev[ ucCount++ ] = '0';
+    }
+
+    while( ucCount > 0 )
+    {
+        if( ucCount == ucDecimals )
+        {
+            pcBuf[ ucLength++ ] = '.';
+        }
+        pcBuf[ ucLength++ ] = pcRev[ --ucCount ];
+    }
+    return ucLength;
+}
@@ -0,0 +1,55 @@
+/**
+ * @file fmt.h
+ * @brief Division-free integer formatting
+ *
+ * @details
+ * Converts integers to ASCII without printf and without calls to the
+ * software division routine. Decimal digits are produced by multiplying
+ * with the reciprocal of 10 on the MPY32 peripheral: 16x16 products through
+ * the compiler (--use_hw_mpy=F5), 32x32 high words through hal_mpy.
+ *
+ * All functions write into a caller supplied buffer, do not append a
+ * terminating zero and return the number of characters written. The buffer
+ * must hold at least fmtMAX_xxx characters for the chosen conversion.
+ */
+
+#ifndef FMT_H
+#define FMT_H
+
+#include <stdint.h>
+
+/* Worst-case number of characters produced by each conversion */
+#define fmtMAX_U16          ( 5 )
+#define fmtMAX_S16          ( 6 )
+#define fmtMAX_U32          ( 10 )
+#define fmtMAX_S32          ( 11 )
+#define fmtMAX_HEX16        ( 4 )
+#define fmtMAX_HEX32        ( 8 )
+/* sign, 10 digits, decimal point, leading zero */
+#define fmtMAX_FIXED        ( 13 )
+
+/* Unsigned decimal */
+uint8_t ucFmtU16( char *pcBuf, uint16_t usValue );
+uint8_t ucFmtU32( char *pcBuf, uint32_t ulValue );
+
+/* Unsigned decimal, left padded with zeros to at least ucWidth digits */
+uint8_t ucFmtU16Pad( char *pcBuf, uint16_t usValue, uint8_t ucWidth );
+
+/* Signed decimal, '-' prefix for negative values */
+uint8_t ucFmtS16( char *pcBuf, int16_t sValue );
+uint8_t ucFmtS32( char *pcBuf, int32_t lValue );
+
+/* Upper case hexadecimal, always 4 / 8 digits */
+uint8_t ucFmtHex16( char *pcBuf, uint16_t usValue );
+uint8_t ucFmtHex32( char *pcBuf, uint32_t ulValue );
+
+/**
+ * @brief Signed fixed point decimal
+ *
+ * lValue is interpreted as lValue / 10^ucDecimals, e.g.
+ * ucFmtFixed( buf, -1234, 2 ) writes "-12.34" and ucFmtFixed( buf, 5, 3 )
+ * writes "0.005". ucDecimals must not exceed 9.
+ */
+uint8_t ucFmtFixed( char *pcBuf, int32_t lValue, uint8_t ucDecimals );
+
+#endif /* FMT_H */
@@ -0,0 +1,58 @@
+/**
+ * @file frame.c
+ * @brief Binary telemetry frames
+ */
+
+#include "frame.h"
+#include "ETF5529_HAL/hal_crc.h"
+
+uint8_t ucFrameEncode( uint8_t *pucFrame, uint8_t ucType, const uint8_t *pucPayload, uint8_t ucLength )
+{
+    uint8_t ucIndex;
+    uint16_t usCrc;
+
+    pucFrame[ 0 ] = frameSYNC;
+    pucFrame[ 1 ] = ucType;
+    pucFrame[ 2 ] = ucLength;
+    for( ucIndex = 0; ucIndex < ucLength; ucIndex++ )
+    {
+        pucFrame[ 3 + ucIndex ] = pucPayload[ ucIndex ];
+    }
+
+    usCrc = usHALCRC16( &pucFrame[ 1 ], ( uint16_t ) ucLength + 2, halCRC16_SEED );
+    framePUT_U16( &pucFrame[ 3 + ucLength ], usCrc );
+
+    return ucLength + frameOVERHEAD;
+}
+
+uint8_t ucFrameLogBlock( uint8_t *pucFrame, const LogBlock_t *pxBlock )
+{
+    uint8_t *pucPayload = &pucFrame[ 3 ];
+    const uint8_t *pucData = ( const uint8_t * ) ( pxBlock + 1 );
+    uint8_t ucIndex;
+
+    framePUT_U16( &pucPayload[ 0 ], pxBlock->usLength );
+    pucPayload[ 2 ] = pxBlock->ucChannel;
+    pucPayload[ 3 ] = pxBlock->ucCount;
+    framePUT_U32( &pucPayload[ 4 ], pxBlock->ulSequence );
+    framePUT_U32( &pucPayload[ 8 ], pxBlock->ulTicks );
+    framePUT_U16( &pucPayload[ 12 ], pxBlock->usPeriod );
+    framePUT_U16( &pucPayload[ 14 ], pxBlock->usFirst );
+    for( ucIndex = 0; ucIndex < pxBlock->usLength; ucIndex++ )
+    {
+        pucPayload[ 16 + ucIndex ] = pucData[ ucIndex ];
+    }
+
+    return ucFrameEncode( pucFrame, frameTYPE_LOG_BLOCK, pucPayload, 16 + ( uint8_t ) pxBlock->usLength );
+}
+
+uint8_t ucFrameLogEnd( uint8_t *pucFrame, const LogStats_t *pxStats )
+{
+    uint8_t *pucPayload = &pucFrame[ 3 ];
+
+    framePUT_U32( &pucPayload[ 0 ], pxStats->ulOldest );
+    framePUT_U32( &pucPayload[ 4 ], pxStats->ulNext );
+    framePUT_U16( &pucPayload[ 8 ], pxStats->usMaxErase );
+
+    return ucFrameEncode( pucFrame, frameTYPE_LOG_END, pucPayload, 10 );
+}
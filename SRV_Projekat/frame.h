@@ -0,0 +1,74 @@
+/**
+ * @file frame.h
+ * @brief Binary telemetry frames
+ *
+ * @details
+ * Frame layout (all multi-byte fields little endian):
+ *
+ *  | SYNC 0xA5 | type | length | payload[ length ] | CRC16 |
+ *
+ * The CRC is CRC-16/CCITT (hal_crc.h) over type, length and payload. A
+ * receiver resynchronises by scanning for SYNC and validating the CRC.
+ */
+
+#ifndef FRAME_H
+#define FRAME_H
+
+#include <stdint.h>
+
+#include "log.h"
+
+#define frameSYNC                   ( 0xA5 )
+#define frameMAX_PAYLOAD            ( 64 )
+/* SYNC, type, length and CRC */
+#define frameOVERHEAD               ( 5 )
+#define frameMAX_SIZE               ( frameMAX_PAYLOAD + frameOVERHEAD )
+
+/* Frame types */
+#define frameTYPE_CAPTURE_HEADER    ( 0x10 )
+#define frameTYPE_CAPTURE_DATA      ( 0x11 )
+#define frameTYPE_LOG_BLOCK         ( 0x20 )
+#define frameTYPE_LOG_END           ( 0x21 )
+
+/**
+ * @brief Build a frame around ucLength payload bytes
+ *
+ * pucFrame must hold frameOVERHEAD + ucLength bytes and ucLength must not
+ * exceed frameMAX_PAYLOAD. The payload may already be in place, i.e.
+ * pucPayload == &pucFrame[ 3 ].
+ *
+ * @return total frame size in bytes
+ */
+uint8_t ucFrameEncode( uint8_t *pucFrame, uint8_t ucType, const uint8_t *pucPayload, uint8_t ucLength );
+
+/**
+ * @brief Build a LOG_BLOCK frame from a block of the flash log
+ *
+ * The payload is the block header (length, channel, count, sequence
+ * number, ticks, period, first sample) and its packed deltas (log.h); the
+ * flash CRC is replaced by the frame CRC. The header and the payload must
+ * fit frameMAX_PAYLOAD.
+ *
+ * @return total frame size in bytes
+ */
+uint8_t ucFrameLogBlock( uint8_t *pucFrame, const LogBlock_t *pxBlock );
+
+/**
+ * @brief Build the LOG_END frame that closes a dump
+ *
+ * The payload is the oldest block kept, the next one to be written and the
+ * highest segment erase count.
+ *
+ * @return total frame size in bytes
+ */
+uint8_t ucFrameLogEnd( uint8_t *pucFrame, const LogStats_t *pxStats );
+
+/* Store little endian values into a payload */
+#define framePUT_U16( pucDest, usValue )                            \
+    do{ ( pucDest )[ 0 ] = ( uint8_t ) ( usValue );                 \
+        ( pucDest )[ 1 ] = ( uint8_t ) ( ( usValue ) >> 8 ); }while( 0 )
+#define framePUT_U32( pucDest, ulValue )                            \
+    do{ framePUT_U16( ( pucDest ), ( uint16_t ) ( ulValue ) );      \
+        framePUT_U16( &( pucDest )[ 2 ], ( uint16_t ) ( ( ulValue ) >> 16 ) ); }while( 0 )
+
+#endif /* FRAME_H */
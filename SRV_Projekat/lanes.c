@@ -0,0 +1,44 @@
+/**
+ * @file lanes.c
+ * @brief Order of the UART transmit lanes at frame boundaries
+ */
+
+#include "lanes.h"
+
+void vLanesInit( Lanes_t *pxLanes )
+{
+    pxLanes->usDumpFrames = 0;
+    pxLanes->xLogDump = false;
+}
+
+void vLanesStartDump( Lanes_t *pxLanes, uint16_t usFrames )
+{
+    pxLanes->usDumpFrames = usFrames;
+}
+
+void vLanesLogDump( Lanes_t *pxLanes, bool xRunning )
+{
+    pxLanes->xLogDump = xRunning;
+}
+
+LanesNext_t xLanesNext( Lanes_t *pxLanes, bool xControl, bool xBulk )
+{
+    if( xControl )
+    {
+        return LANES_CONTROL;
+    }
+    if( pxLanes->usDumpFrames > 0 )
+    {
+        pxLanes->usDumpFrames--;
+        return LANES_DUMP;
+    }
+    if( xBulk )
+    {
+        return LANES_BULK;
+    }
+    if( pxLanes->xLogDump )
+    {
+        return LANES_LOG;
+    }
+    return LANES_WAIT;
+}
@@ -0,0 +1,60 @@
+/**
+ * @file lanes.h
+ * @brief Order of the UART transmit lanes at frame boundaries
+ *
+ * @details
+ * The transmitter sends one text line or binary frame at a time and asks
+ * xLanesNext() before each one what comes next:
+ *  1. a record of the control lane (command responses, alarms),
+ *  2. the next frame of the capture dump in progress,
+ *  3. the next record of the bulk lane (samples, summaries, spectra, dump
+ *     requests),
+ *  4. the next block of a running log dump, which only fills the time both
+ *     lanes are empty.
+ * A control record therefore waits for the line or frame on the wire when
+ * it is queued, not for the bulk records queued before it or for the rest
+ * of a dump.
+ */
+
+#ifndef LANES_H
+#define LANES_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef enum{
+    LANES_CONTROL,          // one line of the control lane
+    LANES_DUMP,             // the next frame of the capture dump
+    LANES_BULK,             // the next record of the bulk lane
+    LANES_LOG,              // the next block of the log dump
+    LANES_WAIT              // nothing to send, wait for a record in either lane
+}LanesNext_t;
+
+/**
+ * @brief State of the transmitter
+ */
+typedef struct{
+    uint16_t usDumpFrames;  // frames of the capture dump left to send
+    bool     xLogDump;      // a log dump is running
+}Lanes_t;
+
+void vLanesInit( Lanes_t *pxLanes );
+
+/* A capture dump of usFrames frames follows its header */
+void vLanesStartDump( Lanes_t *pxLanes, uint16_t usFrames );
+
+/* Start or stop the log dump */
+void vLanesLogDump( Lanes_t *pxLanes, bool xRunning );
+
+/**
+ * @brief What to send next, at a frame boundary
+ *
+ * LANES_DUMP counts the frame as sent; the frame is then the one at index
+ * usFrames - 1 - pxLanes->usDumpFrames of the dump.
+ *
+ * @param xControl  the control lane holds a record
+ * @param xBulk     the bulk lane holds a record
+ */
+LanesNext_t xLanesNext( Lanes_t *pxLanes, bool xControl, bool xBulk );
+
+#endif /* LANES_H */
@@ -56,14 +56,16 @@ MEMORY
     SFR                     : origin = 0x0000, length = 0x0010
     PERIPHERALS_8BIT        : origin = 0x0010, length = 0x00F0
     PERIPHERALS_16BIT       : origin = 0x0100, length = 0x0100
-    RAM                     : origin = 0x2400, length = 0x2000
+    RAM                     : origin = 0x2400, length = 0x1F80
+    RAMVECT                 : origin = 0x4380, length = 0x0080  /* Vectors while the flash erases, hal_flash.c */
     USBRAM                  : origin = 0x1C00, length = 0x0800
     INFOA                   : origin = 0x1980, length = 0x0080
     INFOB                   : origin = 0x1900, length = 0x0080
     INFOC                   : origin = 0x1880, length = 0x0080
     INFOD                   : origin = 0x1800, length = 0x0080
     FLASH                   : origin = 0x4400, length = 0xBB80
-    FLASH2                  : origin = 0x10000,length = 0x143F8 /* Boundaries changed to fix CPU47 */
+    LOG                     : origin = 0x10000,length = 0x8000  /* Flash logger, appLOG_START in app_config.h */
+    FLASH2                  : origin = 0x18000,length = 0xC3F8  /* Boundaries changed to fix CPU47 */
     INT00                   : origin = 0xFF80, length = 0x0002
     INT01                   : origin = 0xFF82, length = 0x0002
     INT02                   : origin = 0xFF84, length = 0x0002
@@ -141,6 +143,7 @@ SECTIONS
     .TI.noinit  : {} > RAM                  /* For #pragma noinit                */
     .sysmem     : {} > RAM                  /* Dynamic memory allocation area    */
     .stack      : {} > RAM (HIGH)           /* Software system stack             */
+    .ramvect    : {} > RAMVECT, type = NOINIT /* RAM vector table (SYSRIVECT)      */
 
 #ifndef __LARGE_CODE_MODEL__
     .text       : {} > FLASH                /* Code                              */
@@ -0,0 +1,440 @@
+/**
+ * @file log.c
+ * @brief Sample logger in a ring of flash segments
+ *
+ * The segment after the head is kept erased (the spare). A block that does
+ * not fit into the head opens the spare with a new header; the next
+ * segment then becomes the spare and is erased by a later vLogStep().
+ */
+
+#include <stddef.h>
+
+#include "log.h"
+#include "hal_flash.h"
+#include "hal_crc.h"
+
+#define logSEGMENT              ( halFLASH_MAIN_SEGMENT )
+#define logESCAPE               ( 0x0F )
+/* Nibble usAt of a payload, the high one of a byte first */
+#define logNIBBLE( pucPayload, usAt )                                           \
+    ( ( ( pucPayload )[ ( usAt ) / 2U ] >> ( ( ( usAt ) & 1U ) ? 0 : 4 ) ) & 0x0F )
+
+/* A block being collected, followed by room for the padding and the CRC */
+typedef struct{
+    LogBlock_t xHeader;
+    uint8_t pucPayload[ appLOG_PAYLOAD_BYTES + 2 ];
+    uint16_t usLast;
+    uint8_t ucNibbles;
+}LogBuffer_t;
+
+static uint8_t *pucBase;
+static uint16_t usSegments;
+/* Segment being filled and its first free byte, logSEGMENT when closed */
+static uint16_t usHead;
+static uint16_t usOffset;
+static bool xSpareErased;
+static uint16_t usSpareErase;
+static uint16_t usMaxErase;
+static uint32_t ulNext;
+
+/* One buffer per channel and the closed block waiting to be written */
+static LogBuffer_t pxBuffers[ appNUM_CHANNELS + 1 ];
+static LogBuffer_t *pxOpen[ appNUM_CHANNELS ];
+static LogBuffer_t *pxClosed;
+
+#define prvSEGMENT( usIndex )   ( ( LogSegment_t * ) ( pucBase + ( uint32_t ) ( usIndex ) * logSEGMENT ) )
+#define prvSPARE()              ( ( uint16_t ) ( ( usHead + 1U ) % usSegments ) )
+
+static uint16_t prvBlockCRC( const LogBlock_t *pxBlock )
+{
+    return usHALCRC16( ( const uint8_t * ) pxBlock, logBLOCK_SIZE( pxBlock->usLength ) - 2U, halCRC16_SEED );
+}
+
+/* Stored CRC of a block, at the end of its padded payload */
+static uint16_t prvStoredCRC( const LogBlock_t *pxBlock )
+{
+    return *( const uint16_t * ) ( ( const uint8_t * ) pxBlock + logBLOCK_SIZE( pxBlock->usLength ) - 2U );
+}
+
+/**
+ * @brief Check the block at usAt of a segment
+ *
+ * @return the block, 0 at the end of the written blocks or at a bad one
+ */
+static const LogBlock_t *prvBlockAt( const LogSegment_t *pxSegment, uint16_t usAt, bool *pxBad )
+{
+    const LogBlock_t *pxBlock = ( const LogBlock_t * ) ( ( const uint8_t * ) pxSegment + usAt );
+
+    *pxBad = false;
+    if( usAt + sizeof( LogBlock_t ) > logSEGMENT || pxBlock->usLength == halFLASH_ERASED )
+    {
+        return 0;
+    }
+    if( pxBlock->usLength > appLOG_PAYLOAD_BYTES || usAt + logBLOCK_SIZE( pxBlock->usLength ) > logSEGMENT ||
+        prvStoredCRC( pxBlock ) != prvBlockCRC( pxBlock ) )
+    {
+        *pxBad = true;
+        return 0;
+    }
+    return pxBlock;
+}
+
+static uint16_t prvSegmentCRC( const LogSegment_t *pxSegment )
+{
+    return usHALCRC16( ( const uint8_t * ) pxSegment, offsetof( LogSegment_t, usCheck ), halCRC16_SEED );
+}
+
+static bool prvSegmentValid( const LogSegment_t *pxSegment )
+{
+    return ( pxSegment->usMagic == logMAGIC ) && ( pxSegment->usCheck == prvSegmentCRC( pxSegment ) );
+}
+
+static bool prvSegmentErased( const LogSegment_t *pxSegment )
+{
+    const uint16_t *pusWord = ( const uint16_t * ) pxSegment;
+    uint16_t usWords;
+
+    for( usWords = logSEGMENT / 2U; usWords > 0; usWords-- )
+    {
+        if( *pusWord++ != halFLASH_ERASED )
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void prvBufferReset( LogBuffer_t *pxBuffer )
+{
+    pxBuffer->xHeader.ucCount = 0;
+    pxBuffer->ucNibbles = 0;
+}
+
+void vLogInit( void *pvBase, uint16_t usCount )
+{
+    const LogSegment_t *pxSegment;
+    const LogBlock_t *pxBlock;
+    bool xFound = false;
+    bool xBad = false;
+    uint16_t usIndex;
+
+    pucBase = ( uint8_t * ) pvBase;
+    usSegments = usCount;
+    usMaxErase = 0;
+
+    for( usIndex = 0; usIndex < usSegments; usIndex++ )
+    {
+        pxSegment = prvSEGMENT( usIndex );
+        if( prvSegmentValid( pxSegment ) == false )
+        {
+            continue;
+        }
+        if( pxSegment->usErase > usMaxErase )
+        {
+            usMaxErase = pxSegment->usErase;
+        }
+        if( ( xFound == false ) || ( pxSegment->ulSequence > prvSEGMENT( usHead )->ulSequence ) )
+        {
+            usHead = usIndex;
+            xFound = true;
+        }
+    }
+
+    if( xFound )
+    {
+        /* Walk the blocks of the head up to the free space or a torn block */
+        ulNext = prvSEGMENT( usHead )->ulSequence;
+        usOffset = sizeof( LogSegment_t );
+        while( ( pxBlock = prvBlockAt( prvSEGMENT( usHead ), usOffset, &xBad ) ) != 0 )
+        {
+            ulNext = pxBlock->ulSequence + 1UL;
+            usOffset += logBLOCK_SIZE( pxBlock->usLength );
+        }
+        /* A torn block closes the head; its sequence number is not reused, so
+        the next segment starts above the head */
+        if( xBad )
+        {
+            usOffset = logSEGMENT;
+            ulNext++;
+        }
+    }
+    else
+    {
+        /* Empty log, start in the first segment */
+        usHead = usSegments - 1U;
+        usOffset = logSEGMENT;
+        ulNext = 0;
+    }
+
+    /* The erase of the spare may have been cut short */
+    xSpareErased = prvSegmentErased( prvSEGMENT( prvSPARE() ) );
+    usSpareErase = ( usMaxErase > 0 ) ? usMaxErase : 1U;
+
+    pxClosed = &pxBuffers[ appNUM_CHANNELS ];
+    for( usIndex = 0; usIndex < appNUM_CHANNELS; usIndex++ )
+    {
+        pxOpen[ usIndex ] = &pxBuffers[ usIndex ];
+        prvBufferReset( pxOpen[ usIndex ] );
+    }
+    prvBufferReset( pxClosed );
+}
+
+/* Hand the block of a channel over for writing, pxClosed must be free */
+static void prvClose( uint8_t ucChannel )
+{
+    LogBuffer_t *pxBuffer = pxOpen[ ucChannel ];
+
+    pxBuffer->xHeader.usLength = ( pxBuffer->ucNibbles + 1U ) / 2U;
+    pxOpen[ ucChannel ] = pxClosed;
+    pxClosed = pxBuffer;
+    prvBufferReset( pxOpen[ ucChannel ] );
+}
+
+static void prvPutNibble( LogBuffer_t *pxBuffer, uint8_t ucNibble )
+{
+    uint8_t *pucByte = &pxBuffer->pucPayload[ pxBuffer->ucNibbles / 2U ];
+
+    if( pxBuffer->ucNibbles & 1U )
+    {
+        *pucByte |= ucNibble;
+    }
+    else
+    {
+        *pucByte = ( uint8_t ) ( ucNibble << 4 );
+    }
+    pxBuffer->ucNibbles++;
+}
+
+bool xLogAdd( uint8_t ucChannel, uint16_t usValue, uint32_t ulTicks, uint16_t usPeriod )
+{
+    LogBuffer_t *pxBuffer = pxOpen[ ucChannel ];
+    LogBlock_t *pxHeader = &pxBuffer->xHeader;
+    int16_t sDelta;
+    uint8_t ucZigZag;
+
+    if( pxHeader->ucCount != 0 )
+    {
+        sDelta = ( int16_t ) ( usValue - pxBuffer->usLast );
+        ucZigZag = ( sDelta >= 0 ) ? ( uint8_t ) ( 2 * sDelta ) : ( uint8_t ) ( -2 * sDelta - 1 );
+        if( ( sDelta > 7 ) || ( sDelta < -7 ) )
+        {
+            ucZigZag = logESCAPE;
+        }
+
+        /* The block goes on only with the next sample at the same period */
+        if( ( usPeriod != pxHeader->usPeriod ) ||
+            ( ulTicks != pxHeader->ulTicks + ( uint32_t ) pxHeader->ucCount * usPeriod ) ||
+            ( pxBuffer->ucNibbles + ( ( ucZigZag == logESCAPE ) ? 4U : 1U ) > 2U * appLOG_PAYLOAD_BYTES ) )
+        {
+            if( pxClosed->xHeader.ucCount != 0 )
+            {
+                return false;
+            }
+            prvClose( ucChannel );
+            pxBuffer = pxOpen[ ucChannel ];
+            pxHeader = &pxBuffer->xHeader;
+        }
+        else
+        {
+            prvPutNibble( pxBuffer, ucZigZag );
+            if( ucZigZag == logESCAPE )
+            {
+                prvPutNibble( pxBuffer, ( uint8_t ) ( ( usValue >> 8 ) & 0x0F ) );
+                prvPutNibble( pxBuffer, ( uint8_t ) ( ( usValue >> 4 ) & 0x0F ) );
+                prvPutNibble( pxBuffer, ( uint8_t ) ( usValue & 0x0F ) );
+            }
+            pxHeader->ucCount++;
+            pxBuffer->usLast = usValue;
+            return true;
+        }
+    }
+
+    pxHeader->ucChannel = ucChannel;
+    pxHeader->ucCount = 1;
+    pxHeader->ulTicks = ulTicks;
+    pxHeader->usPeriod = usPeriod;
+    pxHeader->usFirst = usValue;
+    pxBuffer->usLast = usValue;
+    return true;
+}
+
+bool xLogFlush( uint8_t ucChannel )
+{
+    if( pxOpen[ ucChannel ]->xHeader.ucCount == 0 )
+    {
+        return true;
+    }
+    if( pxClosed->xHeader.ucCount != 0 )
+    {
+        return false;
+    }
+    prvClose( ucChannel );
+    return true;
+}
+
+LogOp_t xLogPending( void )
+{
+    if( pxClosed->xHeader.ucCount != 0 )
+    {
+        if( ( usOffset + logBLOCK_SIZE( pxClosed->xHeader.usLength ) <= logSEGMENT ) || xSpareErased )
+        {
+            return LOG_WRITE;
+        }
+        return LOG_ERASE;
+    }
+    return xSpareErased ? LOG_IDLE : LOG_ERASE;
+}
+
+/* Make the spare the head, the header is committed by its magic */
+static void prvOpenSpare( void )
+{
+    LogSegment_t xHeader;
+
+    usHead = prvSPARE();
+    xHeader.ulSequence = ulNext;
+    xHeader.usErase = usSpareErase;
+    xHeader.usCheck = prvSegmentCRC( &xHeader );
+    xHeader.usMagic = logMAGIC;
+    vHALFlashWrite( prvSEGMENT( usHead ), &xHeader, offsetof( LogSegment_t, usMagic ) );
+    vHALFlashWrite( &prvSEGMENT( usHead )->usMagic, &xHeader.usMagic, sizeof( xHeader.usMagic ) );
+    usOffset = sizeof( LogSegment_t );
+    xSpareErased = false;
+}
+
+void vLogStep( void )
+{
+    LogSegment_t *pxSpare;
+    LogBlock_t *pxHeader = &pxClosed->xHeader;
+    uint16_t usSize;
+
+    switch( xLogPending() )
+    {
+    case LOG_ERASE:
+        pxSpare = prvSEGMENT( prvSPARE() );
+        /* Without a header the count is lost, the highest one is the best guess */
+        if( prvSegmentValid( pxSpare ) )
+        {
+            usSpareErase = pxSpare->usErase + 1U;
+        }
+        else
+        {
+            usSpareErase = ( usMaxErase > 0 ) ? usMaxErase : 1U;
+        }
+        if( usSpareErase > usMaxErase )
+        {
+            usMaxErase = usSpareErase;
+        }
+        /* Interrupts are enabled while it waits, also in a critical section of the caller */
+        vHALFlashEraseLive( pxSpare, logSEGMENT );
+        xSpareErased = true;
+        break;
+
+    case LOG_WRITE:
+        usSize = logBLOCK_SIZE( pxHeader->usLength );
+        if( usOffset + usSize > logSEGMENT )
+        {
+            prvOpenSpare();
+        }
+        pxHeader->ulSequence = ulNext;
+        *( uint16_t * ) ( ( uint8_t * ) pxHeader + usSize - 2U ) = prvBlockCRC( pxHeader );
+        /* Words are programmed in order, the CRC last */
+        vHALFlashWrite( ( uint8_t * ) prvSEGMENT( usHead ) + usOffset, pxHeader, usSize );
+        usOffset += usSize;
+        ulNext++;
+        prvBufferReset( pxClosed );
+        break;
+
+    default:
+        break;
+    }
+}
+
+const LogBlock_t *pxLogFind( uint32_t ulSequence )
+{
+    const LogSegment_t *pxSegment;
+    const LogBlock_t *pxBlock;
+    uint16_t usIndex = usHead;
+    uint16_t usStart = usSegments;
+    uint16_t usLeft = 0;
+    uint16_t usCount;
+    uint16_t usAt;
+    bool xBad;
+
+    /* Sequence numbers rise in ring order from the spare to the head: look
+    for the last segment starting at or before ulSequence, else the oldest */
+    for( usCount = usSegments; usCount > 0; usCount-- )
+    {
+        usIndex = ( uint16_t ) ( ( usIndex + 1U ) % usSegments );
+        pxSegment = prvSEGMENT( usIndex );
+        if( prvSegmentValid( pxSegment ) &&
+            ( ( usStart == usSegments ) || ( pxSegment->ulSequence <= ulSequence ) ) )
+        {
+            usStart = usIndex;
+            usLeft = usCount;
+        }
+    }
+
+    /* Walk the blocks from there up to the head */
+    for( usIndex = usStart; usLeft > 0; usLeft--, usIndex = ( uint16_t ) ( ( usIndex + 1U ) % usSegments ) )
+    {
+        pxSegment = prvSEGMENT( usIndex );
+        if( prvSegmentValid( pxSegment ) == false )
+        {
+            continue;
+        }
+        for( usAt = sizeof( LogSegment_t ); ( pxBlock = prvBlockAt( pxSegment, usAt, &xBad ) ) != 0;
+             usAt += logBLOCK_SIZE( pxBlock->usLength ) )
+        {
+            if( pxBlock->ulSequence >= ulSequence )
+            {
+                return pxBlock;
+            }
+        }
+    }
+    return 0;
+}
+
+uint8_t ucLogDecode( const LogBlock_t *pxBlock, uint16_t *pusValues )
+{
+    const uint8_t *pucPayload = ( const uint8_t * ) ( pxBlock + 1 );
+    uint16_t usNibble = 0;
+    uint16_t usValue = pxBlock->usFirst;
+    uint8_t ucCode;
+    uint8_t ucSample;
+    uint8_t ucDigit;
+
+    pusValues[ 0 ] = usValue;
+    for( ucSample = 1; ucSample < pxBlock->ucCount; ucSample++ )
+    {
+        ucCode = logNIBBLE( pucPayload, usNibble );
+        usNibble++;
+        if( ucCode == logESCAPE )
+        {
+            usValue = 0;
+            for( ucDigit = 0; ucDigit < 3; ucDigit++ )
+            {
+                usValue = ( uint16_t ) ( ( usValue << 4 ) | logNIBBLE( pucPayload, usNibble ) );
+                usNibble++;
+            }
+        }
+        else if( ucCode & 1U )
+        {
+            usValue -= ( ucCode + 1U ) / 2U;
+        }
+        else
+        {
+            usValue += ucCode / 2U;
+        }
+        pusValues[ ucSample ] = usValue;
+    }
+    return pxBlock->ucCount;
+}
+
+void vLogGetStats( LogStats_t *pxStats )
+{
+    const LogBlock_t *pxOldest = pxLogFind( 0 );
+
+    pxStats->ulOldest = ( pxOldest != 0 ) ? pxOldest->ulSequence : ulNext;
+    pxStats->ulNext = ulNext;
+    pxStats->usMaxErase = usMaxErase;
+}
@@ -0,0 +1,123 @@
+/**
+ * @file log.h
+ * @brief Sample logger in a ring of flash segments
+ *
+ * @details
+ * Samples are collected per channel into blocks. A block holds consecutive
+ * samples of one channel at a fixed period: the first one in the header,
+ * the others as 4-bit deltas (a delta outside -7..7 takes an escape nibble
+ * and the 12-bit value, 16 bits in total). A block is closed when it is
+ * full, when the period changes or when a sample is missing, and then
+ * waits to be written. Only one closed block waits at a time; a sample
+ * that would close another one is refused until it has been written.
+ *
+ * The log area is a ring of halFLASH_MAIN_SEGMENT byte segments, written
+ * one after the other and erased one ahead of the segment being filled, so
+ * every segment is erased once per pass through the ring. When the ring is
+ * full the oldest segment is erased for the next one.
+ *
+ * Segment:  LogSegment_t, then blocks
+ * Block:    LogBlock_t, payload padded to an even length, CRC-16 (hal_crc.h)
+ *           over header and payload
+ *
+ * Every record is written with its commit word last: usMagic for a segment
+ * header, the CRC for a block. The header has a CRC of its own, as an erase
+ * cut short may leave any mix of old and erased words. After a power failure xLogInit() finds the
+ * segment with the highest sequence number and walks its blocks; a block
+ * whose CRC does not match closes that segment and writing goes on in the
+ * next one, so a torn write costs at most the rest of one segment. A
+ * segment without a valid header is erased before it is used again.
+ *
+ * Flash is only erased and programmed from vLogStep(), one operation per
+ * call (hal_flash.h). A block is written a word at a time with interrupts
+ * taken in between; a segment is erased with vHALFlashEraseLive(), so the
+ * caller decides which interrupts run from RAM meanwhile. The functions are
+ * not reentrant and are called from one task.
+ */
+
+#ifndef LOG_H
+#define LOG_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "app_config.h"
+
+/* usMagic of a segment with a complete header */
+#define logMAGIC                ( 0x4C47 )
+
+typedef struct{
+    uint32_t ulSequence;    // sequence number of the first block in the segment
+    uint16_t usErase;       // times the segment has been erased
+    uint16_t usCheck;       // CRC-16 of the fields above
+    uint16_t usMagic;       // logMAGIC, written last
+}LogSegment_t;
+
+typedef struct{
+    uint16_t usLength;      // payload bytes
+    uint8_t  ucChannel;     // channel index
+    uint8_t  ucCount;       // samples, the first one included
+    uint32_t ulSequence;    // block number, counts on across power cycles
+    uint32_t ulTicks;       // RTOS ticks since start-up at the first sample
+    uint16_t usPeriod;      // ticks from one sample to the next
+    uint16_t usFirst;       // first sample
+}LogBlock_t;
+
+/* Bytes a block with usLength payload bytes takes in flash */
+#define logBLOCK_SIZE( usLength )   ( sizeof( LogBlock_t ) + ( ( ( usLength ) + 1U ) & ~1U ) + 2U )
+
+typedef enum{
+    LOG_IDLE,               // nothing to do
+    LOG_ERASE,              // a segment erase, halFLASH_MAIN_SEGMENT bytes
+    LOG_WRITE               // a block write, maybe with a segment header
+}LogOp_t;
+
+typedef struct{
+    uint32_t ulOldest;      // sequence number of the oldest block kept
+    uint32_t ulNext;        // sequence number of the next block written
+    uint16_t usMaxErase;    // highest erase count of a segment
+}LogStats_t;
+
+/**
+ * @brief Recover the log from the usSegments segments at pvBase
+ *
+ * Blocks still being collected when the power failed are lost.
+ */
+void vLogInit( void *pvBase, uint16_t usSegments );
+
+/**
+ * @brief Add a sample
+ *
+ * @param ulTicks   tick count at the sample, counting on past 16 bits
+ * @param usPeriod  ticks until the next sample of the channel is due
+ *
+ * @return false if the closed block must be written first (vLogStep())
+ */
+bool xLogAdd( uint8_t ucChannel, uint16_t usValue, uint32_t ulTicks, uint16_t usPeriod );
+
+/* Close the block of a channel early, false as for xLogAdd() */
+bool xLogFlush( uint8_t ucChannel );
+
+/* Flash operation the next vLogStep() carries out */
+LogOp_t xLogPending( void );
+
+/* Carry out xLogPending(): an erase takes up to 32 ms, a block write up to 3 ms */
+void vLogStep( void );
+
+/**
+ * @brief First block with a sequence number of at least ulSequence
+ *
+ * @return the block in flash, 0 if there is none
+ */
+const LogBlock_t *pxLogFind( uint32_t ulSequence );
+
+/**
+ * @brief Decode the samples of a block
+ *
+ * @return samples written to pusValues, pxBlock->ucCount
+ */
+uint8_t ucLogDecode( const LogBlock_t *pxBlock, uint16_t *pusValues );
+
+void vLogGetStats( LogStats_t *pxStats );
+
+#endif /* LOG_H */
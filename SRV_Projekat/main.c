@@ -6,15 +6,17 @@
  *
  * @details
  * This project implements a real-time application that performs Analog-to-Digital
- * (ADC) conversions on two channels every second and transmits the converted
+ * (ADC) conversions on the configured channels and transmits the converted
  * values over UART to a PC for display. The user can interact with the system
  * via UART commands to select which ADC channel data to display or to stop
  * the display.
  *
  * @section Functional Overview
  * 1. ADC Sampling:
- *    - Two ADC channels are sampled every second using a software timer.
- *    - The converted ADC values are processed to retain only the upper 9 bits.
+ *    - Every channel is sampled at its own period (appCHANNELS); the
+ *      channels due on a tick are converted in one ADC sequence.
+ *    - The converted ADC values are reduced or oversampled to the resolution
+ *      of their channel (9, 10, 12, 14 or 16 bit, resolution.h).
  *
  * 2. UART Communication:
  *    - UART is used to receive commands from the user and to transmit ADC values
@@ -23,11 +25,43 @@
  *      - '1': Display values from the first ADC channel.
  *      - '2': Display values from the second ADC channel.
  *      - '3': Display values from both ADC channels.
+ *      - '5': Add the on-chip temperature and AVcc channels to the display,
+ *             or remove them again (sensors.h).
  *      - '4': Stop displaying values.
+ *      - 'r': Stream every sample (default). When the selected channels
+ *             would exceed appUART_LOAD_PERCENT of the UART, the means of
+ *             N samples are sent instead and 'D: N' announces the ratio.
+ *      - 's': Send one min/max/mean/RMS summary per channel and window.
+ *      - 'a': Adaptive rate - each channel is sampled faster while it
+ *             changes and slower while it is stable (adaptive.h); 'A: ms'
+ *             announces the ADC period.
+ *      - 'd': Report by exception - send a channel only when it leaves the
+ *             deadband, with a heartbeat after a configured silence.
+ *      - 'c': Arm a pre-trigger capture at appCAPTURE_RATE_HZ; once it is
+ *             complete the frozen buffer is dumped as binary frames (frame.h).
+ *      - 'f': Spectral mode - report the amplitude of the appSPECTRUM_BINS
+ *             frequencies of each channel, one capture block at a time.
+ *      - 'q': Report dropped items and the high-water mark of each queue,
+ *             'E: erases refused' for the log erases done and the attempts
+ *             that found no window, and 'V: cycles/budget' for the display
+ *             refresh measured at start-up; over the budget the display is
+ *             off.
+ *      - 'L': 'L' or 'Ln' followed by any non-digit, e.g. Enter - dump the
+ *             flash log from block n (default 0) on as binary frames,
+ *             between the live records, up to the newest block written.
+ *      - 'b': Step the resolution of the selected channels through 9, 10,
+ *             12, 14 and 16 bit; 'Rc: bits' confirms the new setting.
+ *      - 'k': Measure the next user calibration point on the lowest selected
+ *             channel (appCAL_LOW_CODE, then appCAL_HIGH_CODE); 'K1: code'
+ *             and 'K2: code gain offset' report it, gain 0 if rejected.
+ *      - 'K': Erase the user calibration, 'K0: 0 gain offset' reports the
+ *             device calibration now in use.
+ *      - 'v': Show the next channel on the 7-segment display, or none.
+ *      - 'V': Step the display brightness, off to full.
  *
  * @section Tasks and Synchronization
  * 1. Task1 (ADC Processing Task):
- *    - Handles ADC conversions and processes the values to retain the upper 9 bits.
+ *    - Handles ADC conversions and brings the values to the channel resolution.
  *
  * 2. Task2 (UART Receiving Task):
  *    - Handles UART reception using deferred interrupt processing.
@@ -36,69 +70,387 @@
  * 3. Task3 (UART Transmission Task):
  *    - Transmits processed ADC values over UART to the PC.
  *
+ * 4. Log Task:
+ *    - Appends every conversion to the flash log.
+ *
  * @section Synchronization Mechanisms
  * - Binary Semaphores: Used to synchronize tasks.
  * - Queues: Used to handle UART commands and ADC data.
- * - Event Groups: Used to manage task notifications and events.
+ * - Task notifications: Bits that wake Task1 for ADC data, commands and
+ *   completed captures.
+ *
+ * @section Sampling schedule
+ * - The tick hook runs the rate groups (rategroup.h): on every RTOS tick
+ *   it builds an ADC12 sequence of the channels that are due and starts it,
+ *   so a slow channel is not converted at the rate of a fast one.
+ *
+ * @section Board health
+ * - The internal temperature sensor and AVcc / 2 are channels like the
+ *   external inputs, at their own low rate. The tick hook switches the
+ *   reference on when one of them is due and converts them on a later
+ *   tick without external channels, so the external sampling instants do
+ *   not move; Task1 converts them to degC and mV (sensors.h).
+ *
+ * @section Alarms
+ * - Task1 checks every conversion of the channels in appALARMS against
+ *   their limits, with hysteresis (alarm.h). A change sets the blink code
+ *   of the LED of the channel and sends '!c: state value latency' to the
+ *   control lane, ahead of the sample stream. The latency, conversion to
+ *   formatting in us, stays within one bulk frame: 57 ms behind capture
+ *   frames at 9600 baud, 72 ms behind log frames, and the 29 B line is on
+ *   the wire 90 ms and 104 ms after the conversion (tests/host/test_lanes.c).
+ *
+ * @section LEDs
+ * - The tick hook steps both LEDs through their patterns (pattern.h) every
+ *   appPATTERN_STEP_MS and writes the port only when one changes. The
+ *   heartbeat LED pulses while the tick runs, the activity LED flashes for
+ *   every line or frame Task3 sends; an alarm blink code replaces either.
+ *
+ * @section Transmit lanes
+ * - Task3 serves two queues: the control lane (command responses, alarms)
+ *   and the bulk lane (samples, summaries, spectra, capture dumps). At
+ *   every frame boundary - after a text line or a capture frame - the next
+ *   one is taken from the control lane first, then a capture dump in
+ *   progress, the bulk lane and the log dump (lanes.h).
+ * - A response therefore waits for at most the bulk frame on the wire, the
+ *   two bytes in TXBUF and the shift register and its own line: 80 ms for
+ *   a 20 B response behind capture frames at 9600 baud, 95 ms behind log
+ *   frames (tests/host/test_lanes.c).
+ *
+ * @section Flow control
+ * - The TX ISR sends the line or frame handed over by Task3 byte by byte.
+ *   An XOFF from the host (or CTS deasserted) stops it after the current
+ *   byte until XON (or CTS); Task3 waits, the producers keep queueing
+ *   into the lanes and their stages drop what does not fit (flow.h).
+ * - When the command queue nears full the device sends XOFF (or deasserts
+ *   RTS) ahead of any pending data, and XON once Task2 has caught up.
+ *
+ * @section Flash log
+ * - Task1 passes every conversion to the log task, which packs it into
+ *   blocks and writes them to a ring of segments in FLASH2 (log.h).
+ * - A block is programmed a word at a time, interrupts are taken between
+ *   the words. A segment erase (up to 32 ms) runs from RAM with the vector
+ *   table in RAM, so only handlers placed there run meanwhile: the tick is
+ *   counted and UART bytes are kept, the other interrupts wait. The log
+ *   task therefore starts an erase only when no conversion is due for its
+ *   duration and no capture is running. The bytes are then passed on and
+ *   the ticks replayed through the tick interrupt, so the sampling instants
+ *   and timestamps do not move and nothing received is lost.
+ * - 'L' streams logged blocks through Task3 whenever the bulk lane is empty,
+ *   so the live records keep their place and the dump takes the rest of
+ *   the line. A dump cut short is resumed with 'L' and the sequence number
+ *   after the last block received. The dump runs at appUART_BAUD like the
+ *   rest of the link (app_config.h); block frames are 93 % log data, about
+ *   0.76 line bytes per sample (tests/host/test_dump.c).
  *
- * @section Software Timer
- * - A software timer is configured to trigger ADC conversions every second.
+ * @section Display
+ * - TA1 multiplexes the two 7-segment digits (display.h); Task1 puts every
+ *   conversion of the selected channel on it, whether it is sent or not.
+ *
+ * @section Calibration
+ * - The ADC ISR corrects every sequence with the gain and offset from the
+ *   device TLV or the user calibration in information memory D
+ *   (calibration.h) before the samples are queued or captured.
+ *
+ * @section Timestamps
+ * - The ADC ISR stamps every sequence with the RTOS tick and the TA0R
+ *   sub-tick (timestamp.h); the stamp travels with the samples and is
+ *   printed at the end of each line when appOUTPUT_TIMESTAMP is set.
+ *
+ * @section Back-pressure
+ * - The ADC ISR, the UART RX ISR and Task1 send through stages (stage.h)
+ *   that apply the overflow policy configured for their queue and count
+ *   every item that is dropped, so a slow UART no longer stalls the
+ *   pipeline silently.
  *
  * @section Implementation Details
  * - The project utilizes FreeRTOS for task management and synchronization.
- * - ADC values are stored in a buffer, and the upper 9 bits are extracted for transmission.
+ * - The ADC ISR passes corrected 12-bit results on; Task1 applies the resolution.
  * - UART communication is implemented with interrupt handling to ensure responsive command processing.
  *
  * @author Uros Stefanovic
  ********************************************************************************/
 
 /* Standard includes. */
+#include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 /* FreeRTOS includes. */
 #include "FreeRTOS.h"
 #include "task.h"
 #include "semphr.h"
 #include "queue.h"
-#include "timers.h"
-#include "event_groups.h"
 #include "semphr.h"
+#include "rtos_objects.h"
 
 /* Hardware includes. */
 #include "msp430.h"
 
 /* User's includes */
 #include "../ETF5529_HAL/hal_ETF_5529.h"
+#include "app_config.h"
+#include "fmt.h"
+#include "stats.h"
+#include "deadband.h"
+#include "capture.h"
+#include "frame.h"
+#include "spectrum.h"
+#include "timestamp.h"
+#include "stage.h"
+#include "decimate.h"
+#include "adaptive.h"
+#include "rategroup.h"
+#include "resolution.h"
+#include "calibration.h"
+#include "sensors.h"
+#include "alarm.h"
+#include "flow.h"
+#include "display.h"
+#include "pattern.h"
+#include "log.h"
+#include "lanes.h"
 
 /* Macros for converting between ASCII and binary coding */
 #define ASCII2DIGIT(x)      (x - '0')
 #define DIGIT2ASCII(x)      (x + '0')
-#define ARRAY_LENGTH        9
+/* Longest line of any record type: "Scc: mmmmm MMMMM aaaaa rrrrr ttttt.ss\n\r" */
+#define ARRAY_LENGTH        40
+
+/* Notification bits of Task1 */
+#define  mainEVENT_ADC                  0x02    // ADC ISR has sent Task1 a message
+#define  mainEVENT_COMMAND              0x04    // Task2 has queued a command for Task1
+#define  mainEVENT_CAPTURE              0x08    // ADC ISR has completed a capture
+
+/**
+ * @brief Message struct used for communication between tasks
+ *
+ * The message contains:
+ * a value after ADC conversion,
+ * the channel from which the value is sampled,
+ * the time at which the sequence completed
+ */
+struct Message{
+    uint8_t channel;
+    uint16_t value;
+    uint32_t timestamp;
+};
 
-/** Task priorities */
-#define xTASK1_PRIO        ( 1 )
-#define xTASK2_PRIO        ( 2 )
-#define xTASK3_PRIO        ( 3 )
+/* Record types */
+#define recordSAMPLE        0   // single sample, u.value
+#define recordSTATS         1   // window summary, u.stats
+#define recordHEARTBEAT     2   // liveness record in deadband mode, u.value
+#define recordCAPTURE       3   // dump the frozen capture buffer, no data
+#define recordSPECTRUM      4   // amplitude of one frequency bin, u.spectrum
+#define recordQUEUE         5   // overrun counters of stage 'channel', u.queue
+#define recordRATIO         6   // stream aggregation ratio, u.value
+#define recordPERIOD        7   // ADC period in ms in adaptive mode, u.value
+#define recordRESOLUTION    8   // new resolution of the channel, u.value bits
+#define recordCALIBRATION   9   // user calibration point 'channel', u.calibration
+#define recordALARM         10  // alarm state change, u.alarm
+#define recordLOG           11  // dump the flash log from block u.ulSequence on, no data
+#define recordDISPLAY       12  // MCLK cycles of one display refresh, u.value
+#define recordERASE         13  // log erases done and attempts refused, u.erase
 
-/* freeRTOS object parameters */
-#define QUEUE_LENGTH            10
-#define ADC_TIMER_PERIOD        (pdMS_TO_TICKS(1000))
+/**
+ * @brief Record struct passed from Task1 to Task3 for transmission
+ */
+struct Record{
+    uint8_t type;
+    uint8_t channel;
+    uint8_t bits;           // resolution of sample values
+    uint32_t timestamp;     // time of the (last) sample the record is based on
+    union{
+        uint16_t        value;
+        uint32_t        ulSequence;
+        StatsSummary_t  stats;
+        struct{
+            uint16_t usHz;
+            uint16_t usAmplitude;
+        }spectrum;
+        struct{
+            uint32_t ulDropped;
+            uint8_t ucHighWater;
+            uint8_t ucLength;
+        }queue;
+        struct{
+            uint16_t usCode;
+            uint16_t usGain;
+            int16_t sOffset;
+        }calibration;
+        struct{
+            uint16_t usValue;
+            uint8_t ucState;        // AlarmState_t
+        }alarm;
+        struct{
+            uint32_t ulDone;
+            uint32_t ulRefused;
+        }erase;
+    }u;
+};
 
-/* Event bit definitions */
-#define  mainEVENT_ADC                  0x02    // ADC ISR has sent Task1 a message
-#define  mainEVENT_STOP_SENDING         0x04    // Task2 has detected '4' on UART input
-#define  mainEVENT_SEND_1               0x08    // Task2 has detected '1' on UART input
-#define  mainEVENT_SEND_2               0x10    // Task2 has detected '2' on UART input
-#define  mainEVENT_SEND_BOTH            0x20    // Task2 has detected '3' on UART input
+/**
+ * @brief Commands decoded by Task2 and executed by Task1
+ */
+typedef enum{
+    CMD_SEND_1,
+    CMD_SEND_2,
+    CMD_SEND_BOTH,
+    CMD_SEND_SENSORS,
+    CMD_STOP_SENDING,
+    CMD_MODE_STREAM,
+    CMD_MODE_STATS,
+    CMD_MODE_DEADBAND,
+    CMD_CAPTURE,
+    CMD_MODE_SPECTRUM,
+    CMD_QUEUE_STATS,
+    CMD_MODE_ADAPTIVE,
+    CMD_RESOLUTION,
+    CMD_CALIBRATE,
+    CMD_CALIBRATION_CLEAR,
+    CMD_DISPLAY_CHANNEL,
+    CMD_DISPLAY_LEVEL,
+    CMD_LOG_DUMP
+}command_t;
 
-/* freeRTOS object handlers */
-xQueueHandle        xADCQueue;
-xQueueHandle        xCharQueue;
-xQueueHandle        xMessageQueue;
-EventGroupHandle_t  xEventGroup;
-TimerHandle_t       xADCTimer;
-xSemaphoreHandle    xEventDataSent;
+/**
+ * @brief Command struct passed from Task2 to Task1, with its argument
+ */
+struct Command{
+    command_t type;
+    uint32_t ulSequence;    // CMD_LOG_DUMP: first block to dump
+};
+
+/* freeRTOS objects, statically allocated with typed accessors */
+rtosTASK_DEFINE( xTask1, appTASK1_STACK );
+rtosTASK_DEFINE( xTask2, appTASK2_STACK );
+rtosTASK_DEFINE( xTask3, appTASK3_STACK );
+rtosTASK_DEFINE( xLogTask, appLOG_STACK );
+rtosQUEUE_DEFINE( xADCQueue, struct Message, appADC_QUEUE_LENGTH );
+rtosQUEUE_DEFINE( xCharQueue, char, appCHAR_QUEUE_LENGTH );
+rtosQUEUE_DEFINE( xMessageQueue, struct Record, appMESSAGE_QUEUE_LENGTH );
+rtosQUEUE_DEFINE( xControlQueue, struct Record, appCONTROL_QUEUE_LENGTH );
+rtosQUEUE_DEFINE( xCommandQueue, struct Command, appCOMMAND_QUEUE_LENGTH );
+rtosQUEUE_DEFINE( xLogQueue, struct Message, appLOG_QUEUE_LENGTH );
+rtosBINARY_SEMAPHORE_DEFINE( xEventDataSent );
+/* Given after every send to either transmit lane */
+rtosBINARY_SEMAPHORE_DEFINE( xTxPending );
+
+/* Producer side of the data queues, numbered 1..4 in queue reports */
+static Stage_t xADCStage;
+static Stage_t xCharStage;
+static Stage_t xMessageStage;
+static Stage_t xControlStage;
+static Stage_t xLogStage;
+
+appSTATIC_ASSERT( sizeof( struct Message ) <= stageMAX_ITEM_SIZE &&
+                  sizeof( struct Record ) <= stageMAX_ITEM_SIZE, mainCheckStageItemSize );
+/* UART (10 bits per byte) must carry every line of a period at the largest ratio */
+appSTATIC_ASSERT( (unsigned long) appLINE_MAX_BYTES * appLINES_PER_KS
+                  <= appUART_BAUD * appUART_LOAD_PERCENT * decimateMAX_RATIO, mainCheckUARTBandwidth );
+/* Capture dump requests are sent to the bulk lane and must not be evicted */
+appSTATIC_ASSERT( appMESSAGE_POLICY != STAGE_DROP_OLDEST, mainCheckMessagePolicy );
+/* A log block, header and payload, fits one frame */
+appSTATIC_ASSERT( sizeof( LogBlock_t ) + appLOG_PAYLOAD_BYTES <= frameMAX_PAYLOAD, mainCheckLogFrame );
+
+/* Channel index converted into each ADC12MEMx of the current sequence */
+static uint8_t pucSequence[appNUM_CHANNELS];
+static uint8_t ucSequenceLength;
+/* Channels of the current sequence, bit n - channel n */
+static uint16_t usSequenceMask;
+/* pdTRUE from the start of a tick sequence until the ADC ISR read its results */
+static volatile BaseType_t xSequenceRunning;
+/* Channels that fell due while a sequence was running, started by the ADC ISR */
+static uint16_t usSequenceLatched;
+
+/* Append one channel to the sequence if it is in usMask */
+#define prvSEQUENCE_CHANNEL( ucIndex, usInput, ucPin, usPeriodMs )              \
+    if( usMask & ( 1U << ( ucIndex ) ) ){                                       \
+        ( &ADC12MCTL0 )[ ucLength ] = ( usInput ) |                             \
+                                      ( ( ucPin ) ? appADC_SREF : ADC12SREF_1 ); \
+        pucSequence[ ucLength++ ] = ( ucIndex );                                \
+    }
+
+/* ADC12CTL0 for external and for internal sequences; the temperature
+   sensor needs 30 us of sampling, 256 ADC12OSC cycles */
+#define mainADC12CTL0_EXTERNAL  ( ADC12SHT0_2 + ADC12MSC + ADC12ON )
+#define mainADC12CTL0_INTERNAL  ( ADC12SHT0_8 + ADC12MSC + ADC12ON )
+
+/* Sensor_t of every channel */
+#define prvSENSOR_OF_CHANNEL( ucIndex, usInput, ucPin, usPeriodMs )  sensorsOF_INPUT( usInput ),
+static const uint8_t pucSensor[appNUM_CHANNELS] = { appCHANNELS( prvSENSOR_OF_CHANNEL ) };
+
+/* Alarm limits and LED of every channel, from appALARMS */
+#define prvALARM_LIMITS( ucIndex, usLow, usHigh, usHysteresis, ucLed )      \
+    [ ucIndex ] = { ( usLow ), ( usHigh ), ( usHysteresis ), true },
+#define prvALARM_LED( ucIndex, usLow, usHigh, usHysteresis, ucLed )         \
+    [ ucIndex ] = ( ucLed ),
+static const AlarmLimits_t pxAlarmLimits[appNUM_CHANNELS] = { appALARMS( prvALARM_LIMITS ) };
+static const uint8_t pucAlarmLed[appNUM_CHANNELS] = { appALARMS( prvALARM_LED ) };
+/* Blink code of every AlarmState_t */
+static const uint8_t pucAlarmPattern[] = { PATTERN_NONE, PATTERN_CODE_1, PATTERN_CODE_2 };
+
+/* LEDs stepped by the tick hook */
+#define mainLED_HEARTBEAT       ( 0 )
+#define mainLED_ACTIVITY        ( 1 )
+#define mainNUM_LEDS            ( 2 )
+static PatternLed_t pxLeds[mainNUM_LEDS];
+
+#if appDISPLAY_BENCHMARK
+/* MCLK cycles of one display refresh, measured at start-up */
+static uint16_t usDisplayCycles;
+#endif
+
+/**
+ * @brief Queue a command response in the control lane, through its stage
+ */
+static void prvSendControl( const struct Record *pxRecord )
+{
+    if(uxStageSend(&xControlStage, pxRecord, 1) > 0){
+        xTxPendingGive();
+    }
+}
+
+/**
+ * @brief Queue a group of records in the bulk lane, through its stage
+ *
+ * @return number of records queued
+ */
+static UBaseType_t prvSendBulk( const struct Record *pxRecords, UBaseType_t uxCount )
+{
+    UBaseType_t uxSent;
+
+    uxSent = uxStageSend(&xMessageStage, pxRecords, uxCount);
+    if(uxSent > 0){
+        xTxPendingGive();
+    }
+    return uxSent;
+}
+
+/**
+ * @brief Program the ADC12 sequence to convert the channels in usMask
+ *
+ * The channels take ADC12MEM0 onwards in index order and the interrupt
+ * is raised by the last one. Called with interrupts disabled, and never
+ * while the results of a sequence are still unread: the ADC ISR maps
+ * ADC12MEMx to channels through pucSequence.
+ */
+static void prvADCSequence( uint16_t usMask )
+{
+    uint8_t ucLength = 0;
+
+    while(ADC12CTL1 & ADC12BUSY);                 // Let a running sequence finish
+    ADC12CTL0 &= ~ADC12ENC;                       // Control bits may only change with ENC clear
+    ADC12CTL0 = ( usMask & appINTERNAL_MASK ) ? mainADC12CTL0_INTERNAL : mainADC12CTL0_EXTERNAL;
+    appCHANNELS( prvSEQUENCE_CHANNEL )            // Input and reference select per channel
+    ( &ADC12MCTL0 )[ ucLength - 1 ] |= ADC12EOS;  // End of sequence on the last channel
+    ADC12IE = 1U << ( ucLength - 1 );             // Interrupt on the last memory
+    ADC12CTL0 |= ADC12ENC;                        // Enable conversions
+
+    ucSequenceLength = ucLength;
+    usSequenceMask = usMask;
+}
 
 /**
  * @brief Configure hardware upon boot
@@ -118,368 +470,1881 @@ static void prvSetupHardware( void )
 //    P1OUT |= 0x30;
 
     /* Initialize ADC */
-    ADC12CTL0 = ADC12SHT0_2 + ADC12MSC + ADC12ON; // Sampling time, multi-sample conversion, ADC on
+#if appADC_VREF_MV != 0
+    REFCTL0 = REFMSTR | appREF_VSEL | REFON;      // Internal reference for the ADC
+#else
+    REFCTL0 = REFMSTR | appREF_VSEL;              // Reference for the sensors, on while they are due
+#endif
+    ADC12CTL0 = mainADC12CTL0_EXTERNAL;           // Sampling time, multi-sample conversion, ADC on
     ADC12CTL1 = ADC12SHP + ADC12CONSEQ_1;         // Use sampling timer, single sequence
-    ADC12MCTL0 = ADC12INCH_0;                     // A0 ADC input select; Vref=AVcc
-    ADC12MCTL1 = ADC12INCH_1 + ADC12EOS;          // A1 ADC input select; Vref=AVcc, end of sequence
-    ADC12IE = ADC12IE1;                           // Enable interrupt for ADC12MEM1 (end of sequence)
-    ADC12CTL0 |= ADC12ENC;                        // Enable conversions
-    P6SEL          |= 0x03;                      // P6.0 and P6.1 ADC option select
+    prvADCSequence( appEXTERNAL_MASK );           // Inputs, end of sequence and interrupt
+    P6SEL          |= appP6SEL_MASK;             // ADC option select for the configured pins
 
     /* Initialize UART */
     P4SEL       |= BIT4+BIT5;                    // P4.4,5 = USCI_AA TXD/RXD
     UCA1CTL1    |= UCSWRST;                      // **Put state machine in reset**
     UCA1CTL1    |= UCSSEL_2;                     // SMCLK
-    UCA1BRW      = 1041;                         // 1MHz - Baudrate 9600
-    UCA1MCTL    |= UCBRS_6 + UCBRF_0;            // Modulation UCBRSx=1, UCBRFx=0
+    UCA1BRW      = appUART_BRW;                  // SMCLK / appUART_BAUD
+    UCA1MCTL    |= ( appUART_BRS << 1 ) + UCBRF_0; // Modulation UCBRSx from the fraction, UCBRFx=0
     UCA1CTL1    &= ~UCSWRST;                     // **Initialize USCI state machine**
     UCA1IE      |= UCRXIE;                       // Enable USCI_A1 RX interrupt
     UCA1IE      |= UCTXIE;                       // Enable USCI_A1 TX interrupt
+#if appUART_RTSCTS
+    P1OUT       &= ~appUART_RTS_BIT;             // RTS asserted, the host may send
+    P1DIR       |= appUART_RTS_BIT;
+    P1DIR       &= ~appUART_CTS_BIT;
+    P1IES       |= appUART_CTS_BIT;              // CTS asserted on the falling edge
+    P1IFG       &= ~appUART_CTS_BIT;
+    P1IE        |= appUART_CTS_BIT;
+#endif
 
     /* initialize LEDs */
     vHALInitLED();
+    vPatternInit(&pxLeds[mainLED_HEARTBEAT], appLED_HEARTBEAT, PATTERN_HEARTBEAT);
+    vPatternInit(&pxLeds[mainLED_ACTIVITY], appLED_ACTIVITY, PATTERN_OFF);
 }
 
 
+/* Internal channels that are due but not converted yet */
+static uint16_t usInternalPending;
+/* Ticks into the current LED pattern step, LEDs lit in it */
+static uint16_t usPatternTicks;
+static uint8_t ucLedsLit;
+
 /**
- * @brief Software timer Callback Function
+ * @brief Advance the LED patterns by one step, called from the tick hook
  *
- *  The timer will run for 1000ms, after which it will start the ADC and sample channel A0 and A1
+ *  The port is only written for the LEDs that change.
  */
-void    prvADCTimerCallback(TimerHandle_t xTimer){
-    // Trigger ADC Conversion
-    ADC12CTL0 |= ADC12SC;
+static void prvLedStep( void )
+{
+    uint8_t ucLit = 0;
+    uint8_t ucOff;
+    uint8_t ucOn;
+    UBaseType_t uxLed;
+
+    for(uxLed = 0; uxLed < mainNUM_LEDS; uxLed++){
+        ucLit |= ucPatternStep(&pxLeds[uxLed]);
+    }
+    if(ucLit != ucLedsLit){
+        ucOff = ucLedsLit & ~ucLit;
+        ucOn = ucLit & ~ucLedsLit;
+        halCLR_LED(ucOff);
+        halSET_LED(ucOn);
+        ucLedsLit = ucLit;
+    }
 }
 
+/* Ticks that passed during a log erase and are not replayed yet */
+static volatile uint8_t ucLogTicksOwed;
+/* Log erases carried out, and attempts that found no window */
+static uint32_t ulLogErases;
+static uint32_t ulLogEraseRefused;
+
+/* ACLK counts at the end of a tick period in which no tick is raised by hand */
+#define mainLOG_TICK_MARGIN     ( 4 )
+
 /**
- * @brief Message struct used for communication between tasks
+ * @brief Raise one tick interrupt owed for a log erase
  *
- * The message contains:
- * a value after ADC conversion,
- * the channel from which the value is sampled
+ * The tick ISR then runs as for a timer tick, kernel and tick hook included,
+ * and the hook raises the next one. A flag raised just before TA0 sets it
+ * would merge two ticks, so none is raised in the last mainLOG_TICK_MARGIN
+ * counts of a period; the hook of the timer tick goes on. Called with
+ * interrupts disabled.
  */
-struct Message{
-    uint8_t channel;
-    uint16_t value;
-};
+static void prvLogTickRaise( void )
+{
+    uint16_t usCount = TA0R;
 
+    while(usCount != TA0R){ // ACLK is asynchronous to MCLK
+        usCount = TA0R;
+    }
+    if((TA0CCTL0 & CCIFG) == 0 && usCount < TA0CCR0 - mainLOG_TICK_MARGIN){
+        ucLogTicksOwed--;
+        TA0CCTL0 |= CCIFG;
+    }
+}
 
 /**
- * @brief UART state enum
+ * @brief Tick hook
  *
- * The state is kept in Task1 and used for keeping track of which channel to display over UART
+ *  Replays the ticks of a log erase. Steps the LED patterns, runs the rate groups and starts an ADC sequence over
+ *  the channels that are due. Due internal channels switch the reference on and
+ *  are converted on the next tick without external channels, once it has
+ *  settled (75 us). If the ADC ISR has not read the previous sequence yet, the
+ *  due inputs are latched for it to start and the sensors wait a tick.
  */
-typedef enum{
-    SEND_1,
-    SEND_2,
-    SEND_BOTH,
-    DONT_SEND
-}state_t;
+void vApplicationTickHook( void )
+{
+    uint16_t usDue = usRateGroupTick();
 
+    if(ucLogTicksOwed != 0){
+        prvLogTickRaise();
+    }
+    if(++usPatternTicks >= pdMS_TO_TICKS(appPATTERN_STEP_MS)){
+        usPatternTicks = 0;
+        prvLedStep();
+    }
+    // The capture timer owns the ADC while a capture is running
+    if(xCaptureGetState() == CAPTURE_ARMED || xCaptureGetState() == CAPTURE_TRIGGERED){
+        return;
+    }
+    usInternalPending |= usDue & appINTERNAL_MASK;
+    usDue &= appEXTERNAL_MASK;
+    if(usInternalPending != 0){
+        if((REFCTL0 & REFON) == 0){
+            REFCTL0 |= REFON;
+        }
+        else if(usDue == 0){
+            usDue = usInternalPending;
+            usInternalPending = 0;
+        }
+    }
+    if(usDue == 0){
+        return;
+    }
+    if(xSequenceRunning){
+        usInternalPending |= usDue & appINTERNAL_MASK;
+        usSequenceLatched |= usDue & appEXTERNAL_MASK;
+        return;
+    }
+    if(usDue != usSequenceMask){
+        prvADCSequence(usDue);
+    }
+    // Trigger ADC Conversion
+    xSequenceRunning = pdTRUE;
+    ADC12CTL0 |= ADC12SC;
+}
 
 /**
- * @brief xTask1: ADC Processing Task
+ * @brief Start Timer B0 pacing ADC sequences, usPeriod + 1 SMCLK cycles apart
  *
- * This task does deffered interrupt processing for ADC.
- * It receives a message from ADC ISR and determines which channels
- * should be passed to Task3 (sent over UART).
+ * Every set of a capture holds all external channels.
  */
-static void prvxTask1( void *pvParameters )
+static void prvCaptureTimerStart( uint16_t usPeriod )
 {
-    EventBits_t eventValue;
-
-    volatile state_t state = DONT_SEND;
-
-    volatile struct Message xMessage;
-
-    volatile uint16_t xFirstChannelLastValue = 0;
-    volatile uint16_t xSecondChannelLastValue = 0;
-
-    while(1){
+    while(xSequenceRunning){
+        // The capture is armed, so the tick hook starts no more sequences;
+        // the ADC ISR reads a running one within a conversion time
+    }
 
-        /* Wait for ADC event or a char sent from UART */
-        eventValue = xEventGroupWaitBits(xEventGroup,
-                    mainEVENT_ADC | mainEVENT_SEND_1 | mainEVENT_SEND_2 | mainEVENT_SEND_BOTH | mainEVENT_STOP_SENDING,
-                    pdTRUE,
-                    pdFALSE,
-                    portMAX_DELAY);
+    taskENTER_CRITICAL();
+    usSequenceLatched = 0;
+    prvADCSequence(appEXTERNAL_MASK);
+    taskEXIT_CRITICAL();
 
-        /*Check what caused the exit from the blocked state*/
-        if(eventValue & mainEVENT_ADC){
-            xQueueReceive(xADCQueue, &xMessage, 0); // Non-blocking call
+    TB0CTL = TBSSEL_2 | TBCLR;                    // SMCLK, stopped
+    TB0CCR0 = usPeriod;
+    TB0CCTL0 = CCIE;
+    TB0CTL |= MC_1;                               // Up mode
+}
 
-            // Change last received value
-            xFirstChannelLastValue = xMessage.value;
+/**
+ * @brief Stop the capture timer, called from the ADC ISR
+ */
+static void prvCaptureTimerStop( void )
+{
+    TB0CTL &= ~MC_3;
+    TB0CCTL0 = 0;
+}
 
-            // If in proper state, send the value to task 3
-            if(state==SEND_1 || state==SEND_BOTH){
-                xQueueSendToBack(xMessageQueue, &xMessage, portMAX_DELAY);
-            }
 
-            xQueueReceive(xADCQueue, &xMessage, 0); // Non-blocking call
+/**
+ * @brief Output mode
+ *
+ * The mode is kept in Task1 and selects how samples are turned into records
+ */
+typedef enum{
+    MODE_STREAM,
+    MODE_STATS,
+    MODE_DEADBAND,
+    MODE_SPECTRUM,
+    MODE_ADAPTIVE
+}outputMode_t;
 
-            // Change last received value
-            xSecondChannelLastValue = xMessage.value;
 
-            // If in proper state, send the value to task 3
-            if(state==SEND_2 || state==SEND_BOTH){
-                xQueueSendToBack(xMessageQueue, &xMessage, portMAX_DELAY);
-            }
+/**
+ * @brief Start a spectral analysis block if the capture buffer is free
+ *
+ * The block is captured untriggered at appSPECTRUM_RATE_HZ.
+ *
+ * @return pdTRUE if the block was started
+ */
+static BaseType_t prvSpectrumStart( void )
+{
+    if(xCaptureArm(0, CAPTURE_ABOVE, 0, 0)){
+        prvCaptureTimerStart(appSPECTRUM_TIMER_PERIOD);
+        return pdTRUE;
+    }
+    return pdFALSE;
+}
 
+/**
+ * @brief Send the amplitude of every bin of every selected channel
+ */
+static void prvSpectrumReport( UBaseType_t uxSendMask )
+{
+    struct Record xRecord;
+    uint8_t ucChannel;
+    uint8_t ucBin;
+
+    xRecord.type = recordSPECTRUM;
+    // The block is triggered on its first set
+    xRecord.timestamp = ulCaptureGetTriggerTime();
+    for(ucChannel = 0; ucChannel < appNUM_EXTERNAL; ucChannel++){
+        if((uxSendMask & (1U << ucChannel)) == 0){
+            continue;
         }
-        if(eventValue & mainEVENT_SEND_1){
-            state = SEND_1;
-        }
-        if(eventValue & mainEVENT_SEND_2){
-            state = SEND_2;
-        }
-        if(eventValue & mainEVENT_SEND_BOTH){
-            state = SEND_BOTH;
-        }
-        if(eventValue & mainEVENT_STOP_SENDING){
-            state = DONT_SEND;
+        xRecord.channel = ucChannel + 1;
+        for(ucBin = 0; ucBin < spectrumNUM_BINS; ucBin++){
+            xRecord.u.spectrum.usHz = usSpectrumBinHz(ucBin);
+            xRecord.u.spectrum.usAmplitude = usSpectrumAmplitude(ucChannel, ucBin);
+            prvSendBulk(&xRecord, 1);
         }
     }
 }
 
 
-
 /**
- * @brief xTask2: UART Receiver Task
- *
- *  This task does deffered interrupt processing for UART.
- *  When the user send over UART a character between '1' and '4',
- *  this task signals Task1 accordingly.
+ * @brief Stream aggregation ratio that fits the selected channels to the UART
  */
-static void prvxTask2( void *pvParameters ){
-
-    volatile char        recChar =   0;
-
-    while(1){
-        /*Read char from the queue*/
-        xQueueReceive(xCharQueue, &recChar, portMAX_DELAY); // blocking call
-        switch(recChar){
-        case '1':
-            xEventGroupSetBits(xEventGroup, mainEVENT_SEND_1);
-            break;
-        case '2':
-            xEventGroupSetBits(xEventGroup, mainEVENT_SEND_2);
-            break;
-        case '3':
-            xEventGroupSetBits(xEventGroup, mainEVENT_SEND_BOTH);
-            break;
-        case '4':
-            xEventGroupSetBits(xEventGroup, mainEVENT_STOP_SENDING);
-            break;
+static uint8_t prvStreamRatio( UBaseType_t uxSendMask, const Resolution_t *pxResolution )
+{
+    uint32_t ulBytesPerKs = 0;
+    uint32_t ulLinesPerKs;
+    uint8_t ucChannel;
+    uint8_t ucBits;
+
+    for(ucChannel = 0; ucChannel < appNUM_CHANNELS; ucChannel++){
+        if(uxSendMask & (1U << ucChannel)){
+            ucBits = pxResolution[ucChannel].ucBits;
+            ulLinesPerKs = 1000UL * configTICK_RATE_HZ / usRateGroupGetPeriod(ucChannel)
+                           / usResolutionConversions(ucBits);
+            // Narrower samples print fewer digits than the longest line
+            ulBytesPerKs += ulLinesPerKs * (appLINE_MAX_BYTES - resolutionMAX_DIGITS
+                                            + ucResolutionDigits(ucBits));
         }
     }
+    if(ulBytesPerKs == 0){
+        return 1;
+    }
+    return ucDecimateRatio(ulBytesPerKs, appUART_BAUD, appUART_LOAD_PERCENT);
 }
 
 /**
- * @brief xTask3: UART Transmission Task
+ * @brief Finish one user calibration point and report it
  *
- *  This task sends data over UART.
+ * @param ucPoint    0 - calibration cleared, 1 - low point, 2 - high point,
+ *                   which derives and stores the user calibration
+ * @param usMeasured averaged reading in LSB << calibrationPOINT_SHIFT
+ * @param pusLow     low point, kept until the high one is measured
  */
-static void prvxTask3( void *pvParameters ){
-    volatile struct Message xMessage;
-
-    // Values from last message, used for finding difference
-    volatile uint16_t xFirstChannelLastValue = 0;
-    volatile uint16_t xSecondChannelLastValue = 0;
+static void prvCalibrationPoint( uint8_t ucPoint, uint16_t usMeasured, uint16_t *pusLow )
+{
+    struct Record xRecord;
+    BaseType_t xStored = pdTRUE;
 
-    // Variables used for formating the value for sending
-    volatile int xValueToDisplay;
-    volatile uint8_t xHundredDigit;
-    volatile uint8_t xTenDigit;
-    volatile uint8_t xOneDigit;
-    volatile bool negative;
+    if(ucPoint == 1){
+        *pusLow = usMeasured;
+    }
+    else if(ucPoint == 2){
+        // Rejected points leave the previous correction active
+        xStored = xCalibrationSetUser(*pusLow, usMeasured);
+    }
+    xRecord.type = recordCALIBRATION;
+    xRecord.channel = ucPoint;
+    xRecord.timestamp = (uint32_t)xTaskGetTickCount() << 16;
+    xRecord.u.calibration.usCode = usMeasured >> calibrationPOINT_SHIFT;
+    xRecord.u.calibration.usGain = xStored ? usCalibrationGain() : 0;
+    xRecord.u.calibration.sOffset = sCalibrationOffset();
+    prvSendControl(&xRecord);
+}
 
-    // An array of chars used for UART transmission
-    volatile char uartBuffer[ARRAY_LENGTH];
-    volatile int index = 0;
-    volatile int bufferLength;
+/**
+ * @brief Bring a sample to appSAMPLE_BITS, the resolution thresholds are given in
+ */
+static uint16_t prvNormalise( uint16_t usSample, uint8_t ucBits )
+{
+    return (ucBits >= appSAMPLE_BITS) ? usSample >> (ucBits - appSAMPLE_BITS)
+                                      : usSample << (appSAMPLE_BITS - ucBits);
+}
 
-    while(1){
-        xQueueReceive(xMessageQueue, &xMessage, portMAX_DELAY); // blocking call
+/**
+ * @brief Turn a conversion into a sample of its channel
+ *
+ * External inputs go through their resolution, internal sensors are
+ * converted to their unit (sensors.h).
+ *
+ * @return pdTRUE when a sample was completed and written to pusSample
+ */
+static BaseType_t prvChannelSample( Resolution_t *pxResolution, UBaseType_t uxIndex,
+                                    uint16_t usValue, uint16_t *pusSample )
+{
+    if(pucSensor[uxIndex] != SENSOR_NONE){
+        *pusSample = usSensorsConvert((Sensor_t)pucSensor[uxIndex], usValue);
+        return pdTRUE;
+    }
+    return xResolutionAdd(&pxResolution[uxIndex], usValue, pusSample) ? pdTRUE : pdFALSE;
+}
 
-        if(xMessage.channel==1){
-            xValueToDisplay = xMessage.value - xFirstChannelLastValue;
-            xFirstChannelLastValue = xMessage.value;
-        }
-        if(xMessage.channel==2){
-            xValueToDisplay = xMessage.value - xSecondChannelLastValue;
-            xSecondChannelLastValue = xMessage.value;
-        }
-        // In case of negative differences
-        if(xValueToDisplay>=0){
-            negative = false;
-        }
-        else{
-            negative = true;
-            xValueToDisplay *= -1;
-        }
+/**
+ * @brief Check a conversion against the alarm limits of its channel
+ *
+ * A change of state sets the blink code of the alarm LEDs, from the worst
+ * state of their channels, and is sent to the control lane, ahead of the
+ * samples waiting in the bulk lane.
+ */
+static void prvAlarmCheck( AlarmState_t *pxAlarm, UBaseType_t uxIndex, const struct Message *pxMessage )
+{
+    struct Record xRecord;
+    uint16_t usValue;
+    AlarmState_t xWorst;
+    UBaseType_t uxChannel;
+    UBaseType_t uxLed;
+
+    // Sensor limits are in their unit, the others in LSB
+    usValue = usSensorsConvert((Sensor_t)pucSensor[uxIndex], pxMessage->value);
+    if(xAlarmUpdate(&pxAlarmLimits[uxIndex], &pxAlarm[uxIndex], usValue) == false){
+        return;
+    }
 
-        // Finding the digits in decimal format
-        xHundredDigit = xValueToDisplay/100;
-        xValueToDisplay -= xHundredDigit*100;
-        xTenDigit = xValueToDisplay/10;
-        xOneDigit = xValueToDisplay - xTenDigit*10;
-
-        // Format: '1/2: (-)xxx'
-        index = 0;
-        uartBuffer[index++] = DIGIT2ASCII(xMessage.channel);
-        uartBuffer[index++] = ':';
-        uartBuffer[index++] = ' ';
-        if(negative){
-            uartBuffer[index++] = '-';
-        }
-        uartBuffer[index++] = DIGIT2ASCII(xHundredDigit);
-        uartBuffer[index++] = DIGIT2ASCII(xTenDigit);
-        uartBuffer[index++] = DIGIT2ASCII(xOneDigit);
-        uartBuffer[index++] = '\n';
-        uartBuffer[index++] = '\r';
-        bufferLength = index;
-
-        // Sending data
-        for(index = 0; index < bufferLength; index++){
-            UCA1TXBUF = uartBuffer[index];
-            xSemaphoreTake(xEventDataSent, portMAX_DELAY); // blocking call
+    for(uxLed = 0; uxLed < mainNUM_LEDS; uxLed++){
+        xWorst = ALARM_NORMAL;
+        for(uxChannel = 0; uxChannel < appNUM_CHANNELS; uxChannel++){
+            if(pucAlarmLed[uxChannel] == pxLeds[uxLed].ucMask && pxAlarm[uxChannel] > xWorst){
+                xWorst = pxAlarm[uxChannel];
+            }
         }
+        // The tick hook steps the LEDs
+        taskENTER_CRITICAL();
+        vPatternSetOverride(&pxLeds[uxLed], (Pattern_t)pucAlarmPattern[xWorst]);
+        taskEXIT_CRITICAL();
     }
-}
 
+    xRecord.type = recordALARM;
+    xRecord.channel = uxIndex + 1;
+    xRecord.timestamp = pxMessage->timestamp;
+    xRecord.u.alarm.usValue = usValue;
+    xRecord.u.alarm.ucState = pxAlarm[uxIndex];
+    prvSendControl(&xRecord);
+}
 
+/**
+ * @brief Show a conversion on the 7-segment display
+ *
+ * External inputs in percent of full scale, the temperature in degC and
+ * AVcc in 0.1 V.
+ */
+static void prvDisplayValue( UBaseType_t uxIndex, uint16_t usRaw )
+{
+    uint16_t usValue = usSensorsConvert((Sensor_t)pucSensor[uxIndex], usRaw);
+    int16_t sTenths;
 
+    switch(pucSensor[uxIndex]){
+    case SENSOR_TEMPERATURE:
+        sTenths = (int16_t)usValue - sensorsZERO_CELSIUS;
+        vDisplayNumber((sTenths + (sTenths < 0 ? -5 : 5)) / 10);
+        break;
+    case SENSOR_SUPPLY:
+        vDisplayNumber((usValue + 50) / 100);
+        break;
+    default:
+        vDisplayNumber((int16_t)(((uint32_t)usValue * 100) >> 12));
+        break;
+    }
+}
 
 /**
- * @brief main function
+ * @brief Sample every external channel at the given period
  */
-void main( void )
+static void prvSetSamplePeriod( TickType_t xPeriod )
 {
-    /* Configure peripherals */
-    prvSetupHardware();
+    uint8_t ucChannel;
 
-    /* Create tasks */
-    xTaskCreate( prvxTask1,                         // task function
-                 "ADC Processing Task",             // task name
-                 configMINIMAL_STACK_SIZE,          // stack size
-                 NULL,                              // no parameter is passed
-                 xTASK1_PRIO,                       // priority
-                 NULL                               // we don't need handle
-               );
-    xTaskCreate( prvxTask2,                         // task function
-                 "UART Receiver Task",              // task name
-                 configMINIMAL_STACK_SIZE,          // stack size
-                 NULL,                              // no parameter is passed
-                 xTASK2_PRIO,                       // priority
-                 NULL                               // we don't need handle
-               );
-    xTaskCreate( prvxTask3,                         // task function
-                 "UART Transmission Task",          // task name
-                 configMINIMAL_STACK_SIZE,          // stack size
-                 NULL,                              // no parameter is passed
-                 xTASK3_PRIO,                       // priority
-                 NULL                               // we don't need handle
-               );
-
-    /* Create timer */
-    xADCTimer = xTimerCreate("ADC timer",
-                 ADC_TIMER_PERIOD,
-                 pdTRUE,
-                 NULL,
-                 prvADCTimerCallback);
+    for(ucChannel = 0; ucChannel < appNUM_EXTERNAL; ucChannel++){
+        vRateGroupSetPeriod(ucChannel, xPeriod);
+    }
+}
 
+/**
+ * @brief Adaptive mode: move the ADC to the fastest level of the selected channels
+ *
+ * @return the new base level
+ */
+static uint8_t prvAdaptiveRebase( Adaptive_t *pxAdaptive, UBaseType_t uxSendMask, uint8_t ucBaseLevel )
+{
+    struct Record xRecord;
+    uint8_t ucLevel = appADAPTIVE_LEVELS - 1;
+    UBaseType_t uxIndex;
 
-    // Create other freeRTOS objects
-    xEventGroup         = xEventGroupCreate();
+    for(uxIndex = 0; uxIndex < appNUM_CHANNELS; uxIndex++){
+        if((uxSendMask & (1U << uxIndex)) && pxAdaptive[uxIndex].ucLevel < ucLevel){
+            ucLevel = pxAdaptive[uxIndex].ucLevel;
+        }
+    }
+    if(ucLevel == ucBaseLevel){
+        return ucBaseLevel;
+    }
 
-    xEventDataSent      =   xSemaphoreCreateBinary();
+    for(uxIndex = 0; uxIndex < appNUM_CHANNELS; uxIndex++){
+        vAdaptiveRebase(&pxAdaptive[uxIndex]);
+    }
+    prvSetSamplePeriod(pdMS_TO_TICKS((uint32_t)appADAPTIVE_MIN_PERIOD_MS << ucLevel));
+
+    xRecord.type = recordPERIOD;
+    xRecord.channel = 0;
+    xRecord.timestamp = (uint32_t)xTaskGetTickCount() << 16;
+    xRecord.u.value = appADAPTIVE_MIN_PERIOD_MS << ucLevel;
+    prvSendControl(&xRecord);
+    return ucLevel;
+}
 
-    xADCQueue             =   xQueueCreate(QUEUE_LENGTH,sizeof(struct Message));
-    xCharQueue             =   xQueueCreate(QUEUE_LENGTH,sizeof(char));
-    xMessageQueue             =   xQueueCreate(QUEUE_LENGTH,sizeof(struct Message));
+/**
+ * @brief Send the overrun counters of every stage
+ */
+static void prvQueueReport( void )
+{
+    static Stage_t * const pxStages[] = { &xADCStage, &xCharStage, &xMessageStage, &xControlStage, &xLogStage };
+    struct Record xRecord;
+    UBaseType_t uxStage;
+    UBaseType_t uxHighWater;
+
+    xRecord.type = recordQUEUE;
+    xRecord.timestamp = (uint32_t)xTaskGetTickCount() << 16;
+    for(uxStage = 0; uxStage < sizeof(pxStages) / sizeof(pxStages[0]); uxStage++){
+        vStageGetCounters(pxStages[uxStage], &xRecord.u.queue.ulDropped, &uxHighWater);
+        xRecord.channel = uxStage + 1;
+        xRecord.u.queue.ucHighWater = uxHighWater;
+        xRecord.u.queue.ucLength = pxStages[uxStage]->uxLength;
+        prvSendControl(&xRecord);
+    }
+    xRecord.type = recordERASE;
+    xRecord.channel = 0;
+    taskENTER_CRITICAL();
+    xRecord.u.erase.ulDone = ulLogErases;
+    xRecord.u.erase.ulRefused = ulLogEraseRefused;
+    taskEXIT_CRITICAL();
+    prvSendControl(&xRecord);
+#if appDISPLAY_BENCHMARK
+    xRecord.type = recordDISPLAY;
+    xRecord.channel = 0;
+    xRecord.u.value = usDisplayCycles;
+    prvSendControl(&xRecord);
+#endif
+}
 
-    // Start timer
-    xTimerStart(xADCTimer, portMAX_DELAY);
 
-    /* Start the scheduler. */
-    vTaskStartScheduler();
+/**
+ * @brief xTask1: ADC Processing Task
+ *
+ * This task does deffered interrupt processing for ADC.
+ * It receives messages from ADC ISR and, depending on the selected
+ * channels and output mode, passes records to Task3 (sent over UART).
+ */
+static void prvxTask1( void *pvParameters )
+{
+    uint32_t eventValue;
+
+    /* Bit n set - channel n + 1 is passed on to Task3 */
+    UBaseType_t uxSendMask = 0;
+    UBaseType_t uxIndex;
+    outputMode_t xMode = MODE_STREAM;
+    struct Command xCommand;
+    // The running capture block belongs to spectral mode
+    BaseType_t xSpectrumBlock = pdFALSE;
+    // A frozen capture waits for room in the bulk lane
+    BaseType_t xDumpPending = pdFALSE;
+    // So does a log dump request, from block ulLogDumpStart on
+    BaseType_t xLogDumpPending = pdFALSE;
+    uint32_t ulLogDumpStart = 0;
+
+    struct Message xMessage;
+    struct Record xRecord;
+    /* Per-channel state is static, off the task stack (appTASK1_STACK) */
+    /* Records made from one ADC sequence, sent as one group */
+    static struct Record xRecords[appNUM_CHANNELS];
+    struct Record *pxRecord;
+    UBaseType_t uxRecords = 0;
+
+    static StatsWindow_t xStats[appNUM_CHANNELS];
+    static Deadband_t xDeadband[appNUM_CHANNELS];
+    static Decimator_t xDecimator[appNUM_CHANNELS];
+    /* Stream aggregation ratio, 0 until announced */
+    uint8_t ucRatio = 0;
+    uint8_t ucNewRatio;
+    static Adaptive_t xAdaptive[appNUM_CHANNELS];
+    /* Level the ADC timer runs at in adaptive mode */
+    uint8_t ucBaseLevel = 0;
+    outputMode_t xPreviousMode;
+    static Resolution_t xResolution[appNUM_CHANNELS];
+    uint16_t usSample;
+    /* User calibration: next point (1, 2) and conversions still to average */
+    uint8_t ucCalPoint = 1;
+    uint16_t usCalCount = 0;
+    uint32_t ulCalSum = 0;
+    uint16_t usCalLow = 0;
+    UBaseType_t uxCalChannel = 0;
+    static AlarmState_t xAlarm[appNUM_CHANNELS];
+    /* Channel on the 7-segment display, index + 1, 0 none */
+    uint8_t ucDisplayChannel = appDISPLAY_CHANNEL;
+
+    for(uxIndex = 0; uxIndex < appNUM_CHANNELS; uxIndex++){
+        vStatsInit(&xStats[uxIndex], appSTATS_WINDOW_LOG2);
+        xResolutionSet(&xResolution[uxIndex], appSAMPLE_BITS);
+        xAlarm[uxIndex] = ALARM_NORMAL;
+    }
 
+    while(1){
 
-    /* If all is well then this line will never be reached.  If it is reached
-    then it is likely that there was insufficient (FreeRTOS) heap memory space
-    to create the idle task.  This may have been trapped by the malloc() failed
-    hook function, if one is configured. */
-    for( ;; );
-}
+        /* Wait for ADC event or a command from UART */
+        xTaskNotifyWait(0, 0xFFFFFFFFUL, &eventValue, portMAX_DELAY);
 
+        /*Check what caused the exit from the blocked state*/
+        if(eventValue & mainEVENT_COMMAND){
+            xPreviousMode = xMode;
+            while(xCommandQueueReceive(&xCommand, 0) == pdPASS){
+                switch(xCommand.type){
+                case CMD_SEND_1:
+                    uxSendMask = 1U << 0;
+                    break;
+                case CMD_SEND_2:
+                    uxSendMask = 1U << 1;
+                    break;
+                case CMD_SEND_BOTH:
+                    uxSendMask = appEXTERNAL_MASK;
+                    break;
+                case CMD_SEND_SENSORS:
+                    uxSendMask ^= appINTERNAL_MASK;
+                    break;
+                case CMD_STOP_SENDING:
+                    uxSendMask = 0;
+                    break;
+                case CMD_MODE_STREAM:
+                    xMode = MODE_STREAM;
+                    // Announce the ratio again
+                    ucRatio = 0;
+                    break;
+                case CMD_MODE_STATS:
+                    xMode = MODE_STATS;
+                    // Start every window afresh
+                    for(uxIndex = 0; uxIndex < appNUM_CHANNELS; uxIndex++){
+                        vStatsInit(&xStats[uxIndex], appSTATS_WINDOW_LOG2);
+                    }
+                    break;
+                case CMD_CAPTURE:
+                    // Ignored while a previous capture is still in progress
+                    if(xCaptureArm(appCAPTURE_TRIGGER_CHANNEL, appCAPTURE_TRIGGER,
+                                   appCAPTURE_TRIGGER_LEVEL, appCAPTURE_PRETRIGGER)){
+                        prvCaptureTimerStart(appCAPTURE_TIMER_PERIOD);
+                    }
+                    break;
+                case CMD_MODE_SPECTRUM:
+                    xMode = MODE_SPECTRUM;
+                    if(xSpectrumBlock == pdFALSE){
+                        xSpectrumBlock = prvSpectrumStart();
+                    }
+                    break;
+                case CMD_QUEUE_STATS:
+                    prvQueueReport();
+                    break;
+                case CMD_LOG_DUMP:
+                    ulLogDumpStart = xCommand.ulSequence;
+                    xLogDumpPending = pdTRUE;
+                    break;
+                case CMD_MODE_ADAPTIVE:
+                    xMode = MODE_ADAPTIVE;
+                    break;
+                case CMD_RESOLUTION:
+                    for(uxIndex = 0; uxIndex < appNUM_EXTERNAL; uxIndex++){
+                        if((uxSendMask & (1U << uxIndex)) == 0){
+                            continue;
+                        }
+                        xResolutionSet(&xResolution[uxIndex],
+                                       ucResolutionNext(xResolution[uxIndex].ucBits));
+                        // Windows and references of the old resolution are void
+                        vStatsInit(&xStats[uxIndex], appSTATS_WINDOW_LOG2);
+                        vDeadbandInit(&xDeadband[uxIndex]);
+                        vDecimateInit(&xDecimator[uxIndex]);
+
+                        xRecord.type = recordRESOLUTION;
+                        xRecord.channel = uxIndex + 1;
+                        xRecord.bits = xResolution[uxIndex].ucBits;
+                        xRecord.timestamp = (uint32_t)xTaskGetTickCount() << 16;
+                        xRecord.u.value = xResolution[uxIndex].ucBits;
+                        prvSendControl(&xRecord);
+                    }
+                    // The stream ratio is recomputed below
+                    break;
+                case CMD_CALIBRATE:
+                    // Lowest selected channel, the first one if none is selected
+                    for(uxCalChannel = 0; uxCalChannel < appNUM_EXTERNAL; uxCalChannel++){
+                        if(uxSendMask & (1U << uxCalChannel)){
+                            break;
+                        }
+                    }
+                    if(uxCalChannel == appNUM_EXTERNAL){
+                        uxCalChannel = 0;
+                    }
+                    ulCalSum = 0;
+                    usCalCount = 1U << appCAL_AVERAGE_LOG2;
+                    break;
+                case CMD_CALIBRATION_CLEAR:
+                    vCalibrationClearUser();
+                    ucCalPoint = 1;
+                    usCalCount = 0;
+                    prvCalibrationPoint(0, 0, &usCalLow);
+                    break;
+                case CMD_DISPLAY_CHANNEL:
+                    ucDisplayChannel = (ucDisplayChannel + 1) % (appNUM_CHANNELS + 1);
+                    // The next conversion of the channel fills it in
+                    vDisplayBlank();
+                    break;
+                case CMD_DISPLAY_LEVEL:
+                    vDisplaySetLevel((ucDisplayGetLevel() + 1) % (appDISPLAY_LEVELS + 1));
+                    break;
+                case CMD_MODE_DEADBAND:
+                    xMode = MODE_DEADBAND;
+                    // First sample of every channel is reported
+                    for(uxIndex = 0; uxIndex < appNUM_CHANNELS; uxIndex++){
+                        vDeadbandInit(&xDeadband[uxIndex]);
+                    }
+                    break;
+                }
+            }
+            if(xMode == MODE_ADAPTIVE && xPreviousMode != MODE_ADAPTIVE){
+                // Every channel starts slow, the first sample decides
+                for(uxIndex = 0; uxIndex < appNUM_CHANNELS; uxIndex++){
+                    vAdaptiveInit(&xAdaptive[uxIndex]);
+                }
+                ucBaseLevel = appADAPTIVE_LEVELS;
+                ucBaseLevel = prvAdaptiveRebase(xAdaptive, uxSendMask, ucBaseLevel);
+            }
+            else if(xMode != MODE_ADAPTIVE && xPreviousMode == MODE_ADAPTIVE){
+                // Back to the configured periods
+                vRateGroupInit();
+            }
+        }
+        if(xMode == MODE_STREAM){
+            // Fit the stream to the UART for the current channel selection
+            ucNewRatio = prvStreamRatio(uxSendMask, xResolution);
+            if(ucNewRatio != ucRatio){
+                ucRatio = ucNewRatio;
+                for(uxIndex = 0; uxIndex < appNUM_CHANNELS; uxIndex++){
+                    vDecimateInit(&xDecimator[uxIndex]);
+                }
+                xRecord.type = recordRATIO;
+                xRecord.channel = 0;
+                xRecord.timestamp = (uint32_t)xTaskGetTickCount() << 16;
+                xRecord.u.value = ucRatio;
+                prvSendControl(&xRecord);
+            }
+        }
+        if(eventValue & mainEVENT_CAPTURE){
+            if(xSpectrumBlock){
+                xSpectrumBlock = pdFALSE;
+                if(xMode == MODE_SPECTRUM){
+                    prvSpectrumReport(uxSendMask);
+                }
+                vCaptureRelease();
+            }
+            else{
+                xDumpPending = pdTRUE;
+            }
+        }
+        // Retried on every event, a paused link must not stall the acquisition
+        if(xDumpPending){
+            xRecord.type = recordCAPTURE;
+            xRecord.channel = appCAPTURE_TRIGGER_CHANNEL + 1;
+            xRecord.timestamp = ulCaptureGetTriggerTime();
+            if(xMessageQueueSend(&xRecord, 0) == pdPASS){ // Non-blocking call
+                xDumpPending = pdFALSE;
+                xTxPendingGive();
+            }
+        }
+        if(xLogDumpPending){
+            xRecord.type = recordLOG;
+            xRecord.channel = 0;
+            xRecord.timestamp = (uint32_t)xTaskGetTickCount() << 16;
+            xRecord.u.ulSequence = ulLogDumpStart;
+            if(xMessageQueueSend(&xRecord, 0) == pdPASS){ // Non-blocking call
+                xLogDumpPending = pdFALSE;
+                xTxPendingGive();
+            }
+        }
+        // Keep spectral blocks coming, also after a raw capture has been dumped
+        if(xMode == MODE_SPECTRUM && xSpectrumBlock == pdFALSE){
+            xSpectrumBlock = prvSpectrumStart();
+        }
+        if(eventValue & mainEVENT_ADC){
+            /* Drain everything the ISR has posted since the last event */
+            while(xADCQueueReceive(&xMessage, 0) == pdPASS){ // Non-blocking call
+                uxIndex = xMessage.channel - 1;
+
+                // A new stamp starts the next sequence
+                if(uxRecords > 0 && xMessage.timestamp != xRecords[0].timestamp){
+                    prvSendBulk(xRecords, uxRecords);
+                    uxRecords = 0;
+                }
+
+                prvAlarmCheck(xAlarm, uxIndex, &xMessage);
+                (void)uxStageSend(&xLogStage, &xMessage, 1);
+                if(uxIndex + 1 == ucDisplayChannel){
+                    prvDisplayValue(uxIndex, xMessage.value);
+                }
+
+                // User calibration point, averaged over corrected conversions
+                if(usCalCount > 0 && uxIndex == uxCalChannel){
+                    ulCalSum += xMessage.value;
+                    if(--usCalCount == 0){
+                        prvCalibrationPoint(ucCalPoint,
+                                            (uint16_t)(ulCalSum >> (appCAL_AVERAGE_LOG2 - calibrationPOINT_SHIFT)),
+                                            &usCalLow);
+                        ucCalPoint = (ucCalPoint == 1) ? 2 : 1;
+                    }
+                }
+
+                // Only channels in proper state are passed to task 3,
+                // oversampled channels once their block is complete
+                if((uxSendMask & (1U << uxIndex)) &&
+                   prvChannelSample(xResolution, uxIndex, xMessage.value, &usSample)){
+                    pxRecord = &xRecords[uxRecords];
+                    pxRecord->channel = xMessage.channel;
+                    // Sensor units take the thresholds as they are
+                    pxRecord->bits = (pucSensor[uxIndex] == SENSOR_NONE) ?
+                                     xResolution[uxIndex].ucBits : appSAMPLE_BITS;
+                    pxRecord->timestamp = xMessage.timestamp;
+                    switch(xMode){
+                    case MODE_STREAM:
+                        if(xDecimateAdd(&xDecimator[uxIndex], usSample, ucRatio,
+                                        &pxRecord->u.value)){
+                            pxRecord->type = recordSAMPLE;
+                            uxRecords++;
+                        }
+                        break;
+                    case MODE_STATS:
+                        if(xStatsAdd(&xStats[uxIndex], usSample, &pxRecord->u.stats)){
+                            pxRecord->type = recordSTATS;
+                            uxRecords++;
+                        }
+                        break;
+                    case MODE_DEADBAND:
+                        switch(xDeadbandCheck(&xDeadband[uxIndex], prvNormalise(usSample, pxRecord->bits),
+                                              appDEADBAND, appDEADBAND_MAX_SILENT)){
+                        case DEADBAND_REPORT:
+                            pxRecord->type = recordSAMPLE;
+                            pxRecord->u.value = usSample;
+                            uxRecords++;
+                            break;
+                        case DEADBAND_HEARTBEAT:
+                            pxRecord->type = recordHEARTBEAT;
+                            pxRecord->u.value = usSample;
+                            uxRecords++;
+                            break;
+                        default:
+                            break;
+                        }
+                        break;
+                    case MODE_ADAPTIVE:
+                        // Sensors keep their own period
+                        if(pucSensor[uxIndex] != SENSOR_NONE ||
+                           xAdaptiveAdd(&xAdaptive[uxIndex], prvNormalise(usSample, pxRecord->bits),
+                                        ucBaseLevel)){
+                            pxRecord->type = recordSAMPLE;
+                            pxRecord->u.value = usSample;
+                            uxRecords++;
+                        }
+                        break;
+                    case MODE_SPECTRUM:
+                        // Reported per capture block
+                        break;
+                    }
+                }
+            }
+            // Last sequence
+            if(uxRecords > 0){
+                prvSendBulk(xRecords, uxRecords);
+                uxRecords = 0;
+            }
+            if(xMode == MODE_ADAPTIVE){
+                ucBaseLevel = prvAdaptiveRebase(xAdaptive, uxSendMask, ucBaseLevel);
+            }
+        }
+    }
+}
 
 
 
+/* Buffer being sent by the TX ISR */
+static const uint8_t * volatile pucTxData;
+static volatile uint16_t usTxLeft;
+/* XON or XOFF to send ahead of the buffer, 0 if none */
+static volatile char cTxFlow;
+/* The TX ISR runs as long as it has something to send */
+static volatile bool xTxActive;
+static Flow_t xFlow;
 
+#if appUART_RTSCTS
+#define prvTX_PAUSED()      ( xFlow.xPaused || ( P1IN & appUART_CTS_BIT ) )
+#else
+#define prvTX_PAUSED()      ( xFlow.xPaused )
+#endif
 
 /**
- * @brief ADC12 ISR
+ * @brief Restart the TX ISR if it has stopped
  *
- * When the interrupt happens on the ADC12IFG1,
- * the values from the ADC12MEM0 and ADC12MEM1 registers are formatted
- * into a message structure, after which they are sent to the ADCQueue.
+ * TXBUF is empty once the ISR has stopped, so raising TXIFG is safe.
+ * Called with interrupts disabled.
  */
-void __attribute__ ( ( interrupt( ADC12_VECTOR  ) ) ) vADC12ISR( void )
+static void prvUARTKick( void )
 {
-    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
-    uint16_t    temp =0;
-    struct Message message;
-    switch(__even_in_range(ADC12IV,34))
-    {
-        case  0: break;                           // Vector  0:  No interrupt
-        case  2: break;                           // Vector  2:  ADC overflow
-        case  4: break;                           // Vector  4:  ADC timing overflow
-        case  6:                                  // Vector  6:  ADC12IFG0
+    if(xTxActive == false){
+        xTxActive = true;
+        UCA1IFG |= UCTXIFG;
+    }
+}
+
+/**
+ * @brief Stop or let go the host as the command queue fills and drains
+ *
+ * Called with interrupts disabled.
+ */
+static void prvFlowSignal( UBaseType_t uxWaiting )
+{
+    char cSignal = cFlowLevel(&xFlow, (uint8_t)uxWaiting);
+
+    if(cSignal == 0){
+        return;
+    }
+#if appUART_RTSCTS
+    if(cSignal == flowXOFF){
+        P1OUT |= appUART_RTS_BIT;
+    }
+    else{
+        P1OUT &= ~appUART_RTS_BIT;
+    }
+#endif
+#if appUART_XONXOFF
+    cTxFlow = cSignal;
+    prvUARTKick();
+#endif
+}
+
+/**
+ * @brief Pass a received character on to xTask2
+ *
+ * XON and XOFF pause and resume the transmitter instead. Called with
+ * interrupts disabled.
+ */
+static void prvUARTReceive( char cReceived, BaseType_t *pxHigherPriorityTaskWoken )
+{
+#if appUART_XONXOFF
+    if(xFlowReceive(&xFlow, cReceived)){
+        if(xFlow.xPaused == false){
+            prvUARTKick();
+        }
+        return;
+    }
+#endif
+    uxStageSendFromISR(&xCharStage, &cReceived, 1, pxHigherPriorityTaskWoken);
+    prvFlowSignal(uxQueueMessagesWaitingFromISR(xCharQueue));
+}
+
+/**
+ * @brief Send a buffer over UART
+ *
+ * The TX ISR sends the bytes and gives xEventDataSent once the last one is
+ * in TXBUF, so the buffer may be reused on return. Every line or frame
+ * flashes the activity LED.
+ */
+static void prvUARTSend( const uint8_t *pucData, uint16_t usLength )
+{
+    if(usLength == 0){
+        return;
+    }
+    vPatternFlash(&pxLeds[mainLED_ACTIVITY]);
+    taskENTER_CRITICAL();
+    pucTxData = pucData;
+    usTxLeft = usLength;
+    prvUARTKick();
+    taskEXIT_CRITICAL();
+    xEventDataSentTake(portMAX_DELAY); // blocking call
+}
+
+/**
+ * @brief xTask2: UART Receiver Task
+ *
+ *  This task does deffered interrupt processing for UART.
+ *  When the user sends a known command character over UART,
+ *  this task passes the command to Task1.
+ */
+static void prvxTask2( void *pvParameters ){
+
+    char        recChar =   0;
+    struct Command xCommand = { CMD_SEND_1, 0 };
+    BaseType_t  xLogNumber = pdFALSE;   // reading the block number after 'L'
+    uint32_t    ulLogNumber = 0;
+
+    while(1){
+        /*Read char from the queue*/
+        xCharQueueReceive(&recChar, portMAX_DELAY); // blocking call
+        taskENTER_CRITICAL();
+        prvFlowSignal(uxQueueMessagesWaiting(xCharQueue));
+        taskEXIT_CRITICAL();
+        // The first non-digit ends the number and is a command of its own
+        if(xLogNumber){
+            if(recChar >= '0' && recChar <= '9'){
+                ulLogNumber = ulLogNumber * 10 + (uint32_t)(recChar - '0');
+                continue;
+            }
+            xLogNumber = pdFALSE;
+            xCommand.type = CMD_LOG_DUMP;
+            xCommand.ulSequence = ulLogNumber;
+            xCommandQueueSend(&xCommand, portMAX_DELAY);
+            xTaskNotify(xTask1, mainEVENT_COMMAND, eSetBits);
+        }
+        switch(recChar){
+        case '1':
+            xCommand.type = CMD_SEND_1;
+            break;
+        case '2':
+            xCommand.type = CMD_SEND_2;
+            break;
+        case '3':
+            xCommand.type = CMD_SEND_BOTH;
+            break;
+        case '5':
+            xCommand.type = CMD_SEND_SENSORS;
             break;
-        case  8:                                  // Vector  8:  ADC12IFG1
-            // Reset 'Start Conversion' bit
-            ADC12CTL0 &= ~(ADC12SC);
-
-            // Put into a message object
-            message.channel = 1;
-            message.value = ADC12MEM0 >> 3;
-            // Send to Task1
-            xQueueSendToBackFromISR(xADCQueue, &message, &xHigherPriorityTaskWoken);
-
-            // Put into a message object
-            message.channel = 2;
-            message.value = ADC12MEM1 >> 3;
-            // Send to Task1
-            xQueueSendToBackFromISR(xADCQueue, &message, &xHigherPriorityTaskWoken);
+        case '4':
+            xCommand.type = CMD_STOP_SENDING;
+            break;
+        case 'r':
+            xCommand.type = CMD_MODE_STREAM;
+            break;
+        case 's':
+            xCommand.type = CMD_MODE_STATS;
+            break;
+        case 'a':
+            xCommand.type = CMD_MODE_ADAPTIVE;
+            break;
+        case 'b':
+            xCommand.type = CMD_RESOLUTION;
+            break;
+        case 'k':
+            xCommand.type = CMD_CALIBRATE;
+            break;
+        case 'K':
+            xCommand.type = CMD_CALIBRATION_CLEAR;
+            break;
+        case 'v':
+            xCommand.type = CMD_DISPLAY_CHANNEL;
+            break;
+        case 'V':
+            xCommand.type = CMD_DISPLAY_LEVEL;
+            break;
+        case 'd':
+            xCommand.type = CMD_MODE_DEADBAND;
+            break;
+        case 'c':
+            xCommand.type = CMD_CAPTURE;
+            break;
+        case 'f':
+            xCommand.type = CMD_MODE_SPECTRUM;
+            break;
+        case 'q':
+            xCommand.type = CMD_QUEUE_STATS;
+            break;
+        case 'L':
+            xLogNumber = pdTRUE;
+            ulLogNumber = 0;
+            continue;
+        default:
+            continue;
+        }
+        xCommandQueueSend(&xCommand, portMAX_DELAY);
+        xTaskNotify(xTask1, mainEVENT_COMMAND, eSetBits);
+    }
+}
 
-            // Signal xTask1 the ISR has finished
-            xEventGroupSetBitsFromISR(xEventGroup, mainEVENT_ADC, &xHigherPriorityTaskWoken);
+/* Values from last sample record, used for finding difference */
+static uint16_t xLastValue[appNUM_CHANNELS];
+
+/**
+ * @brief Format the value of a channel
+ *
+ * External samples are zero padded to ucDigits, temperatures are printed in
+ * degC with one decimal and the supply in mV.
+ *
+ * @return number of characters written
+ */
+static uint8_t prvFormatValue( char *pcBuffer, uint8_t ucChannel, uint16_t usValue, uint8_t ucDigits )
+{
+    switch(pucSensor[ucChannel - 1]){
+    case SENSOR_TEMPERATURE:
+        return ucFmtFixed(pcBuffer, (int32_t)usValue - sensorsZERO_CELSIUS, 1);
+    case SENSOR_SUPPLY:
+        return ucFmtU16(pcBuffer, usValue);
+    default:
+        return ucFmtU16Pad(pcBuffer, usValue, ucDigits);
+    }
+}
+
+/**
+ * @brief Format a sample record
+ *
+ * Format: '1/2: (-)xxx', zero padded to the digits of the resolution
+ *
+ * @return number of characters written
+ */
+static uint8_t prvFormatSample( char *pcBuffer, const struct Record *pxRecord )
+{
+    uint8_t index;
+    int32_t xValueToDisplay;
+
+#if appOUTPUT_FORMAT == appFORMAT_DIFFERENCE
+    xValueToDisplay = (int32_t)pxRecord->u.value - xLastValue[pxRecord->channel - 1];
+    xLastValue[pxRecord->channel - 1] = pxRecord->u.value;
+#else
+    xValueToDisplay = pxRecord->u.value;
+#endif
+    index = ucFmtU16(pcBuffer, pxRecord->channel);
+    pcBuffer[index++] = ':';
+    pcBuffer[index++] = ' ';
+    // Sensor readings are always absolute, in their unit
+    if(pucSensor[pxRecord->channel - 1] != SENSOR_NONE){
+        return index + prvFormatValue(&pcBuffer[index], pxRecord->channel, pxRecord->u.value, 0);
+    }
+    // In case of negative differences
+    if(xValueToDisplay < 0){
+        pcBuffer[index++] = '-';
+        xValueToDisplay = -xValueToDisplay;
+    }
+    index += ucFmtU16Pad(&pcBuffer[index], (uint16_t)xValueToDisplay,
+                         ucResolutionDigits(pxRecord->bits));
+    return index;
+}
+
+/**
+ * @brief Format a heartbeat record
+ *
+ * Format: 'H1/2: xxx', always the absolute value
+ *
+ * @return number of characters written
+ */
+static uint8_t prvFormatHeartbeat( char *pcBuffer, const struct Record *pxRecord )
+{
+    uint8_t index = 0;
+
+    // Later differences are relative to the value sent here
+    xLastValue[pxRecord->channel - 1] = pxRecord->u.value;
+
+    pcBuffer[index++] = 'H';
+    index += ucFmtU16(&pcBuffer[index], pxRecord->channel);
+    pcBuffer[index++] = ':';
+    pcBuffer[index++] = ' ';
+    index += prvFormatValue(&pcBuffer[index], pxRecord->channel, pxRecord->u.value,
+                            ucResolutionDigits(pxRecord->bits));
+    return index;
+}
+
+/**
+ * @brief Format a spectrum record
+ *
+ * Format: 'F1/2: Hz amplitude'
+ *
+ * @return number of characters written
+ */
+static uint8_t prvFormatSpectrum( char *pcBuffer, const struct Record *pxRecord )
+{
+    uint8_t index = 0;
+
+    pcBuffer[index++] = 'F';
+    index += ucFmtU16(&pcBuffer[index], pxRecord->channel);
+    pcBuffer[index++] = ':';
+    pcBuffer[index++] = ' ';
+    index += ucFmtU16(&pcBuffer[index], pxRecord->u.spectrum.usHz);
+    pcBuffer[index++] = ' ';
+    index += ucFmtU16(&pcBuffer[index], pxRecord->u.spectrum.usAmplitude);
+    return index;
+}
+
+#if appOUTPUT_TIMESTAMP
+/**
+ * @brief Format a timestamp
+ *
+ * Format: ' ttttt.ss', tick count and sub-tick
+ *
+ * @return number of characters written
+ */
+static uint8_t prvFormatTimestamp( char *pcBuffer, uint32_t ulTimestamp )
+{
+    uint8_t index = 0;
+
+    pcBuffer[index++] = ' ';
+    index += ucFmtU16(&pcBuffer[index], timestampTICKS(ulTimestamp));
+    pcBuffer[index++] = '.';
+    index += ucFmtU16Pad(&pcBuffer[index], timestampSUBTICK(ulTimestamp), 2);
+    return index;
+}
+#endif
+
+/**
+ * @brief Format a ratio record
+ *
+ * Format: 'D: N', one line per N samples of each channel from now on
+ *
+ * @return number of characters written
+ */
+static uint8_t prvFormatRatio( char *pcBuffer, const struct Record *pxRecord )
+{
+    uint8_t index = 0;
+
+    pcBuffer[index++] = 'D';
+    pcBuffer[index++] = ':';
+    pcBuffer[index++] = ' ';
+    index += ucFmtU16(&pcBuffer[index], pxRecord->u.value);
+    return index;
+}
+
+/**
+ * @brief Format a period record
+ *
+ * Format: 'A: ms', the ADC period from now on
+ *
+ * @return number of characters written
+ */
+static uint8_t prvFormatPeriod( char *pcBuffer, const struct Record *pxRecord )
+{
+    uint8_t index = 0;
+
+    pcBuffer[index++] = 'A';
+    pcBuffer[index++] = ':';
+    pcBuffer[index++] = ' ';
+    index += ucFmtU16(&pcBuffer[index], pxRecord->u.value);
+    return index;
+}
+
+/**
+ * @brief Format an erase record
+ *
+ * Format: 'E: erases refused', log erases done and attempts without a window
+ *
+ * @return number of characters written
+ */
+static uint8_t prvFormatErase( char *pcBuffer, const struct Record *pxRecord )
+{
+    uint8_t index = 0;
+
+    pcBuffer[index++] = 'E';
+    pcBuffer[index++] = ':';
+    pcBuffer[index++] = ' ';
+    index += ucFmtU32(&pcBuffer[index], pxRecord->u.erase.ulDone);
+    pcBuffer[index++] = ' ';
+    index += ucFmtU32(&pcBuffer[index], pxRecord->u.erase.ulRefused);
+    return index;
+}
+
+/**
+ * @brief Format a display record
+ *
+ * Format: 'V: cycles/budget', the display is off if cycles exceed the budget
+ *
+ * @return number of characters written
+ */
+static uint8_t prvFormatDisplay( char *pcBuffer, const struct Record *pxRecord )
+{
+    uint8_t index = 0;
+
+    pcBuffer[index++] = 'V';
+    pcBuffer[index++] = ':';
+    pcBuffer[index++] = ' ';
+    index += ucFmtU16(&pcBuffer[index], pxRecord->u.value);
+    pcBuffer[index++] = '/';
+    index += ucFmtU16(&pcBuffer[index], appDISPLAY_BUDGET_CYCLES);
+    return index;
+}
+
+/**
+ * @brief Format a resolution record
+ *
+ * Format: 'R1/2: bits'
+ *
+ * @return number of characters written
+ */
+static uint8_t prvFormatResolution( char *pcBuffer, const struct Record *pxRecord )
+{
+    uint8_t index = 0;
+
+    // Differences start again from zero at the new resolution
+    xLastValue[pxRecord->channel - 1] = 0;
+
+    pcBuffer[index++] = 'R';
+    index += ucFmtU16(&pcBuffer[index], pxRecord->channel);
+    pcBuffer[index++] = ':';
+    pcBuffer[index++] = ' ';
+    index += ucFmtU16(&pcBuffer[index], pxRecord->u.value);
+    return index;
+}
+
+/**
+ * @brief Format a calibration record
+ *
+ * Format: 'K1: code' for the low point, 'K0/2: code gain offset' otherwise
+ *
+ * @return number of characters written
+ */
+static uint8_t prvFormatCalibration( char *pcBuffer, const struct Record *pxRecord )
+{
+    uint8_t index = 0;
+
+    pcBuffer[index++] = 'K';
+    index += ucFmtU16(&pcBuffer[index], pxRecord->channel);
+    pcBuffer[index++] = ':';
+    pcBuffer[index++] = ' ';
+    index += ucFmtU16(&pcBuffer[index], pxRecord->u.calibration.usCode);
+    if(pxRecord->channel != 1){
+        pcBuffer[index++] = ' ';
+        index += ucFmtU16(&pcBuffer[index], pxRecord->u.calibration.usGain);
+        pcBuffer[index++] = ' ';
+        index += ucFmtS16(&pcBuffer[index], pxRecord->u.calibration.sOffset);
+    }
+    return index;
+}
+
+/**
+ * @brief Format an alarm record
+ *
+ * Format: '!1/2: N/L/H value latency' - normal, low or high, the value in
+ * the unit of the channel and the time from the conversion to this line in us
+ *
+ * @return number of characters written
+ */
+static uint8_t prvFormatAlarm( char *pcBuffer, const struct Record *pxRecord, uint32_t ulLatency )
+{
+    static const char pcState[] = { 'N', 'L', 'H' };
+    uint8_t index = 0;
+
+    pcBuffer[index++] = '!';
+    index += ucFmtU16(&pcBuffer[index], pxRecord->channel);
+    pcBuffer[index++] = ':';
+    pcBuffer[index++] = ' ';
+    pcBuffer[index++] = pcState[pxRecord->u.alarm.ucState];
+    pcBuffer[index++] = ' ';
+    index += prvFormatValue(&pcBuffer[index], pxRecord->channel, pxRecord->u.alarm.usValue, 0);
+    pcBuffer[index++] = ' ';
+    index += ucFmtU32(&pcBuffer[index], timestampSUBTICKS_TO_US(ulLatency));
+    return index;
+}
+
+/**
+ * @brief Format a queue report record
+ *
+ * Format: 'Qn: dropped highwater/length', n = 1 ADC, 2 RX, 3 TX bulk, 4 TX control, 5 log
+ *
+ * @return number of characters written
+ */
+static uint8_t prvFormatQueue( char *pcBuffer, const struct Record *pxRecord )
+{
+    uint8_t index = 0;
+
+    pcBuffer[index++] = 'Q';
+    index += ucFmtU16(&pcBuffer[index], pxRecord->channel);
+    pcBuffer[index++] = ':';
+    pcBuffer[index++] = ' ';
+    index += ucFmtU32(&pcBuffer[index], pxRecord->u.queue.ulDropped);
+    pcBuffer[index++] = ' ';
+    index += ucFmtU16(&pcBuffer[index], pxRecord->u.queue.ucHighWater);
+    pcBuffer[index++] = '/';
+    index += ucFmtU16(&pcBuffer[index], pxRecord->u.queue.ucLength);
+    return index;
+}
+
+/**
+ * @brief Format a statistics record
+ *
+ * Format: 'S1/2: min max mean rms'
+ *
+ * @return number of characters written
+ */
+static uint8_t prvFormatStats( char *pcBuffer, const struct Record *pxRecord )
+{
+    uint8_t index = 0;
+
+    pcBuffer[index++] = 'S';
+    index += ucFmtU16(&pcBuffer[index], pxRecord->channel);
+    pcBuffer[index++] = ':';
+    pcBuffer[index++] = ' ';
+    index += prvFormatValue(&pcBuffer[index], pxRecord->channel, pxRecord->u.stats.usMin, 0);
+    pcBuffer[index++] = ' ';
+    index += prvFormatValue(&pcBuffer[index], pxRecord->channel, pxRecord->u.stats.usMax, 0);
+    pcBuffer[index++] = ' ';
+    index += prvFormatValue(&pcBuffer[index], pxRecord->channel, pxRecord->u.stats.usMean, 0);
+    pcBuffer[index++] = ' ';
+    index += prvFormatValue(&pcBuffer[index], pxRecord->channel, pxRecord->u.stats.usRms, 0);
+    return index;
+}
+
+/* Frame and line under construction, kept off the Task3 stack */
+static uint8_t pucFrame[frameMAX_SIZE];
+static char pcLine[ARRAY_LENGTH];
+
+appSTATIC_ASSERT( 2 + captureBYTES_FOR_SETS( appCAPTURE_SETS_PER_FRAME ) <= frameMAX_PAYLOAD,
+                  mainCheckCaptureFrameSize );
+
+/**
+ * @brief Format a text record as one line and send it
+ */
+static void prvSendLine( const struct Record *pxRecord )
+{
+    uint8_t index = 0;
+
+    switch(pxRecord->type){
+    case recordSTATS:
+        index = prvFormatStats(pcLine, pxRecord);
+        break;
+    case recordHEARTBEAT:
+        index = prvFormatHeartbeat(pcLine, pxRecord);
+        break;
+    case recordSPECTRUM:
+        index = prvFormatSpectrum(pcLine, pxRecord);
+        break;
+    case recordQUEUE:
+        index = prvFormatQueue(pcLine, pxRecord);
+        break;
+    case recordRATIO:
+        index = prvFormatRatio(pcLine, pxRecord);
+        break;
+    case recordPERIOD:
+        index = prvFormatPeriod(pcLine, pxRecord);
+        break;
+    case recordRESOLUTION:
+        index = prvFormatResolution(pcLine, pxRecord);
+        break;
+    case recordCALIBRATION:
+        index = prvFormatCalibration(pcLine, pxRecord);
+        break;
+    case recordDISPLAY:
+        index = prvFormatDisplay(pcLine, pxRecord);
+        break;
+    case recordERASE:
+        index = prvFormatErase(pcLine, pxRecord);
+        break;
+    case recordALARM:
+        index = prvFormatAlarm(pcLine, pxRecord,
+                               ulTimestampElapsed(pxRecord->timestamp, ulTimestampGet()));
+        break;
+    case recordSAMPLE:
+    default:
+        index = prvFormatSample(pcLine, pxRecord);
+        break;
+    }
+#if appOUTPUT_TIMESTAMP
+    index += prvFormatTimestamp(&pcLine[index], pxRecord->timestamp);
+#endif
+    pcLine[index++] = '\n';
+    pcLine[index++] = '\r';
+
+    prvUARTSend((const uint8_t *)pcLine, index);
+}
+
+/* Data frames of a capture dump */
+#define mainCAPTURE_FRAMES      ( ( appCAPTURE_DEPTH + appCAPTURE_SETS_PER_FRAME - 1 ) / appCAPTURE_SETS_PER_FRAME )
+
+/**
+ * @brief Send the header frame of a capture dump
+ *
+ * The header (channels, trigger channel, trigger type, depth, pre-trigger
+ * sets, sample period in us, trigger timestamp) is followed by
+ * mainCAPTURE_FRAMES data frames, each carrying the index of its first set
+ * and the packed samples. Control lines may be sent between the frames.
+ */
+static void prvDumpCaptureHeader( void )
+{
+    uint8_t *pucPayload = &pucFrame[3];
+
+    pucPayload[0] = appNUM_EXTERNAL;
+    pucPayload[1] = appCAPTURE_TRIGGER_CHANNEL;
+    pucPayload[2] = appCAPTURE_TRIGGER;
+    framePUT_U16(&pucPayload[3], appCAPTURE_DEPTH);
+    framePUT_U16(&pucPayload[5], usCaptureGetPreTrigger());
+    framePUT_U16(&pucPayload[7], appCAPTURE_PERIOD_US);
+    framePUT_U32(&pucPayload[9], ulCaptureGetTriggerTime());
+    prvUARTSend(pucFrame, ucFrameEncode(pucFrame, frameTYPE_CAPTURE_HEADER, pucPayload, 13));
+}
+
+/**
+ * @brief Send data frame usFrame of a capture dump
+ *
+ * The buffer is released for the next capture after the last frame.
+ */
+static void prvDumpCaptureFrame( uint16_t usFrame )
+{
+    uint8_t *pucPayload = &pucFrame[3];
+    uint16_t usSet = usFrame * appCAPTURE_SETS_PER_FRAME;
+    uint8_t ucSets;
+    uint8_t ucLength;
+
+    ucSets = (appCAPTURE_DEPTH - usSet > appCAPTURE_SETS_PER_FRAME) ?
+             appCAPTURE_SETS_PER_FRAME : (uint8_t)(appCAPTURE_DEPTH - usSet);
+    framePUT_U16(&pucPayload[0], usSet);
+    ucLength = 2 + ucCapturePack(&pucPayload[2], usSet, ucSets);
+    prvUARTSend(pucFrame, ucFrameEncode(pucFrame, frameTYPE_CAPTURE_DATA, pucPayload, ucLength));
+
+    if(usFrame == mainCAPTURE_FRAMES - 1){
+        vCaptureRelease();
+    }
+}
+
+/**
+ * @brief Send the first logged block from *pulNext on as a binary frame
+ *
+ * The frames are built by ucFrameLogBlock() and, once no block is left,
+ * ucFrameLogEnd() (frame.h).
+ *
+ * The block is copied into the frame before the task blocks, the log task
+ * runs below Task3 and cannot erase it in between.
+ *
+ * @return pdFALSE once the end frame has been sent
+ */
+static BaseType_t prvDumpLogBlock( uint32_t *pulNext )
+{
+    const LogBlock_t *pxBlock = pxLogFind(*pulNext);
+    LogStats_t xStats;
+
+    if(pxBlock == 0){
+        vLogGetStats(&xStats);
+        prvUARTSend(pucFrame, ucFrameLogEnd(pucFrame, &xStats));
+        return pdFALSE;
+    }
+
+    *pulNext = pxBlock->ulSequence + 1;
+    prvUARTSend(pucFrame, ucFrameLogBlock(pucFrame, pxBlock));
+    return pdTRUE;
+}
+
+/**
+ * @brief xTask3: UART Transmission Task
+ *
+ *  This task formats records and sends them over UART, one line or frame
+ *  at a time in the order of lanes.h: the control lane first, then a
+ *  capture dump in progress, then the bulk lane. A log dump fills the time
+ *  both lanes are empty.
+ */
+static void prvxTask3( void *pvParameters ){
+    struct Record xRecord;
+    Lanes_t xLanes;
+    uint32_t ulLogNext = 0;
+
+    vLanesInit(&xLanes);
+    while(1){
+        switch(xLanesNext(&xLanes, uxQueueMessagesWaiting(xControlQueue) > 0,
+                          uxQueueMessagesWaiting(xMessageQueue) > 0)){
+        case LANES_CONTROL:
+            if(xControlQueueReceive(&xRecord, 0) == pdPASS){ // Non-blocking call
+                prvSendLine(&xRecord);
+            }
             break;
-        case 10: break;                           // Vector 10:  ADC12IFG2
-        case 12: break;                           // Vector 12:  ADC12IFG3
-        case 14: break;                           // Vector 14:  ADC12IFG4
-        case 16: break;                           // Vector 16:  ADC12IFG5
-        case 18: break;                           // Vector 18:  ADC12IFG6
-        case 20: break;                           // Vector 20:  ADC12IFG7
-        case 22: break;                           // Vector 22:  ADC12IFG8
-        case 24: break;                           // Vector 24:  ADC12IFG9
-        case 26: break;                           // Vector 26:  ADC12IFG10
-        case 28: break;                           // Vector 28:  ADC12IFG11
-        case 30: break;                           // Vector 30:  ADC12IFG12
-        case 32: break;                           // Vector 32:  ADC12IFG13
-        case 34: break;                           // Vector 34:  ADC12IFG14
-        default: break;
+        case LANES_DUMP:
+            prvDumpCaptureFrame(mainCAPTURE_FRAMES - 1 - xLanes.usDumpFrames);
+            break;
+        case LANES_BULK:
+            if(xMessageQueueReceive(&xRecord, 0) != pdPASS){ // Non-blocking call
+                break;
+            }
+            if(xRecord.type == recordCAPTURE){
+                prvDumpCaptureHeader();
+                vLanesStartDump(&xLanes, mainCAPTURE_FRAMES);
+            }
+            else if(xRecord.type == recordLOG){
+                // A new request restarts a running dump
+                vLanesLogDump(&xLanes, true);
+                ulLogNext = xRecord.u.ulSequence;
+            }
+            else{
+                prvSendLine(&xRecord);
+            }
+            break;
+        case LANES_LOG:
+            vLanesLogDump(&xLanes, prvDumpLogBlock(&ulLogNext) == pdTRUE);
+            break;
+        case LANES_WAIT:
+        default:
+            // Both lanes empty, wait for the next record in either
+            xTxPendingTake(portMAX_DELAY); // blocking call
+            break;
+        }
+    }
+}
+
+
+/* Longest wait of the log task, well below the 16-bit tick wrap */
+#define mainLOG_IDLE_WAIT       pdMS_TO_TICKS( 30000 )
+
+/* UART bytes an erase may take at most to receive */
+#define mainLOG_RX_BYTES        ( ( uint16_t ) ( appUART_BAUD / 10UL * appLOG_ERASE_MS / 1000UL + 2UL ) )
+
+/* UART bytes received during a log erase */
+static volatile char pcLogRx[mainLOG_RX_BYTES];
+static volatile uint16_t usLogRxCount;
+
+/**
+ * @brief TA0 CCR0 handler while the log erases, in RAM
+ *
+ * Counts the tick for the tick hook to replay.
+ */
+static void __attribute__ ( ( interrupt, ramfunc ) ) prvLogEraseTickISR( void )
+{
+    ucLogTicksOwed++;
+}
+
+/**
+ * @brief USCI_A1 handler while the log erases, in RAM
+ *
+ * Keeps the received bytes for prvLogStep(); TXIE is off meanwhile.
+ */
+static void __attribute__ ( ( interrupt, ramfunc ) ) prvLogEraseUARTISR( void )
+{
+    if(UCA1IV == 2){                              // Vector 2 - RXIFG
+        if(usLogRxCount < mainLOG_RX_BYTES){
+            pcLogRx[usLogRxCount++] = UCA1RXBUF;
+        }
+        else{
+            (void)UCA1RXBUF;
+        }
+    }
+}
+
+/**
+ * @brief Carry out one flash operation of the log if it may start now
+ *
+ * A block write takes interrupts between its words and runs at once. An
+ * erase runs from RAM and only the RAM handlers above are taken while it
+ * lasts, so no conversion may be due or running for its duration and no
+ * capture may be pacing the ADC; the UART transmitter, CTS and the display
+ * are masked and wait. TA1 and TB0 CCR0 clear their flag on entry, so with
+ * either enabled the erase would not be live (hal_flash.h). Afterwards the received bytes are passed on as the
+ * UART ISR does and the counted ticks are replayed through the tick
+ * interrupt. The scheduler is suspended, as the dump in Task3 reads the log.
+ *
+ * @return pdTRUE if the operation was carried out
+ */
+static BaseType_t prvLogStep( void )
+{
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE; // the kernel yields on resuming
+    BaseType_t xDone = pdFALSE;
+    CaptureState_t xCapture;
+    uint16_t usDisplay0;
+    uint16_t usDisplay1;
+    uint16_t usByte;
+    uint8_t ucUartIE;
+    uint8_t ucPort1IE;
+
+    vTaskSuspendAll();
+    if(xLogPending() == LOG_WRITE){
+        vLogStep();
+        xDone = pdTRUE;
+    }
+    else if(xLogPending() == LOG_ERASE){
+        taskENTER_CRITICAL();
+        xCapture = xCaptureGetState();
+        if((xCapture == CAPTURE_IDLE || xCapture == CAPTURE_DONE) && usInternalPending == 0 &&
+           usRateGroupNextDue() > pdMS_TO_TICKS(appLOG_ERASE_MS) && (ADC12CTL1 & ADC12BUSY) == 0){
+            ucUartIE = UCA1IE;
+            ucPort1IE = P1IE;
+            usDisplay0 = TA1CCTL0;
+            usDisplay1 = TA1CCTL1;
+            UCA1IE = ucUartIE & ~UCTXIE;
+            P1IE = 0;
+            TA1CCTL0 = usDisplay0 & ~CCIE;
+            TA1CCTL1 = usDisplay1 & ~CCIE;
+            usLogRxCount = 0;
+
+            // vHALFlashEraseLive() enables interrupts inside this critical
+            // section, against the nesting contract of the port. It holds
+            // as only the RAM handlers above can run: neither touches the
+            // kernel or usCriticalNesting, and the port tick ISR, the only
+            // one that could switch context, is replaced by the counting
+            // one. Interrupts are disabled again before vLogStep() returns.
+            vLogStep();
+
+            TA1CCTL0 = (TA1CCTL0 & ~CCIE) | (usDisplay0 & CCIE);
+            TA1CCTL1 = (TA1CCTL1 & ~CCIE) | (usDisplay1 & CCIE);
+            P1IE = ucPort1IE;
+            UCA1IE = ucUartIE;
+            for(usByte = 0; usByte < usLogRxCount; usByte++){
+                prvUARTReceive(pcLogRx[usByte], &xHigherPriorityTaskWoken);
+            }
+            if(ucLogTicksOwed != 0){
+                prvLogTickRaise();
+            }
+            ulLogErases++;
+            xDone = pdTRUE;
+        }
+        else{
+            ulLogEraseRefused++;
+        }
+        taskEXIT_CRITICAL();
+    }
+    (void)xTaskResumeAll();
+    return xDone;
+}
+
+/**
+ * @brief Log Task
+ *
+ *  Adds the conversions passed on by Task1 to the flash log and writes its
+ *  blocks. A conversion waits in the task while the block before it waits
+ *  for a window; the queue stage drops the oldest ones if that takes long.
+ */
+static void prvxLogTask( void *pvParameters ){
+    struct Message xMessage;
+    BaseType_t xHave = pdFALSE;
+    uint32_t ulTicks = 0;       // tick count, carried on past 16 bits
+    uint32_t ulSample;
+    uint8_t ucChannel;
+    TickType_t xWait;
+
+    while(1){
+        if(xHave == pdFALSE){
+            xWait = (xLogPending() != LOG_IDLE) ? pdMS_TO_TICKS(appLOG_RETRY_MS) : mainLOG_IDLE_WAIT;
+            xHave = xLogQueueReceive(&xMessage, xWait);
+        }
+        else{
+            vTaskDelay(pdMS_TO_TICKS(appLOG_RETRY_MS));
+        }
+        ulTicks += (uint16_t)(xTaskGetTickCount() - (uint16_t)ulTicks);
+
+        if(xHave){
+            // The sample was taken a little earlier than now
+            ulSample = ulTicks - (uint16_t)((uint16_t)ulTicks - timestampTICKS(xMessage.timestamp));
+            ucChannel = xMessage.channel - 1;
+            if(xLogAdd(ucChannel, xMessage.value, ulSample, usRateGroupGetPeriod(ucChannel))){
+                xHave = pdFALSE;
+            }
+        }
+        while(xLogPending() != LOG_IDLE && prvLogStep() == pdTRUE){
+        }
+    }
+}
+
+
+
+
+/**
+ * @brief main function
+ */
+#if appCAL_BENCHMARK
+/* MCLK cycles of one calibrationBENCH_LENGTH block correction, for the debugger */
+static volatile uint16_t usCalibrationCycles;
+#endif
+
+void main( void )
+{
+    /* Configure peripherals */
+    prvSetupHardware();
+
+    /* ADC correction from the user calibration or the device TLV */
+    vCalibrationInit();
+    vSensorsInit();
+#if appCAL_BENCHMARK
+    usCalibrationCycles = usCalibrationBenchmark();
+#endif
+    vDisplayInit();
+#if appDISPLAY_BENCHMARK
+    {
+        // Only the display interrupts may be taken: TXIFG is already set
+        uint8_t ucUartIE = UCA1IE;
+        uint8_t ucPort1IE = P1IE;
+
+        UCA1IE = 0;
+        P1IE = 0;
+        usDisplayCycles = usDisplayBenchmark();
+        UCA1IE = ucUartIE;
+        P1IE = ucPort1IE;
+    }
+    // Over budget the refresh would eat into the ADC and UART ISRs
+    if(usDisplayCycles > appDISPLAY_BUDGET_CYCLES){
+        vDisplayStop();
+    }
+#endif
+
+    /* Create tasks */
+    xTask1Init( prvxTask1, "ADC Processing Task", appTASK1_PRIO );
+    xTask2Init( prvxTask2, "UART Receiver Task", appTASK2_PRIO );
+    xTask3Init( prvxTask3, "UART Transmission Task", appTASK3_PRIO );
+    xLogTaskInit( prvxLogTask, "Log Task", appLOG_PRIO );
+
+    // Create other freeRTOS objects
+    xEventDataSentInit();
+    xTxPendingInit();
+    vFlowInit(&xFlow, appUART_RX_RESUME, appUART_RX_STOP);
+    xADCQueueInit();
+    xCharQueueInit();
+    xMessageQueueInit();
+    xControlQueueInit();
+    xCommandQueueInit();
+    xLogQueueInit();
+    vStageInit(&xADCStage, xADCQueue, appADC_QUEUE_LENGTH, sizeof(struct Message),
+               appADC_POLICY, appSTAGE_DECIMATION);
+    // The messages of one ADC sequence share its timestamp and are evicted together
+    vStageSetGroupKey(&xADCStage, offsetof(struct Message, timestamp), sizeof(uint32_t));
+    vStageInit(&xCharStage, xCharQueue, appCHAR_QUEUE_LENGTH, sizeof(char),
+               appCHAR_POLICY, appSTAGE_DECIMATION);
+    vStageInit(&xMessageStage, xMessageQueue, appMESSAGE_QUEUE_LENGTH, sizeof(struct Record),
+               appMESSAGE_POLICY, appSTAGE_DECIMATION);
+    vStageInit(&xControlStage, xControlQueue, appCONTROL_QUEUE_LENGTH, sizeof(struct Record),
+               appCONTROL_POLICY, appSTAGE_DECIMATION);
+    vStageInit(&xLogStage, xLogQueue, appLOG_QUEUE_LENGTH, sizeof(struct Message),
+               appLOG_POLICY, appSTAGE_DECIMATION);
+    vLogInit((void *)appLOG_START, appLOG_SEGMENTS);
+    vHALFlashSetLiveHandler(TIMER0_A0_VECTOR, prvLogEraseTickISR);
+    vHALFlashSetLiveHandler(USCI_A1_VECTOR, prvLogEraseUARTISR);
+
+    // Sampling starts with the first tick
+    vRateGroupInit();
+
+    /* Start the scheduler. */
+    vTaskStartScheduler();
+
+
+    /* If all is well then this line will never be reached.  If it is reached
+    then it is likely that there was insufficient (FreeRTOS) heap memory space
+    to create the idle task.  This may have been trapped by the malloc() failed
+    hook function, if one is configured. */
+    for( ;; );
+}
+
+
+
+
+
+
+/* Read the conversion result of one external channel into a capture set */
+#define prvREAD_CHANNEL( ucIndex, usInput, ucPin, usPeriodMs )                  \
+    if( ucPin ){                                                                \
+        pusSet[ ucIndex ] = ( &ADC12MEM0 )[ ucIndex ];                          \
+    }
+
+/**
+ * @brief ADC12 ISR
+ *
+ * When the interrupt happens on the last memory of the sequence,
+ * the values from ADC12MEM0..ADC12MEMn are formatted
+ * into message structures, after which they are sent to the ADCQueue.
+ * While a capture is running the values go to the capture buffer instead.
+ * Both are corrected with the active calibration first.
+ */
+void __attribute__ ( ( interrupt( ADC12_VECTOR  ) ) ) vADC12ISR( void )
+{
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+    /* Static: the ISR runs on the stack of the interrupted task */
+    static struct Message pxSequence[appNUM_CHANNELS];
+    static uint16_t pusSet[appNUM_CHANNELS];
+    uint32_t ulTimestamp;
+    uint8_t ucMem;
+
+    // Only the last memory of the sequence has its interrupt enabled
+    if(ADC12IV == 6 + 2 * (ucSequenceLength - 1))
+    {
+        // One stamp for the whole sequence
+        ulTimestamp = ulTimestampFromISR();
+        // Reset 'Start Conversion' bit
+        ADC12CTL0 &= ~(ADC12SC);
+
+        if(xSequenceRunning == pdFALSE &&
+           (xCaptureGetState() == CAPTURE_ARMED || xCaptureGetState() == CAPTURE_TRIGGERED)){
+            // Capture sequences hold every channel in index order
+            appCHANNELS( prvREAD_CHANNEL )
+            vCalibrationApply(pusSet, appNUM_EXTERNAL);
+            if(xCaptureAddSet(pusSet, ulTimestamp)){
+                prvCaptureTimerStop();
+                xTaskNotifyFromISR(xTask1, mainEVENT_CAPTURE, eSetBits, &xHigherPriorityTaskWoken);
+            }
+        }
+        else{
+            // Put each result into a message object and send the sequence to Task1
+            for(ucMem = 0; ucMem < ucSequenceLength; ucMem++){
+                pusSet[ucMem] = ( &ADC12MEM0 )[ucMem];
+            }
+            if(usSequenceMask & appINTERNAL_MASK){
+                // Sensors are converted from raw readings (sensors.h)
+#if appADC_VREF_MV == 0
+                REFCTL0 &= ~REFON;                          // Reference only while sensors are due
+#endif
+            }
+            else{
+                vCalibrationApply(pusSet, ucSequenceLength);
+            }
+            for(ucMem = 0; ucMem < ucSequenceLength; ucMem++){
+                pxSequence[ucMem].channel = pucSequence[ucMem] + 1;
+                pxSequence[ucMem].value = pusSet[ucMem];            // 12 bit, see resolution.h
+                pxSequence[ucMem].timestamp = ulTimestamp;
+            }
+            uxStageSendFromISR(&xADCStage, pxSequence, ucSequenceLength, &xHigherPriorityTaskWoken);
+
+            // The results are read: start what fell due meanwhile, unless a capture took the ADC
+            xSequenceRunning = pdFALSE;
+            if(usSequenceLatched != 0 &&
+               xCaptureGetState() != CAPTURE_ARMED && xCaptureGetState() != CAPTURE_TRIGGERED){
+                if(usSequenceLatched != usSequenceMask){
+                    prvADCSequence(usSequenceLatched);
+                }
+                xSequenceRunning = pdTRUE;
+                ADC12CTL0 |= ADC12SC;
+            }
+            usSequenceLatched = 0;
+
+            // Signal xTask1 the ISR has finished
+            xTaskNotifyFromISR(xTask1, mainEVENT_ADC, eSetBits, &xHigherPriorityTaskWoken);
+        }
     }
     /* trigger scheduler if higher priority task is woken */
     portYIELD_FROM_ISR( xHigherPriorityTaskWoken );
 }
 
+/**
+ * @brief Timer B0 ISR
+ *
+ * Starts one ADC sequence per period while a capture is running.
+ */
+void __attribute__ ( ( interrupt( TIMER0_B0_VECTOR  ) ) ) vCaptureTimerISR( void )
+{
+    ADC12CTL0 |= ADC12SC;
+}
+
+/**
+ * @brief TA1 CCR0 ISR
+ *
+ * Starts the slot of the next display digit.
+ */
+void __attribute__ ( ( interrupt( TIMER1_A0_VECTOR  ) ) ) vDisplayStartISR( void )
+{
+    vDisplaySlotStart();
+}
+
+/**
+ * @brief TA1 CCR1 - CCR2 and overflow ISR
+ *
+ * CCR1 ends the lit part of the slot.
+ */
+void __attribute__ ( ( interrupt( TIMER1_A1_VECTOR  ) ) ) vDisplayEndISR( void )
+{
+    switch(TA1IV)
+    {
+        case 2:                                   // Vector 2 - CCR1
+            vDisplaySlotEnd();
+            break;
+        default: break;
+    }
+}
+
 /**
  * @brief USCI_A1 ISR
  *
- * If a character is received, it is passed to xTask2.
- * When a character was sent, xTask3 is notified.
+ * A received character is passed to xTask2, XON and XOFF pause and resume
+ * the transmitter. Each TXIFG sends the next byte, a flow control byte
+ * first; xTask3 is notified when its buffer is in.
  */
 void __attribute__ ( ( interrupt( USCI_A1_VECTOR  ) ) ) vUARTISR( void )
 {
@@ -489,10 +2354,23 @@ void __attribute__ ( ( interrupt( USCI_A1_VECTOR  ) ) ) vUARTISR( void )
     {
         case 0:break;                             // Vector 0 - no interrupt
         case 2:                                   // Vector 2 - RXIFG
-            xQueueSendToBackFromISR(xCharQueue, &UCA1RXBUF, &xHigherPriorityTaskWoken);
+            prvUARTReceive(UCA1RXBUF, &xHigherPriorityTaskWoken);
         break;
         case 4:                                   // Vector 4 - TXIFG
-            xSemaphoreGive(xEventDataSent);
+            if(cTxFlow != 0){
+                UCA1TXBUF = cTxFlow;
+                cTxFlow = 0;
+            }
+            else if(usTxLeft > 0 && !prvTX_PAUSED()){
+                UCA1TXBUF = *pucTxData++;
+                if(--usTxLeft == 0){
+                    xEventDataSentGiveFromISR(&xHigherPriorityTaskWoken);
+                }
+            }
+            else{
+                // Nothing to send or paused, restarted by prvUARTKick()
+                xTxActive = false;
+            }
             break;
         default: break;
     }
@@ -500,3 +2378,18 @@ void __attribute__ ( ( interrupt( USCI_A1_VECTOR  ) ) ) vUARTISR( void )
     portYIELD_FROM_ISR( xHigherPriorityTaskWoken );
 
 }
+
+#if appUART_RTSCTS
+/**
+ * @brief Port 1 ISR
+ *
+ * CTS asserted again, resume a transmitter it has paused.
+ */
+void __attribute__ ( ( interrupt( PORT1_VECTOR  ) ) ) vCTSISR( void )
+{
+    if(P1IFG & appUART_CTS_BIT){
+        P1IFG &= ~appUART_CTS_BIT;
+        prvUARTKick();
+    }
+}
+#endif
@@ -0,0 +1,84 @@
+/**
+ * @file pattern.c
+ * @brief LED blink patterns
+ */
+
+#include "pattern.h"
+
+/* Steps of a pattern, bit n is step n; the LED is lit while the bit is set */
+static const struct{
+    uint32_t ulSteps;
+    uint8_t ucLength;
+}pxPatterns[PATTERN_COUNT] = {
+    [PATTERN_NONE]      = { 0x00000000UL, 1 },
+    [PATTERN_OFF]       = { 0x00000000UL, 1 },
+    [PATTERN_ON]        = { 0x00000001UL, 1 },
+    [PATTERN_HEARTBEAT] = { 0x00000005UL, 10 },
+    [PATTERN_CODE_1]    = { 0x00000003UL, 20 },
+    [PATTERN_CODE_2]    = { 0x00000033UL, 20 },
+    [PATTERN_CODE_3]    = { 0x00000333UL, 20 },
+    [PATTERN_FAST]      = { 0x00000001UL, 2 }
+};
+
+/* Flash: inverted for one step, then one step as it is */
+#define patternFLASH_STEPS      ( 2 )
+
+void vPatternInit( PatternLed_t *pxLed, uint8_t ucMask, Pattern_t xBase )
+{
+    pxLed->ucMask = ucMask;
+    pxLed->ucBase = xBase;
+    pxLed->ucOverride = PATTERN_NONE;
+    pxLed->ucStep = 0;
+    pxLed->ucFlash = 0;
+    pxLed->xFlashRequest = false;
+}
+
+void vPatternSetBase( PatternLed_t *pxLed, Pattern_t xPattern )
+{
+    if( pxLed->ucBase != xPattern )
+    {
+        pxLed->ucBase = xPattern;
+        pxLed->ucStep = 0;
+    }
+}
+
+void vPatternSetOverride( PatternLed_t *pxLed, Pattern_t xPattern )
+{
+    if( pxLed->ucOverride != xPattern )
+    {
+        pxLed->ucOverride = xPattern;
+        pxLed->ucStep = 0;
+    }
+}
+
+void vPatternFlash( PatternLed_t *pxLed )
+{
+    pxLed->xFlashRequest = true;
+}
+
+uint8_t ucPatternStep( PatternLed_t *pxLed )
+{
+    uint8_t ucPattern = ( pxLed->ucOverride != PATTERN_NONE ) ? pxLed->ucOverride : pxLed->ucBase;
+    bool xLit = ( ( pxPatterns[ ucPattern ].ulSteps >> pxLed->ucStep ) & 1UL ) != 0;
+
+    if( ++pxLed->ucStep >= pxPatterns[ ucPattern ].ucLength )
+    {
+        pxLed->ucStep = 0;
+    }
+
+    if( pxLed->ucFlash > 0 )
+    {
+        pxLed->ucFlash--;
+    }
+    else if( pxLed->xFlashRequest )
+    {
+        pxLed->xFlashRequest = false;
+        pxLed->ucFlash = patternFLASH_STEPS - 1;
+        if( pxLed->ucOverride == PATTERN_NONE )
+        {
+            xLit = !xLit;
+        }
+    }
+
+    return xLit ? pxLed->ucMask : 0;
+}
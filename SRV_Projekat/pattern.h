@@ -0,0 +1,68 @@
+/**
+ * @file pattern.h
+ * @brief LED blink patterns
+ *
+ * @details
+ * A pattern is a sequence of up to 32 on/off steps that repeats. One
+ * periodic call of ucPatternStep() per LED and step advances it, so the
+ * work per step is constant whatever the patterns are, and no timer or
+ * task is needed per LED.
+ *
+ * Each LED has a base pattern and an optional override (e.g. an alarm)
+ * that replaces it while set. vPatternFlash() requests an activity flash:
+ * the base pattern is inverted for one step and shown unchanged for the
+ * next, so continuous activity blinks at half the step rate instead of
+ * blurring into a steady inversion. Flashes are not shown over an
+ * override.
+ *
+ * vPatternFlash() may be called from any task; the other setters must not
+ * run concurrently with ucPatternStep().
+ */
+
+#ifndef PATTERN_H
+#define PATTERN_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef enum{
+    PATTERN_NONE,           // no override
+    PATTERN_OFF,
+    PATTERN_ON,
+    PATTERN_HEARTBEAT,      // two short pulses per second
+    PATTERN_CODE_1,         // one, two or three flashes, then a pause
+    PATTERN_CODE_2,
+    PATTERN_CODE_3,
+    PATTERN_FAST,           // on and off every step
+    PATTERN_COUNT
+}Pattern_t;
+
+/**
+ * @brief State of one LED
+ */
+typedef struct{
+    uint8_t ucMask;                 // returned by ucPatternStep() while lit
+    uint8_t ucBase;                 // Pattern_t
+    uint8_t ucOverride;             // Pattern_t, PATTERN_NONE if none
+    uint8_t ucStep;                 // step of the pattern shown
+    uint8_t ucFlash;                // steps of the current flash left
+    volatile bool xFlashRequest;
+}PatternLed_t;
+
+void vPatternInit( PatternLed_t *pxLed, uint8_t ucMask, Pattern_t xBase );
+
+/* Change the base pattern or the override; a new one starts at its first step */
+void vPatternSetBase( PatternLed_t *pxLed, Pattern_t xPattern );
+void vPatternSetOverride( PatternLed_t *pxLed, Pattern_t xPattern );
+
+/* Request an activity flash, shown from the next step */
+void vPatternFlash( PatternLed_t *pxLed );
+
+/**
+ * @brief Advance the LED by one step
+ *
+ * @return ucMask if the LED is lit in this step, 0 otherwise
+ */
+uint8_t ucPatternStep( PatternLed_t *pxLed );
+
+#endif /* PATTERN_H */
@@ -0,0 +1,78 @@
+/**
+ * @file rategroup.c
+ * @brief Per-channel sampling periods from one tick
+ */
+
+#include "rategroup.h"
+#include "task.h"
+
+#define rategroupPERIOD_OF_CHANNEL( ucIndex, usInput, ucPin, usPeriodMs )   \
+    pdMS_TO_TICKS( usPeriodMs ),
+
+static const uint16_t pusDefaultPeriod[ appNUM_CHANNELS ] = { appCHANNELS( rategroupPERIOD_OF_CHANNEL ) };
+
+static uint16_t pusPeriod[ appNUM_CHANNELS ];
+/* Ticks until the channel is due, 1 = on the next tick */
+static uint16_t pusCountdown[ appNUM_CHANNELS ];
+
+void vRateGroupInit( void )
+{
+    uint8_t ucChannel;
+
+    taskENTER_CRITICAL();
+    for( ucChannel = 0; ucChannel < appNUM_CHANNELS; ucChannel++ )
+    {
+        pusPeriod[ ucChannel ] = pusDefaultPeriod[ ucChannel ];
+        pusCountdown[ ucChannel ] = 1;
+    }
+    taskEXIT_CRITICAL();
+}
+
+void vRateGroupSetPeriod( uint8_t ucChannel, uint16_t usTicks )
+{
+    taskENTER_CRITICAL();
+    pusPeriod[ ucChannel ] = usTicks;
+    /* Keep the phase when slowing down, do not wait a full old period when
+    speeding up */
+    if( pusCountdown[ ucChannel ] > usTicks )
+    {
+        pusCountdown[ ucChannel ] = usTicks;
+    }
+    taskEXIT_CRITICAL();
+}
+
+uint16_t usRateGroupGetPeriod( uint8_t ucChannel )
+{
+    return pusPeriod[ ucChannel ];
+}
+
+uint16_t usRateGroupNextDue( void )
+{
+    uint16_t usNext = 0xFFFF;
+    uint8_t ucChannel;
+
+    for( ucChannel = 0; ucChannel < appNUM_CHANNELS; ucChannel++ )
+    {
+        if( pusCountdown[ ucChannel ] < usNext )
+        {
+            usNext = pusCountdown[ ucChannel ];
+        }
+    }
+    return usNext;
+}
+
+uint16_t usRateGroupTick( void )
+{
+    uint16_t usDue = 0;
+    uint8_t ucChannel;
+
+    for( ucChannel = 0; ucChannel < appNUM_CHANNELS; ucChannel++ )
+    {
+        if( --pusCountdown[ ucChannel ] == 0 )
+        {
+            pusCountdown[ ucChannel ] = pusPeriod[ ucChannel ];
+            usDue |= 1U << ucChannel;
+        }
+    }
+    return usDue;
+}
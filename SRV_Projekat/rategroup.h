@@ -0,0 +1,40 @@
+/**
+ * @file rategroup.h
+ * @brief Per-channel sampling periods from one tick
+ *
+ * @details
+ * Every channel counts down its own period in RTOS ticks. On each tick
+ * usRateGroupTick() returns the channels that are due, so the caller can
+ * convert exactly those channels in one ADC sequence. Channels whose
+ * periods share a multiple are due on the same tick and share a sequence.
+ *
+ * usRateGroupTick() is called from the tick interrupt; the other functions
+ * from task level.
+ */
+
+#ifndef RATEGROUP_H
+#define RATEGROUP_H
+
+#include <stdint.h>
+
+#include "app_config.h"
+
+/* Load the periods from appCHANNELS; every channel is due on the next tick */
+void vRateGroupInit( void );
+
+/* Period of one channel in ticks, from the next tick on */
+void vRateGroupSetPeriod( uint8_t ucChannel, uint16_t usTicks );
+
+uint16_t usRateGroupGetPeriod( uint8_t ucChannel );
+
+/**
+ * @brief Advance one tick
+ *
+ * @return bit n set - channel n is due
+ */
+uint16_t usRateGroupTick( void );
+
+/* Ticks until the next channel is due, 1 = on the next tick */
+uint16_t usRateGroupNextDue( void );
+
+#endif /* RATEGROUP_H */
@@ -0,0 +1,99 @@
+/**
+ * @file resolution.c
+ * @brief Per-channel sample resolution
+ */
+
+#include "resolution.h"
+
+typedef struct{
+    uint8_t ucBits;
+    uint8_t ucOversampleLog4;   // 4^n conversions per sample
+    uint8_t ucDigits;
+}ResolutionInfo_t;
+
+static const ResolutionInfo_t pxInfo[] = {
+    {  9, 0, 3 },
+    { 10, 0, 4 },
+    { 12, 0, 4 },
+    { 14, 2, 5 },
+    { 16, 4, 5 }
+};
+
+#define resolutionCOUNT         ( sizeof( pxInfo ) / sizeof( pxInfo[ 0 ] ) )
+
+static const ResolutionInfo_t *prvFind( uint8_t ucBits )
+{
+    uint8_t ucIndex;
+
+    for( ucIndex = 0; ucIndex < resolutionCOUNT; ucIndex++ )
+    {
+        if( pxInfo[ ucIndex ].ucBits == ucBits )
+        {
+            return &pxInfo[ ucIndex ];
+        }
+    }
+    return 0;
+}
+
+bool xResolutionSet( Resolution_t *pxResolution, uint8_t ucBits )
+{
+    if( prvFind( ucBits ) == 0 )
+    {
+        return false;
+    }
+    pxResolution->ucBits = ucBits;
+    pxResolution->ulSum = 0;
+    pxResolution->usCount = 0;
+    return true;
+}
+
+bool xResolutionAdd( Resolution_t *pxResolution, uint16_t usRaw, uint16_t *pusSample )
+{
+    uint8_t ucLog4;
+
+    if( pxResolution->ucBits <= resolutionRAW_BITS )
+    {
+        *pusSample = usRaw >> ( resolutionRAW_BITS - pxResolution->ucBits );
+        return true;
+    }
+
+    /* n extra bits need 4^n conversions, their sum is shifted right by n */
+    ucLog4 = pxResolution->ucBits - resolutionRAW_BITS;
+    pxResolution->ulSum += usRaw;
+    if( ++pxResolution->usCount < ( 1U << ( 2 * ucLog4 ) ) )
+    {
+        return false;
+    }
+    *pusSample = ( uint16_t ) ( pxResolution->ulSum >> ucLog4 );
+    pxResolution->ulSum = 0;
+    pxResolution->usCount = 0;
+    return true;
+}
+
+uint8_t ucResolutionNext( uint8_t ucBits )
+{
+    uint8_t ucIndex;
+
+    for( ucIndex = 0; ucIndex < resolutionCOUNT - 1; ucIndex++ )
+    {
+        if( pxInfo[ ucIndex ].ucBits == ucBits )
+        {
+            return pxInfo[ ucIndex + 1 ].ucBits;
+        }
+    }
+    return pxInfo[ 0 ].ucBits;
+}
+
+uint16_t usResolutionConversions( uint8_t ucBits )
+{
+    const ResolutionInfo_t *pxEntry = prvFind( ucBits );
+
+    return ( pxEntry == 0 ) ? 1 : ( uint16_t ) ( 1U << ( 2 * pxEntry->ucOversampleLog4 ) );
+}
+
+uint8_t ucResolutionDigits( uint8_t ucBits )
+{
+    const ResolutionInfo_t *pxEntry = prvFind( ucBits );
+
+    return ( pxEntry == 0 ) ? resolutionMAX_DIGITS : pxEntry->ucDigits;
+}
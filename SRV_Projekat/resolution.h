@@ -0,0 +1,56 @@
+/**
+ * @file resolution.h
+ * @brief Per-channel sample resolution
+ *
+ * @details
+ * Turns raw 12-bit conversions into samples of the channel's resolution:
+ *  - 9, 10, 12 bit: the conversion shifted right, one sample per conversion
+ *  - 14, 16 bit:    oversampling, the sum of 4^n conversions ( n = 2, 4 )
+ *                   shifted right by n, one sample per 4^n conversions
+ * Oversampling only gains resolution when the input carries at least one
+ * LSB of noise.
+ */
+
+#ifndef RESOLUTION_H
+#define RESOLUTION_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define resolutionRAW_BITS      ( 12 )
+/* Widest sample, 16 bit */
+#define resolutionMAX_DIGITS    ( 5 )
+
+/**
+ * @brief State of one channel
+ */
+typedef struct{
+    uint32_t ulSum;
+    uint16_t usCount;
+    uint8_t  ucBits;
+}Resolution_t;
+
+/**
+ * @brief Select the resolution and discard a partial oversampling block
+ *
+ * @return false if ucBits is not one of 9, 10, 12, 14, 16
+ */
+bool xResolutionSet( Resolution_t *pxResolution, uint8_t ucBits );
+
+/**
+ * @brief Add one raw conversion
+ *
+ * @return true when a sample was completed and written to pusSample
+ */
+bool xResolutionAdd( Resolution_t *pxResolution, uint16_t usRaw, uint16_t *pusSample );
+
+/* Resolution following ucBits in the order 9, 10, 12, 14, 16, 9, ... */
+uint8_t ucResolutionNext( uint8_t ucBits );
+
+/* Conversions per sample */
+uint16_t usResolutionConversions( uint8_t ucBits );
+
+/* Decimal digits of the largest sample */
+uint8_t ucResolutionDigits( uint8_t ucBits );
+
+#endif /* RESOLUTION_H */
@@ -0,0 +1,148 @@
+/**
+ * @file rtos_objects.h
+ * @brief Typed, statically allocated FreeRTOS kernel objects
+ *
+ * @details
+ * Each DEFINE macro declares a kernel object together with the storage it
+ * needs, sized at compile time, and a set of static inline accessors that
+ * forward directly to the FreeRTOS API. Queues get accessors typed on the
+ * item type, so passing a pointer to the wrong structure is a compile error
+ * instead of a silent memory overrun, and the item size is always
+ * sizeof( item type ).
+ *
+ * The accessors are one-line forwards to the underlying API call, so with
+ * optimisation enabled they compile to exactly the same call sequence as the
+ * plain C API (tests/host/test_rtos_objects.sh); the only difference is that
+ * no heap is touched.
+ *
+ * Cost against the heap (xQueueCreate() etc. on heap_1.c), restricted data
+ * model (4-byte pointers, 2-byte alignment, 16-bit ticks), with the
+ * options of FreeRTOSConfig.h:
+ *  - task:            66 B control block + stack
+ *  - queue:           58 B + length x item size
+ *  - binary semaphore 58 B, event group 20 B
+ * heap_1 hands out exactly these sizes with no block header, rounded up to
+ * 2 bytes, so static allocation needs no more RAM. It saves the unused tail
+ * of configTOTAL_HEAP_SIZE and moves every object into .bss, where the
+ * linker map accounts for it per file. Each accessor is a single call with
+ * the same arguments as the plain API call. Only start-up changes: the
+ * static create functions skip pvPortMalloc() and its scheduler
+ * suspend/resume.
+ *
+ * Usage:
+ *  rtosQUEUE_DEFINE( xADCQueue, struct Message, 10 );
+ *  ...
+ *  xADCQueueInit();
+ *  xADCQueueSendFromISR( &message, &xHigherPriorityTaskWoken );
+ *
+ * Requires configSUPPORT_STATIC_ALLOCATION == 1.
+ */
+
+#ifndef RTOS_OBJECTS_H
+#define RTOS_OBJECTS_H
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "semphr.h"
+#include "event_groups.h"
+
+#if( configSUPPORT_STATIC_ALLOCATION != 1 )
+    #error rtos_objects.h requires configSUPPORT_STATIC_ALLOCATION to be set to 1
+#endif
+
+/**
+ * @brief Queue of uxLength items of type xItemType
+ *
+ * Defines the handle xName and the accessors xName##Init, xName##Send,
+ * xName##SendFromISR, xName##Receive and xName##ReceiveFromISR.
+ */
+#define rtosQUEUE_DEFINE( xName, xItemType, uxLength )                                  \
+    static StaticQueue_t    xName##Buffer;                                              \
+    static uint8_t          xName##Storage[ ( uxLength ) * sizeof( xItemType ) ];       \
+    static QueueHandle_t    xName;                                                      \
+    static inline void xName##Init( void )                                              \
+    {                                                                                   \
+        xName = xQueueCreateStatic( ( uxLength ), sizeof( xItemType ),                  \
+                                    xName##Storage, &xName##Buffer );                   \
+    }                                                                                   \
+    static inline BaseType_t xName##Send( const xItemType *pxItem, TickType_t xTicksToWait ) \
+    {                                                                                   \
+        return xQueueSendToBack( xName, pxItem, xTicksToWait );                         \
+    }                                                                                   \
+    static inline BaseType_t xName##SendFromISR( const xItemType *pxItem,               \
+                                                 BaseType_t *pxHigherPriorityTaskWoken ) \
+    {                                                                                   \
+        return xQueueSendToBackFromISR( xName, pxItem, pxHigherPriorityTaskWoken );     \
+    }                                                                                   \
+    static inline BaseType_t xName##Receive( xItemType *pxItem, TickType_t xTicksToWait ) \
+    {                                                                                   \
+        return xQueueReceive( xName, pxItem, xTicksToWait );                            \
+    }                                                                                   \
+    static inline BaseType_t xName##ReceiveFromISR( xItemType *pxItem,                  \
+                                                    BaseType_t *pxHigherPriorityTaskWoken ) \
+    {                                                                                   \
+        return xQueueReceiveFromISR( xName, pxItem, pxHigherPriorityTaskWoken );        \
+    }                                                                                   \
+    typedef int xName##Defined_t
+
+/**
+ * @brief Task with a stack of usStackDepth words
+ *
+ * Defines the handle xName and xName##Init( function, name, priority ).
+ */
+#define rtosTASK_DEFINE( xName, usStackDepth )                                          \
+    static StackType_t      xName##Stack[ ( usStackDepth ) ];                           \
+    static StaticTask_t     xName##TCB;                                                 \
+    static TaskHandle_t     xName;                                                      \
+    static inline void xName##Init( TaskFunction_t pxTaskCode, const char * const pcName, \
+                                    UBaseType_t uxPriority )                            \
+    {                                                                                   \
+        xName = xTaskCreateStatic( pxTaskCode, pcName, ( usStackDepth ), NULL,          \
+                                   uxPriority, xName##Stack, &xName##TCB );             \
+    }                                                                                   \
+    typedef int xName##Defined_t
+
+/**
+ * @brief Binary semaphore
+ *
+ * Defines the handle xName and the accessors xName##Init, xName##Give,
+ * xName##GiveFromISR and xName##Take.
+ */
+#define rtosBINARY_SEMAPHORE_DEFINE( xName )                                            \
+    static StaticSemaphore_t xName##Buffer;                                             \
+    static SemaphoreHandle_t xName;                                                     \
+    static inline void xName##Init( void )                                              \
+    {                                                                                   \
+        xName = xSemaphoreCreateBinaryStatic( &xName##Buffer );                         \
+    }                                                                                   \
+    static inline BaseType_t xName##Give( void )                                        \
+    {                                                                                   \
+        return xSemaphoreGive( xName );                                                 \
+    }                                                                                   \
+    static inline BaseType_t xName##GiveFromISR( BaseType_t *pxHigherPriorityTaskWoken ) \
+    {                                                                                   \
+        return xSemaphoreGiveFromISR( xName, pxHigherPriorityTaskWoken );               \
+    }                                                                                   \
+    static inline BaseType_t xName##Take( TickType_t xTicksToWait )                     \
+    {                                                                                   \
+        return xSemaphoreTake( xName, xTicksToWait );                                   \
+    }                                                                                   \
+    typedef int xName##Defined_t
+
+/**
+ * @brief Event group
+ *
+ * Defines the handle xName and xName##Init. Bits are manipulated with the
+ * regular xEventGroup* API on the handle.
+ */
+#define rtosEVENT_GROUP_DEFINE( xName )                                                 \
+    static StaticEventGroup_t xName##Buffer;                                            \
+    static EventGroupHandle_t xName;                                                    \
+    static inline void xName##Init( void )                                              \
+    {                                                                                   \
+        xName = xEventGroupCreateStatic( &xName##Buffer );                              \
+    }                                                                                   \
+    typedef int xName##Defined_t
+
+#endif /* RTOS_OBJECTS_H */
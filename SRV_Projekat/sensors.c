@@ -0,0 +1,89 @@
+/**
+ * @file sensors.c
+ * @brief On-chip temperature sensor and supply monitor
+ */
+
+#include "sensors.h"
+#include "calibration.h"
+#include "app_config.h"
+
+#include "msp430.h"
+
+/* ADC12CAL words: raw readings at 30 and 85 degC with the sensor reference */
+#define sensorsTLV_T30          ( appSENSOR_VREF_MV == 1500 ? 2 : appSENSOR_VREF_MV == 2000 ? 4 : 6 )
+#define sensorsTLV_T85          ( sensorsTLV_T30 + 1 )
+/* REFCAL word of the sensor reference */
+#define sensorsTLV_REF          ( appSENSOR_VREF_MV == 1500 ? 0 : appSENSOR_VREF_MV == 2000 ? 1 : 2 )
+
+/* Data sheet typical sensor output, 680 mV + 2.55 mV/degC, as a raw reading */
+#define sensorsTYPICAL_CODE( ulCelsius )                                        \
+    ( ( ( 68000UL + 255UL * ( ulCelsius ) ) * 4096UL ) / ( 100UL * appSENSOR_VREF_MV ) )
+
+/* 30 degC in 0.1 K */
+#define sensorsT30              ( sensorsZERO_CELSIUS + 300 )
+
+static uint16_t usT30 = sensorsTYPICAL_CODE( 30 );
+/* 0.1 K per code, Q16 */
+static uint32_t ulTemperatureSlope;
+/* mV per code, Q15, and mV at code 0 */
+static uint32_t ulSupplyScale;
+static int16_t sSupplyOffset;
+
+void vSensorsInit( void )
+{
+    const uint16_t *pusADC;
+    const uint16_t *pusREF;
+    uint8_t ucWords;
+    uint16_t usT85 = sensorsTYPICAL_CODE( 85 );
+    uint32_t ulGain = 32768UL;
+    int16_t sOffset = 0;
+
+    usT30 = sensorsTYPICAL_CODE( 30 );
+    pusADC = pusCalibrationTLV( TLV_ADC12CAL, &ucWords );
+    if( pusADC != 0 )
+    {
+        ulGain = pusADC[ 0 ];
+        sOffset = ( int16_t ) pusADC[ 1 ];
+        if( ( ucWords > sensorsTLV_T85 ) && ( pusADC[ sensorsTLV_T85 ] > pusADC[ sensorsTLV_T30 ] ) )
+        {
+            usT30 = pusADC[ sensorsTLV_T30 ];
+            usT85 = pusADC[ sensorsTLV_T85 ];
+        }
+    }
+    pusREF = pusCalibrationTLV( TLV_REFCAL, &ucWords );
+    if( ( pusREF != 0 ) && ( ucWords > sensorsTLV_REF ) )
+    {
+        ulGain = ( ulGain * pusREF[ sensorsTLV_REF ] + 16384UL ) >> 15;
+    }
+
+    /* 55 degC between the two points; AVcc = 2 x code x Vref / 4096 */
+    ulTemperatureSlope = ( 550UL << 16 ) / ( usT85 - usT30 );
+    ulSupplyScale = ( ulGain * appSENSOR_VREF_MV ) >> 11;
+    sSupplyOffset = ( int16_t ) ( ( ( int32_t ) sOffset * appSENSOR_VREF_MV ) / 2048 );
+}
+
+uint16_t usSensorsConvert( Sensor_t xSensor, uint16_t usRaw )
+{
+    uint16_t usDelta;
+    int32_t lValue;
+
+    switch( xSensor )
+    {
+    case SENSOR_TEMPERATURE:
+        if( usRaw >= usT30 )
+        {
+            usDelta = usRaw - usT30;
+            return ( uint16_t ) ( sensorsT30 + ( ( usDelta * ulTemperatureSlope + 0x8000UL ) >> 16 ) );
+        }
+        usDelta = usT30 - usRaw;
+        lValue = sensorsT30 - ( int32_t ) ( ( usDelta * ulTemperatureSlope + 0x8000UL ) >> 16 );
+        return ( lValue > 0 ) ? ( uint16_t ) lValue : 0;
+
+    case SENSOR_SUPPLY:
+        lValue = ( int32_t ) ( ( usRaw * ulSupplyScale + 0x4000UL ) >> 15 ) + sSupplyOffset;
+        return ( lValue > 0 ) ? ( uint16_t ) lValue : 0;
+
+    default:
+        return usRaw;
+    }
+}
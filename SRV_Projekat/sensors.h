@@ -0,0 +1,50 @@
+/**
+ * @file sensors.h
+ * @brief On-chip temperature sensor and supply monitor
+ *
+ * @details
+ * ADC12 input 10 (temperature sensor) and input 11 ((AVcc - AVss) / 2) are
+ * listed in appCHANNELS like the external inputs, with P6SEL pin 0. They are
+ * converted against the internal reference at appSENSOR_VREF_MV, in
+ * sequences of their own (main.c), and turned into engineering units:
+ *  - temperature in 0.1 K, between the 30 and 85 degC points of the TLV
+ *  - AVcc in mV, corrected with the ADC and REF factors of the TLV
+ * Without TLV data the data sheet typical values are used.
+ *
+ * Both conversions use factors prepared by vSensorsInit(), so converting a
+ * sample takes one multiply and no division.
+ */
+
+#ifndef SENSORS_H
+#define SENSORS_H
+
+#include <stdint.h>
+
+/**
+ * @brief What an ADC12 input measures
+ */
+typedef enum{
+    SENSOR_NONE,            // external input, raw conversions
+    SENSOR_TEMPERATURE,     // 0.1 K
+    SENSOR_SUPPLY           // mV
+}Sensor_t;
+
+/* Sensor_t of an ADC12INCH_x input, a constant expression */
+#define sensorsOF_INPUT( usInput )                                              \
+    ( ( usInput ) == ADC12INCH_10 ? SENSOR_TEMPERATURE :                        \
+      ( usInput ) == ADC12INCH_11 ? SENSOR_SUPPLY : SENSOR_NONE )
+
+/* 0 degC in 0.1 K */
+#define sensorsZERO_CELSIUS     ( 2732 )
+
+/**
+ * @brief Prepare the conversion factors from the TLV (calibration.h)
+ */
+void vSensorsInit( void );
+
+/**
+ * @brief Convert a raw conversion of xSensor, SENSOR_NONE returns it unchanged
+ */
+uint16_t usSensorsConvert( Sensor_t xSensor, uint16_t usRaw );
+
+#endif /* SENSORS_H */
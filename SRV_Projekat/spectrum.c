@@ -0,0 +1,129 @@
+/**
+ * @file spectrum.c
+ * @brief Goertzel spectral analysis of capture blocks
+ *
+ * For a block x[ 0 .. N-1 ] the resonator
+ *      s[ n ] = x[ n ] + c * s[ n-1 ] - s[ n-2 ],  c = 2cos( w )
+ * leaves |X( w )|^2 = s1^2 + s2^2 - c * s1 * s2 in its last two states, and
+ * the peak amplitude of a sine at w is 2 |X( w )| / N.
+ *
+ * A bin reads the block twice, for the mean and for the resonator, and
+ * makes N + 1 multiplier calls: about 340 MSP430X cycles per set and bin
+ * for N = 512, 104 ms for the three bins of both channels at 10 MHz. The
+ * variable shift inside lHALMPYMulS32x16() takes 210 of them. The table
+ * for every supported block length is in tests/host/test_spectrum.c.
+ */
+
+#include "spectrum.h"
+#include "capture.h"
+#include "hal_mpy.h"
+
+#define spectrumCOEFF_SHIFT            ( 14 )
+
+/*
+ * The coefficients are constant expressions: cos( w ) is a Taylor series,
+ * evaluated in Horner form in Q28 with 64-bit integers,
+ *      cos( w ) = 1 - w^2 / 2! ( 1 - w^2 / ( 3 4 ) ( 1 - w^2 / ( 5 6 ) ( ... ) ) )
+ * Up to w^20 / 20! the error is below 2^-28 for w <= pi, far below half an
+ * LSB of the Q14 result.
+ */
+#define spectrumONE_Q28                ( 1LL << 28 )
+/* 2 pi in Q28 */
+#define spectrumTWO_PI_Q28             ( 1686629713LL )
+/* w = 2 pi f / fs and w^2, Q28 */
+#define spectrumW_Q28( usHz )          ( spectrumTWO_PI_Q28 * ( usHz ) / ( long long ) appSPECTRUM_RATE_HZ )
+#define spectrumW2_Q28( usHz )         ( spectrumW_Q28( usHz ) * spectrumW_Q28( usHz ) / spectrumONE_Q28 )
+/* One Horner step, 1 - w^2 / ( n ( n - 1 ) ) t */
+#define spectrumCOS_STEP( usHz, n, t ) ( spectrumONE_Q28 - spectrumW2_Q28( usHz ) * ( t ) / spectrumONE_Q28 / \
+                                         ( ( n ) * ( ( n ) - 1 ) ) )
+#define spectrumCOS_Q28( usHz )                                                                        \
+    spectrumCOS_STEP( usHz, 2, spectrumCOS_STEP( usHz, 4, spectrumCOS_STEP( usHz, 6,                   \
+    spectrumCOS_STEP( usHz, 8, spectrumCOS_STEP( usHz, 10, spectrumCOS_STEP( usHz, 12,                 \
+    spectrumCOS_STEP( usHz, 14, spectrumCOS_STEP( usHz, 16, spectrumCOS_STEP( usHz, 18,                \
+    spectrumCOS_STEP( usHz, 20, spectrumONE_Q28 ) ) ) ) ) ) ) ) ) )
+/* 2cos( w ) in Q14, rounded: cos in Q28 shifted right by 13, offset to stay non-negative */
+#define spectrumCOEFF( usHz )          ( ( spectrumCOS_Q28( usHz ) + spectrumONE_Q28 + 4096 ) / 8192 - 32768 )
+
+#define spectrumLIST_BIN( usHz )       ( usHz ),
+#define spectrumLIST_COEFF( usHz )     ( int16_t ) spectrumCOEFF( usHz ),
+#define spectrumCHECK_BIN( usHz )                                                                      \
+    appSTATIC_ASSERT( ( usHz ) > 0 && 2UL * ( usHz ) <= appSPECTRUM_RATE_HZ &&                         \
+                      spectrumCOEFF( usHz ) >= -32768 && spectrumCOEFF( usHz ) <= 32767,               \
+                      spectrumCheckCoeff##usHz );
+
+static const uint16_t pusBinHz[ spectrumNUM_BINS ] = { appSPECTRUM_BINS( spectrumLIST_BIN ) };
+/* 2cos( 2 pi f / fs ) in Q14 */
+static const int16_t psCoeff[ spectrumNUM_BINS ] = { appSPECTRUM_BINS( spectrumLIST_COEFF ) };
+
+/* Every bin lies in 0 < f <= fs / 2 and its coefficient fits 16 bits */
+appSPECTRUM_BINS( spectrumCHECK_BIN )
+/* The block is the whole capture */
+appSTATIC_ASSERT( spectrumBLOCK_LENGTH == appCAPTURE_DEPTH, spectrumCheckBlockIsCapture );
+
+/**
+ * @brief Integer square root of a 64-bit value
+ */
+static uint32_t prvSqrt64( uint64_t ullValue )
+{
+    uint64_t ullRoot = 0;
+    uint64_t ullBit = 1ULL << 62;
+
+    while( ullBit > ullValue )
+    {
+        ullBit >>= 2;
+    }
+    while( ullBit != 0 )
+    {
+        if( ullValue >= ullRoot + ullBit )
+        {
+            ullValue -= ullRoot + ullBit;
+            ullRoot = ( ullRoot >> 1 ) + ullBit;
+        }
+        else
+        {
+            ullRoot >>= 1;
+        }
+        ullBit >>= 2;
+    }
+    return ( uint32_t ) ullRoot;
+}
+
+uint16_t usSpectrumBinHz( uint8_t ucBin )
+{
+    return pusBinHz[ ucBin ];
+}
+
+uint16_t usSpectrumAmplitude( uint8_t ucChannel, uint8_t ucBin )
+{
+    int16_t sCoeff = psCoeff[ ucBin ];
+    int32_t lS0;
+    int32_t lS1 = 0;
+    int32_t lS2 = 0;
+    int16_t sMean;
+    uint32_t ulSum = 0;
+    int64_t llPower;
+    uint16_t usSet;
+
+    for( usSet = 0; usSet < spectrumBLOCK_LENGTH; usSet++ )
+    {
+        ulSum += usCaptureGetSample( usSet, ucChannel );
+    }
+    sMean = ( int16_t ) ( ulSum >> appSPECTRUM_BLOCK_LOG2 );
+
+    for( usSet = 0; usSet < spectrumBLOCK_LENGTH; usSet++ )
+    {
+        lS0 = ( ( int16_t ) usCaptureGetSample( usSet, ucChannel ) - sMean )
+              + lHALMPYMulS32x16( lS1, sCoeff, spectrumCOEFF_SHIFT ) - lS2;
+        lS2 = lS1;
+        lS1 = lS0;
+    }
+
+    llPower = ( int64_t ) lS1 * lS1 + ( int64_t ) lS2 * lS2
+              - ( int64_t ) lHALMPYMulS32x16( lS1, sCoeff, spectrumCOEFF_SHIFT ) * lS2;
+    if( llPower < 0 )
+    {
+        llPower = 0;
+    }
+
+    return ( uint16_t ) ( ( 2UL * prvSqrt64( ( uint64_t ) llPower ) ) >> appSPECTRUM_BLOCK_LOG2 );
+}
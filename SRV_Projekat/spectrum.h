@@ -0,0 +1,39 @@
+/**
+ * @file spectrum.h
+ * @brief Goertzel spectral analysis of capture blocks
+ *
+ * @details
+ * Computes the amplitude of a few configured frequencies (appSPECTRUM_BINS)
+ * over all 2^appSPECTRUM_BLOCK_LOG2 sets of a frozen capture taken at
+ * appSPECTRUM_RATE_HZ. Each bin is a Goertzel resonator in fixed point:
+ * the coefficient 2cos( 2 pi f / fs ) is a Q14 constant computed by the
+ * compiler and the resonator state is held in 32 bits, its products taken
+ * on the MPY32, so only the amplitudes are produced and no complex spectrum
+ * has to be stored.
+ *
+ * The block mean is removed before filtering, so the DC level of the
+ * channel does not leak into low bins.
+ */
+
+#ifndef SPECTRUM_H
+#define SPECTRUM_H
+
+#include <stdint.h>
+
+#include "app_config.h"
+
+#define spectrumCOUNT_BIN( usHz )      + 1
+#define spectrumNUM_BINS               ( 0 appSPECTRUM_BINS( spectrumCOUNT_BIN ) )
+#define spectrumBLOCK_LENGTH           ( 1U << appSPECTRUM_BLOCK_LOG2 )
+
+/* Frequency of bin ucBin in Hz */
+uint16_t usSpectrumBinHz( uint8_t ucBin );
+
+/**
+ * @brief Amplitude of bin ucBin on channel ucChannel of the frozen capture
+ *
+ * @return peak amplitude in raw ADC LSB
+ */
+uint16_t usSpectrumAmplitude( uint8_t ucChannel, uint8_t ucBin );
+
+#endif /* SPECTRUM_H */
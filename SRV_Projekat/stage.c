@@ -0,0 +1,218 @@
+/**
+ * @file stage.c
+ * @brief Overflow policies and overrun accounting for pipeline queues
+ */
+
+#include "stage.h"
+#include "task.h"
+
+/**
+ * @brief Whether the ucKeySize bytes at ucKeyOffset of pucItem equal pucKey
+ */
+static BaseType_t prvSameKey( const Stage_t *pxStage, const uint8_t *pucItem, const uint8_t *pucKey )
+{
+    uint8_t ucByte;
+
+    for( ucByte = 0; ucByte < pxStage->ucKeySize; ucByte++ )
+    {
+        if( pucItem[ pxStage->ucKeyOffset + ucByte ] != pucKey[ ucByte ] )
+        {
+            return pdFALSE;
+        }
+    }
+    return pdTRUE;
+}
+
+/**
+ * @brief Evict whole groups from the head until uxCount more items fit
+ *
+ * After the oldest item, the items that share its key are evicted too.
+ * The consumer must not take items in between, or it could receive the
+ * tail of a group whose head was evicted: from a task this is called with
+ * the scheduler suspended, and an ISR is never preempted by a task.
+ *
+ * @param pxHigherPriorityTaskWoken     NULL when called from a task
+ *
+ * @return items left in the queue
+ */
+static UBaseType_t prvEvict( Stage_t *pxStage, UBaseType_t uxWaiting, UBaseType_t uxCount,
+                             BaseType_t *pxHigherPriorityTaskWoken )
+{
+    uint8_t pucItem[ stageMAX_ITEM_SIZE ];
+    uint8_t pucKey[ stageMAX_KEY_SIZE ];
+    uint8_t ucByte;
+    BaseType_t xSameGroup = pdFALSE;
+    BaseType_t xReceived;
+
+    while( ( uxWaiting + uxCount > pxStage->uxLength ) || ( xSameGroup != pdFALSE ) )
+    {
+        xReceived = ( pxHigherPriorityTaskWoken == NULL ) ?
+                    xQueueReceive( pxStage->xQueue, pucItem, 0 ) :
+                    xQueueReceiveFromISR( pxStage->xQueue, pucItem, pxHigherPriorityTaskWoken );
+        if( xReceived != pdPASS )
+        {
+            break;
+        }
+        uxWaiting--;
+        pxStage->ulDropped++;
+
+        if( pxStage->ucKeySize == 0 )
+        {
+            continue;
+        }
+        for( ucByte = 0; ucByte < pxStage->ucKeySize; ucByte++ )
+        {
+            pucKey[ ucByte ] = pucItem[ pxStage->ucKeyOffset + ucByte ];
+        }
+        xReceived = ( pxHigherPriorityTaskWoken == NULL ) ?
+                    xQueuePeek( pxStage->xQueue, pucItem, 0 ) :
+                    xQueuePeekFromISR( pxStage->xQueue, pucItem );
+        xSameGroup = ( xReceived == pdPASS ) ? prvSameKey( pxStage, pucItem, pucKey ) : pdFALSE;
+    }
+    return uxWaiting;
+}
+
+void vStageInit( Stage_t *pxStage, QueueHandle_t xQueue, UBaseType_t uxLength,
+                 UBaseType_t uxItemSize, StagePolicy_t xPolicy, uint8_t ucDecimation )
+{
+    configASSERT( uxItemSize <= stageMAX_ITEM_SIZE );
+    configASSERT( ucDecimation > 0 );
+
+    pxStage->xQueue = xQueue;
+    pxStage->uxLength = uxLength;
+    pxStage->uxItemSize = uxItemSize;
+    pxStage->uxHighWater = 0;
+    pxStage->ulDropped = 0;
+    pxStage->xPolicy = xPolicy;
+    pxStage->ucDecimation = ucDecimation;
+    pxStage->ucPhase = 0;
+    pxStage->ucKeyOffset = 0;
+    pxStage->ucKeySize = 0;
+}
+
+void vStageSetGroupKey( Stage_t *pxStage, uint8_t ucKeyOffset, uint8_t ucKeySize )
+{
+    configASSERT( ucKeySize <= stageMAX_KEY_SIZE && ucKeyOffset + ucKeySize <= pxStage->uxItemSize );
+
+    pxStage->ucKeyOffset = ucKeyOffset;
+    pxStage->ucKeySize = ucKeySize;
+}
+
+/**
+ * @brief Decide whether a group is offered to the queue at all
+ *
+ * @param uxWaiting     items in the queue now
+ *
+ * @return pdFALSE if the group was discarded (and counted)
+ */
+static BaseType_t prvAdmit( Stage_t *pxStage, UBaseType_t uxWaiting, UBaseType_t uxCount )
+{
+    switch( pxStage->xPolicy )
+    {
+        case STAGE_BLOCK:
+        case STAGE_DROP_OLDEST:
+            return pdTRUE;
+        case STAGE_DECIMATE:
+            if( uxWaiting * 2 >= pxStage->uxLength )
+            {
+                if( ++pxStage->ucPhase < pxStage->ucDecimation )
+                {
+                    break;
+                }
+            }
+            pxStage->ucPhase = 0;
+            /* fall through */
+        case STAGE_DROP_NEWEST:
+        default:
+            if( uxWaiting + uxCount <= pxStage->uxLength )
+            {
+                return pdTRUE;
+            }
+            break;
+    }
+    pxStage->ulDropped += uxCount;
+    return pdFALSE;
+}
+
+/**
+ * @brief Account for the items of a group that were not queued
+ */
+static void prvAccount( Stage_t *pxStage, UBaseType_t uxWaiting, UBaseType_t uxQueued,
+                        UBaseType_t uxCount )
+{
+    pxStage->ulDropped += uxCount - uxQueued;
+    if( uxWaiting > pxStage->uxHighWater )
+    {
+        pxStage->uxHighWater = uxWaiting;
+    }
+}
+
+UBaseType_t uxStageSend( Stage_t *pxStage, const void *pvItems, UBaseType_t uxCount )
+{
+    const uint8_t *pucItem = ( const uint8_t * ) pvItems;
+    TickType_t xTicksToWait = ( pxStage->xPolicy == STAGE_BLOCK ) ? portMAX_DELAY : 0;
+    UBaseType_t uxWaiting = uxQueueMessagesWaiting( pxStage->xQueue );
+    UBaseType_t uxQueued;
+
+    if( prvAdmit( pxStage, uxWaiting, uxCount ) == pdFALSE )
+    {
+        return 0;
+    }
+
+    if( pxStage->xPolicy == STAGE_DROP_OLDEST )
+    {
+        vTaskSuspendAll();
+        uxWaiting = prvEvict( pxStage, uxWaiting, uxCount, NULL );
+        ( void ) xTaskResumeAll();
+    }
+
+    for( uxQueued = 0; uxQueued < uxCount; uxQueued++ )
+    {
+        if( xQueueSendToBack( pxStage->xQueue, pucItem, xTicksToWait ) != pdPASS )
+        {
+            break;
+        }
+        pucItem += pxStage->uxItemSize;
+    }
+
+    prvAccount( pxStage, uxQueueMessagesWaiting( pxStage->xQueue ), uxQueued, uxCount );
+    return uxQueued;
+}
+
+UBaseType_t uxStageSendFromISR( Stage_t *pxStage, const void *pvItems, UBaseType_t uxCount,
+                                BaseType_t *pxHigherPriorityTaskWoken )
+{
+    const uint8_t *pucItem = ( const uint8_t * ) pvItems;
+    UBaseType_t uxWaiting = uxQueueMessagesWaitingFromISR( pxStage->xQueue );
+    UBaseType_t uxQueued;
+
+    if( prvAdmit( pxStage, uxWaiting, uxCount ) == pdFALSE )
+    {
+        return 0;
+    }
+
+    if( pxStage->xPolicy == STAGE_DROP_OLDEST )
+    {
+        uxWaiting = prvEvict( pxStage, uxWaiting, uxCount, pxHigherPriorityTaskWoken );
+    }
+
+    for( uxQueued = 0; uxQueued < uxCount; uxQueued++ )
+    {
+        if( xQueueSendToBackFromISR( pxStage->xQueue, pucItem, pxHigherPriorityTaskWoken ) != pdPASS )
+        {
+            break;
+        }
+        pucItem += pxStage->uxItemSize;
+    }
+
+    prvAccount( pxStage, uxWaiting + uxQueued, uxQueued, uxCount );
+    return uxQueued;
+}
+
+void vStageGetCounters( Stage_t *pxStage, uint32_t *pulDropped, UBaseType_t *puxHighWater )
+{
+    taskENTER_CRITICAL();
+    *pulDropped = pxStage->ulDropped;
+    *puxHighWater = pxStage->uxHighWater;
+    taskEXIT_CRITICAL();
+}
@@ -0,0 +1,105 @@
+/**
+ * @file stage.h
+ * @brief Overflow policies and overrun accounting for pipeline queues
+ *
+ * @details
+ * A stage wraps the producer side of a queue. Items are sent in groups
+ * (e.g. one ADC sequence) and the stage's policy decides what happens when
+ * the queue cannot take a group:
+ *  - STAGE_BLOCK        wait for space; task context only
+ *  - STAGE_DROP_NEWEST  discard the whole group
+ *  - STAGE_DROP_OLDEST  evict the oldest queued groups to make room
+ *  - STAGE_DECIMATE     while the queue is at least half full only every
+ *                       ucDecimation-th group is taken, the others are
+ *                       discarded; a group that still does not fit is
+ *                       discarded as with STAGE_DROP_NEWEST
+ *
+ * Every item that does not reach the consumer - rejected or evicted - is
+ * counted exactly once, and the highest queue fill level is recorded.
+ *
+ * The queue does not record where groups start, so eviction recognises a
+ * group by a key its items share (vStageSetGroupKey(), e.g. the timestamp
+ * of an ADC sequence): after the oldest item, the following items with the
+ * same key are evicted as well, with the scheduler suspended so the
+ * consumer cannot take part of them in between. Without a key every item
+ * is its own group. A group the consumer has already started is evicted
+ * without the items it has taken.
+ *
+ * Each stage must have a single producer: either one task or ISRs that do
+ * not nest. Consumers only ever free space, so a check for space by the
+ * producer stays valid until it sends.
+ */
+
+#ifndef STAGE_H
+#define STAGE_H
+
+#include <stdint.h>
+
+#include "FreeRTOS.h"
+#include "queue.h"
+
+/* Largest queue item a stage can evict */
+#define stageMAX_ITEM_SIZE      ( 16 )
+/* Largest group key */
+#define stageMAX_KEY_SIZE       ( 4 )
+
+typedef enum{
+    STAGE_BLOCK,
+    STAGE_DROP_NEWEST,
+    STAGE_DROP_OLDEST,
+    STAGE_DECIMATE
+}StagePolicy_t;
+
+typedef struct{
+    QueueHandle_t   xQueue;
+    UBaseType_t     uxLength;
+    UBaseType_t     uxItemSize;
+    UBaseType_t     uxHighWater;
+    uint32_t        ulDropped;
+    StagePolicy_t   xPolicy;
+    uint8_t         ucDecimation;
+    uint8_t         ucPhase;
+    uint8_t         ucKeyOffset;
+    uint8_t         ucKeySize;
+}Stage_t;
+
+/**
+ * @brief Attach a stage to a created queue
+ *
+ * @param uxLength      queue length
+ * @param uxItemSize    queue item size, at most stageMAX_ITEM_SIZE
+ * @param ucDecimation  1 of ucDecimation groups is kept by STAGE_DECIMATE
+ */
+void vStageInit( Stage_t *pxStage, QueueHandle_t xQueue, UBaseType_t uxLength,
+                 UBaseType_t uxItemSize, StagePolicy_t xPolicy, uint8_t ucDecimation );
+
+/**
+ * @brief Items of one group share the ucKeySize bytes at ucKeyOffset
+ *
+ * Only used by STAGE_DROP_OLDEST; ucKeySize 0 (the default) makes every
+ * item a group of its own.
+ */
+void vStageSetGroupKey( Stage_t *pxStage, uint8_t ucKeyOffset, uint8_t ucKeySize );
+
+/**
+ * @brief Send a group of uxCount consecutive items from a task
+ *
+ * @return number of items queued
+ */
+UBaseType_t uxStageSend( Stage_t *pxStage, const void *pvItems, UBaseType_t uxCount );
+
+/**
+ * @brief Send a group of uxCount consecutive items from an ISR
+ *
+ * STAGE_BLOCK behaves as STAGE_DROP_NEWEST.
+ *
+ * @return number of items queued
+ */
+UBaseType_t uxStageSendFromISR( Stage_t *pxStage, const void *pvItems, UBaseType_t uxCount,
+                                BaseType_t *pxHigherPriorityTaskWoken );
+
+/* Consistent copy of the counters, from the producer task or, for stages
+fed by an ISR, from any task */
+void vStageGetCounters( Stage_t *pxStage, uint32_t *pulDropped, UBaseType_t *puxHighWater );
+
+#endif /* STAGE_H */
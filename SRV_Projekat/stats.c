@@ -0,0 +1,86 @@
+/**
+ * @file stats.c
+ * @brief Windowed per-channel statistics
+ */
+
+#include "stats.h"
+#include "hal_mpy.h"
+
+/**
+ * @brief Integer square root, floor( sqrt( ulValue ) )
+ *
+ * Digit-by-digit method, shifts and subtractions only.
+ */
+static uint16_t prvSqrt32( uint32_t ulValue )
+{
+    uint32_t ulRoot = 0;
+    uint32_t ulBit = 1UL << 30;
+
+    while( ulBit > ulValue )
+    {
+        ulBit >>= 2;
+    }
+    while( ulBit != 0 )
+    {
+        if( ulValue >= ulRoot + ulBit )
+        {
+            ulValue -= ulRoot + ulBit;
+            ulRoot = ( ulRoot >> 1 ) + ulBit;
+        }
+        else
+        {
+            ulRoot >>= 1;
+        }
+        ulBit >>= 2;
+    }
+    return ( uint16_t ) ulRoot;
+}
+
+void vStatsInit( StatsWindow_t *pxWindow, uint8_t ucWindowLog2 )
+{
+    pxWindow->ulSum = 0;
+    pxWindow->ulSumOfSquares = 0;
+    pxWindow->usSumOfSquaresHigh = 0;
+    pxWindow->usMin = 0xFFFF;
+    pxWindow->usMax = 0;
+    pxWindow->usCount = 0;
+    pxWindow->ucWindowLog2 = ( ucWindowLog2 > statsMAX_WINDOW_LOG2 ) ? statsMAX_WINDOW_LOG2 : ucWindowLog2;
+}
+
+bool xStatsAdd( StatsWindow_t *pxWindow, uint16_t usSample, StatsSummary_t *pxSummary )
+{
+    uint32_t ulMeanSquare;
+
+    if( usSample < pxWindow->usMin )
+    {
+        pxWindow->usMin = usSample;
+    }
+    if( usSample > pxWindow->usMax )
+    {
+        pxWindow->usMax = usSample;
+    }
+    pxWindow->ulSum += usSample;
+    pxWindow->ulSumOfSquares = ulHALMPYMacU( pxWindow->ulSumOfSquares, usSample, usSample,
+                                             &pxWindow->usSumOfSquaresHigh );
+
+    if( ++pxWindow->usCount < ( 1U << pxWindow->ucWindowLog2 ) )
+    {
+        return false;
+    }
+
+    pxSummary->usMin = pxWindow->usMin;
+    pxSummary->usMax = pxWindow->usMax;
+    pxSummary->usMean = ( uint16_t ) ( pxWindow->ulSum >> pxWindow->ucWindowLog2 );
+    /* The mean square of 16-bit samples is below 2^32, so the high word
+    only contributes the bits shifted down into it */
+    ulMeanSquare = pxWindow->ulSumOfSquares;
+    if( pxWindow->ucWindowLog2 > 0 )
+    {
+        ulMeanSquare = ( ulMeanSquare >> pxWindow->ucWindowLog2 ) |
+                       ( ( uint32_t ) pxWindow->usSumOfSquaresHigh << ( 32 - pxWindow->ucWindowLog2 ) );
+    }
+    pxSummary->usRms = prvSqrt32( ulMeanSquare );
+
+    vStatsInit( pxWindow, pxWindow->ucWindowLog2 );
+    return true;
+}
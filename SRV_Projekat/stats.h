@@ -0,0 +1,60 @@
+/**
+ * @file stats.h
+ * @brief Windowed per-channel statistics
+ *
+ * @details
+ * Accumulates min, max, mean and RMS of a channel over a window of
+ * 2^ucWindowLog2 samples using integer arithmetic only: the mean and the
+ * mean square are obtained by shifting, and the RMS by an integer square
+ * root. Squares are accumulated on the MPY32 through hal_mpy.
+ *
+ * Samples may use all 16 bits (oversampled channels, resolution.h). The
+ * MAC result is 32 bits wide; its carries are counted in a 16-bit high
+ * word, so the sum of squares is 48 bits wide and the plain sum 32 bits,
+ * and windows of up to statsMAX_WINDOW_LOG2 cannot overflow.
+ */
+
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* 256 x 65535 < 2^32 */
+#define statsMAX_WINDOW_LOG2        ( 8 )
+
+/**
+ * @brief Result of one completed window
+ */
+typedef struct{
+    uint16_t usMin;
+    uint16_t usMax;
+    uint16_t usMean;
+    uint16_t usRms;
+}StatsSummary_t;
+
+/**
+ * @brief Running state of one channel
+ */
+typedef struct{
+    uint32_t ulSum;
+    uint32_t ulSumOfSquares;
+    uint16_t usSumOfSquaresHigh;
+    uint16_t usMin;
+    uint16_t usMax;
+    uint16_t usCount;
+    uint8_t  ucWindowLog2;
+}StatsWindow_t;
+
+/* Start an empty window of 2^ucWindowLog2 samples */
+void vStatsInit( StatsWindow_t *pxWindow, uint8_t ucWindowLog2 );
+
+/**
+ * @brief Add one sample to the window
+ *
+ * @return true when the sample completed the window; pxSummary is then
+ *         filled in and the window restarts empty
+ */
+bool xStatsAdd( StatsWindow_t *pxWindow, uint16_t usSample, StatsSummary_t *pxSummary );
+
+#endif /* STATS_H */
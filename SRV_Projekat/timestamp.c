@@ -0,0 +1,61 @@
+/**
+ * @file timestamp.c
+ * @brief Sample timestamps from the RTOS tick and the tick timer
+ *
+ * TA0 sets CCIFG when it reaches TA0CCR0, which is when the tick interrupt
+ * is requested, and rolls over to 0 on the next ACLK edge. A counter value
+ * equal to TA0CCR0 therefore belongs to the new tick (sub-tick 0) and all
+ * other values are shifted up by one. With interrupts disabled the tick
+ * interrupt may be pending; in that case the tick count has not been
+ * advanced yet and is corrected here, unless the flag was only raised after
+ * the counter had been read (counter still in the second half of the tick).
+ */
+
+#include "timestamp.h"
+#include "task.h"
+
+#include "msp430.h"
+
+uint32_t ulTimestampFromISR( void )
+{
+    TickType_t xTicks;
+    uint16_t usCount;
+    uint16_t usCheck;
+    uint16_t usSub;
+
+    /* TA0 runs from ACLK, asynchronously to MCLK: read until two reads agree */
+    usCount = TA0R;
+    do
+    {
+        usCheck = usCount;
+        usCount = TA0R;
+    } while( usCount != usCheck );
+
+    xTicks = xTaskGetTickCountFromISR();
+    usSub = ( usCount == TA0CCR0 ) ? 0 : usCount + 1;
+
+    if( ( TA0CCTL0 & CCIFG ) && ( usSub < timestampSUBTICKS / 2 ) )
+    {
+        xTicks++;
+    }
+
+    return ( ( uint32_t ) xTicks << 16 ) | usSub;
+}
+
+uint32_t ulTimestampGet( void )
+{
+    uint32_t ulStamp;
+
+    taskENTER_CRITICAL();
+    ulStamp = ulTimestampFromISR();
+    taskEXIT_CRITICAL();
+    return ulStamp;
+}
+
+uint32_t ulTimestampElapsed( uint32_t ulFrom, uint32_t ulTo )
+{
+    uint16_t usTicks = timestampTICKS( ulTo ) - timestampTICKS( ulFrom );
+
+    /* The sub-tick difference may be negative, the total is not */
+    return ( uint32_t ) usTicks * timestampSUBTICKS + timestampSUBTICK( ulTo ) - timestampSUBTICK( ulFrom );
+}
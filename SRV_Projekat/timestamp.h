@@ -0,0 +1,55 @@
+/**
+ * @file timestamp.h
+ * @brief Sample timestamps from the RTOS tick and the tick timer
+ *
+ * @details
+ * A timestamp is the RTOS tick count in the upper 16 bits and the position
+ * within the tick in the lower 16 bits. The position is taken from TA0R,
+ * the ACLK counter that generates the tick (util.c), and counts from 0 at
+ * the tick interrupt up to timestampSUBTICKS - 1, so one sub-tick is one
+ * ACLK period (about 30.5 us).
+ *
+ * Timestamps increase monotonically and wrap together with the 16-bit tick
+ * count; differences are taken modulo 2^32 and scaled by timestampSUBTICKS.
+ */
+
+#ifndef TIMESTAMP_H
+#define TIMESTAMP_H
+
+#include <stdint.h>
+
+#include "FreeRTOS.h"
+
+/* Sub-ticks per tick: TA0 counts 0 .. TA0CCR0 in up mode */
+#define timestampSUBTICKS           ( configLFXT_CLOCK_HZ / configTICK_RATE_HZ + 1 )
+
+#define timestampTICKS( ulStamp )       ( ( uint16_t ) ( ( ulStamp ) >> 16 ) )
+#define timestampSUBTICK( ulStamp )     ( ( uint16_t ) ( ulStamp ) )
+
+/* Longest time in sub-ticks interrupts may stay disabled once the tick is
+   due; a tick pending for longer is missed in the timestamps */
+#define timestampMAX_LOCKED         ( timestampSUBTICKS / 2 - 1 )
+
+/**
+ * @brief Timestamp of the current instant
+ *
+ * Must be called with interrupts disabled, i.e. from an ISR, and no later
+ * than timestampMAX_LOCKED sub-ticks after the tick interrupt was due.
+ */
+uint32_t ulTimestampFromISR( void );
+
+/**
+ * @brief Timestamp of the current instant, from a task
+ */
+uint32_t ulTimestampGet( void );
+
+/**
+ * @brief Sub-ticks from ulFrom to the later ulTo
+ */
+uint32_t ulTimestampElapsed( uint32_t ulFrom, uint32_t ulTo );
+
+/* Sub-ticks to microseconds, one sub-tick is one ACLK period; exact for
+   32768 Hz and within 32 bits up to about 8 s */
+#define timestampSUBTICKS_TO_US( ulSub )    ( ( ( ulSub ) * 15625UL ) / ( configLFXT_CLOCK_HZ / 64UL ) )
+
+#endif /* TIMESTAMP_H */
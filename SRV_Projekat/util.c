@@ -13,7 +13,6 @@
 /* FreeRTOS includes. */
 #include "FreeRTOS.h"
 #include "task.h"
-#include "timers.h"
 
 /* Hardware includes. */
 #include "msp430.h"
@@ -21,14 +20,6 @@
 /* User's includes */
 #include "ETF5529_HAL/hal_ETF_5529.h"
 
-/**
- * @brief Tick hook
- */
-void vApplicationTickHook( void )
-{
-    ;
-}
-
 /**
  * @author FreeRTOS
  * @brief Configure Tick
@@ -106,3 +97,21 @@ void vApplicationStackOverflowHook( TaskHandle_t pxTask, char *pcTaskName )
     taskDISABLE_INTERRUPTS();
     for( ;; );
 }
+
+/**
+ * @author FreeRTOS
+ * @brief Provide memory for the Idle task
+ *
+ * Required when configSUPPORT_STATIC_ALLOCATION is 1.
+ */
+void vApplicationGetIdleTaskMemory( StaticTask_t **ppxIdleTaskTCBBuffer,
+                                    StackType_t **ppxIdleTaskStackBuffer,
+                                    uint32_t *pulIdleTaskStackSize )
+{
+    static StaticTask_t xIdleTaskTCB;
+    static StackType_t uxIdleTaskStack[ configMINIMAL_STACK_SIZE ];
+
+    *ppxIdleTaskTCBBuffer = &xIdleTaskTCB;
+    *ppxIdleTaskStackBuffer = uxIdleTaskStack;
+    *pulIdleTaskStackSize = configMINIMAL_STACK_SIZE;
+}
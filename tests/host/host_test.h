@@ -0,0 +1,46 @@
+/**
+ * @file host_test.h
+ * @brief Checks and timing shared by the host tests
+ *
+ * Host timings compare implementations relative to each other on the build
+ * machine; they are not MSP430 cycle counts.
+ *
+ * The repository holds no recorded ADC logs. Tests that need input signals
+ * generate traces from fixed seeds, so every run sees the same samples.
+ */
+
+#ifndef HOST_TEST_H
+#define HOST_TEST_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/* Stop the test with a message when xCondition does not hold */
+#define hostCHECK( xCondition, ... )                                    \
+    do                                                                  \
+    {                                                                   \
+        if( !( xCondition ) )                                           \
+        {                                                               \
+            printf( "%s:%d: check failed: %s\n  ", __FILE__, __LINE__,  \
+                    #xCondition );                                      \
+            printf( __VA_ARGS__ );                                      \
+            printf( "\n" );                                             \
+            exit( 1 );                                                  \
+        }                                                               \
+    } while( 0 )
+
+/* Monotonic time in nanoseconds */
+static inline uint64_t ullHostNowNs( void )
+{
+    struct timespec xNow;
+
+    clock_gettime( CLOCK_MONOTONIC, &xNow );
+    return ( uint64_t ) xNow.tv_sec * 1000000000ULL + ( uint64_t ) xNow.tv_nsec;
+}
+
+/* Keeps a result alive so the optimiser cannot drop a timed loop */
+static volatile uint32_t ulHostSink;
+
+#endif /* HOST_TEST_H */
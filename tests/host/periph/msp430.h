@@ -0,0 +1,201 @@
+/**
+ * @file msp430.h
+ * @brief Host model of the MPY32 and CRC16 registers
+ *
+ * Used instead of stub/msp430.h by the C++ tests (test_xxx.cpp), which
+ * build the HAL with __MSP430__, __MSP430_HAS_MPY32__ and
+ * __MSP430_HAS_CRC__ defined, so its register paths run against this model.
+ * Each register is an object whose assignment and read behave like the
+ * peripheral of the MSP430x5xx family user's guide (SLAU208):
+ *  - MPY32: writing OP2 starts a 16x16 (or 32x16, after MPY32L/H) operation
+ *    in the mode of the last operand 1 register written; writing OP2H
+ *    starts a 32x32 one. MAC/MACS add to RESLO/RESHI, which may be written
+ *    to preload the accumulator; SUMEXT holds the carry (MAC) or the sign
+ *    extension (MPYS, MACS).
+ *  - CRC16: CRCINIRES seeds and returns the CRC-CCITT, CRCDIRB_L feeds one
+ *    byte MSB first.
+ * All other registers come from stub/msp430.h.
+ *
+ * For benchmarks the model counts register accesses and the sections run
+ * with interrupts disabled; on the device each access is a 3 to 5 cycle
+ * MOV to or from an absolute address.
+ */
+
+#ifndef PERIPH_MSP430_H
+#define PERIPH_MSP430_H
+
+#include <stdint.h>
+
+#ifndef HOST_PERIPH
+#define HOST_PERIPH
+#endif
+#include "../stub/msp430.h"
+
+enum eHostReg
+{
+    eMPY, eMPYS, eMAC, eMACS, eOP2, eRESLO, eRESHI, eSUMEXT,
+    eMPY32L, eMPY32H, eMPYS32L, eMPYS32H, eOP2L, eOP2H,
+    eRES0, eRES1, eRES2, eRES3, eCRCINIRES, eCRCDIRB_L
+};
+
+struct xHostMpy
+{
+    uint32_t ulOp1;
+    bool     xOp1Is32;
+    bool     xSigned;
+    bool     xAccumulate;
+    uint16_t usOp2Low;
+    uint64_t ullResult;
+    uint16_t usSumExt;
+    uint32_t ulOperations;
+};
+
+inline xHostMpy xHostMpyState;
+inline uint16_t usHostCrc;
+inline uint32_t ulHostCrcBytes;
+
+/* Register accesses in total, interrupt-disabled sections and the most
+register accesses made in one of them */
+inline uint32_t ulHostAccesses;
+inline uint32_t ulHostLocks;
+inline uint32_t ulHostLongestLock;
+inline uint32_t ulHostLockStart;
+
+static inline void vHostLock( void )
+{
+    ulHostLocks++;
+    ulHostLockStart = ulHostAccesses;
+}
+
+static inline void vHostUnlock( void )
+{
+    if( ulHostAccesses - ulHostLockStart > ulHostLongestLock )
+    {
+        ulHostLongestLock = ulHostAccesses - ulHostLockStart;
+    }
+}
+
+#undef __disable_interrupt
+#undef __set_interrupt_state
+#define __disable_interrupt()           vHostLock()
+#define __set_interrupt_state( x )      ( ( void ) ( x ), vHostUnlock() )
+
+static inline void vHostMpyRun( uint32_t ulOp2, bool xOp2Is32 )
+{
+    xHostMpy &x = xHostMpyState;
+    int64_t llA = x.xOp1Is32 ? ( x.xSigned ? ( int64_t ) ( int32_t ) x.ulOp1 : ( int64_t ) x.ulOp1 )
+                             : ( x.xSigned ? ( int64_t ) ( int16_t ) x.ulOp1 : ( int64_t ) ( uint16_t ) x.ulOp1 );
+    int64_t llB = xOp2Is32 ? ( x.xSigned ? ( int64_t ) ( int32_t ) ulOp2 : ( int64_t ) ulOp2 )
+                           : ( x.xSigned ? ( int64_t ) ( int16_t ) ulOp2 : ( int64_t ) ( uint16_t ) ulOp2 );
+    int64_t llProduct = llA * llB;
+
+    x.ulOperations++;
+    if( x.xAccumulate )
+    {
+        /* 16x16 accumulation into RESLO/RESHI, carry or sign to SUMEXT */
+        uint64_t ullSum = ( uint32_t ) x.ullResult + ( uint64_t ) ( uint32_t ) llProduct;
+        if( x.xSigned )
+        {
+            int64_t llSum = ( int64_t ) ( int32_t ) x.ullResult + ( int32_t ) llProduct;
+            x.usSumExt = ( ( int32_t ) llSum < 0 ) ? 0xFFFF : 0;
+        }
+        else
+        {
+            x.usSumExt = ( uint16_t ) ( ullSum >> 32 );
+        }
+        x.ullResult = ( x.ullResult & 0xFFFFFFFF00000000ULL ) | ( uint32_t ) ullSum;
+    }
+    else
+    {
+        x.ullResult = ( uint64_t ) llProduct;
+        x.usSumExt = ( x.xSigned && llProduct < 0 ) ? 0xFFFF : 0;
+    }
+}
+
+static inline void vHostCrcByte( uint8_t ucByte )
+{
+    int iBit;
+
+    usHostCrc ^= ( uint16_t ) ( ucByte << 8 );
+    for( iBit = 0; iBit < 8; iBit++ )
+    {
+        usHostCrc = ( usHostCrc & 0x8000 ) ? ( uint16_t ) ( ( usHostCrc << 1 ) ^ 0x1021 )
+                                           : ( uint16_t ) ( usHostCrc << 1 );
+    }
+    ulHostCrcBytes++;
+}
+
+static inline void vHostWrite( int iReg, unsigned uValue )
+{
+    xHostMpy &x = xHostMpyState;
+    uint16_t usValue = ( uint16_t ) uValue;
+
+    ulHostAccesses++;
+    switch( iReg )
+    {
+        case eMPY:      x.ulOp1 = usValue; x.xOp1Is32 = false; x.xSigned = false; x.xAccumulate = false; break;
+        case eMPYS:     x.ulOp1 = usValue; x.xOp1Is32 = false; x.xSigned = true;  x.xAccumulate = false; break;
+        case eMAC:      x.ulOp1 = usValue; x.xOp1Is32 = false; x.xSigned = false; x.xAccumulate = true;  break;
+        case eMACS:     x.ulOp1 = usValue; x.xOp1Is32 = false; x.xSigned = true;  x.xAccumulate = true;  break;
+        case eMPY32L:   x.ulOp1 = usValue; x.xSigned = false; x.xAccumulate = false; break;
+        case eMPYS32L:  x.ulOp1 = usValue; x.xSigned = true;  x.xAccumulate = false; break;
+        case eMPY32H:
+        case eMPYS32H:  x.ulOp1 = ( x.ulOp1 & 0xFFFF ) | ( ( uint32_t ) usValue << 16 ); x.xOp1Is32 = true; break;
+        case eOP2:      vHostMpyRun( usValue, false ); break;
+        case eOP2L:     x.usOp2Low = usValue; break;
+        case eOP2H:     vHostMpyRun( x.usOp2Low | ( ( uint32_t ) usValue << 16 ), true ); break;
+        case eRESLO:    x.ullResult = ( x.ullResult & ~0xFFFFULL ) | usValue; break;
+        case eRESHI:    x.ullResult = ( x.ullResult & ~0xFFFF0000ULL ) | ( ( uint64_t ) usValue << 16 ); break;
+        case eCRCINIRES: usHostCrc = usValue; break;
+        case eCRCDIRB_L: vHostCrcByte( ( uint8_t ) uValue ); break;
+        default: break;
+    }
+}
+
+static inline unsigned uHostRead( int iReg )
+{
+    const xHostMpy &x = xHostMpyState;
+
+    ulHostAccesses++;
+    switch( iReg )
+    {
+        case eRESLO:
+        case eRES0:     return ( uint16_t ) x.ullResult;
+        case eRESHI:
+        case eRES1:     return ( uint16_t ) ( x.ullResult >> 16 );
+        case eRES2:     return ( uint16_t ) ( x.ullResult >> 32 );
+        case eRES3:     return ( uint16_t ) ( x.ullResult >> 48 );
+        case eSUMEXT:   return x.usSumExt;
+        case eCRCINIRES: return usHostCrc;
+        default:        return 0;
+    }
+}
+
+template< int iReg > struct xHostRegister
+{
+    xHostRegister &operator=( unsigned uValue ) { vHostWrite( iReg, uValue ); return *this; }
+    operator unsigned() const { return uHostRead( iReg ); }
+};
+
+inline xHostRegister< eMPY >        MPY;
+inline xHostRegister< eMPYS >       MPYS;
+inline xHostRegister< eMAC >        MAC;
+inline xHostRegister< eMACS >       MACS;
+inline xHostRegister< eOP2 >        OP2;
+inline xHostRegister< eRESLO >      RESLO;
+inline xHostRegister< eRESHI >      RESHI;
+inline xHostRegister< eSUMEXT >     SUMEXT;
+inline xHostRegister< eMPY32L >     MPY32L;
+inline xHostRegister< eMPY32H >     MPY32H;
+inline xHostRegister< eMPYS32L >    MPYS32L;
+inline xHostRegister< eMPYS32H >    MPYS32H;
+inline xHostRegister< eOP2L >       OP2L;
+inline xHostRegister< eOP2H >       OP2H;
+inline xHostRegister< eRES0 >       RES0;
+inline xHostRegister< eRES1 >       RES1;
+inline xHostRegister< eRES2 >       RES2;
+inline xHostRegister< eRES3 >       RES3;
+inline xHostRegister< eCRCINIRES >  CRCINIRES;
+inline xHostRegister< eCRCDIRB_L >  CRCDIRB_L;
+
+#endif /* PERIPH_MSP430_H */
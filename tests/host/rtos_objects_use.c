@@ -0,0 +1,95 @@
+/**
+ * @file rtos_objects_use.c
+ * @brief The same kernel object use, typed or on the plain API
+ *
+ * Built twice by test_rtos_objects.sh: with -DTYPED through the accessors
+ * of rtos_objects.h, without it on handles and storage declared by hand
+ * under the names the DEFINE macros give them. Both builds must produce
+ * the same object code.
+ */
+
+#include "rtos_objects.h"
+
+struct Item{
+    uint8_t  ucChannel;
+    uint16_t usValue;
+    uint32_t ulTimestamp;
+};
+
+#define useLENGTH               ( 10 )
+#define useSTACK                ( 128 )
+
+#ifdef TYPED
+
+rtosQUEUE_DEFINE( xItems, struct Item, useLENGTH );
+rtosTASK_DEFINE( xWorker, useSTACK );
+rtosBINARY_SEMAPHORE_DEFINE( xPending );
+rtosEVENT_GROUP_DEFINE( xEvents );
+
+#else
+
+static StaticQueue_t        xItemsBuffer;
+static uint8_t              xItemsStorage[ useLENGTH * sizeof( struct Item ) ];
+static QueueHandle_t        xItems;
+static StackType_t          xWorkerStack[ useSTACK ];
+static StaticTask_t         xWorkerTCB;
+static TaskHandle_t         xWorker;
+static StaticSemaphore_t    xPendingBuffer;
+static SemaphoreHandle_t    xPending;
+static StaticEventGroup_t   xEventsBuffer;
+static EventGroupHandle_t   xEvents;
+
+#endif
+
+void vUseInit( TaskFunction_t pxWorker )
+{
+#ifdef TYPED
+    xItemsInit();
+    xWorkerInit( pxWorker, "Worker", 2 );
+    xPendingInit();
+    xEventsInit();
+#else
+    xItems = xQueueCreateStatic( useLENGTH, sizeof( struct Item ), xItemsStorage, &xItemsBuffer );
+    xWorker = xTaskCreateStatic( pxWorker, "Worker", useSTACK, NULL, 2, xWorkerStack, &xWorkerTCB );
+    xPending = xSemaphoreCreateBinaryStatic( &xPendingBuffer );
+    xEvents = xEventGroupCreateStatic( &xEventsBuffer );
+#endif
+}
+
+BaseType_t xUseFromISR( const struct Item *pxItem )
+{
+    BaseType_t xWoken = pdFALSE;
+    struct Item xItem;
+
+#ifdef TYPED
+    ( void ) xItemsSendFromISR( pxItem, &xWoken );
+    ( void ) xItemsReceiveFromISR( &xItem, &xWoken );
+    ( void ) xPendingGiveFromISR( &xWoken );
+#else
+    ( void ) xQueueSendToBackFromISR( xItems, pxItem, &xWoken );
+    ( void ) xQueueReceiveFromISR( xItems, &xItem, &xWoken );
+    ( void ) xSemaphoreGiveFromISR( xPending, &xWoken );
+#endif
+    return xWoken + xItem.usValue;
+}
+
+uint16_t usUseFromTask( const struct Item *pxItem )
+{
+    struct Item xItem = { 0 };
+
+#ifdef TYPED
+    if( xItemsSend( pxItem, 10 ) == pdPASS && xPendingTake( portMAX_DELAY ) == pdPASS )
+    {
+        ( void ) xItemsReceive( &xItem, 0 );
+        ( void ) xPendingGive();
+    }
+#else
+    if( xQueueSendToBack( xItems, pxItem, 10 ) == pdPASS && xSemaphoreTake( xPending, portMAX_DELAY ) == pdPASS )
+    {
+        ( void ) xQueueReceive( xItems, &xItem, 0 );
+        ( void ) xSemaphoreGive( xPending );
+    }
+#endif
+    ( void ) xEventGroupSetBits( xEvents, 1 );
+    return xItem.usValue;
+}
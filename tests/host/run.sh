@@ -0,0 +1,72 @@
+#!/bin/sh
+#
+# Builds and runs the host tests: tests/host/run.sh [test_xxx ...]
+#
+# Each test_xxx.c names the firmware files it links against on a
+# " * Sources:" line of its header (paths relative to SRV_Projekat) and
+# may add compiler options on a " * Flags:" line. Firmware headers come
+# first from stub/, which stands in for msp430.h and the parts of FreeRTOS
+# a test does not link. test_xxx.cpp tests build everything as C++ with
+# periph/msp430.h, the register model of the MPY32 and CRC16, in front.
+# test_xxx.sh tests compare builds themselves; they are run with COMPILE,
+# the C compiler with the options above, and OUT and HERE set. Tests print
+# their measurements and exit non-zero on the first failed check.
+
+HERE=$(cd "$(dirname "$0")" && pwd)
+PROJ="$HERE/../../SRV_Projekat"
+OUT="${TMPDIR:-/tmp}/srv_host_tests"
+CC="${CC:-gcc}"
+CXX="${CXX:-g++}"
+
+mkdir -p "$OUT" || exit 1
+
+if [ $# -eq 0 ]; then
+    set -- $(cd "$HERE" && ls test_*.c test_*.cpp test_*.sh 2>/dev/null)
+fi
+
+FAILED=""
+for TEST in "$@"; do
+    case "$TEST" in
+        *.c | *.cpp | *.sh) ;;
+        *) TEST=$(cd "$HERE" && ls "$TEST".c "$TEST".cpp "$TEST".sh 2>/dev/null | head -n 1) ;;
+    esac
+    SRC="$HERE/$TEST"
+    TEST=${TEST%.*}
+    case "$SRC" in
+        *.cpp) COMPILE="$CXX -std=gnu++17 -x c++ -DHOST_PERIPH -I$HERE/periph" ;;
+        *) COMPILE="$CC -std=gnu11" ;;
+    esac
+    COMPILE="$COMPILE -O2 -Wall -Wno-unused-function -I$HERE/stub -I$PROJ -I$PROJ/ETF5529_HAL
+             -I$PROJ/FreeRTOS_source/include -I$PROJ/FreeRTOS_source/portable/CCS/MSP430X
+             -include stdbool.h"
+
+    echo "== $TEST"
+    case "$SRC" in
+        *.sh)
+            if ! COMPILE="$COMPILE" OUT="$OUT" HERE="$HERE" sh "$SRC"; then
+                FAILED="$FAILED $TEST"
+            fi
+            continue
+            ;;
+    esac
+    SOURCES=$(sed -n 's/^ \* Sources:[ ]*//p' "$SRC")
+    FLAGS=$(sed -n 's/^ \* Flags:[ ]*//p' "$SRC")
+    FILES=""
+    for F in $SOURCES; do
+        FILES="$FILES $PROJ/$F"
+    done
+
+    if ! $COMPILE $FLAGS -o "$OUT/$TEST" "$SRC" "$HERE/stub/registers.c" $FILES -lm; then
+        FAILED="$FAILED $TEST"
+        continue
+    fi
+    if ! "$OUT/$TEST"; then
+        FAILED="$FAILED $TEST"
+    fi
+done
+
+if [ -n "$FAILED" ]; then
+    echo "FAILED:$FAILED"
+    exit 1
+fi
+echo "all host tests passed"
@@ -0,0 +1,184 @@
+/**
+ * @file msp430.h
+ * @brief Host stand-in for the device header
+ *
+ * Peripheral registers are plain variables (registers.c), so firmware
+ * modules compile and run on the host; writes are only remembered. Names
+ * and bit values are the ones of msp430f5529.h the firmware uses. The
+ * __MSP430_HAS_xxx__ feature macros are not defined, so the HAL selects its
+ * portable paths; periph/msp430.h models the MPY32 and CRC16 registers
+ * for the tests of the register paths.
+ */
+
+#ifndef STUB_MSP430_H
+#define STUB_MSP430_H
+
+#include <stdint.h>
+
+/* registers.c defines the registers, every other file declares them */
+#ifndef SFR16
+#define SFR16( x )  extern volatile unsigned int x;
+#define SFR8( x )   extern volatile unsigned char x;
+#endif
+
+SFR16( WDTCTL )
+SFR16( ADC12CTL0 ) SFR16( ADC12CTL1 ) SFR16( ADC12CTL2 )
+SFR8( ADC12MCTL0 ) SFR8( ADC12MCTL1 ) SFR8( ADC12MCTL2 ) SFR8( ADC12MCTL3 )
+SFR16( ADC12IE ) SFR16( ADC12IFG ) SFR16( ADC12IV )
+SFR16( ADC12MEM0 ) SFR16( ADC12MEM1 ) SFR16( ADC12MEM2 ) SFR16( ADC12MEM3 )
+SFR8( P1DIR ) SFR8( P1OUT ) SFR8( P1SEL ) SFR8( P1REN ) SFR8( P1IN ) SFR8( P1IE ) SFR8( P1IES ) SFR8( P1IFG )
+SFR8( P2DIR ) SFR8( P2OUT ) SFR8( P2SEL ) SFR8( P2IN )
+SFR8( P3DIR ) SFR8( P3OUT ) SFR8( P3IN )
+SFR8( P4DIR ) SFR8( P4OUT ) SFR8( P4SEL ) SFR8( P4IN )
+SFR8( P6DIR ) SFR8( P6OUT ) SFR8( P6SEL ) SFR8( P6IN )
+SFR8( P7DIR ) SFR8( P7OUT ) SFR8( P7IN )
+SFR8( P8DIR ) SFR8( P8OUT ) SFR8( P8IN )
+SFR16( PAOUT ) SFR16( PADIR ) SFR16( PASEL ) SFR16( PBOUT ) SFR16( PBDIR ) SFR16( PBSEL )
+SFR16( PCOUT ) SFR16( PCDIR ) SFR16( PCSEL ) SFR16( PDOUT ) SFR16( PDDIR ) SFR16( PDSEL )
+SFR16( PJOUT ) SFR16( PJDIR )
+SFR8( UCA1CTL1 ) SFR16( UCA1BRW ) SFR8( UCA1MCTL ) SFR8( UCA1IE ) SFR8( UCA1IFG ) SFR16( UCA1IV )
+SFR8( UCA1RXBUF ) SFR8( UCA1TXBUF ) SFR8( UCA1STAT )
+SFR16( TA0CTL ) SFR16( TA0CCR0 )
+#ifdef HOST_TA0_MODEL
+/* TA0 in up mode, counted on by ACLK edges between or during accesses (registers.c) */
+SFR16( usHostTA0R ) SFR16( usHostTA0CCTL0 )
+#define TA0R                ( *pusHostTA0( &usHostTA0R ) )
+#define TA0CCTL0            ( *pusHostTA0( &usHostTA0CCTL0 ) )
+#else
+SFR16( TA0CCTL0 ) SFR16( TA0R )
+#endif
+SFR16( TA1CTL ) SFR16( TA1CCR0 ) SFR16( TA1CCR1 ) SFR16( TA1CCTL0 ) SFR16( TA1CCTL1 ) SFR16( TA1IV ) SFR16( TA1R )
+SFR16( TA2CTL ) SFR16( TA2CCR0 ) SFR16( TA2CCR1 ) SFR16( TA2CCTL0 ) SFR16( TA2CCTL1 ) SFR16( TA2IV ) SFR16( TA2R )
+SFR16( TB0CTL ) SFR16( TB0CCR0 ) SFR16( TB0CCTL0 ) SFR16( TB0R )
+#ifndef HOST_PERIPH
+/* Modelled by periph/msp430.h in the C++ register tests */
+SFR16( MPY ) SFR16( MPYS ) SFR16( MAC ) SFR16( MACS ) SFR16( OP2 ) SFR16( RESLO ) SFR16( RESHI )
+SFR16( SUMEXT ) SFR16( MPY32CTL0 )
+SFR16( MPY32L ) SFR16( MPY32H ) SFR16( MPYS32L ) SFR16( MPYS32H ) SFR16( MACS32L ) SFR16( MACS32H )
+SFR16( OP2L ) SFR16( OP2H ) SFR16( RES0 ) SFR16( RES1 ) SFR16( RES2 ) SFR16( RES3 )
+SFR16( CRCDI ) SFR8( CRCDI_L ) SFR16( CRCDIRB ) SFR8( CRCDIRB_L ) SFR16( CRCINIRES ) SFR16( CRCRESR )
+#endif
+SFR16( REFCTL0 ) SFR16( FCTL1 ) SFR16( FCTL3 ) SFR16( FCTL4 )
+
+#define BIT0                0x01
+#define BIT1                0x02
+#define BIT2                0x04
+#define BIT3                0x08
+#define BIT4                0x10
+#define BIT5                0x20
+#define BIT6                0x40
+#define BIT7                0x80
+
+#define WDTPW               0x5A00
+#define WDTHOLD             0x80
+
+#define ADC12SHT0_2         0x200
+#define ADC12SHT0_8         0x800
+#define ADC12SHT1_8         0x8000
+#define ADC12MSC            0x80
+#define ADC12ON             0x10
+#define ADC12ENC            0x02
+#define ADC12SC             0x01
+#define ADC12REFON          0x20
+#define ADC12REF2_5V        0x40
+#define ADC12SHP            0x200
+#define ADC12CONSEQ_1       0x2
+#define ADC12CONSEQ_3       0x6
+#define ADC12CSTARTADD_0    0
+#define ADC12INCH_0         0
+#define ADC12INCH_1         1
+#define ADC12INCH_10        10
+#define ADC12INCH_11        11
+#define ADC12SREF_0         0
+#define ADC12SREF_1         0x10
+#define ADC12EOS            0x80
+#define ADC12IE0            1
+#define ADC12IE1            2
+#define ADC12IE2            4
+#define ADC12IE3            8
+#define ADC12BUSY           1
+#define ADC12RES_0          0
+#define ADC12RES_2          0x20
+#define ADC12TCOFF          0x10
+
+#define REFMSTR             0x80
+#define REFON               0x01
+#define REFVSEL_0           0
+#define REFVSEL_1           0x10
+#define REFVSEL_2           0x20
+#define REFTCOFF            0x08
+
+#define UCSWRST             1
+#define UCSSEL_2            0x80
+#define UCBRS_6             0x0c
+#define UCBRF_0             0
+#define UCRXIE              1
+#define UCTXIE              2
+#define UCTXIFG             2
+#define UCBUSY              1
+
+#define TASSEL_1            0x100
+#define TASSEL_2            0x200
+#define TACLR               4
+#define MC_1                0x10
+#define MC_2                0x20
+#define MC_3                0x30
+#define MC__UP              0x10
+#define ID_3                0xc0
+#define CCIE                0x10
+#define CCIFG               0x0001
+#define TBSSEL_2            0x200
+#define TBCLR               4
+
+#define LPM0_bits           0x10
+#define GIE                 0x08
+
+#define FWKEY               0xA500
+#define ERASE               0x02
+#define WRT                 0x40
+#define BLKWRT              0x80
+#define LOCK                0x10
+#define BUSY                0x01
+
+#define MPYSAT              0x20
+#define MPYFRAC             0x10
+
+#define TLV_START           0x1A08
+#define TLV_END             0x1AFF
+#define TLV_TAGEND          0xFF
+#define TLV_ADC12CAL        0x11
+#define TLV_REFCAL          0x12
+
+#define TIMER0_A0_VECTOR    53
+#define TIMER0_B0_VECTOR    59
+#define TIMER1_A0_VECTOR    49
+#define TIMER1_A1_VECTOR    48
+#define TIMER2_A0_VECTOR    44
+#define ADC12_VECTOR        54
+#define USCI_A1_VECTOR      46
+#define PORT1_VECTOR        47
+
+#define __even_in_range( a, b )         ( a )
+#define __bis_SR_register( x )          ( ( void ) 0 )
+#define __bic_SR_register_on_exit( x )  ( ( void ) 0 )
+#define __disable_interrupt()           ( ( void ) 0 )
+#define __enable_interrupt()            ( ( void ) 0 )
+#define __get_interrupt_state()         0u
+#define __set_interrupt_state( x )      ( ( void ) ( x ) )
+#define __no_operation()                ( ( void ) 0 )
+#define __delay_cycles( x )             ( ( void ) 0 )
+#define _disable_interrupt()            ( ( void ) 0 )
+#define _enable_interrupt()             ( ( void ) 0 )
+#define _nop()                          ( ( void ) 0 )
+typedef unsigned int __istate_t;
+
+#ifdef HOST_TA0_MODEL
+/* Access to TA0 ulHostTA0EdgeAt from now (1 = the next one) sees an ACLK
+   edge; 0 for none. A counter read during the edge returns any value. */
+extern uint32_t ulHostTA0EdgeAt;
+volatile unsigned int *pusHostTA0( volatile unsigned int *pusRegister );
+/* One ACLK edge: count up to TA0CCR0, setting CCIFG there, then back to 0 */
+void vHostTA0Edge( void );
+#endif
+
+#endif /* STUB_MSP430_H */
@@ -0,0 +1,46 @@
+/**
+ * @file registers.c
+ * @brief Storage of the registers declared by the host msp430.h
+ *
+ * With HOST_TA0_MODEL, TA0R and TA0CCTL0 go through pusHostTA0(), which
+ * lets the tick timer count on between two accesses or during one.
+ */
+
+#define SFR16( x )  volatile unsigned int x;
+#define SFR8( x )   volatile unsigned char x;
+
+#include "msp430.h"
+
+#ifdef HOST_TA0_MODEL
+uint32_t ulHostTA0EdgeAt;
+
+void vHostTA0Edge( void )
+{
+    if( usHostTA0R == TA0CCR0 )
+    {
+        usHostTA0R = 0;
+    }
+    else if( ++usHostTA0R == TA0CCR0 )
+    {
+        usHostTA0CCTL0 |= CCIFG;
+    }
+}
+
+volatile unsigned int *pusHostTA0( volatile unsigned int *pusRegister )
+{
+    static volatile unsigned int usGlitch;
+    unsigned int usBefore = usHostTA0R;
+
+    if( ulHostTA0EdgeAt != 0 && --ulHostTA0EdgeAt == 0 )
+    {
+        vHostTA0Edge();
+        if( pusRegister == &usHostTA0R )
+        {
+            /* Bits caught changing: neither the old nor the new count */
+            usGlitch = ( usBefore ^ usHostTA0R ) << 8 | usHostTA0R;
+            return &usGlitch;
+        }
+    }
+    return pusRegister;
+}
+#endif
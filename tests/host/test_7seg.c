@@ -0,0 +1,212 @@
+/**
+ * @file test_7seg.c
+ * @brief Glyph table of hal_7seg against the segment pin definitions
+ *
+ * Sources: ETF5529_HAL/hal_7seg.c
+ *
+ * For every glyph and segment port the set and clear masks of
+ * pxHAL7SEGGlyphs[] must be disjoint and together cover exactly the pins
+ * HAL_7SEG_SEGMENT_x_PORT and _MASK put on that port. Written from
+ * all-high and from all-low ports, each glyph must light exactly the
+ * segments named for it below and leave the other pins alone. Digits 0-9
+ * must leave the ports as the old vHAL7SEGWriteDigit() switch did, one
+ * HAL_7SEG_SEGMENT_x_ON or _OFF per segment, and out-of-range glyphs must
+ * be rejected.
+ *
+ * The cycle counts come from the MSP430X instruction timings (SLAU208,
+ * format I) applied to the masks in hal_7seg.h: the old switch pays one
+ * bis.b / bic.b #mask,&PxOUT per segment, 4 cycles when the mask comes
+ * from the constant generator and 5 otherwise; the table pays one
+ * mov.b &PxOUT,Rn / bis.b x(Rm),Rn / bic.b y(Rm),Rn / mov.b Rn,&PxOUT
+ * per port. Call and return are the same for both and not counted.
+ */
+
+#include <string.h>
+
+#include "host_test.h"
+#include "msp430.h"
+#include "hal_7seg.h"
+
+/* cmp.b #10,r12; jhs; rla.w r12; br table(r12); jmp to the exit */
+#define testOLD_DISPATCH        ( 2 + 2 + 1 + 3 + 2 )
+/* cmp.b #19,r12; jhs; rlam.w #3,r12; adda #table,r12 */
+#define testNEW_DISPATCH        ( 2 + 2 + 3 + 3 )
+/* The inline macro in the display ISR has no range check */
+#define testMACRO_DISPATCH      ( 3 + 3 )
+#define testNEW_PORT            ( 3 + 3 + 3 + 4 )
+#define testROUNDS              ( 10000000UL )
+
+/* Lit segments of each glyph */
+static const char * const pcLit[ HAL_7SEG_NUM_GLYPHS ] = {
+    "abcdef", "bc", "abdeg", "abcdg", "bcfg", "acdfg", "acdefg", "abc", "abcdefg", "abcfg",
+    "abcefg", "cdefg", "adef", "bcdeg", "adefg", "aefg", "", "g", "adg"
+};
+
+static volatile unsigned char * const pucPort[ HAL_7SEG_NUM_PORTS ] = { &P2OUT, &P3OUT, &P4OUT, &P8OUT };
+
+static const struct{
+    volatile unsigned char *pucOut;
+    uint8_t ucMask;
+}pxSegment[ 7 ] = {
+    { &HAL_7SEG_SEGMENT_A_OUT, HAL_7SEG_SEGMENT_A_MASK },
+    { &HAL_7SEG_SEGMENT_B_OUT, HAL_7SEG_SEGMENT_B_MASK },
+    { &HAL_7SEG_SEGMENT_C_OUT, HAL_7SEG_SEGMENT_C_MASK },
+    { &HAL_7SEG_SEGMENT_D_OUT, HAL_7SEG_SEGMENT_D_MASK },
+    { &HAL_7SEG_SEGMENT_E_OUT, HAL_7SEG_SEGMENT_E_MASK },
+    { &HAL_7SEG_SEGMENT_F_OUT, HAL_7SEG_SEGMENT_F_MASK },
+    { &HAL_7SEG_SEGMENT_G_OUT, HAL_7SEG_SEGMENT_G_MASK }
+};
+
+/* One case of the old switch: every segment on or off, a to g */
+#define testOLD_SEGMENT( seg, ucSegments )                                  \
+    if( ( ucSegments ) & HAL_7SEG_BIT_##seg ) { HAL_7SEG_SEGMENT_##seg##_ON; } \
+    else { HAL_7SEG_SEGMENT_##seg##_OFF; }
+
+static void prvOldWriteDigit( uint8_t ucDigit )
+{
+    static const uint8_t pucOld[ 10 ] = { 0x3F, 0x06, 0x5B, 0x4F, 0x66, 0x6D, 0x7D, 0x07, 0x7F, 0x67 };
+    uint8_t ucSegments = pucOld[ ucDigit ];
+
+    testOLD_SEGMENT( A, ucSegments )
+    testOLD_SEGMENT( B, ucSegments )
+    testOLD_SEGMENT( C, ucSegments )
+    testOLD_SEGMENT( D, ucSegments )
+    testOLD_SEGMENT( E, ucSegments )
+    testOLD_SEGMENT( F, ucSegments )
+    testOLD_SEGMENT( G, ucSegments )
+}
+
+static void prvFill( uint8_t ucValue )
+{
+    uint8_t ucPort;
+
+    for( ucPort = 0; ucPort < HAL_7SEG_NUM_PORTS; ucPort++ )
+    {
+        *pucPort[ ucPort ] = ucValue;
+    }
+}
+
+/* Segment pins of port ucPort */
+static uint8_t prvPortPins( uint8_t ucPort )
+{
+    uint8_t ucPins = 0;
+    uint8_t ucSegment;
+
+    for( ucSegment = 0; ucSegment < 7; ucSegment++ )
+    {
+        ucPins |= ( pxSegment[ ucSegment ].pucOut == pucPort[ ucPort ] ) ? pxSegment[ ucSegment ].ucMask : 0;
+    }
+    return ucPins;
+}
+
+static void prvCheckGlyphs( void )
+{
+    const hal_7seg_glyph_t *pxGlyph;
+    uint8_t pucOld[ HAL_7SEG_NUM_PORTS ];
+    uint8_t ucGlyph;
+    uint8_t ucPort;
+    uint8_t ucSegment;
+    uint8_t ucFill;
+    bool xLit;
+
+    for( ucGlyph = 0; ucGlyph < HAL_7SEG_NUM_GLYPHS; ucGlyph++ )
+    {
+        pxGlyph = &pxHAL7SEGGlyphs[ ucGlyph ];
+        for( ucPort = 0; ucPort < HAL_7SEG_NUM_PORTS; ucPort++ )
+        {
+            hostCHECK( ( pxGlyph->pucSet[ ucPort ] & pxGlyph->pucClear[ ucPort ] ) == 0 &&
+                       ( pxGlyph->pucSet[ ucPort ] | pxGlyph->pucClear[ ucPort ] ) == prvPortPins( ucPort ),
+                       "glyph %u port %u: set 0x%02x clear 0x%02x, segment pins 0x%02x", ucGlyph, ucPort,
+                       pxGlyph->pucSet[ ucPort ], pxGlyph->pucClear[ ucPort ], prvPortPins( ucPort ) );
+        }
+
+        for( ucFill = 0; ucFill < 2; ucFill++ )
+        {
+            prvFill( ucFill ? 0xFF : 0x00 );
+            hostCHECK( ucHAL7SEGWriteGlyph( ucGlyph ) == 0, "glyph %u rejected", ucGlyph );
+            for( ucSegment = 0; ucSegment < 7; ucSegment++ )
+            {
+                xLit = ( *pxSegment[ ucSegment ].pucOut & pxSegment[ ucSegment ].ucMask ) == 0;
+                hostCHECK( xLit == ( strchr( pcLit[ ucGlyph ], 'a' + ucSegment ) != NULL ),
+                           "glyph %u segment %c %s", ucGlyph, 'a' + ucSegment, xLit ? "lit" : "dark" );
+            }
+            for( ucPort = 0; ucPort < HAL_7SEG_NUM_PORTS; ucPort++ )
+            {
+                hostCHECK( ( *pucPort[ ucPort ] & ~prvPortPins( ucPort ) ) ==
+                           ( ( ucFill ? 0xFF : 0x00 ) & ~prvPortPins( ucPort ) ),
+                           "glyph %u changed other pins of port %u", ucGlyph, ucPort );
+            }
+        }
+
+        if( ucGlyph < 10 )
+        {
+            prvFill( 0x5A );
+            prvOldWriteDigit( ucGlyph );
+            for( ucPort = 0; ucPort < HAL_7SEG_NUM_PORTS; ucPort++ )
+            {
+                pucOld[ ucPort ] = *pucPort[ ucPort ];
+            }
+            prvFill( 0x5A );
+            hostCHECK( vHAL7SEGWriteDigit( ucGlyph ) == 0, "digit %u rejected", ucGlyph );
+            for( ucPort = 0; ucPort < HAL_7SEG_NUM_PORTS; ucPort++ )
+            {
+                hostCHECK( *pucPort[ ucPort ] == pucOld[ ucPort ], "digit %u port %u: 0x%02x, old 0x%02x",
+                           ucGlyph, ucPort, *pucPort[ ucPort ], pucOld[ ucPort ] );
+            }
+        }
+    }
+
+    hostCHECK( ucHAL7SEGWriteGlyph( HAL_7SEG_NUM_GLYPHS ) != 0 && vHAL7SEGWriteDigit( 10 ) != 0,
+               "glyph out of range accepted" );
+    printf( "  %u glyphs: masks cover the segment pins of %u ports, digits match the old switch\n",
+            HAL_7SEG_NUM_GLYPHS, HAL_7SEG_NUM_PORTS );
+}
+
+static void prvCycles( void )
+{
+    unsigned uOld = testOLD_DISPATCH;
+    unsigned uSegment;
+    uint64_t ullStart;
+    uint64_t ullOld;
+    uint64_t ullNew;
+    uint32_t ulRound;
+
+    for( uSegment = 0; uSegment < 7; uSegment++ )
+    {
+        switch( pxSegment[ uSegment ].ucMask )
+        {
+            case 0x01: case 0x02: case 0x04: case 0x08:
+                uOld += 4;
+                break;
+            default:
+                uOld += 5;
+                break;
+        }
+    }
+    printf( "  MSP430X cycles per digit: old switch %u (7 port writes), table %u, "
+            "inline in the display ISR %u (%u port writes)\n", uOld,
+            testNEW_DISPATCH + HAL_7SEG_NUM_PORTS * testNEW_PORT,
+            testMACRO_DISPATCH + HAL_7SEG_NUM_PORTS * testNEW_PORT, HAL_7SEG_NUM_PORTS );
+
+    ullStart = ullHostNowNs();
+    for( ulRound = 0; ulRound < testROUNDS; ulRound++ )
+    {
+        prvOldWriteDigit( ( uint8_t ) ( ulRound % 10 ) );
+    }
+    ullOld = ullHostNowNs() - ullStart;
+    ullStart = ullHostNowNs();
+    for( ulRound = 0; ulRound < testROUNDS; ulRound++ )
+    {
+        ( void ) vHAL7SEGWriteDigit( ( uint8_t ) ( ulRound % 10 ) );
+    }
+    ullNew = ullHostNowNs() - ullStart;
+    printf( "  host ns per digit: old switch %.2f, table %.2f\n",
+            ( double ) ullOld / testROUNDS, ( double ) ullNew / testROUNDS );
+}
+
+int main( void )
+{
+    prvCheckGlyphs();
+    prvCycles();
+    return 0;
+}
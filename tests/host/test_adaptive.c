@@ -0,0 +1,182 @@
+/**
+ * @file test_adaptive.c
+ * @brief Conversions and reconstruction error of adaptive mode on traces
+ *
+ * Sources: adaptive.c
+ *
+ * One hour traces at the fastest adaptive period
+ * (appADAPTIVE_MIN_PERIOD_MS) also serve as the reference: an idle input, a
+ * slow drift, a level with steps, a ramp and a sine burst on a quiet level,
+ * each with one LSB of noise. Every trace is sampled as Task1 does in
+ * adaptive mode - the ADC runs at the fastest level of the selected
+ * channels, xAdaptiveAdd() decides which samples are sent and the channels
+ * are rebased when that level changes - and at the fixed 1 s rate the mode
+ * replaces. The receiver holds the last sent value; the test reports ADC
+ * sequences, sent lines and the mean and worst error of the held value
+ * against the reference.
+ *
+ * It fails if adaptive mode converts more than the fixed rate on the idle
+ * trace, or if it tracks the active part of the burst trace worse than
+ * the fixed rate.
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "host_test.h"
+#include "app_config.h"
+#include "adaptive.h"
+
+#define testFIXED_MS            ( 1000 )
+#define testSTEPS               ( 3600UL * 1000UL / appADAPTIVE_MIN_PERIOD_MS )
+#define testFIXED_STEPS         ( testFIXED_MS / appADAPTIVE_MIN_PERIOD_MS )
+#define testTRACES              ( 5 )
+/* Active part of the burst trace, in steps */
+#define testBURST_START         ( 900UL * 1000UL / appADAPTIVE_MIN_PERIOD_MS )
+#define testBURST_END           ( 960UL * 1000UL / appADAPTIVE_MIN_PERIOD_MS )
+
+static const char * const pcTraces[ testTRACES ] = { "idle", "drift", "steps", "ramp", "burst" };
+
+static uint32_t ulSeed;
+
+static uint32_t prvRandom32( void )
+{
+    ulSeed ^= ulSeed << 13;
+    ulSeed ^= ulSeed >> 17;
+    ulSeed ^= ulSeed << 5;
+    return ulSeed;
+}
+
+/* Input of iTrace at step ulStep, before the noise */
+static double prvTruth( int iTrace, uint32_t ulStep )
+{
+    double dSeconds = ulStep * ( appADAPTIVE_MIN_PERIOD_MS / 1000.0 );
+
+    switch( iTrace )
+    {
+        case 0:     /* idle */
+            return 2048.0;
+        case 1:     /* drift: 300 LSB over the hour */
+            return 1500.0 + 300.0 * sin( 3.14159265 * dSeconds / 3600.0 );
+        case 2:     /* steps of 100 LSB every ten minutes */
+            return 1000.0 + 100.0 * floor( dSeconds / 600.0 );
+        case 3:     /* ramp of 0.8 LSB/s for 100 s out of a quiet level */
+            return 1000.0 + 0.8 * fmin( fmax( dSeconds - 2600.0, 0.0 ), 100.0 );
+        default:    /* 60 LSB sine burst of 4 s period for a minute */
+            return 2048.0 + ( ( ulStep >= testBURST_START && ulStep < testBURST_END ) ?
+                              60.0 * sin( 6.2831853 * dSeconds / 4.0 ) : 0.0 );
+    }
+}
+
+typedef struct{
+    uint32_t ulSequences;
+    uint32_t ulLines;
+    double dError;
+    double dBurstError;
+    int iWorst;
+}Result_t;
+
+/* Adds the error of the held value at one reference step */
+static void prvError( Result_t *pxResult, uint16_t usReference, uint16_t usHeld, uint32_t ulStep )
+{
+    int iError = abs( ( int ) usReference - ( int ) usHeld );
+
+    pxResult->dError += iError;
+    if( ulStep >= testBURST_START && ulStep < testBURST_END )
+    {
+        pxResult->dBurstError += iError;
+    }
+    if( iError > pxResult->iWorst )
+    {
+        pxResult->iWorst = iError;
+    }
+}
+
+static void prvRun( int iTrace, Result_t *pxAdaptive, Result_t *pxFixed )
+{
+    Adaptive_t xAdaptive;
+    uint8_t ucBaseLevel;
+    uint32_t ulNext = 0;
+    uint32_t ulStep;
+    uint16_t usSample;
+    uint16_t usHeld = 0;
+    uint16_t usFixed = 0;
+
+    ulSeed = 0x2345678U + ( uint32_t ) iTrace;
+    vAdaptiveInit( &xAdaptive );
+    ucBaseLevel = xAdaptive.ucLevel;
+
+    for( ulStep = 0; ulStep < testSTEPS; ulStep++ )
+    {
+        usSample = ( uint16_t ) lround( prvTruth( iTrace, ulStep ) ) +
+                   ( uint16_t ) ( prvRandom32() % 3U ) - 1U;
+
+        if( ulStep % testFIXED_STEPS == 0 )
+        {
+            pxFixed->ulSequences++;
+            pxFixed->ulLines++;
+            usFixed = usSample;
+        }
+
+        if( ulStep == ulNext )
+        {
+            pxAdaptive->ulSequences++;
+            if( xAdaptiveAdd( &xAdaptive, usSample, ucBaseLevel ) )
+            {
+                pxAdaptive->ulLines++;
+                usHeld = usSample;
+            }
+            /* prvAdaptiveRebase() with the one channel selected */
+            if( xAdaptive.ucLevel != ucBaseLevel )
+            {
+                ucBaseLevel = xAdaptive.ucLevel;
+                vAdaptiveRebase( &xAdaptive );
+            }
+            ulNext = ulStep + ( 1UL << ucBaseLevel );
+        }
+
+        prvError( pxAdaptive, usSample, usHeld, ulStep );
+        prvError( pxFixed, usSample, usFixed, ulStep );
+    }
+}
+
+int main( void )
+{
+    Result_t xAdaptive;
+    Result_t xFixed;
+    int iTrace;
+
+    printf( "  %lu steps of %d ms; levels %d..%d ms, threshold %d LSB, hold %d\n", testSTEPS,
+            appADAPTIVE_MIN_PERIOD_MS, appADAPTIVE_MIN_PERIOD_MS,
+            appADAPTIVE_MIN_PERIOD_MS << ( appADAPTIVE_LEVELS - 1 ), appADAPTIVE_THRESHOLD,
+            appADAPTIVE_HOLD );
+    for( iTrace = 0; iTrace < testTRACES; iTrace++ )
+    {
+        memset( &xAdaptive, 0, sizeof( xAdaptive ) );
+        memset( &xFixed, 0, sizeof( xFixed ) );
+        prvRun( iTrace, &xAdaptive, &xFixed );
+
+        printf( "  %-5s fixed %4lu sequences, error %5.2f LSB, worst %3d; "
+                "adaptive %5lu sequences (%+6.1f %%), %5lu lines, error %5.2f LSB, worst %3d\n",
+                pcTraces[ iTrace ], ( unsigned long ) xFixed.ulSequences,
+                xFixed.dError / testSTEPS, xFixed.iWorst,
+                ( unsigned long ) xAdaptive.ulSequences,
+                100.0 * ( ( double ) xAdaptive.ulSequences / xFixed.ulSequences - 1.0 ),
+                ( unsigned long ) xAdaptive.ulLines, xAdaptive.dError / testSTEPS,
+                xAdaptive.iWorst );
+
+        if( iTrace == 0 )
+        {
+            hostCHECK( xAdaptive.ulSequences < xFixed.ulSequences,
+                       "idle: %lu adaptive sequences", ( unsigned long ) xAdaptive.ulSequences );
+        }
+        if( iTrace == testTRACES - 1 )
+        {
+            printf( "        burst error: fixed %5.2f LSB, adaptive %5.2f LSB\n",
+                    xFixed.dBurstError / ( testBURST_END - testBURST_START ),
+                    xAdaptive.dBurstError / ( testBURST_END - testBURST_START ) );
+            hostCHECK( xAdaptive.dBurstError < xFixed.dBurstError, "burst tracked worse" );
+        }
+    }
+    return 0;
+}
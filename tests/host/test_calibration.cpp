@@ -0,0 +1,213 @@
+/**
+ * @file test_calibration.cpp
+ * @brief Calibration kernel accuracy, two-point calibration and benchmark
+ *
+ * Sources: ETF5529_HAL/hal_mpy.c ETF5529_HAL/hal_crc.c
+ * Flags: -D__MSP430__ -D__MSP430_HAS_MPY32__
+ *
+ * calibration.c is included so the test can load factors with prvSet()
+ * instead of reading the TLV and information memory at their device
+ * addresses; the flash functions are replaced by a copy of the record.
+ *
+ * vCalibrationApply() runs through the MPY32 block scaler of the register
+ * model and is compared with raw * gain + offset rounded and clamped, over
+ * every code and a grid of gains and offsets. A simulated ADC with a gain
+ * error of 0.987 and an offset of +7.3 LSB is then calibrated from two
+ * averaged points as the 'k' command does, from identity and from other
+ * active factors, and must read within 2 LSB everywhere: the ADC code, the
+ * integer offset and the corrected code are each rounded to half an LSB.
+ *
+ * The benchmark reports the multiplier register accesses per sample and
+ * the longest interrupt-disabled section of one calibrationBENCH_LENGTH
+ * block, and the host time per sample; the device cycle count comes from
+ * usCalibrationBenchmark() with appCAL_BENCHMARK set.
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "host_test.h"
+#include "msp430.h"
+#include "../../SRV_Projekat/calibration.c"
+
+/* Last record written to information memory D */
+static CalibrationUser_t xStored;
+static uint32_t ulErases;
+
+void vHALFlashErase( void *pvSegment, uint16_t usSize )
+{
+    ( void ) pvSegment;
+    ( void ) usSize;
+    memset( &xStored, 0xFF, sizeof( xStored ) );
+    ulErases++;
+}
+
+void vHALFlashWrite( void *pvDest, const void *pvSource, uint16_t usLength )
+{
+    hostCHECK( pvDest == ( const void * ) calUSER_RECORD && usLength == sizeof( xStored ),
+               "write of %u bytes outside the user record", usLength );
+    memcpy( &xStored, pvSource, usLength );
+}
+
+static uint16_t prvExact( uint16_t usRaw, uint16_t usG, int16_t sO )
+{
+    double dValue = floor( usRaw * ( usG / 32768.0 ) + sO + 0.5 );
+
+    return ( uint16_t ) fmin( fmax( dValue, 0.0 ), calibrationMAX_CODE );
+}
+
+static void prvCheckKernel( void )
+{
+    static uint16_t pusBlock[ calibrationMAX_CODE + 1 ];
+    uint32_t ulCodes = 0;
+    uint32_t ulExact = 0;
+    uint32_t ulGain;
+    int32_t lOffset;
+    uint16_t usRaw;
+    uint16_t usExpected;
+
+    for( ulGain = calGAIN_MIN; ulGain <= calGAIN_MAX; ulGain += 997 )
+    {
+        for( lOffset = -200; lOffset <= 200; lOffset += 37 )
+        {
+            prvSet( ( uint16_t ) ulGain, ( int16_t ) lOffset, CALIBRATION_USER );
+            /* Blocks of up to 255 conversions, as the ISR passes them */
+            for( usRaw = 0; usRaw <= calibrationMAX_CODE; usRaw++ )
+            {
+                pusBlock[ usRaw ] = usRaw;
+            }
+            for( usRaw = 0; usRaw <= calibrationMAX_CODE; usRaw += 255 )
+            {
+                vCalibrationApply( &pusBlock[ usRaw ],
+                                   ( uint8_t ) ( ( calibrationMAX_CODE + 1 - usRaw < 255 ) ?
+                                                 calibrationMAX_CODE + 1 - usRaw : 255 ) );
+            }
+            for( usRaw = 0; usRaw <= calibrationMAX_CODE; usRaw++ )
+            {
+                usExpected = prvExact( usRaw, ( uint16_t ) ulGain, ( int16_t ) lOffset );
+                hostCHECK( abs( ( int ) pusBlock[ usRaw ] - ( int ) usExpected ) <= 1,
+                           "gain %lu offset %ld raw %u: %u, expected %u", ( unsigned long ) ulGain,
+                           ( long ) lOffset, usRaw, pusBlock[ usRaw ], usExpected );
+                ulExact += ( pusBlock[ usRaw ] == usExpected );
+                ulCodes++;
+            }
+        }
+    }
+    printf( "  kernel within 1 LSB of exact rounding for %lu codes, %.3f %% exact\n",
+            ( unsigned long ) ulCodes, 100.0 * ulExact / ulCodes );
+}
+
+/* ADC under test: raw code of an input that should read dInput */
+static uint16_t prvADC( double dInput )
+{
+    double dRaw = floor( ( dInput - 7.3 ) / 0.987 + 0.5 );
+
+    return ( uint16_t ) fmin( fmax( dRaw, 0.0 ), calibrationMAX_CODE );
+}
+
+/* Corrected average of 2^appCAL_AVERAGE_LOG2 dithered readings, LSB << calibrationPOINT_SHIFT */
+static uint16_t prvPoint( double dInput )
+{
+    uint32_t ulSum = 0;
+    uint16_t usValue;
+    uint32_t ulIndex;
+
+    for( ulIndex = 0; ulIndex < ( 1UL << appCAL_AVERAGE_LOG2 ); ulIndex++ )
+    {
+        usValue = prvADC( dInput + ( ( double ) ( ulIndex % 8 ) - 3.5 ) * 0.4 );
+        vCalibrationApply( &usValue, 1 );
+        ulSum += usValue;
+    }
+    return ( uint16_t ) ( ulSum >> ( appCAL_AVERAGE_LOG2 - calibrationPOINT_SHIFT ) );
+}
+
+/* Worst error of the corrected ADC over the range */
+static double prvWorstError( void )
+{
+    double dWorst = 0.0;
+    double dInput;
+    uint16_t usValue;
+
+    for( dInput = 50.0; dInput < 4000.0; dInput += 0.37 )
+    {
+        usValue = prvADC( dInput );
+        vCalibrationApply( &usValue, 1 );
+        dWorst = fmax( dWorst, fabs( usValue - dInput ) );
+    }
+    return dWorst;
+}
+
+static void prvCheckTwoPoint( void )
+{
+    static const struct{
+        uint16_t usGain;
+        int16_t sOffset;
+    }pxActive[] = { { calGAIN_ONE, 0 }, { 33100, -4 }, { 32000, 12 } };
+    double dBefore;
+    double dAfter;
+    size_t xIndex;
+
+    for( xIndex = 0; xIndex < sizeof( pxActive ) / sizeof( pxActive[ 0 ] ); xIndex++ )
+    {
+        prvSet( pxActive[ xIndex ].usGain, pxActive[ xIndex ].sOffset, CALIBRATION_TLV );
+        dBefore = prvWorstError();
+        hostCHECK( xCalibrationSetUser( prvPoint( appCAL_LOW_CODE ), prvPoint( appCAL_HIGH_CODE ) ),
+                   "calibration rejected" );
+        dAfter = prvWorstError();
+        printf( "  two-point from gain %5u offset %+3d: worst error %5.2f LSB before, %4.2f after\n",
+                pxActive[ xIndex ].usGain, pxActive[ xIndex ].sOffset, dBefore, dAfter );
+        hostCHECK( dAfter <= 2.0, "worst error %.2f LSB", dAfter );
+        hostCHECK( xCalibrationSource() == CALIBRATION_USER && xStored.usMagic == calUSER_MAGIC &&
+                   xStored.usGain == usCalibrationGain() &&
+                   xStored.sOffset == sCalibrationOffset() && xStored.usCrc == prvUserCrc( &xStored ),
+                   "stored record does not match" );
+    }
+
+    /* Points in the wrong order or a gain outside 0.5 .. 2.0 store nothing */
+    ulErases = 0;
+    hostCHECK( !xCalibrationSetUser( appCAL_HIGH_CODE << calibrationPOINT_SHIFT,
+                                     appCAL_LOW_CODE << calibrationPOINT_SHIFT ), "reversed points" );
+    hostCHECK( !xCalibrationSetUser( 1000 << calibrationPOINT_SHIFT, 1001 << calibrationPOINT_SHIFT ),
+               "gain above 2" );
+    hostCHECK( ulErases == 0, "rejected calibration was stored" );
+}
+
+static void prvBenchmark( void )
+{
+    uint16_t pusBlock[ calibrationBENCH_LENGTH ];
+    uint64_t ullStart;
+    uint64_t ullNs;
+    uint32_t ulRound;
+    uint8_t ucIndex;
+
+    prvSet( 32500, 5, CALIBRATION_USER );
+    ulHostAccesses = 0;
+    ulHostLongestLock = 0;
+    for( ucIndex = 0; ucIndex < calibrationBENCH_LENGTH; ucIndex++ )
+    {
+        pusBlock[ ucIndex ] = ucIndex * ( calibrationMAX_CODE / calibrationBENCH_LENGTH );
+    }
+    vCalibrationApply( pusBlock, calibrationBENCH_LENGTH );
+    printf( "  %u-sample block: %.2f multiplier accesses/sample, longest lock %lu accesses\n",
+            calibrationBENCH_LENGTH, ( double ) ulHostAccesses / calibrationBENCH_LENGTH,
+            ( unsigned long ) ulHostLongestLock );
+
+    ullStart = ullHostNowNs();
+    for( ulRound = 0; ulRound < 1000000UL; ulRound++ )
+    {
+        pusBlock[ ulRound % calibrationBENCH_LENGTH ] = ( uint16_t ) ( ulRound & calibrationMAX_CODE );
+        vCalibrationApply( pusBlock, calibrationBENCH_LENGTH );
+    }
+    ullNs = ullHostNowNs() - ullStart;
+    ulHostSink = pusBlock[ 0 ];
+    printf( "  host, register model: %.2f ns/sample\n",
+            ( double ) ullNs / ( 1000000.0 * calibrationBENCH_LENGTH ) );
+}
+
+int main( void )
+{
+    prvCheckKernel();
+    prvCheckTwoPoint();
+    prvBenchmark();
+    return 0;
+}
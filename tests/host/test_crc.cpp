@@ -0,0 +1,97 @@
+/**
+ * @file test_crc.cpp
+ * @brief hal_crc peripheral path against the software table, and throughput
+ *
+ * Sources: ETF5529_HAL/hal_crc.c
+ * Flags: -D__MSP430__ -D__MSP430_HAS_CRC__
+ *
+ * usHALCRC16() is built for the CRC16 peripheral and runs against the
+ * register model of periph/msp430.h; for random buffers, lengths and seeds
+ * it must equal usHALCRC16Soft() and a bitwise reference. Throughput is
+ * reported as host bytes/s of the table version and, for the peripheral
+ * version, as register accesses per byte (each a 4 to 5 cycle MOV on the
+ * device) and the longest interrupt-disabled section.
+ */
+
+#include "host_test.h"
+#include "msp430.h"
+#include "hal_crc.h"
+
+#define testBUFFER_SIZE         ( 300 )
+#define testTIMED_BYTES         ( 200000000UL )
+
+static uint32_t ulSeed = 3;
+
+static uint32_t prvRandom32( void )
+{
+    ulSeed ^= ulSeed << 13;
+    ulSeed ^= ulSeed >> 17;
+    ulSeed ^= ulSeed << 5;
+    return ulSeed;
+}
+
+static uint16_t prvCrcBitwise( const uint8_t *pucData, uint16_t usLength, uint16_t usCrc )
+{
+    int iBit;
+
+    while( usLength-- > 0 )
+    {
+        usCrc ^= ( uint16_t ) ( *pucData++ << 8 );
+        for( iBit = 0; iBit < 8; iBit++ )
+        {
+            usCrc = ( usCrc & 0x8000 ) ? ( uint16_t ) ( ( usCrc << 1 ) ^ 0x1021 ) : ( uint16_t ) ( usCrc << 1 );
+        }
+    }
+    return usCrc;
+}
+
+int main( void )
+{
+    static uint8_t pucBuffer[ testBUFFER_SIZE ];
+    const uint8_t pucCheck[] = "123456789";
+    uint16_t usLength;
+    uint16_t usSeed;
+    uint16_t usCrc;
+    uint32_t ulIndex;
+    uint32_t ulPass;
+    uint64_t ullStart;
+    uint64_t ullNs;
+
+    hostCHECK( usHALCRC16( pucCheck, 9, halCRC16_SEED ) == 0x29B1, "check value" );
+    hostCHECK( usHALCRC16Soft( pucCheck, 9, halCRC16_SEED ) == 0x29B1, "check value, software" );
+
+    for( ulPass = 0; ulPass < 20000UL; ulPass++ )
+    {
+        usLength = ( uint16_t ) ( prvRandom32() % testBUFFER_SIZE );
+        usSeed = ( uint16_t ) prvRandom32();
+        for( ulIndex = 0; ulIndex < usLength; ulIndex++ )
+        {
+            pucBuffer[ ulIndex ] = ( uint8_t ) prvRandom32();
+        }
+        usCrc = prvCrcBitwise( pucBuffer, usLength, usSeed );
+        hostCHECK( usHALCRC16( pucBuffer, usLength, usSeed ) == usCrc, "peripheral, %u bytes", usLength );
+        hostCHECK( usHALCRC16Soft( pucBuffer, usLength, usSeed ) == usCrc, "table, %u bytes", usLength );
+        /* A CRC continued over two buffers equals the CRC of both */
+        hostCHECK( usHALCRC16( &pucBuffer[ usLength / 3 ], ( uint16_t ) ( usLength - usLength / 3 ),
+                               usHALCRC16( pucBuffer, ( uint16_t ) ( usLength / 3 ), usSeed ) ) == usCrc,
+                   "split, %u bytes", usLength );
+    }
+    printf( "  peripheral and table CRC match the bitwise reference for 20000 buffers\n" );
+
+    ulHostSink = 0;
+    ullStart = ullHostNowNs();
+    for( ulIndex = 0; ulIndex < testTIMED_BYTES / testBUFFER_SIZE; ulIndex++ )
+    {
+        ulHostSink += usHALCRC16Soft( pucBuffer, testBUFFER_SIZE, ( uint16_t ) ulIndex );
+    }
+    ullNs = ullHostNowNs() - ullStart;
+
+    ulHostAccesses = 0;
+    ulHostLongestLock = 0;
+    usHALCRC16( pucBuffer, 64, halCRC16_SEED );
+    printf( "  table: %.0f MB/s on the host; peripheral: %.2f register accesses/byte "
+            "over a 64-byte frame, longest lock %lu accesses\n",
+            ( double ) testTIMED_BYTES * 1000.0 / ( double ) ullNs,
+            ( double ) ulHostAccesses / 64, ( unsigned long ) ulHostLongestLock );
+    return 0;
+}
@@ -0,0 +1,150 @@
+/**
+ * @file test_deadband.c
+ * @brief Byte savings of deadband mode on sample traces
+ *
+ * Sources: deadband.c fmt.c ETF5529_HAL/hal_mpy.c
+ *
+ * The traces look like the bench signals: an idle input, a slow thermal
+ * drift, a level with occasional steps and a noisy input, one hour at 1 Hz
+ * each. Every trace goes through xDeadbandCheck() with the configured
+ * appDEADBAND and appDEADBAND_MAX_SILENT, and the lines Task3 would send
+ * are counted in bytes in the layout of prvFormatSample() and
+ * prvFormatHeartbeat() (12-bit, difference format, timestamps on) against
+ * streaming every sample. The test fails if the value the receiver holds
+ * ever strays more than the deadband from the input, or if a channel stays
+ * silent for longer than the heartbeat interval.
+ */
+
+#include <math.h>
+
+#include "host_test.h"
+#include "app_config.h"
+#include "deadband.h"
+#include "fmt.h"
+
+#define testSAMPLES             ( 3600 )
+#define testDIGITS              ( 4 )
+
+static uint32_t ulSeed;
+
+static uint32_t prvRandom32( void )
+{
+    ulSeed ^= ulSeed << 13;
+    ulSeed ^= ulSeed >> 17;
+    ulSeed ^= ulSeed << 5;
+    return ulSeed;
+}
+
+/* Uniform noise in -iAmplitude .. iAmplitude */
+static int prvNoise( int iAmplitude )
+{
+    return ( int ) ( prvRandom32() % ( 2U * iAmplitude + 1U ) ) - iAmplitude;
+}
+
+static uint16_t prvSample( int iTrace, int iIndex )
+{
+    static int iLevel;
+    int iValue;
+
+    switch( iTrace )
+    {
+        case 0:     /* idle: a fixed level with one LSB of noise */
+            iValue = 2048 + prvNoise( 1 );
+            break;
+        case 1:     /* drift: 300 LSB over the hour */
+            iValue = 1500 + ( int ) ( 300.0 * sin( 3.14159265 * iIndex / testSAMPLES ) ) + prvNoise( 1 );
+            break;
+        case 2:     /* steps: a new level about every five minutes */
+            if( iIndex == 0 || prvRandom32() % 300 == 0 )
+            {
+                iLevel = 500 + ( int ) ( prvRandom32() % 3000 );
+            }
+            iValue = iLevel + prvNoise( 1 );
+            break;
+        default:    /* noisy: four LSB of noise on a slow sine */
+            iValue = 2048 + ( int ) ( 100.0 * sin( 6.2831853 * iIndex / 600.0 ) ) + prvNoise( 4 );
+            break;
+    }
+    return ( uint16_t ) iValue;
+}
+
+/* Timestamp part of a line, ' ttttt.ss', and the line end */
+static uint32_t prvTailBytes( int iIndex )
+{
+    char pcBuf[ fmtMAX_U16 ];
+
+    return 1 + ucFmtU16( pcBuf, ( uint16_t ) ( iIndex * 1000 ) ) + 3 + 2;
+}
+
+/* 'c: (-)dddd' with the difference to the last value the receiver holds */
+static uint32_t prvSampleBytes( int32_t lDifference )
+{
+    return 3 + ( lDifference < 0 ) + testDIGITS;
+}
+
+int main( void )
+{
+    static const char * const pcTraces[] = { "idle", "drift", "steps", "noisy" };
+    Deadband_t xDeadband;
+    uint32_t ulStream;
+    uint32_t ulDeadband;
+    uint32_t ulLines;
+    uint16_t usSample;
+    uint16_t usPrevious;
+    uint16_t usHeld;
+    int iSilent;
+    int iWorst;
+    int iTrace;
+    int iIndex;
+
+    printf( "  deadband %d LSB, heartbeat after %d samples, %d samples per trace\n",
+            appDEADBAND, appDEADBAND_MAX_SILENT, testSAMPLES );
+    for( iTrace = 0; iTrace < 4; iTrace++ )
+    {
+        ulSeed = 0x1234567U + ( uint32_t ) iTrace;
+        vDeadbandInit( &xDeadband );
+        ulStream = 0;
+        ulDeadband = 0;
+        ulLines = 0;
+        usPrevious = 0;
+        usHeld = 0;
+        iSilent = 0;
+        iWorst = 0;
+
+        for( iIndex = 0; iIndex < testSAMPLES; iIndex++ )
+        {
+            usSample = prvSample( iTrace, iIndex );
+            ulStream += prvSampleBytes( ( int32_t ) usSample - usPrevious ) + prvTailBytes( iIndex );
+            usPrevious = usSample;
+
+            switch( xDeadbandCheck( &xDeadband, usSample, appDEADBAND, appDEADBAND_MAX_SILENT ) )
+            {
+                case DEADBAND_REPORT:
+                    ulDeadband += prvSampleBytes( ( int32_t ) usSample - usHeld ) + prvTailBytes( iIndex );
+                    usHeld = usSample;
+                    ulLines++;
+                    iSilent = 0;
+                    break;
+                case DEADBAND_HEARTBEAT:
+                    /* 'Hc: dddd', absolute */
+                    ulDeadband += 4 + testDIGITS + prvTailBytes( iIndex );
+                    usHeld = usSample;
+                    ulLines++;
+                    iSilent = 0;
+                    break;
+                default:
+                    iSilent++;
+                    break;
+            }
+            hostCHECK( abs( ( int ) usSample - ( int ) usHeld ) <= appDEADBAND,
+                       "%s: held %u for input %u", pcTraces[ iTrace ], usHeld, usSample );
+            hostCHECK( iSilent <= appDEADBAND_MAX_SILENT, "%s: silent for %d samples",
+                       pcTraces[ iTrace ], iSilent );
+            iWorst = ( abs( ( int ) usSample - ( int ) usHeld ) > iWorst ) ? abs( ( int ) usSample - ( int ) usHeld ) : iWorst;
+        }
+        printf( "  %-6s stream %6lu B, deadband %6lu B in %4lu lines, saved %5.1f %%, worst error %d LSB\n",
+                pcTraces[ iTrace ], ( unsigned long ) ulStream, ( unsigned long ) ulDeadband,
+                ( unsigned long ) ulLines, 100.0 * ( 1.0 - ( double ) ulDeadband / ulStream ), iWorst );
+    }
+    return 0;
+}
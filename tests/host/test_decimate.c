@@ -0,0 +1,246 @@
+/**
+ * @file test_decimate.c
+ * @brief Stream aggregation ratio over a sweep of rates
+ *
+ * Sources: decimate.c
+ *
+ * For every UART baud rate, channel count and sample period of the sweep,
+ * ucDecimateRatio() must return a ratio whose lines fit
+ * appUART_LOAD_PERCENT of the UART and one less that would not. The
+ * configurations that do not fit even at decimateMAX_RATIO are the ones the
+ * mainCheckUARTBandwidth assert rejects, and are only counted.
+ *
+ * A subset is then run through a simulation of the stream path: every
+ * sample period the ADC delivers one sample per channel, xDecimateAdd()
+ * turns each completed block into a line for the message queue of
+ * appMESSAGE_QUEUE_LENGTH, and Task3 takes one line at a time and
+ * transmits appLINE_MAX_BYTES at 10 bits per byte. Task1 never waits on a
+ * full queue in any of these configurations, so the output does not stall
+ * the ADC path; the test prints the highest queue occupancy and the UART
+ * load reached.
+ */
+
+#include "host_test.h"
+#include "app_config.h"
+#include "decimate.h"
+
+#define testMAX_CHANNELS        ( 16 )
+#define testMAX_PERIOD_MS       ( 2000 )
+#define testSIM_PERIODS         ( 20000UL )
+
+static const uint32_t pulBauds[] = { 9600, 19200, 57600, 115200 };
+static const uint32_t pulSimPeriods[] = { 1, 2, 5, 10, 20, 50, 100, 200, 500, 1000, 2000 };
+
+/* Bytes per 1000 s at ratio 1, as prvStreamRatio() in main.c counts them */
+static uint32_t prvBytesPerKs( uint8_t ucChannels, uint32_t ulPeriodMs )
+{
+    return ucChannels * ( 1000000UL / ulPeriodMs ) * appLINE_MAX_BYTES;
+}
+
+/* Bytes per second the lines take at ucRatio */
+static double prvLoad( uint8_t ucChannels, uint32_t ulPeriodMs, uint8_t ucRatio )
+{
+    return prvBytesPerKs( ucChannels, ulPeriodMs ) / 1000.0 / ucRatio;
+}
+
+static uint8_t prvRatio( uint8_t ucChannels, uint32_t ulPeriodMs, uint32_t ulBaud )
+{
+    return ucDecimateRatio( prvBytesPerKs( ucChannels, ulPeriodMs ), ulBaud,
+                            appUART_LOAD_PERCENT );
+}
+
+static void prvSweep( void )
+{
+    uint32_t ulBaud;
+    uint32_t ulPeriod;
+    uint8_t ucChannels;
+    uint8_t ucRatio;
+    double dCapacity;
+    unsigned uConfigs = 0;
+    unsigned uReduced = 0;
+    unsigned uRejected = 0;
+    size_t xIndex;
+
+    for( xIndex = 0; xIndex < sizeof( pulBauds ) / sizeof( pulBauds[ 0 ] ); xIndex++ )
+    {
+        ulBaud = pulBauds[ xIndex ];
+        dCapacity = ulBaud / 10.0 * appUART_LOAD_PERCENT / 100.0;
+        for( ucChannels = 1; ucChannels <= testMAX_CHANNELS; ucChannels++ )
+        {
+            for( ulPeriod = 1; ulPeriod <= testMAX_PERIOD_MS; ulPeriod++ )
+            {
+                ucRatio = prvRatio( ucChannels, ulPeriod, ulBaud );
+                uConfigs++;
+                hostCHECK( ucRatio >= 1 && ucRatio <= decimateMAX_RATIO, "ratio %u", ucRatio );
+                if( prvLoad( ucChannels, ulPeriod, ucRatio ) > dCapacity + 1e-9 )
+                {
+                    hostCHECK( ucRatio == decimateMAX_RATIO,
+                               "%lu baud, %u channels, %lu ms: ratio %u does not fit",
+                               ( unsigned long ) ulBaud, ucChannels, ( unsigned long ) ulPeriod,
+                               ucRatio );
+                    uRejected++;
+                    continue;
+                }
+                hostCHECK( ucRatio == 1 ||
+                           prvLoad( ucChannels, ulPeriod, ucRatio - 1 ) > dCapacity + 1e-9,
+                           "%lu baud, %u channels, %lu ms: ratio %u is not minimal",
+                           ( unsigned long ) ulBaud, ucChannels, ( unsigned long ) ulPeriod,
+                           ucRatio );
+                uReduced += ( ucRatio > 1 );
+            }
+        }
+    }
+    printf( "  %u configurations: %u aggregated, %u beyond ratio %u\n", uConfigs, uReduced,
+            uRejected, decimateMAX_RATIO );
+}
+
+/* Highest message queue occupancy, fails if Task1 would have to wait */
+static unsigned prvSimulate( uint32_t ulBaud, uint8_t ucChannels, uint32_t ulPeriodMs,
+                             uint8_t ucRatio, double *pdLoad )
+{
+    Decimator_t xDecimator[ testMAX_CHANNELS ];
+    uint64_t ullPeriodNs = ( uint64_t ) ulPeriodMs * 1000000ULL;
+    uint64_t ullLineNs = ( uint64_t ) appLINE_MAX_BYTES * 10ULL * 1000000000ULL / ulBaud;
+    uint64_t ullNow;
+    /* Time the UART finishes the line it is sending */
+    uint64_t ullIdle = 0;
+    uint64_t ullBusy = 0;
+    unsigned uQueued = 0;
+    unsigned uHighWater = 0;
+    uint32_t ulSample;
+    uint16_t usOut;
+    uint8_t ucChannel;
+
+    for( ucChannel = 0; ucChannel < ucChannels; ucChannel++ )
+    {
+        vDecimateInit( &xDecimator[ ucChannel ] );
+    }
+    /* The ratio announcement goes first */
+    uQueued = 1;
+
+    for( ulSample = 0; ulSample < testSIM_PERIODS; ulSample++ )
+    {
+        ullNow = ulSample * ullPeriodNs;
+
+        /* Task3 drains the queue up to the next ADC sequence */
+        while( ( uQueued > 0 ) && ( ullIdle <= ullNow ) )
+        {
+            uQueued--;
+            ullIdle += ullLineNs;
+            ullBusy += ullLineNs;
+        }
+        if( ullIdle < ullNow )
+        {
+            ullIdle = ullNow;
+        }
+
+        for( ucChannel = 0; ucChannel < ucChannels; ucChannel++ )
+        {
+            if( xDecimateAdd( &xDecimator[ ucChannel ], ( uint16_t ) ( ulSample & 0x0FFF ),
+                              ucRatio, &usOut ) )
+            {
+                /* A line waiting for the UART while Task3 is idle is taken at once */
+                if( ( uQueued == 0 ) && ( ullIdle <= ullNow ) )
+                {
+                    ullIdle = ullNow + ullLineNs;
+                    ullBusy += ullLineNs;
+                    continue;
+                }
+                hostCHECK( uQueued < appMESSAGE_QUEUE_LENGTH,
+                           "%lu baud, %u channels, %lu ms, ratio %u: queue full at sample %lu",
+                           ( unsigned long ) ulBaud, ucChannels, ( unsigned long ) ulPeriodMs,
+                           ucRatio, ( unsigned long ) ulSample );
+                uQueued++;
+                if( uQueued > uHighWater )
+                {
+                    uHighWater = uQueued;
+                }
+            }
+        }
+    }
+
+    *pdLoad = ( double ) ullBusy / ( ( double ) testSIM_PERIODS * ullPeriodNs );
+    return uHighWater;
+}
+
+static void prvSimulateSweep( void )
+{
+    uint32_t ulBaud;
+    uint32_t ulPeriod;
+    uint8_t ucChannels;
+    uint8_t ucRatio;
+    unsigned uHighWater;
+    unsigned uWorst = 0;
+    unsigned uRuns = 0;
+    double dLoad;
+    double dMaxLoad = 0.0;
+    size_t xBaud;
+    size_t xPeriod;
+
+    for( xBaud = 0; xBaud < sizeof( pulBauds ) / sizeof( pulBauds[ 0 ] ); xBaud++ )
+    {
+        ulBaud = pulBauds[ xBaud ];
+        for( ucChannels = 1; ucChannels <= appSEQUENCE_MAX; ucChannels++ )
+        {
+            for( xPeriod = 0; xPeriod < sizeof( pulSimPeriods ) / sizeof( pulSimPeriods[ 0 ] );
+                 xPeriod++ )
+            {
+                ulPeriod = pulSimPeriods[ xPeriod ];
+                ucRatio = prvRatio( ucChannels, ulPeriod, ulBaud );
+                if( prvLoad( ucChannels, ulPeriod, ucRatio ) >
+                    ulBaud / 10.0 * appUART_LOAD_PERCENT / 100.0 )
+                {
+                    /* Rejected at compile time */
+                    continue;
+                }
+                uHighWater = prvSimulate( ulBaud, ucChannels, ulPeriod, ucRatio, &dLoad );
+                uRuns++;
+                if( uHighWater > uWorst )
+                {
+                    uWorst = uHighWater;
+                }
+                if( dLoad > dMaxLoad )
+                {
+                    dMaxLoad = dLoad;
+                }
+            }
+        }
+    }
+    printf( "  %u simulated configurations of %lu periods: queue high water %u of %u, "
+            "UART load at most %.1f %%\n", uRuns, testSIM_PERIODS, uWorst,
+            appMESSAGE_QUEUE_LENGTH, dMaxLoad * 100.0 );
+}
+
+static void prvMean( void )
+{
+    Decimator_t xDecimator;
+    uint16_t usOut = 0;
+    uint16_t usSample;
+    unsigned uLines = 0;
+
+    vDecimateInit( &xDecimator );
+    for( usSample = 0; usSample < 9; usSample++ )
+    {
+        if( xDecimateAdd( &xDecimator, usSample, 3, &usOut ) )
+        {
+            /* Means of 0 1 2, 3 4 5 and 6 7 8 */
+            hostCHECK( usOut == 3 * uLines + 1, "line %u mean %u", uLines, usOut );
+            uLines++;
+        }
+    }
+    hostCHECK( uLines == 3, "%u lines", uLines );
+
+    /* Rounded: mean of 0 and 1 */
+    hostCHECK( xDecimateAdd( &xDecimator, 0, 2, &usOut ) == false, "early line" );
+    hostCHECK( xDecimateAdd( &xDecimator, 1, 2, &usOut ) && usOut == 1, "mean %u", usOut );
+
+    hostCHECK( xDecimateAdd( &xDecimator, 4095, 1, &usOut ) && usOut == 4095, "ratio 1" );
+}
+
+int main( void )
+{
+    prvMean();
+    prvSweep();
+    prvSimulateSweep();
+    return 0;
+}
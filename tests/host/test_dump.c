@@ -0,0 +1,269 @@
+/**
+ * @file test_dump.c
+ * @brief Log dump frames read back, resumed dumps and the dump throughput
+ *
+ * Sources: log.c frame.c ETF5529_HAL/hal_flash.c ETF5529_HAL/hal_crc.c
+ *
+ * Four channels, two every 10 ticks and two every 50, are logged for 400 s
+ * into a ring of testSEGMENTS segments, a random walk of a few LSB with a
+ * jump in one sample out of 40. The ring is then dumped as the 'L' command
+ * does in Task3, one ucFrameLogBlock() per block from pxLogFind() on and
+ * ucFrameLogEnd() at the end, into a wire buffer. The receiver side checks
+ * sync and CRC of every frame, decodes the blocks and compares them with
+ * the blocks as they were written: in order, without gaps, from the oldest
+ * block kept up to the next sequence number reported by the end frame.
+ * Dumps resumed from a block in the middle and from one already
+ * overwritten must give the blocks from there on.
+ *
+ * The throughput is reported as the share of the line bytes that is log
+ * data, the line bytes per sample and the samples per second at
+ * appUART_BAUD (10 bits per byte), against sending the samples raw as
+ * 16-bit values. The live records take their share of the line first; the
+ * dump fills the rest.
+ */
+
+#include <string.h>
+
+#include "host_test.h"
+#include "log.h"
+#include "frame.h"
+#include "hal_flash.h"
+#include "hal_crc.h"
+
+#define testSEGMENTS            ( 16 )
+#define testCHANNELS            ( 4 )
+#define testRUN_TICKS           ( 400000UL )
+#define testMAX_BLOCKS          ( 20000UL )
+#define testWIRE_BYTES          ( 1UL << 20 )
+
+typedef struct{
+    bool     xWritten;
+    uint8_t  ucChannel;
+    uint8_t  ucCount;
+    uint32_t ulTicks;
+    uint16_t pusValues[ 256 ];
+}Written_t;
+
+typedef struct{
+    uint32_t ulBlocks;
+    uint32_t ulSamples;
+    uint32_t ulFirst;
+    uint32_t ulDataBytes;   // block headers and packed samples
+    LogStats_t xEnd;
+}Dump_t;
+
+static uint8_t pucFlash[ testSEGMENTS * halFLASH_MAIN_SEGMENT ] __attribute__ ( ( aligned( halFLASH_MAIN_SEGMENT ) ) );
+static Written_t pxWritten[ testMAX_BLOCKS ];
+static uint8_t pucWire[ testWIRE_BYTES ];
+static uint32_t ulWire;
+
+void vHALFlashPowerFail( void )
+{
+    hostCHECK( 0, "no power failure is simulated" );
+}
+
+static uint16_t prvGet16( const uint8_t *pucData )
+{
+    return ( uint16_t ) ( pucData[ 0 ] | ( pucData[ 1 ] << 8 ) );
+}
+
+static uint32_t prvGet32( const uint8_t *pucData )
+{
+    return prvGet16( pucData ) | ( ( uint32_t ) prvGet16( &pucData[ 2 ] ) << 16 );
+}
+
+/* Carry out every pending operation and keep a copy of each block written */
+static void prvSteps( void )
+{
+    LogStats_t xStats;
+    LogOp_t xOp;
+    const LogBlock_t *pxBlock;
+    Written_t *pxCopy;
+
+    while( ( xOp = xLogPending() ) != LOG_IDLE )
+    {
+        vLogGetStats( &xStats );
+        vLogStep();
+        if( xOp != LOG_WRITE )
+        {
+            continue;
+        }
+        pxBlock = pxLogFind( xStats.ulNext );
+        hostCHECK( pxBlock != 0 && pxBlock->ulSequence < testMAX_BLOCKS, "block %lu not written",
+                   ( unsigned long ) xStats.ulNext );
+        pxCopy = &pxWritten[ pxBlock->ulSequence ];
+        pxCopy->xWritten = true;
+        pxCopy->ucChannel = pxBlock->ucChannel;
+        pxCopy->ulTicks = pxBlock->ulTicks;
+        pxCopy->ucCount = ucLogDecode( pxBlock, pxCopy->pusValues );
+    }
+}
+
+static void prvLogRun( void )
+{
+    uint16_t pusValue[ testCHANNELS ] = { 2000, 1000, 3000, 500 };
+    uint16_t usPeriod;
+    uint32_t ulTick;
+    uint8_t ucChannel;
+    int iStep;
+
+    srand( 5 );
+    memset( pucFlash, 0xFF, sizeof( pucFlash ) );
+    vLogInit( pucFlash, testSEGMENTS );
+    for( ulTick = 0; ulTick < testRUN_TICKS; ulTick++ )
+    {
+        for( ucChannel = 0; ucChannel < testCHANNELS; ucChannel++ )
+        {
+            usPeriod = ( ucChannel < 2 ) ? 10 : 50;
+            if( ulTick % usPeriod != 0 )
+            {
+                continue;
+            }
+            iStep = ( rand() % 40 == 0 ) ? rand() % 400 - 200 : rand() % 9 - 4;
+            pusValue[ ucChannel ] = ( uint16_t ) ( ( pusValue[ ucChannel ] + iStep ) & 0xFFF );
+            while( xLogAdd( ucChannel, pusValue[ ucChannel ], ulTick, usPeriod ) == false )
+            {
+                prvSteps();
+            }
+        }
+        prvSteps();
+    }
+}
+
+/* Send blocks from ulNext on until the end frame, as Task3 does */
+static void prvDump( uint32_t ulNext )
+{
+    static uint8_t pucFrame[ frameMAX_SIZE ];
+    const LogBlock_t *pxBlock;
+    LogStats_t xStats;
+    uint8_t ucSize;
+
+    while( ( pxBlock = pxLogFind( ulNext ) ) != 0 )
+    {
+        ulNext = pxBlock->ulSequence + 1UL;
+        ucSize = ucFrameLogBlock( pucFrame, pxBlock );
+        hostCHECK( ulWire + ucSize <= testWIRE_BYTES, "wire buffer full" );
+        memcpy( &pucWire[ ulWire ], pucFrame, ucSize );
+        ulWire += ucSize;
+    }
+    vLogGetStats( &xStats );
+    ucSize = ucFrameLogEnd( pucFrame, &xStats );
+    memcpy( &pucWire[ ulWire ], pucFrame, ucSize );
+    ulWire += ucSize;
+}
+
+/* Receiver: check the frames from ulFrom on against the blocks written */
+static void prvReceive( uint32_t ulFrom, Dump_t *pxDump )
+{
+    union{
+        LogBlock_t xHeader;
+        uint8_t pucBytes[ sizeof( LogBlock_t ) + frameMAX_PAYLOAD ];
+    }xBlock;
+    uint16_t pusValues[ 256 ];
+    const uint8_t *pucPayload;
+    const Written_t *pxCopy;
+    uint32_t ulExpected = 0;
+    uint8_t ucLength;
+    uint8_t ucType;
+    uint8_t ucCount;
+
+    memset( pxDump, 0, sizeof( *pxDump ) );
+    for( ;; )
+    {
+        hostCHECK( ulFrom + frameOVERHEAD <= ulWire && pucWire[ ulFrom ] == frameSYNC, "no frame at %lu",
+                   ( unsigned long ) ulFrom );
+        ucType = pucWire[ ulFrom + 1 ];
+        ucLength = pucWire[ ulFrom + 2 ];
+        pucPayload = &pucWire[ ulFrom + 3 ];
+        hostCHECK( usHALCRC16( &pucWire[ ulFrom + 1 ], ( uint16_t ) ucLength + 2U, halCRC16_SEED ) ==
+                   prvGet16( &pucPayload[ ucLength ] ), "CRC of the frame at %lu", ( unsigned long ) ulFrom );
+        ulFrom += ucLength + frameOVERHEAD;
+        if( ucType == frameTYPE_LOG_END )
+        {
+            hostCHECK( ucLength == 10, "end frame of %u bytes", ucLength );
+            pxDump->xEnd.ulOldest = prvGet32( &pucPayload[ 0 ] );
+            pxDump->xEnd.ulNext = prvGet32( &pucPayload[ 4 ] );
+            pxDump->xEnd.usMaxErase = prvGet16( &pucPayload[ 8 ] );
+            return;
+        }
+
+        hostCHECK( ucType == frameTYPE_LOG_BLOCK && ucLength >= 16 && prvGet16( pucPayload ) == ucLength - 16U,
+                   "frame type 0x%02x of %u bytes", ucType, ucLength );
+        xBlock.xHeader.usLength = prvGet16( &pucPayload[ 0 ] );
+        xBlock.xHeader.ucChannel = pucPayload[ 2 ];
+        xBlock.xHeader.ucCount = pucPayload[ 3 ];
+        xBlock.xHeader.ulSequence = prvGet32( &pucPayload[ 4 ] );
+        xBlock.xHeader.ulTicks = prvGet32( &pucPayload[ 8 ] );
+        xBlock.xHeader.usPeriod = prvGet16( &pucPayload[ 12 ] );
+        xBlock.xHeader.usFirst = prvGet16( &pucPayload[ 14 ] );
+        memcpy( &xBlock.pucBytes[ sizeof( LogBlock_t ) ], &pucPayload[ 16 ], xBlock.xHeader.usLength );
+
+        hostCHECK( pxDump->ulBlocks == 0 || xBlock.xHeader.ulSequence == ulExpected,
+                   "block %lu after %lu", ( unsigned long ) xBlock.xHeader.ulSequence,
+                   ( unsigned long ) ulExpected - 1UL );
+        hostCHECK( xBlock.xHeader.ulSequence < testMAX_BLOCKS, "block %lu", ( unsigned long ) xBlock.xHeader.ulSequence );
+        pxCopy = &pxWritten[ xBlock.xHeader.ulSequence ];
+        ucCount = ucLogDecode( &xBlock.xHeader, pusValues );
+        hostCHECK( pxCopy->xWritten && pxCopy->ucChannel == xBlock.xHeader.ucChannel &&
+                   pxCopy->ulTicks == xBlock.xHeader.ulTicks && pxCopy->ucCount == ucCount &&
+                   memcmp( pxCopy->pusValues, pusValues, ucCount * sizeof( uint16_t ) ) == 0,
+                   "block %lu does not match the one written", ( unsigned long ) xBlock.xHeader.ulSequence );
+
+        pxDump->ulFirst = ( pxDump->ulBlocks == 0 ) ? xBlock.xHeader.ulSequence : pxDump->ulFirst;
+        pxDump->ulBlocks++;
+        pxDump->ulSamples += ucCount;
+        pxDump->ulDataBytes += ucLength;
+        ulExpected = xBlock.xHeader.ulSequence + 1UL;
+    }
+}
+
+int main( void )
+{
+    Dump_t xDump;
+    Dump_t xResumed;
+    LogStats_t xStats;
+    uint32_t ulStart;
+    uint32_t ulMiddle;
+    double dSeconds;
+
+    prvLogRun();
+    vLogGetStats( &xStats );
+
+    ulStart = ulWire;
+    prvDump( 0 );
+    prvReceive( ulStart, &xDump );
+    hostCHECK( xDump.ulFirst == xStats.ulOldest && xDump.ulBlocks == xStats.ulNext - xStats.ulOldest,
+               "%lu blocks from %lu, log keeps %lu to %lu", ( unsigned long ) xDump.ulBlocks,
+               ( unsigned long ) xDump.ulFirst, ( unsigned long ) xStats.ulOldest,
+               ( unsigned long ) xStats.ulNext );
+    hostCHECK( memcmp( &xDump.xEnd, &xStats, sizeof( xStats ) ) == 0, "end frame does not match the log" );
+    hostCHECK( xStats.ulOldest > 0 && xStats.usMaxErase > 1, "the ring did not wrap" );
+
+    dSeconds = ( ulWire - ulStart ) * 10.0 / appUART_BAUD;
+    printf( "  %lu blocks, %lu samples: %lu line bytes, %.1f s at %lu baud\n", ( unsigned long ) xDump.ulBlocks,
+            ( unsigned long ) xDump.ulSamples, ( unsigned long ) ( ulWire - ulStart ), dSeconds,
+            ( unsigned long ) appUART_BAUD );
+    printf( "    %.1f %% of the line rate is log data, %.2f line bytes per sample (2 raw): "
+            "%.0f samples/s, %.1fx the raw rate\n", 100.0 * xDump.ulDataBytes / ( ulWire - ulStart ),
+            ( double ) ( ulWire - ulStart ) / xDump.ulSamples, xDump.ulSamples / dSeconds,
+            2.0 * xDump.ulSamples / ( ulWire - ulStart ) );
+
+    ulMiddle = ( xStats.ulOldest + xStats.ulNext ) / 2UL;
+    ulStart = ulWire;
+    prvDump( ulMiddle );
+    prvReceive( ulStart, &xResumed );
+    hostCHECK( xResumed.ulFirst == ulMiddle && xResumed.ulBlocks == xStats.ulNext - ulMiddle,
+               "resumed from %lu: %lu blocks from %lu", ( unsigned long ) ulMiddle,
+               ( unsigned long ) xResumed.ulBlocks, ( unsigned long ) xResumed.ulFirst );
+
+    /* Block 1 was overwritten long ago, the dump starts at the oldest kept */
+    ulStart = ulWire;
+    prvDump( 1 );
+    prvReceive( ulStart, &xResumed );
+    hostCHECK( xResumed.ulFirst == xStats.ulOldest && xResumed.ulBlocks == xDump.ulBlocks,
+               "resumed from an overwritten block: %lu blocks from %lu", ( unsigned long ) xResumed.ulBlocks,
+               ( unsigned long ) xResumed.ulFirst );
+    printf( "  resumed from block %lu and from an overwritten one: the blocks from there on\n",
+            ( unsigned long ) ulMiddle );
+    return 0;
+}
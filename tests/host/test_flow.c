@@ -0,0 +1,329 @@
+/**
+ * @file test_flow.c
+ * @brief XON/XOFF flow control over a pseudo terminal with a throttling reader
+ *
+ * Sources: flow.c
+ *
+ * The device side runs on the pty master: a producer queues a numbered
+ * line every millisecond into appMESSAGE_QUEUE_LENGTH lines without ever
+ * waiting (a full queue drops the line, as the output stage does), the
+ * transmitter sends one byte per 100 us (about 100 kbaud) unless paused,
+ * and received commands go through xFlowReceive() into a receive queue of
+ * appCHAR_QUEUE_LENGTH that Task2 drains one character per 3 ms, with
+ * cFlowLevel() at appUART_RX_STOP / appUART_RX_RESUME.
+ *
+ * The reader, a child process on the pty slave, has a 64-byte buffer that
+ * it asks to be paused at 48 bytes and resumed at 16; it takes 2 bytes/ms
+ * for 200 ms and then stalls for 300 ms, and floods the device with a
+ * command every millisecond while the device has not sent XOFF.
+ *
+ * With flow control no byte may be lost on either side and every line the
+ * reader completes must follow the one before. The same run with flow
+ * control ignored by both sides must lose data, so the test is known to
+ * detect a broken pause.
+ */
+
+#define _DEFAULT_SOURCE
+#define _XOPEN_SOURCE 600
+
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <termios.h>
+#include <sys/wait.h>
+
+#include "host_test.h"
+#include "app_config.h"
+#include "flow.h"
+
+#define testRUN_US              ( 3000000LL )
+#define testLINE_BYTES          ( 16 )
+#define testREADER_BUFFER       ( 64 )
+
+typedef struct{
+    long lLost;
+    long lGaps;
+    long lLines;
+    long lSent;
+}Reader_t;
+
+static int64_t llNowUs( void )
+{
+    return ( int64_t ) ( ullHostNowNs() / 1000ULL );
+}
+
+/* Device side: returns the command characters lost */
+static long prvDevice( int iFd, bool xFlow )
+{
+    Flow_t xLink;
+    char pcCommands[ appCHAR_QUEUE_LENGTH ];
+    char pcLines[ appMESSAGE_QUEUE_LENGTH ][ testLINE_BYTES ];
+    int iWaiting = 0;
+    int iHead = 0;
+    int iQueued = 0;
+    int iPosition = 0;
+    long lLost = 0;
+    long lQueued = 0;
+    long lDropped = 0;
+    long lPauses = 0;
+    long lSequence = 0;
+    char cSignal = 0;
+    char cLevel;
+    char cReceived;
+    bool xWasPaused = false;
+    int64_t llStart = llNowUs();
+    int64_t llNow;
+    int64_t llProduce = llStart;
+    int64_t llConsume = llStart;
+    int64_t llByte = llStart;
+    int64_t llPaused = 0;
+    int64_t llPauseStart = 0;
+
+    vFlowInit( &xLink, appUART_RX_RESUME, appUART_RX_STOP );
+    fcntl( iFd, F_SETFL, O_NONBLOCK );
+
+    while( ( llNow = llNowUs() ) - llStart < testRUN_US )
+    {
+        /* UART RX ISR */
+        while( read( iFd, &cReceived, 1 ) == 1 )
+        {
+            if( xFlow ? xFlowReceive( &xLink, cReceived ) :
+                        ( cReceived == flowXON || cReceived == flowXOFF ) )
+            {
+                continue;
+            }
+            if( iWaiting < appCHAR_QUEUE_LENGTH )
+            {
+                pcCommands[ iWaiting++ ] = cReceived;
+            }
+            else
+            {
+                lLost++;
+            }
+            cLevel = cFlowLevel( &xLink, ( uint8_t ) iWaiting );
+            cSignal = ( cLevel != 0 ) ? cLevel : cSignal;
+        }
+        if( xLink.xPaused != xWasPaused )
+        {
+            xWasPaused = xLink.xPaused;
+            lPauses += xWasPaused;
+            if( xWasPaused )
+            {
+                llPauseStart = llNow;
+            }
+            else
+            {
+                llPaused += llNow - llPauseStart;
+            }
+        }
+
+        /* Task2 */
+        if( llNow >= llConsume )
+        {
+            llConsume += 3000;
+            if( iWaiting > 0 )
+            {
+                memmove( pcCommands, pcCommands + 1, ( size_t ) --iWaiting );
+                cLevel = cFlowLevel( &xLink, ( uint8_t ) iWaiting );
+                cSignal = ( cLevel != 0 ) ? cLevel : cSignal;
+            }
+        }
+
+        /* Task1, never waits for the output */
+        if( llNow >= llProduce )
+        {
+            llProduce += 1000;
+            if( iQueued < appMESSAGE_QUEUE_LENGTH )
+            {
+                snprintf( pcLines[ ( iHead + iQueued ) % appMESSAGE_QUEUE_LENGTH ], testLINE_BYTES,
+                          "L%06d\n", ( int ) ( lSequence++ % 1000000L ) );
+                iQueued++;
+                lQueued++;
+            }
+            else
+            {
+                lDropped++;
+            }
+        }
+
+        /* UART TX, XON/XOFF go out ahead of the data */
+        if( llNow >= llByte )
+        {
+            llByte = llNow + 100;
+            if( cSignal != 0 && xFlow )
+            {
+                if( write( iFd, &cSignal, 1 ) == 1 )
+                {
+                    cSignal = 0;
+                }
+            }
+            else if( iQueued > 0 && ( xLink.xPaused == false || xFlow == false ) )
+            {
+                if( write( iFd, &pcLines[ iHead ][ iPosition ], 1 ) == 1 &&
+                    pcLines[ iHead ][ ++iPosition ] == '\0' )
+                {
+                    iPosition = 0;
+                    iHead = ( iHead + 1 ) % appMESSAGE_QUEUE_LENGTH;
+                    iQueued--;
+                }
+            }
+        }
+        usleep( 20 );
+    }
+
+    if( xWasPaused )
+    {
+        llPaused += llNow - llPauseStart;
+    }
+    printf( "    device: %ld lines queued, %ld dropped by the producer, paused %ld times "
+            "(%.0f %% of the run), %ld command characters lost\n", lQueued, lDropped, lPauses,
+            100.0 * llPaused / testRUN_US, lLost );
+    return lLost;
+}
+
+/* Reader side, in the child; reports through the pipe */
+static void prvReader( const char *pcName, bool xFlow, int iReport )
+{
+    Reader_t xResult = { 0, 0, 0, 0 };
+    struct termios xTerm;
+    char pcBuffer[ testREADER_BUFFER ];
+    char pcLine[ testLINE_BYTES ];
+    int iFd = open( pcName, O_RDWR | O_NOCTTY );
+    int iBuffered = 0;
+    int iLength = 0;
+    long lExpected = -1;
+    long lValue;
+    bool xStopped = false;
+    bool xAsked = false;
+    char cByte;
+    int64_t llStart = llNowUs();
+    int64_t llNow;
+    int64_t llCommand = llStart;
+    int64_t llTake = llStart;
+
+    tcgetattr( iFd, &xTerm );
+    cfmakeraw( &xTerm );
+    tcsetattr( iFd, TCSANOW, &xTerm );
+    fcntl( iFd, F_SETFL, O_NONBLOCK );
+
+    /* Stop a little early so the device still drains what the reader sends */
+    while( ( llNow = llNowUs() ) - llStart < testRUN_US - 300000LL )
+    {
+        while( read( iFd, &cByte, 1 ) == 1 )
+        {
+            if( xFlow && ( cByte == flowXOFF || cByte == flowXON ) )
+            {
+                xStopped = ( cByte == flowXOFF );
+                continue;
+            }
+            if( iBuffered < testREADER_BUFFER )
+            {
+                pcBuffer[ iBuffered++ ] = cByte;
+            }
+            else
+            {
+                xResult.lLost++;
+            }
+        }
+        if( xFlow && !xAsked && iBuffered > 48 )
+        {
+            cByte = flowXOFF;
+            xAsked = ( write( iFd, &cByte, 1 ) == 1 );
+        }
+        if( xFlow && xAsked && iBuffered < 16 )
+        {
+            cByte = flowXON;
+            xAsked = ( write( iFd, &cByte, 1 ) != 1 );
+        }
+
+        /* Takes 2 bytes/ms for 200 ms, then stalls for 300 ms */
+        if( ( ( llNow - llStart ) / 1000 ) % 500 < 200 && llNow >= llTake && iBuffered > 0 )
+        {
+            llTake = llNow + 500;
+            cByte = pcBuffer[ 0 ];
+            memmove( pcBuffer, pcBuffer + 1, ( size_t ) --iBuffered );
+            if( cByte == '\n' )
+            {
+                pcLine[ iLength ] = '\0';
+                lValue = atol( pcLine + 1 );
+                xResult.lGaps += ( lExpected >= 0 && lValue != lExpected ) || pcLine[ 0 ] != 'L';
+                lExpected = lValue + 1;
+                xResult.lLines++;
+                iLength = 0;
+            }
+            else if( iLength < testLINE_BYTES - 1 )
+            {
+                pcLine[ iLength++ ] = cByte;
+            }
+        }
+
+        if( !xStopped && llNow >= llCommand )
+        {
+            llCommand = llNow + 1000;
+            cByte = 'q';
+            xResult.lSent += ( write( iFd, &cByte, 1 ) == 1 );
+        }
+        usleep( 20 );
+    }
+
+    if( write( iReport, &xResult, sizeof( xResult ) ) != sizeof( xResult ) )
+    {
+        _exit( 2 );
+    }
+    _exit( 0 );
+}
+
+static void prvRun( bool xFlow, long *plDeviceLost, Reader_t *pxReader )
+{
+    struct termios xTerm;
+    int piPipe[ 2 ];
+    int iMaster;
+    int iStatus;
+    pid_t xChild;
+    char *pcName;
+
+    iMaster = posix_openpt( O_RDWR | O_NOCTTY );
+    hostCHECK( iMaster >= 0 && grantpt( iMaster ) == 0 && unlockpt( iMaster ) == 0, "no pty" );
+    tcgetattr( iMaster, &xTerm );
+    cfmakeraw( &xTerm );
+    tcsetattr( iMaster, TCSANOW, &xTerm );
+    pcName = strdup( ptsname( iMaster ) );
+    hostCHECK( pipe( piPipe ) == 0, "no pipe" );
+
+    printf( "  flow control %s:\n", xFlow ? "on" : "off" );
+    fflush( stdout );
+    xChild = fork();
+    hostCHECK( xChild >= 0, "fork failed" );
+    if( xChild == 0 )
+    {
+        close( piPipe[ 0 ] );
+        prvReader( pcName, xFlow, piPipe[ 1 ] );
+    }
+    close( piPipe[ 1 ] );
+
+    *plDeviceLost = prvDevice( iMaster, xFlow );
+    hostCHECK( read( piPipe[ 0 ], pxReader, sizeof( *pxReader ) ) == sizeof( *pxReader ),
+               "no report from the reader" );
+    waitpid( xChild, &iStatus, 0 );
+    close( piPipe[ 0 ] );
+    close( iMaster );
+    free( pcName );
+
+    printf( "    reader: %ld lines, %ld out of sequence, %ld bytes lost, %ld commands sent\n",
+            pxReader->lLines, pxReader->lGaps, pxReader->lLost, pxReader->lSent );
+}
+
+int main( void )
+{
+    Reader_t xReader;
+    long lDeviceLost;
+
+    prvRun( true, &lDeviceLost, &xReader );
+    hostCHECK( lDeviceLost == 0 && xReader.lLost == 0 && xReader.lGaps == 0,
+               "data lost with flow control" );
+    hostCHECK( xReader.lLines > 100 && xReader.lSent > 100, "link did not carry data" );
+
+    prvRun( false, &lDeviceLost, &xReader );
+    hostCHECK( lDeviceLost > 0 && xReader.lLost > 0, "no loss without flow control" );
+    return 0;
+}
@@ -0,0 +1,161 @@
+/**
+ * @file test_fmt.c
+ * @brief fmt.c against snprintf, and its cost against snprintf
+ *
+ * Sources: fmt.c ETF5529_HAL/hal_mpy.c
+ *
+ * Every 16-bit value and 2 million random 32-bit values are formatted by
+ * both and compared. The timing compares ucFmtS16() with snprintf( "%d" )
+ * and with the /100 and /10 digit split Task3 used before fmt.c. The host
+ * divides in hardware, so the split is cheap here; on the MSP430 each of
+ * its divisions is a call to the compiler's software division routine,
+ * which fmt.c avoids.
+ */
+
+#include <string.h>
+#include <limits.h>
+
+#include "host_test.h"
+#include "fmt.h"
+#include "hal_mpy.h"
+
+#define testRANDOM_VALUES       ( 2000000UL )
+#define testTIMED_PASSES        ( 200 )
+
+static uint32_t ulSeed = 1;
+
+static uint32_t prvRandom32( void )
+{
+    /* xorshift32 */
+    ulSeed ^= ulSeed << 13;
+    ulSeed ^= ulSeed >> 17;
+    ulSeed ^= ulSeed << 5;
+    return ulSeed;
+}
+
+static void prvExpect( const char *pcBuf, uint8_t ucLength, const char *pcExpected )
+{
+    hostCHECK( ucLength == strlen( pcExpected ) && memcmp( pcBuf, pcExpected, ucLength ) == 0,
+               "got \"%.*s\", expected \"%s\"", ucLength, pcBuf, pcExpected );
+}
+
+static void prvCheckAgainstSnprintf( void )
+{
+    char pcBuf[ fmtMAX_FIXED ];
+    char pcExpected[ 32 ];
+    uint32_t ulValue;
+    uint32_t ulIndex;
+
+    for( ulValue = 0; ulValue <= 0xFFFFUL; ulValue++ )
+    {
+        snprintf( pcExpected, sizeof( pcExpected ), "%u", ( unsigned ) ulValue );
+        prvExpect( pcBuf, ucFmtU16( pcBuf, ( uint16_t ) ulValue ), pcExpected );
+        snprintf( pcExpected, sizeof( pcExpected ), "%d", ( int16_t ) ulValue );
+        prvExpect( pcBuf, ucFmtS16( pcBuf, ( int16_t ) ulValue ), pcExpected );
+        snprintf( pcExpected, sizeof( pcExpected ), "%04X", ( unsigned ) ulValue );
+        prvExpect( pcBuf, ucFmtHex16( pcBuf, ( uint16_t ) ulValue ), pcExpected );
+        snprintf( pcExpected, sizeof( pcExpected ), "%03u", ( unsigned ) ulValue );
+        prvExpect( pcBuf, ucFmtU16Pad( pcBuf, ( uint16_t ) ulValue, 3 ), pcExpected );
+    }
+
+    for( ulIndex = 0; ulIndex < testRANDOM_VALUES; ulIndex++ )
+    {
+        /* Every fourth value is small so all digit counts are covered */
+        ulValue = prvRandom32() >> ( ( ulIndex & 3 ) * ( ulIndex & 7 ) );
+        snprintf( pcExpected, sizeof( pcExpected ), "%lu", ( unsigned long ) ulValue );
+        prvExpect( pcBuf, ucFmtU32( pcBuf, ulValue ), pcExpected );
+        snprintf( pcExpected, sizeof( pcExpected ), "%ld", ( long ) ( int32_t ) ulValue );
+        prvExpect( pcBuf, ucFmtS32( pcBuf, ( int32_t ) ulValue ), pcExpected );
+        snprintf( pcExpected, sizeof( pcExpected ), "%08lX", ( unsigned long ) ulValue );
+        prvExpect( pcBuf, ucFmtHex32( pcBuf, ulValue ), pcExpected );
+        hostCHECK( ulHALMPYMulHighU32( ulValue, 0xCCCCCCCDUL ) >> 3 == ulValue / 10,
+                   "%lu / 10", ( unsigned long ) ulValue );
+    }
+
+    prvExpect( pcBuf, ucFmtU32( pcBuf, UINT32_MAX ), "4294967295" );
+    prvExpect( pcBuf, ucFmtS32( pcBuf, INT32_MIN ), "-2147483648" );
+    prvExpect( pcBuf, ucFmtFixed( pcBuf, -1234, 2 ), "-12.34" );
+    prvExpect( pcBuf, ucFmtFixed( pcBuf, 5, 3 ), "0.005" );
+    prvExpect( pcBuf, ucFmtFixed( pcBuf, 0, 0 ), "0" );
+    prvExpect( pcBuf, ucFmtFixed( pcBuf, INT32_MIN, 9 ), "-2.147483648" );
+    prvExpect( pcBuf, ucFmtFixed( pcBuf, 123456789, 9 ), "0.123456789" );
+}
+
+/* Task3 before fmt.c: sign, then hundreds, tens and ones by division */
+static uint8_t prvFormatDivide( char *pcBuf, int16_t sValue )
+{
+    uint8_t ucIndex = 0;
+    int16_t sHundreds;
+    int16_t sTens;
+
+    if( sValue < 0 )
+    {
+        pcBuf[ ucIndex++ ] = '-';
+        sValue = -sValue;
+    }
+    sHundreds = sValue / 100;
+    sValue -= sHundreds * 100;
+    sTens = sValue / 10;
+    pcBuf[ ucIndex++ ] = ( char ) ( '0' + sHundreds );
+    pcBuf[ ucIndex++ ] = ( char ) ( '0' + sTens );
+    pcBuf[ ucIndex++ ] = ( char ) ( '0' + sValue - sTens * 10 );
+    return ucIndex;
+}
+
+static void prvTime( void )
+{
+    /* The divide variant only covers the three digit range Task3 sent */
+    static volatile int16_t sRange = 999;
+    char pcBuf[ 32 ];
+    uint64_t ullStart;
+    uint64_t pullNs[ 3 ];
+    uint32_t ulCalls = 0;
+    uint32_t ulSum = 0;
+    int16_t sValue;
+    int iPass;
+
+    ullStart = ullHostNowNs();
+    for( iPass = 0; iPass < testTIMED_PASSES; iPass++ )
+    {
+        for( sValue = -sRange; sValue <= sRange; sValue++ )
+        {
+            ulSum += ucFmtS16( pcBuf, sValue ) + ( uint8_t ) pcBuf[ 0 ];
+        }
+    }
+    pullNs[ 0 ] = ullHostNowNs() - ullStart;
+
+    ullStart = ullHostNowNs();
+    for( iPass = 0; iPass < testTIMED_PASSES; iPass++ )
+    {
+        for( sValue = -sRange; sValue <= sRange; sValue++ )
+        {
+            ulSum += ( uint32_t ) snprintf( pcBuf, sizeof( pcBuf ), "%d", sValue ) + ( uint8_t ) pcBuf[ 0 ];
+        }
+    }
+    pullNs[ 1 ] = ullHostNowNs() - ullStart;
+
+    ullStart = ullHostNowNs();
+    for( iPass = 0; iPass < testTIMED_PASSES; iPass++ )
+    {
+        for( sValue = -sRange; sValue <= sRange; sValue++ )
+        {
+            ulSum += prvFormatDivide( pcBuf, sValue ) + ( uint8_t ) pcBuf[ 0 ];
+            ulCalls++;
+        }
+    }
+    pullNs[ 2 ] = ullHostNowNs() - ullStart;
+    ulHostSink = ulSum;
+
+    printf( "  host ns per value (-999..999): ucFmtS16 %.1f, snprintf %.1f, /100 /10 split %.1f\n",
+            ( double ) pullNs[ 0 ] / ulCalls, ( double ) pullNs[ 1 ] / ulCalls,
+            ( double ) pullNs[ 2 ] / ulCalls );
+}
+
+int main( void )
+{
+    prvCheckAgainstSnprintf();
+    printf( "  fmt matches snprintf for all 16-bit and %lu random 32-bit values\n",
+            ( unsigned long ) testRANDOM_VALUES );
+    prvTime();
+    return 0;
+}
@@ -0,0 +1,198 @@
+/**
+ * @file test_lanes.c
+ * @brief Response and alarm latency behind a saturated bulk lane
+ *
+ * Sources: lanes.c
+ *
+ * Task3 is replayed with xLanesNext() against a UART at appUART_BAUD, 10
+ * bits per byte. prvUARTSend() returns once the last byte of a line or
+ * frame is in TXBUF, while the byte before it is still being shifted out,
+ * so Task3 picks the next one two byte times before the wire is free.
+ *
+ * The bulk lane never runs empty: it holds sample lines of
+ * appLINE_MAX_BYTES, or capture dumps (a header and data frames of
+ * appCAPTURE_SETS_PER_FRAME sets), or a mix of both with a log dump that
+ * sends frameMAX_SIZE frames whenever the lane is empty. Command responses
+ * of testRESPONSE_BYTES are queued one at a time, testARRIVALS of them at
+ * random instants.
+ *
+ * The latency is the time from queueing to the last byte of the response
+ * on the wire. It must not exceed the two bytes of the hand-over, the
+ * longest bulk frame and the response itself: one capture frame plus one
+ * control line with capture dumps, one log frame plus one line with the
+ * log dump.
+ *
+ * Alarm lines take the same control lane. Their latency field is the time
+ * from the conversion to formatting, when Task3 takes the line. Task1
+ * queues the alarm right after the conversion it checks, so apart from the
+ * work of Task1 (not modelled here) the field is at most the longest bulk
+ * frame, and the alarm is on the wire one hand-over and one alarm line
+ * later. Alarms of several channels changing at once add one line each.
+ */
+
+#include <string.h>
+
+#include "host_test.h"
+#include "app_config.h"
+#include "capture.h"
+#include "frame.h"
+#include "lanes.h"
+
+#define testARRIVALS            ( 200000UL )
+/* "D: nnnnn ttttt.ss\n\r" and the other command responses */
+#define testRESPONSE_BYTES      ( 20 )
+/* "!c: H vvvvv llllll ttttt.ss\n\r": channel, state, value, latency up to 1 s, timestamp */
+#define testALARM_BYTES         ( 1 + 1 + 2 + 1 + 1 + 5 + 1 + 6 + 9 + 2 )
+/* Longest gap between a response on the wire and the next one, us */
+#define testMAX_GAP_US          ( 200000UL )
+
+#define testBYTE_US             ( 10.0e6 / appUART_BAUD )
+#define testHEADER_BYTES        ( 13 + frameOVERHEAD )
+#define testCAPTURE_BYTES       ( 2 + captureBYTES_FOR_SETS( appCAPTURE_SETS_PER_FRAME ) + frameOVERHEAD )
+#define testCAPTURE_FRAMES      ( ( appCAPTURE_DEPTH + appCAPTURE_SETS_PER_FRAME - 1 ) / appCAPTURE_SETS_PER_FRAME )
+#define testLOG_BYTES           ( frameMAX_SIZE )
+
+typedef enum{
+    BULK_LINES,             // sample lines only
+    BULK_CAPTURES,          // capture dumps back to back
+    BULK_MIXED              // lines and dumps, log dump in the gaps
+}Bulk_t;
+
+typedef struct{
+    double   dMax;
+    double   dFormatMax;    // queueing to Task3 taking the line
+    double   dSum;
+    uint32_t ulCount;
+    uint32_t ulLongestFrame;
+}Latency_t;
+
+static uint32_t ulSeed;
+
+static uint32_t prvRandom( void )
+{
+    ulSeed = ulSeed * 1103515245UL + 12345UL;
+    return ulSeed >> 8;
+}
+
+/* Replay Task3 until testARRIVALS responses have been sent */
+static void prvRun( Bulk_t xBulk, uint16_t usResponseBytes, Latency_t *pxResult )
+{
+    Lanes_t xLanes;
+    LanesNext_t xNext;
+    double dNow = 0.0;          // Task3 at the frame boundary
+    double dWireFree = 0.0;     // last byte on the wire
+    double dArrival;
+    uint32_t ulBytes;
+    bool xWaiting = false;
+    bool xBulkWaiting;
+
+    memset( pxResult, 0, sizeof( *pxResult ) );
+    ulSeed = 7;
+    vLanesInit( &xLanes );
+    vLanesLogDump( &xLanes, xBulk == BULK_MIXED );
+    dArrival = prvRandom() % testMAX_GAP_US;
+
+    while( pxResult->ulCount < testARRIVALS )
+    {
+        if( !xWaiting && dArrival <= dNow )
+        {
+            xWaiting = true;
+        }
+        /* The mix leaves the bulk lane empty one frame boundary in four */
+        xBulkWaiting = ( xBulk != BULK_MIXED ) || ( prvRandom() % 4U != 0 );
+        xNext = xLanesNext( &xLanes, xWaiting, xBulkWaiting );
+
+        switch( xNext )
+        {
+        case LANES_CONTROL:
+            ulBytes = usResponseBytes;
+            break;
+        case LANES_DUMP:
+            ulBytes = testCAPTURE_BYTES;
+            break;
+        case LANES_BULK:
+            if( xBulk == BULK_CAPTURES || ( xBulk == BULK_MIXED && prvRandom() % 8U == 0 ) )
+            {
+                vLanesStartDump( &xLanes, testCAPTURE_FRAMES );
+                ulBytes = testHEADER_BYTES;
+            }
+            else
+            {
+                ulBytes = appLINE_MAX_BYTES;
+            }
+            break;
+        case LANES_LOG:
+            ulBytes = testLOG_BYTES;
+            break;
+        case LANES_WAIT:
+        default:
+            /* Woken by the next record */
+            dNow = ( dArrival > dNow ) ? dArrival : dNow;
+            continue;
+        }
+
+        if( xNext == LANES_CONTROL )
+        {
+            pxResult->dFormatMax = ( dNow - dArrival > pxResult->dFormatMax ) ? dNow - dArrival : pxResult->dFormatMax;
+        }
+
+        /* Handed over; Task3 is back two bytes before the wire is free */
+        dWireFree = ( ( dNow > dWireFree ) ? dNow : dWireFree ) + ulBytes * testBYTE_US;
+        dNow = dWireFree - 2.0 * testBYTE_US;
+        if( xNext != LANES_CONTROL )
+        {
+            pxResult->ulLongestFrame = ( ulBytes > pxResult->ulLongestFrame ) ? ulBytes : pxResult->ulLongestFrame;
+            continue;
+        }
+
+        pxResult->dMax = ( dWireFree - dArrival > pxResult->dMax ) ? dWireFree - dArrival : pxResult->dMax;
+        pxResult->dSum += dWireFree - dArrival;
+        pxResult->ulCount++;
+        xWaiting = false;
+        dArrival = dWireFree + prvRandom() % testMAX_GAP_US;
+    }
+}
+
+static void prvCheck( const char *pcName, Bulk_t xBulk, uint16_t usLongest )
+{
+    Latency_t xLanes;
+    double dBound = ( 2U + usLongest + testRESPONSE_BYTES ) * testBYTE_US;
+
+    prvRun( xBulk, testRESPONSE_BYTES, &xLanes );
+    printf( "  %-30s worst %5.1f ms, mean %4.1f ms, bound %5.1f ms (%u B frame)\n", pcName,
+            xLanes.dMax / 1000.0, xLanes.dSum / xLanes.ulCount / 1000.0, dBound / 1000.0, usLongest );
+    hostCHECK( xLanes.ulLongestFrame == usLongest, "longest frame %lu B", ( unsigned long ) xLanes.ulLongestFrame );
+    hostCHECK( xLanes.dMax <= dBound, "%s: %.1f ms over the bound of %.1f ms", pcName, xLanes.dMax / 1000.0,
+               dBound / 1000.0 );
+    hostCHECK( xLanes.dMax > dBound - 2.0 * testBYTE_US, "%s: the worst case was never reached", pcName );
+}
+
+static void prvCheckAlarm( const char *pcName, Bulk_t xBulk, uint16_t usLongest )
+{
+    Latency_t xLanes;
+    double dFormatBound = usLongest * testBYTE_US;
+    double dBound = ( 2U + usLongest + testALARM_BYTES ) * testBYTE_US;
+
+    prvRun( xBulk, testALARM_BYTES, &xLanes );
+    printf( "  %-30s field %4.1f ms, bound %4.1f ms; on the wire %5.1f ms, bound %5.1f ms\n", pcName,
+            xLanes.dFormatMax / 1000.0, dFormatBound / 1000.0, xLanes.dMax / 1000.0, dBound / 1000.0 );
+    hostCHECK( xLanes.dFormatMax <= dFormatBound, "%s: latency field %.1f ms over the bound of %.1f ms", pcName,
+               xLanes.dFormatMax / 1000.0, dFormatBound / 1000.0 );
+    hostCHECK( xLanes.dFormatMax > dFormatBound - 2.0 * testBYTE_US, "%s: the worst field was never reached", pcName );
+    hostCHECK( xLanes.dMax <= dBound, "%s: %.1f ms over the bound of %.1f ms", pcName, xLanes.dMax / 1000.0,
+               dBound / 1000.0 );
+}
+
+int main( void )
+{
+    printf( "  %lu responses of %u B at %lu baud behind a saturated bulk lane:\n",
+            ( unsigned long ) testARRIVALS, testRESPONSE_BYTES, ( unsigned long ) appUART_BAUD );
+    prvCheck( "sample lines", BULK_LINES, appLINE_MAX_BYTES );
+    prvCheck( "capture dumps", BULK_CAPTURES, testCAPTURE_BYTES );
+    prvCheck( "lines, capture and log dumps", BULK_MIXED, testLOG_BYTES );
+    printf( "  alarms of %u B, latency field and last byte on the wire:\n", testALARM_BYTES );
+    prvCheckAlarm( "sample lines", BULK_LINES, appLINE_MAX_BYTES );
+    prvCheckAlarm( "capture dumps", BULK_CAPTURES, testCAPTURE_BYTES );
+    prvCheckAlarm( "lines, capture and log dumps", BULK_MIXED, testLOG_BYTES );
+    return 0;
+}
@@ -0,0 +1,259 @@
+/**
+ * @file test_log.c
+ * @brief Flash log recovery after power failures, and its throughput
+ *
+ * Sources: log.c ETF5529_HAL/hal_flash.c ETF5529_HAL/hal_crc.c
+ *
+ * Four channels at 10, 20, 100 and 1000 ticks are logged into a ring of
+ * testSEGMENTS segments that starts out neither erased nor formatted. The
+ * input of a channel is a function of the channel and the tick - a ramp of
+ * one LSB per sample over 2000 codes with one LSB of noise, and a jump to
+ * a random code in 3 % of the samples - so every sample read back can be
+ * checked against it.
+ *
+ * The clean run reports the flash bytes per sample, the operations and the
+ * time the flash controller is busy, against the data sheet figures of
+ * 85 us per word and 32 ms per segment erase.
+ *
+ * The power failure run sets ulHALFlashPowerBudget to cut the power in the
+ * middle of a random erase or block write, leaving that word half done,
+ * again and again. After each cut the log is recovered with vLogInit() and
+ * must hold every block whose write had completed, back to the oldest one
+ * kept, in order and with the samples of the input; sequence numbers must
+ * not be reused.
+ */
+
+#include <setjmp.h>
+#include <string.h>
+
+#include "host_test.h"
+#include "log.h"
+#include "hal_flash.h"
+
+#define testSEGMENTS            ( 16 )
+#define testCHANNELS            ( 4 )
+#define testRUN_TICKS           ( 2000000UL )
+#define testCUTS                ( 2000 )
+#define testMAX_BLOCKS          ( 1UL << 16 )
+/* Data sheet: word write and segment erase */
+#define testWORD_US             ( 85.0 )
+#define testERASE_US            ( 32000.0 )
+
+static uint8_t pucFlash[ testSEGMENTS * halFLASH_MAIN_SEGMENT ] __attribute__ ( ( aligned( halFLASH_MAIN_SEGMENT ) ) );
+static const uint16_t pusPeriod[ testCHANNELS ] = { 10, 20, 100, 1000 };
+
+/* Blocks whose write has completed, by sequence number */
+static uint8_t pucCommitted[ testMAX_BLOCKS ];
+static jmp_buf xPowerFail;
+
+typedef struct{
+    uint32_t ulSamples;
+    uint32_t ulWords;
+    uint32_t ulErases;
+    uint32_t ulWrites;
+    uint32_t ulCuts;
+    uint32_t ulChecked;
+}Result_t;
+
+void vHALFlashPowerFail( void )
+{
+    longjmp( xPowerFail, 1 );
+}
+
+static uint32_t prvHash( uint32_t ulValue )
+{
+    ulValue ^= ulValue >> 16;
+    ulValue *= 0x7FEB352DUL;
+    ulValue ^= ulValue >> 15;
+    ulValue *= 0x846CA68BUL;
+    ulValue ^= ulValue >> 16;
+    return ulValue;
+}
+
+/* Input of ucChannel at ulTick */
+static uint16_t prvSignal( uint8_t ucChannel, uint32_t ulTick )
+{
+    uint32_t ulHash = prvHash( ulTick * testCHANNELS + ucChannel );
+    int32_t lValue;
+
+    if( ulHash % 100U < 3U )
+    {
+        return ( uint16_t ) ( ( ulHash >> 8 ) % 4096U );
+    }
+    lValue = 2048 + ( int32_t ) ( ( ( ulTick / pusPeriod[ ucChannel ] ) % 2000U ) ) - 1000 +
+             ( int32_t ) ( ( ulHash >> 8 ) % 3U ) - 1;
+    return ( uint16_t ) lValue;
+}
+
+/* Carry out every pending operation, as the log task does when it may */
+static void prvSteps( Result_t *pxResult )
+{
+    LogStats_t xStats;
+    LogOp_t xOp;
+    const LogBlock_t *pxBlock;
+
+    while( ( xOp = xLogPending() ) != LOG_IDLE )
+    {
+        vLogGetStats( &xStats );
+        vLogStep();
+        if( xOp == LOG_ERASE )
+        {
+            pxResult->ulErases++;
+            continue;
+        }
+        pxBlock = pxLogFind( xStats.ulNext );
+        hostCHECK( pxBlock != 0 && pxBlock->ulSequence == xStats.ulNext, "block %lu not found after its write",
+                   ( unsigned long ) xStats.ulNext );
+        hostCHECK( xStats.ulNext < testMAX_BLOCKS, "more than %lu blocks", testMAX_BLOCKS );
+        pucCommitted[ xStats.ulNext ] = 1;
+        pxResult->ulWrites++;
+        pxResult->ulWords += logBLOCK_SIZE( pxBlock->usLength ) / 2U;
+    }
+}
+
+/* Every block kept must be one written, and every one written back to the oldest kept must be there */
+static void prvVerify( Result_t *pxResult )
+{
+    uint16_t pusValues[ 256 ];
+    const LogBlock_t *pxBlock;
+    LogStats_t xStats;
+    uint32_t ulSequence;
+    uint32_t ulLast = 0;
+    uint32_t ulCommittedEnd = 0;
+    uint8_t ucCount;
+    uint8_t ucSample;
+    bool xFirst = true;
+
+    vLogGetStats( &xStats );
+    for( ulSequence = 0; ulSequence < testMAX_BLOCKS; ulSequence++ )
+    {
+        ulCommittedEnd = pucCommitted[ ulSequence ] ? ulSequence + 1UL : ulCommittedEnd;
+    }
+    hostCHECK( xStats.ulNext >= ulCommittedEnd, "next block %lu reuses a written one, %lu written",
+               ( unsigned long ) xStats.ulNext, ( unsigned long ) ulCommittedEnd );
+
+    for( ulSequence = xStats.ulOldest; ( pxBlock = pxLogFind( ulSequence ) ) != 0;
+         ulSequence = pxBlock->ulSequence + 1UL )
+    {
+        hostCHECK( xFirst || pxBlock->ulSequence > ulLast, "block %lu after %lu",
+                   ( unsigned long ) pxBlock->ulSequence, ( unsigned long ) ulLast );
+        hostCHECK( pxBlock->ulSequence < testMAX_BLOCKS && pucCommitted[ pxBlock->ulSequence ],
+                   "block %lu was never written", ( unsigned long ) pxBlock->ulSequence );
+        ucCount = ucLogDecode( pxBlock, pusValues );
+        hostCHECK( pxBlock->ucChannel < testCHANNELS && pxBlock->usPeriod == pusPeriod[ pxBlock->ucChannel ],
+                   "block %lu: channel %u period %u", ( unsigned long ) pxBlock->ulSequence,
+                   pxBlock->ucChannel, pxBlock->usPeriod );
+        for( ucSample = 0; ucSample < ucCount; ucSample++ )
+        {
+            hostCHECK( pusValues[ ucSample ] ==
+                       prvSignal( pxBlock->ucChannel, pxBlock->ulTicks + ( uint32_t ) ucSample * pxBlock->usPeriod ),
+                       "block %lu sample %u: %u", ( unsigned long ) pxBlock->ulSequence, ucSample,
+                       pusValues[ ucSample ] );
+        }
+        xFirst = false;
+        ulLast = pxBlock->ulSequence;
+        pxResult->ulChecked++;
+    }
+
+    for( ulSequence = xStats.ulOldest; ulSequence < ulCommittedEnd; ulSequence++ )
+    {
+        pxBlock = pxLogFind( ulSequence );
+        hostCHECK( pucCommitted[ ulSequence ] == 0 || ( pxBlock != 0 && pxBlock->ulSequence == ulSequence ),
+                   "written block %lu lost, oldest kept %lu", ( unsigned long ) ulSequence,
+                   ( unsigned long ) xStats.ulOldest );
+    }
+}
+
+static void prvRun( uint32_t ulCuts, Result_t *pxResult )
+{
+    static volatile uint32_t ulTick;
+    static uint32_t pulDue[ testCHANNELS ];
+    static uint32_t ulSeed;
+    uint8_t ucChannel;
+
+    memset( pucFlash, 0xA5, sizeof( pucFlash ) );
+    memset( pucCommitted, 0, sizeof( pucCommitted ) );
+    memset( pxResult, 0, sizeof( *pxResult ) );
+    memset( pulDue, 0, sizeof( pulDue ) );
+    ulSeed = 7;
+    ulTick = 0;
+    ulHALFlashPowerBudget = 0;
+    vLogInit( pucFlash, testSEGMENTS );
+
+    if( setjmp( xPowerFail ) != 0 )
+    {
+        /* The samples being collected are lost, logging goes on from the next tick */
+        pxResult->ulCuts++;
+        ulHALFlashPowerBudget = 0;
+        vLogInit( pucFlash, testSEGMENTS );
+        prvVerify( pxResult );
+        for( ucChannel = 0; ucChannel < testCHANNELS; ucChannel++ )
+        {
+            pulDue[ ucChannel ] = ( ulTick / pusPeriod[ ucChannel ] + 1UL ) * pusPeriod[ ucChannel ];
+        }
+    }
+
+    for( ; ulTick < testRUN_TICKS; ulTick++ )
+    {
+        for( ucChannel = 0; ucChannel < testCHANNELS; ucChannel++ )
+        {
+            if( pulDue[ ucChannel ] != ulTick )
+            {
+                continue;
+            }
+            while( xLogAdd( ucChannel, prvSignal( ucChannel, ulTick ), ulTick, pusPeriod[ ucChannel ] ) == false )
+            {
+                prvSteps( pxResult );
+            }
+            pxResult->ulSamples++;
+            pulDue[ ucChannel ] += pusPeriod[ ucChannel ];
+        }
+        if( pxResult->ulCuts < ulCuts && ulHALFlashPowerBudget == 0 && xLogPending() != LOG_IDLE )
+        {
+            ulSeed = prvHash( ulSeed );
+            /* Anywhere in an erase (256 words) or a block write */
+            ulHALFlashPowerBudget = 1UL + ulSeed % 300UL;
+        }
+        prvSteps( pxResult );
+    }
+    ulHALFlashPowerBudget = 0;
+    prvVerify( pxResult );
+}
+
+static void prvCleanRun( void )
+{
+    Result_t xResult;
+    LogStats_t xStats;
+    double dBusyUs;
+    double dSeconds = testRUN_TICKS / 1000.0;
+
+    prvRun( 0, &xResult );
+    vLogGetStats( &xStats );
+    dBusyUs = xResult.ulWords * testWORD_US + xResult.ulErases * testERASE_US;
+    printf( "  clean run: %lu samples in %.0f s, %lu blocks kept, segments erased up to %u times\n",
+            ( unsigned long ) xResult.ulSamples, dSeconds, ( unsigned long ) xResult.ulChecked,
+            xStats.usMaxErase );
+    printf( "    %.2f flash bytes per sample (2 raw), %lu block writes, %lu erases\n",
+            2.0 * xResult.ulWords / xResult.ulSamples,
+            ( unsigned long ) xResult.ulWrites, ( unsigned long ) xResult.ulErases );
+    printf( "    flash busy %.2f %% of the time: %.1f us per sample, so at most %.0f samples/s\n",
+            dBusyUs / ( dSeconds * 1e4 ), dBusyUs / xResult.ulSamples, 1e6 * xResult.ulSamples / dBusyUs );
+    hostCHECK( xResult.ulErases > testSEGMENTS * 4, "the ring did not wrap" );
+}
+
+static void prvPowerFailRun( void )
+{
+    Result_t xResult;
+
+    prvRun( testCUTS, &xResult );
+    printf( "  %lu power failures during erases and writes: every written block recovered, "
+            "%lu block checks\n", ( unsigned long ) xResult.ulCuts, ( unsigned long ) xResult.ulChecked );
+    hostCHECK( xResult.ulCuts == testCUTS, "%lu cuts", ( unsigned long ) xResult.ulCuts );
+}
+
+int main( void )
+{
+    prvCleanRun();
+    prvPowerFailRun();
+    return 0;
+}
@@ -0,0 +1,219 @@
+/**
+ * @file test_mpy.cpp
+ * @brief hal_mpy register paths and the statistics built on them
+ *
+ * Sources: ETF5529_HAL/hal_mpy.c stats.c
+ * Flags: -D__MSP430__ -D__MSP430_HAS_MPY32__
+ *
+ * hal_mpy is built for the MPY32 and runs against the register model of
+ * periph/msp430.h; results are compared with plain 64-bit arithmetic.
+ * Statistics windows of full-scale 16-bit samples check that the MAC carry
+ * reaches the 48-bit sum of squares.
+ *
+ * The benchmark reports, per kernel, the multiplier register accesses per
+ * sample and the longest interrupt-disabled section, as counted by the
+ * model, next to host nanoseconds per sample of the portable fallback
+ * (the same C expression, built here as prvScaleQ15Portable() etc.).
+ */
+
+#include <math.h>
+
+#include "host_test.h"
+#include "msp430.h"
+#include "hal_mpy.h"
+#include "stats.h"
+
+static uint32_t ulSeed = 7;
+
+static uint32_t prvRandom32( void )
+{
+    ulSeed ^= ulSeed << 13;
+    ulSeed ^= ulSeed >> 17;
+    ulSeed ^= ulSeed << 5;
+    return ulSeed;
+}
+
+static void prvCheckPrimitives( void )
+{
+    uint32_t ulIndex;
+    uint32_t ulAcc;
+    uint32_t ulA;
+    uint32_t ulB;
+    uint16_t usCarry;
+    uint16_t usA;
+    uint16_t usB;
+    uint64_t ullExpected;
+    int16_t psBlock[ 37 ];
+    int16_t sGain;
+
+    for( ulIndex = 0; ulIndex < 1000000UL; ulIndex++ )
+    {
+        ulAcc = prvRandom32();
+        usA = ( uint16_t ) prvRandom32();
+        usB = ( uint16_t ) prvRandom32();
+        usCarry = 3;
+        ullExpected = ( uint64_t ) ulAcc + ( uint32_t ) usA * usB;
+        hostCHECK( ulHALMPYMacU( ulAcc, usA, usB, &usCarry ) == ( uint32_t ) ullExpected &&
+                   usCarry == 3 + ( ullExpected >> 32 ), "mac %lu + %u * %u",
+                   ( unsigned long ) ulAcc, usA, usB );
+
+        ulA = prvRandom32();
+        ulB = prvRandom32();
+        hostCHECK( lHALMPYMulS32x16( ( int32_t ) ulA, ( int16_t ) ulB, ( uint8_t ) ( ulIndex % 17 ) ) ==
+                   ( int32_t ) ( ( ( int64_t ) ( int32_t ) ulA * ( int16_t ) ulB ) >> ( ulIndex % 17 ) ),
+                   "mul32x16 %ld * %d", ( long ) ( int32_t ) ulA, ( int16_t ) ulB );
+        hostCHECK( ulHALMPYMulHighU32( ulA, ulB ) == ( uint32_t ) ( ( ( uint64_t ) ulA * ulB ) >> 32 ),
+                   "mulhigh %lu * %lu", ( unsigned long ) ulA, ( unsigned long ) ulB );
+    }
+
+    for( ulIndex = 0; ulIndex < 10000UL; ulIndex++ )
+    {
+        uint16_t usSample;
+
+        sGain = ( int16_t ) prvRandom32();
+        for( usSample = 0; usSample < 37; usSample++ )
+        {
+            psBlock[ usSample ] = ( int16_t ) prvRandom32();
+        }
+        {
+            int16_t psInput[ 37 ];
+
+            for( usSample = 0; usSample < 37; usSample++ )
+            {
+                psInput[ usSample ] = psBlock[ usSample ];
+            }
+            vHALMPYScaleQ15( psBlock, 37, sGain );
+            for( usSample = 0; usSample < 37; usSample++ )
+            {
+                hostCHECK( psBlock[ usSample ] == ( int16_t ) ( ( ( int32_t ) psInput[ usSample ] * sGain ) >> 15 ),
+                           "scale %d * %d", psInput[ usSample ], sGain );
+            }
+        }
+    }
+}
+
+static void prvCheckStats( void )
+{
+    StatsWindow_t xWindow;
+    StatsSummary_t xSummary;
+    uint8_t ucLog2;
+    uint16_t usCount;
+    uint16_t usSample;
+    uint64_t ullSquares;
+    uint32_t ulOperations;
+    int iWindow;
+
+    for( ucLog2 = 0; ucLog2 <= statsMAX_WINDOW_LOG2; ucLog2++ )
+    {
+        for( iWindow = 0; iWindow < 200; iWindow++ )
+        {
+            vStatsInit( &xWindow, ucLog2 );
+            ullSquares = 0;
+            ulOperations = xHostMpyState.ulOperations;
+            for( usCount = 0; usCount < ( 1U << ucLog2 ); usCount++ )
+            {
+                /* Window 0 is all full scale, the rest are random */
+                usSample = ( iWindow == 0 ) ? 0xFFFF : ( uint16_t ) prvRandom32();
+                ullSquares += ( uint32_t ) usSample * usSample;
+                hostCHECK( xStatsAdd( &xWindow, usSample, &xSummary ) == ( usCount + 1U == ( 1U << ucLog2 ) ),
+                           "window end" );
+            }
+            hostCHECK( xHostMpyState.ulOperations - ulOperations == ( 1UL << ucLog2 ),
+                       "one MPY32 MAC per sample" );
+            hostCHECK( xSummary.usRms == ( uint16_t ) sqrtl( ( long double ) ( ullSquares >> ucLog2 ) ),
+                       "rms of 2^%u samples: %u, expected %u", ucLog2, xSummary.usRms,
+                       ( unsigned ) sqrtl( ( long double ) ( ullSquares >> ucLog2 ) ) );
+        }
+    }
+}
+
+/* The fallback kernels of hal_mpy.c, for the host timing */
+static void prvScaleQ15Portable( int16_t *psBlock, uint16_t usLength, int16_t sGain )
+{
+    while( usLength-- > 0 )
+    {
+        *psBlock = ( int16_t ) ( ( ( int32_t ) *psBlock * sGain ) >> 15 );
+        psBlock++;
+    }
+}
+
+static uint32_t prvMacPortable( uint32_t ulAcc, uint16_t usA, uint16_t usB, uint16_t *pusCarry )
+{
+    uint32_t ulResult = ulAcc + ( uint32_t ) usA * usB;
+
+    if( ulResult < ulAcc )
+    {
+        ( *pusCarry )++;
+    }
+    return ulResult;
+}
+
+static void prvReport( const char *pcKernel, uint32_t ulSamples, uint64_t ullPortableNs,
+                       uint32_t ulPortableSamples )
+{
+    printf( "  %-36s %5.2f accesses/sample, longest lock %2lu accesses, portable %.2f ns/sample\n",
+            pcKernel, ( double ) ulHostAccesses / ulSamples, ( unsigned long ) ulHostLongestLock,
+            ( double ) ullPortableNs / ulPortableSamples );
+    ulHostAccesses = 0;
+    ulHostLocks = 0;
+    ulHostLongestLock = 0;
+}
+
+static void prvBenchmark( void )
+{
+    static int16_t psBlock[ 64 ];
+    uint32_t ulAcc = 0;
+    uint16_t usCarry = 0;
+    uint32_t ulIndex;
+    uint64_t ullStart;
+    uint64_t ullNs;
+
+    for( ulIndex = 0; ulIndex < 64; ulIndex++ )
+    {
+        psBlock[ ulIndex ] = ( int16_t ) prvRandom32();
+    }
+
+    ullStart = ullHostNowNs();
+    for( ulIndex = 0; ulIndex < 100000UL; ulIndex++ )
+    {
+        prvScaleQ15Portable( psBlock, 64, 0x7FF0 );
+    }
+    ullNs = ullHostNowNs() - ullStart;
+    ulHostAccesses = 0;
+    ulHostLongestLock = 0;
+    vHALMPYScaleQ15( psBlock, 64, 0x7FF0 );
+    prvReport( "vHALMPYScaleQ15 (64-sample block)", 64, ullNs, 6400000UL );
+
+    ullStart = ullHostNowNs();
+    for( ulIndex = 0; ulIndex < 10000000UL; ulIndex++ )
+    {
+        ulAcc = prvMacPortable( ulAcc, ( uint16_t ) ulIndex, ( uint16_t ) ulIndex, &usCarry );
+    }
+    ullNs = ullHostNowNs() - ullStart;
+    ulHostSink = ulAcc + usCarry;
+    ulHostAccesses = 0;
+    ulHostLongestLock = 0;
+    ulAcc = ulHALMPYMacU( ulAcc, 1234, 1234, &usCarry );
+    prvReport( "ulHALMPYMacU (stats, per sample)", 1, ullNs, 10000000UL );
+
+    ullStart = ullHostNowNs();
+    for( ulIndex = 0; ulIndex < 10000000UL; ulIndex++ )
+    {
+        ulAcc += ( uint32_t ) ( ( ( uint64_t ) ( ulAcc ^ ulIndex ) * 0xCCCCCCCDUL ) >> 32 );
+    }
+    ullNs = ullHostNowNs() - ullStart;
+    ulHostSink = ulAcc;
+    ulHostAccesses = 0;
+    ulHostLongestLock = 0;
+    ulAcc = ulHALMPYMulHighU32( ulAcc, 0xCCCCCCCDUL );
+    prvReport( "ulHALMPYMulHighU32 (fmt, per digit)", 1, ullNs, 10000000UL );
+}
+
+int main( void )
+{
+    prvCheckPrimitives();
+    prvCheckStats();
+    printf( "  MPY32 paths match 64-bit arithmetic; stats RMS exact for 16-bit windows of 1..256\n" );
+    prvBenchmark();
+    return 0;
+}
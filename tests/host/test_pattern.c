@@ -0,0 +1,130 @@
+/**
+ * @file test_pattern.c
+ * @brief LED states of the blink patterns, step by step
+ *
+ * Sources: pattern.c
+ *
+ * ucPatternStep() is called as the tick hook does, once per step, and the
+ * returned mask is recorded as '#' (lit) or '.' (dark); any other value is
+ * a failure. The records must match the heartbeat and the blink codes over
+ * two repetitions. A new base pattern or override starts at its first
+ * step, setting the same one again does not. A flash inverts exactly one
+ * step and leaves the next one as it is, also when flashes are requested
+ * every step, and a flash requested during an override is not shown, then
+ * or after the override ends.
+ */
+
+#include <string.h>
+
+#include "host_test.h"
+#include "pattern.h"
+
+#define testMASK                ( 0x40 )
+#define testMAX_STEPS           ( 64 )
+
+/* Step the LED ucSteps times, with a flash requested before every step if xFlash */
+static const char *prvRecord( PatternLed_t *pxLed, uint8_t ucSteps, bool xFlash )
+{
+    static char pcSteps[ testMAX_STEPS + 1 ];
+    uint8_t ucMask;
+    uint8_t ucStep;
+
+    for( ucStep = 0; ucStep < ucSteps; ucStep++ )
+    {
+        if( xFlash )
+        {
+            vPatternFlash( pxLed );
+        }
+        ucMask = ucPatternStep( pxLed );
+        hostCHECK( ucMask == 0 || ucMask == testMASK, "step %u: mask 0x%02x", ucStep, ucMask );
+        pcSteps[ ucStep ] = ucMask ? '#' : '.';
+    }
+    pcSteps[ ucSteps ] = '\0';
+    return pcSteps;
+}
+
+static void prvExpect( const char *pcName, const char *pcSteps, const char *pcExpected )
+{
+    hostCHECK( strcmp( pcSteps, pcExpected ) == 0, "%s: %s, expected %s", pcName, pcSteps, pcExpected );
+    printf( "  %-36s %s\n", pcName, pcSteps );
+}
+
+static void prvPatterns( void )
+{
+    PatternLed_t xLed;
+
+    vPatternInit( &xLed, testMASK, PATTERN_HEARTBEAT );
+    prvExpect( "heartbeat", prvRecord( &xLed, 20, false ), "#.#.......#.#......." );
+    vPatternInit( &xLed, testMASK, PATTERN_CODE_1 );
+    prvExpect( "code 1", prvRecord( &xLed, 40, false ), "##..................##.................." );
+    vPatternInit( &xLed, testMASK, PATTERN_CODE_2 );
+    prvExpect( "code 2", prvRecord( &xLed, 40, false ), "##..##..............##..##.............." );
+    vPatternInit( &xLed, testMASK, PATTERN_CODE_3 );
+    prvExpect( "code 3", prvRecord( &xLed, 40, false ), "##..##..##..........##..##..##.........." );
+    vPatternInit( &xLed, testMASK, PATTERN_OFF );
+    prvExpect( "off", prvRecord( &xLed, 4, false ), "...." );
+    vPatternInit( &xLed, testMASK, PATTERN_ON );
+    prvExpect( "on", prvRecord( &xLed, 4, false ), "####" );
+}
+
+static void prvChanges( void )
+{
+    PatternLed_t xLed;
+
+    /* A new base starts at its first step, the same one keeps its place */
+    vPatternInit( &xLed, testMASK, PATTERN_HEARTBEAT );
+    ( void ) prvRecord( &xLed, 3, false );
+    vPatternSetBase( &xLed, PATTERN_CODE_2 );
+    prvExpect( "base changed after 3 steps", prvRecord( &xLed, 8, false ), "##..##.." );
+    vPatternSetBase( &xLed, PATTERN_CODE_2 );
+    prvExpect( "same base set again", prvRecord( &xLed, 4, false ), "...." );
+
+    /* So does an override, and the base after it */
+    vPatternInit( &xLed, testMASK, PATTERN_HEARTBEAT );
+    ( void ) prvRecord( &xLed, 5, false );
+    vPatternSetOverride( &xLed, PATTERN_CODE_1 );
+    prvExpect( "override after 5 steps", prvRecord( &xLed, 4, false ), "##.." );
+    vPatternSetOverride( &xLed, PATTERN_CODE_1 );
+    prvExpect( "same override set again", prvRecord( &xLed, 4, false ), "...." );
+    vPatternSetOverride( &xLed, PATTERN_NONE );
+    prvExpect( "override cleared", prvRecord( &xLed, 10, false ), "#.#......." );
+}
+
+static void prvFlashes( void )
+{
+    PatternLed_t xLed;
+
+    /* One inverted step, then one plain step */
+    vPatternInit( &xLed, testMASK, PATTERN_OFF );
+    vPatternFlash( &xLed );
+    prvExpect( "flash on off", prvRecord( &xLed, 4, false ), "#..." );
+    vPatternInit( &xLed, testMASK, PATTERN_ON );
+    vPatternFlash( &xLed );
+    prvExpect( "flash on on", prvRecord( &xLed, 4, false ), ".###" );
+    vPatternInit( &xLed, testMASK, PATTERN_HEARTBEAT );
+    ( void ) prvRecord( &xLed, 2, false );
+    vPatternFlash( &xLed );
+    prvExpect( "flash on heartbeat step 2", prvRecord( &xLed, 10, false ), "........#." );
+
+    /* A request during the plain step waits for the step after it */
+    vPatternInit( &xLed, testMASK, PATTERN_OFF );
+    prvExpect( "flash before every step", prvRecord( &xLed, 12, true ), "#.#.#.#.#.#." );
+    prvExpect( "last request, in a plain step", prvRecord( &xLed, 4, false ), "#..." );
+
+    /* Not shown over an override, nor once the override is cleared */
+    vPatternInit( &xLed, testMASK, PATTERN_OFF );
+    vPatternSetOverride( &xLed, PATTERN_ON );
+    prvExpect( "flash before every step, ON override", prvRecord( &xLed, 6, true ), "######" );
+    vPatternFlash( &xLed );
+    prvExpect( "one flash during the override", prvRecord( &xLed, 2, false ), "##" );
+    vPatternSetOverride( &xLed, PATTERN_NONE );
+    prvExpect( "override cleared", prvRecord( &xLed, 4, false ), "...." );
+}
+
+int main( void )
+{
+    prvPatterns();
+    prvChanges();
+    prvFlashes();
+    return 0;
+}
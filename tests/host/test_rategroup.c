@@ -0,0 +1,152 @@
+/**
+ * @file test_rategroup.c
+ * @brief Delivered rate of every channel and the conversions rate groups save
+ *
+ * Sources: rategroup.c
+ *
+ * The tick hook is replayed for 100000 ticks, once with the periods of
+ * appCHANNELS and once with mixed periods of 1 tick to 1 s. Every channel
+ * must be due exactly every period, and usRateGroupNextDue() must predict
+ * the next due tick. The test reports the conversions and ADC sequences -
+ * internal and external channels are never converted together - against
+ * converting every channel at the fastest rate, as the single ADC timer did.
+ * Period changes must take effect within the new period when speeding up
+ * and keep the phase when slowing down.
+ */
+
+#include <string.h>
+
+#include "host_test.h"
+#include "rategroup.h"
+
+#define testTICKS               ( 100000UL )
+
+volatile uint16_t usCriticalNesting;
+
+static void prvRun( const char *pcName, const uint16_t *pusPeriod )
+{
+    uint32_t pulCount[ appNUM_CHANNELS ];
+    uint32_t pulLast[ appNUM_CHANNELS ];
+    uint32_t ulConversions = 0;
+    uint32_t ulSequences = 0;
+    uint32_t ulTick;
+    uint16_t usFastest = 0xFFFF;
+    uint16_t usNext;
+    uint16_t usDue;
+    uint8_t ucChannel;
+
+    memset( pulCount, 0, sizeof( pulCount ) );
+    memset( pulLast, 0, sizeof( pulLast ) );
+    for( ucChannel = 0; ucChannel < appNUM_CHANNELS; ucChannel++ )
+    {
+        hostCHECK( usRateGroupGetPeriod( ucChannel ) == pusPeriod[ ucChannel ],
+                   "channel %u period %u", ucChannel, usRateGroupGetPeriod( ucChannel ) );
+        usFastest = ( pusPeriod[ ucChannel ] < usFastest ) ? pusPeriod[ ucChannel ] : usFastest;
+    }
+
+    usNext = usRateGroupNextDue();
+    for( ulTick = 1; ulTick <= testTICKS; ulTick++ )
+    {
+        usDue = usRateGroupTick();
+        hostCHECK( ( usDue != 0 ) == ( usNext == 1 ), "tick %lu: due 0x%x, predicted in %u",
+                   ( unsigned long ) ulTick, usDue, usNext );
+        usNext = usRateGroupNextDue();
+
+        ulSequences += ( ( usDue & appEXTERNAL_MASK ) != 0 ) + ( ( usDue & appINTERNAL_MASK ) != 0 );
+        for( ucChannel = 0; ucChannel < appNUM_CHANNELS; ucChannel++ )
+        {
+            if( usDue & ( 1U << ucChannel ) )
+            {
+                hostCHECK( pulCount[ ucChannel ] == 0 ||
+                           ulTick - pulLast[ ucChannel ] == pusPeriod[ ucChannel ],
+                           "%s: channel %u due after %lu ticks, period %u", pcName, ucChannel,
+                           ( unsigned long ) ( ulTick - pulLast[ ucChannel ] ),
+                           pusPeriod[ ucChannel ] );
+                pulLast[ ucChannel ] = ulTick;
+                pulCount[ ucChannel ]++;
+                ulConversions++;
+            }
+        }
+    }
+
+    printf( "  %s:\n", pcName );
+    for( ucChannel = 0; ucChannel < appNUM_CHANNELS; ucChannel++ )
+    {
+        hostCHECK( pulCount[ ucChannel ] == ( testTICKS + pusPeriod[ ucChannel ] - 1 ) / pusPeriod[ ucChannel ],
+                   "channel %u: %lu samples", ucChannel, ( unsigned long ) pulCount[ ucChannel ] );
+        printf( "    channel %u every %4u ticks: %6lu samples\n", ucChannel, pusPeriod[ ucChannel ],
+                ( unsigned long ) pulCount[ ucChannel ] );
+    }
+    printf( "    %lu conversions in %lu sequences; all channels every %u ticks: %lu conversions "
+            "in %lu sequences, %.1f %% saved\n", ( unsigned long ) ulConversions,
+            ( unsigned long ) ulSequences, usFastest,
+            ( unsigned long ) ( appNUM_CHANNELS * ( testTICKS / usFastest ) ),
+            ( unsigned long ) ( testTICKS / usFastest ),
+            100.0 * ( 1.0 - ( double ) ulConversions / ( appNUM_CHANNELS * ( testTICKS / usFastest ) ) ) );
+}
+
+/* Ticks until ucChannel is due */
+static uint32_t prvTicksToDue( uint8_t ucChannel )
+{
+    uint32_t ulTicks = 0;
+
+    do
+    {
+        ulTicks++;
+    } while( ( usRateGroupTick() & ( 1U << ucChannel ) ) == 0 );
+    return ulTicks;
+}
+
+static void prvPeriodChange( void )
+{
+    uint32_t ulTick;
+
+    /* Speeding up: due within the new period, not after the old one */
+    vRateGroupInit();
+    vRateGroupSetPeriod( 0, 1000 );
+    ( void ) prvTicksToDue( 0 );
+    for( ulTick = 0; ulTick < 10; ulTick++ )
+    {
+        ( void ) usRateGroupTick();
+    }
+    vRateGroupSetPeriod( 0, 2 );
+    hostCHECK( prvTicksToDue( 0 ) <= 2, "speeding up waits for the old period" );
+    hostCHECK( prvTicksToDue( 0 ) == 2, "new period not applied" );
+
+    /* Slowing down: the pending due tick is kept */
+    vRateGroupSetPeriod( 0, 10 );
+    ( void ) prvTicksToDue( 0 );
+    for( ulTick = 0; ulTick < 6; ulTick++ )
+    {
+        ( void ) usRateGroupTick();
+    }
+    vRateGroupSetPeriod( 0, 100 );
+    hostCHECK( prvTicksToDue( 0 ) == 4, "slowing down lost the phase" );
+    hostCHECK( prvTicksToDue( 0 ) == 100, "new period not applied" );
+}
+
+int main( void )
+{
+    static const uint16_t pusMixed[] = { 1, 3, 10, 250, 1000, 7, 20, 500,
+                                         2, 5, 50, 100, 200, 1000, 4, 30 };
+    uint16_t pusPeriod[ appNUM_CHANNELS ];
+    uint8_t ucChannel;
+
+    vRateGroupInit();
+    for( ucChannel = 0; ucChannel < appNUM_CHANNELS; ucChannel++ )
+    {
+        pusPeriod[ ucChannel ] = usRateGroupGetPeriod( ucChannel );
+    }
+    prvRun( "appCHANNELS periods", pusPeriod );
+
+    vRateGroupInit();
+    for( ucChannel = 0; ucChannel < appNUM_CHANNELS; ucChannel++ )
+    {
+        pusPeriod[ ucChannel ] = pusMixed[ ucChannel ];
+        vRateGroupSetPeriod( ucChannel, pusPeriod[ ucChannel ] );
+    }
+    prvRun( "mixed periods", pusPeriod );
+
+    prvPeriodChange();
+    return 0;
+}
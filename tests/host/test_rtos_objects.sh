@@ -0,0 +1,35 @@
+#!/bin/sh
+#
+# test_rtos_objects.sh: the typed layer of rtos_objects.h costs nothing
+#
+# rtos_objects_use.c is compiled at -O2 through the accessors (-DTYPED)
+# and on the plain FreeRTOS API. The sections of both objects must be the
+# same size, and their disassembly with relocations - every instruction
+# and every call target - must be the same. The host compiler stands in
+# for cl430: both inline a static one-line forward at this level.
+#
+# Run by run.sh with COMPILE, OUT and HERE set.
+
+TYPED="$OUT/rtos_objects_typed.o"
+DIRECT="$OUT/rtos_objects_direct.o"
+
+$COMPILE -c -DTYPED -o "$TYPED" "$HERE/rtos_objects_use.c" || exit 1
+$COMPILE -c -o "$DIRECT" "$HERE/rtos_objects_use.c" || exit 1
+
+# text data bss of each object
+SIZE_TYPED=$(size "$TYPED" | awk 'NR == 2 { print $1, $2, $3 }')
+SIZE_DIRECT=$(size "$DIRECT" | awk 'NR == 2 { print $1, $2, $3 }')
+echo "  text data bss: accessors $SIZE_TYPED, plain API $SIZE_DIRECT"
+if [ "$SIZE_TYPED" != "$SIZE_DIRECT" ]; then
+    echo "  check failed: the accessors change the object size"
+    exit 1
+fi
+
+objdump -dr --no-show-raw-insn "$TYPED" | sed '1,/^Disassembly/d' > "$OUT/rtos_objects_typed.dis"
+objdump -dr --no-show-raw-insn "$DIRECT" | sed '1,/^Disassembly/d' > "$OUT/rtos_objects_direct.dis"
+if ! cmp -s "$OUT/rtos_objects_typed.dis" "$OUT/rtos_objects_direct.dis"; then
+    echo "  check failed: the accessors change the code"
+    diff "$OUT/rtos_objects_typed.dis" "$OUT/rtos_objects_direct.dis" | head -n 20
+    exit 1
+fi
+echo "  $(grep -c '^ ' "$OUT/rtos_objects_typed.dis") instructions, the same with and without the accessors"
@@ -0,0 +1,243 @@
+/**
+ * @file test_spectrum.c
+ * @brief Goertzel amplitudes against a double precision reference
+ *
+ * Sources: ETF5529_HAL/hal_mpy.c
+ *
+ * spectrum.c is included so its compile-time coefficients can be checked:
+ * spectrumCOEFF( f ) must equal lround( 2^15 cos( 2 pi f / fs ) ) for every
+ * integer f up to fs / 2. Blocks of sines, DC and noise are written to a
+ * stand-in for the capture buffer and each configured bin is compared with
+ * 2 |X( f )| / N of the same mean-free block computed in double. The cost
+ * of one bin is reported in host nanoseconds per set.
+ *
+ * The multiplier calls and capture reads of every bin are counted: N + 1
+ * lHALMPYMulS32x16() calls and 2 N reads for a block of N sets. From them
+ * the cost per set and bin is given for every block length the capture
+ * buffer holds (appCAPTURE_RAM_BUDGET) whose frequency resolution fs / N
+ * still separates the configured bins, in calls and in MSP430X cycles from
+ * the instruction timings of SLAU208 (format I and II, CALLA 5, RETA 4):
+ *  - a capture read, usCaptureGetSample(): argument moves 2, CALLA 5,
+ *    add &usWrite 3, cmp and jlo 4, rlam and add for the index 3, the
+ *    indexed load 3, RETA 4; 24 cycles
+ *  - a multiplier call: arguments 5, CALLA 5; interrupts off and on 5,
+ *    three absolute operand writes 12, __delay_cycles( 7 ), three result
+ *    reads 9; the shifts by the variable ucShift through __mspabi_srll
+ *    and __mspabi_slll, 9 cycles each plus 6 per bit, 14 and 18 bits; the
+ *    or, the shift test and RETA 8; 283 cycles
+ *  - the mean pass adds one read to a 32-bit sum, 2 cycles and 5 for the
+ *    loop; the resonator subtracts the mean and widens the sample 5 cycles,
+ *    adds and moves its states 8 and loops 5
+ *  - once per bin: a multiplier call, two 32 x 32 bit products to 64 bits
+ *    through __mspabi_mpyll on the MPY32, about 70 cycles each, and up to
+ *    32 rounds of prvSqrt64() on 64-bit values, about 45 cycles each
+ * A radix-2 FFT is listed for comparison as the real products it needs
+ * for all bins at once, 2 N log2 N, per set.
+ */
+
+#include <math.h>
+
+#include "host_test.h"
+#include "hal_mpy.h"
+
+static uint32_t ulMulCalls;
+static uint32_t ulReads;
+
+static int32_t prvCountedMul( int32_t lA, int16_t sB, uint8_t ucShift )
+{
+    ulMulCalls++;
+    return lHALMPYMulS32x16( lA, sB, ucShift );
+}
+
+#define lHALMPYMulS32x16        prvCountedMul
+#include "../../SRV_Projekat/spectrum.c"
+#undef lHALMPYMulS32x16
+
+#define testPI                  ( 3.14159265358979 )
+
+/* MSP430X cycles, see above */
+#define testREAD_CYCLES         ( 2 + 5 + 3 + 4 + 3 + 3 + 4 )
+#define testMUL_CYCLES          ( 5 + 5 + 5 + 12 + 7 + 9 + ( 9 + 6 * 14 ) + ( 9 + 6 * 18 ) + 8 )
+#define testMEAN_CYCLES         ( testREAD_CYCLES + 2 + 5 )
+#define testRESONATOR_CYCLES    ( testREAD_CYCLES + 5 + testMUL_CYCLES + 8 + 5 )
+#define testBIN_CYCLES          ( testMUL_CYCLES + 2 * 70 + 32 * 45 )
+
+static uint16_t pusBlock[ appCAPTURE_DEPTH ][ appNUM_EXTERNAL ];
+
+uint16_t usCaptureGetSample( uint16_t usSet, uint8_t ucChannel )
+{
+    ulReads++;
+    return pusBlock[ usSet ][ ucChannel ];
+}
+
+static uint32_t ulSeed = 5;
+
+static uint32_t prvRandom32( void )
+{
+    ulSeed ^= ulSeed << 13;
+    ulSeed ^= ulSeed >> 17;
+    ulSeed ^= ulSeed << 5;
+    return ulSeed;
+}
+
+static double prvReference( uint8_t ucChannel, uint16_t usHz )
+{
+    double dMean = 0;
+    double dRe = 0;
+    double dIm = 0;
+    double dX;
+    uint16_t usSet;
+
+    for( usSet = 0; usSet < spectrumBLOCK_LENGTH; usSet++ )
+    {
+        dMean += pusBlock[ usSet ][ ucChannel ];
+    }
+    dMean /= spectrumBLOCK_LENGTH;
+    for( usSet = 0; usSet < spectrumBLOCK_LENGTH; usSet++ )
+    {
+        dX = pusBlock[ usSet ][ ucChannel ] - dMean;
+        dRe += dX * cos( 2.0 * testPI * usHz * usSet / appSPECTRUM_RATE_HZ );
+        dIm += dX * sin( 2.0 * testPI * usHz * usSet / appSPECTRUM_RATE_HZ );
+    }
+    return 2.0 * sqrt( dRe * dRe + dIm * dIm ) / spectrumBLOCK_LENGTH;
+}
+
+static void prvCheckCoefficients( void )
+{
+    uint32_t ulHz;
+    long lExpected;
+
+    for( ulHz = 1; 2 * ulHz <= appSPECTRUM_RATE_HZ; ulHz++ )
+    {
+        lExpected = lround( 32768.0 * cos( 2.0 * testPI * ulHz / appSPECTRUM_RATE_HZ ) );
+        hostCHECK( spectrumCOEFF( ulHz ) == lExpected, "%lu Hz: %lld, expected %ld",
+                   ( unsigned long ) ulHz, ( long long ) spectrumCOEFF( ulHz ), lExpected );
+    }
+}
+
+static void prvCheckAmplitudes( void )
+{
+    double pdAmplitude[ spectrumNUM_BINS ];
+    double dWorst = 0;
+    double dReference;
+    double dError;
+    double dSample;
+    uint16_t usSet;
+    uint8_t ucBin;
+    int iBlock;
+
+    for( iBlock = 0; iBlock < 200; iBlock++ )
+    {
+        for( ucBin = 0; ucBin < spectrumNUM_BINS; ucBin++ )
+        {
+            pdAmplitude[ ucBin ] = ( double ) ( prvRandom32() % 1500 );
+        }
+        for( usSet = 0; usSet < spectrumBLOCK_LENGTH; usSet++ )
+        {
+            dSample = 2048.0 + ( double ) ( prvRandom32() % 9 ) - 4.0;
+            for( ucBin = 0; ucBin < spectrumNUM_BINS; ucBin++ )
+            {
+                dSample += pdAmplitude[ ucBin ] / spectrumNUM_BINS *
+                           sin( 2.0 * testPI * pusBinHz[ ucBin ] * usSet / appSPECTRUM_RATE_HZ + ucBin );
+            }
+            pusBlock[ usSet ][ 0 ] = ( uint16_t ) lround( dSample );
+            pusBlock[ usSet ][ 1 ] = ( uint16_t ) ( prvRandom32() & 0x0FFF );
+        }
+        for( ucBin = 0; ucBin < spectrumNUM_BINS; ucBin++ )
+        {
+            dReference = prvReference( 0, pusBinHz[ ucBin ] );
+            dError = fabs( usSpectrumAmplitude( 0, ucBin ) - dReference );
+            hostCHECK( dError < 2.0, "bin %u Hz: %u, reference %.2f", pusBinHz[ ucBin ],
+                       usSpectrumAmplitude( 0, ucBin ), dReference );
+            dWorst = ( dError > dWorst ) ? dError : dWorst;
+
+            /* Full-scale white noise on the other channel */
+            dReference = prvReference( 1, pusBinHz[ ucBin ] );
+            dError = fabs( usSpectrumAmplitude( 1, ucBin ) - dReference );
+            hostCHECK( dError < 2.0, "noise, bin %u Hz: %u, reference %.2f", pusBinHz[ ucBin ],
+                       usSpectrumAmplitude( 1, ucBin ), dReference );
+            dWorst = ( dError > dWorst ) ? dError : dWorst;
+        }
+    }
+    printf( "  %u-set blocks: every bin within %.2f LSB of the double reference\n",
+            spectrumBLOCK_LENGTH, dWorst );
+}
+
+static void prvTime( void )
+{
+    uint64_t ullStart;
+    uint64_t ullNs;
+    uint32_t ulSum = 0;
+    int iPass;
+
+    ullStart = ullHostNowNs();
+    for( iPass = 0; iPass < 20000; iPass++ )
+    {
+        ulSum += usSpectrumAmplitude( 0, ( uint8_t ) ( iPass % spectrumNUM_BINS ) );
+    }
+    ullNs = ullHostNowNs() - ullStart;
+    ulHostSink = ulSum;
+    printf( "  host: %.2f ns per set and bin (%u sets, mean and resonator passes)\n",
+            ( double ) ullNs / 20000.0 / spectrumBLOCK_LENGTH, spectrumBLOCK_LENGTH );
+}
+
+static void prvCost( void )
+{
+    char pcLabel[ 40 ];
+    uint16_t usSpacing = pusBinHz[ 0 ];
+    uint16_t usLength;
+    uint8_t ucLog2;
+    uint8_t ucBin;
+
+    ulMulCalls = 0;
+    ulReads = 0;
+    for( ucBin = 0; ucBin < spectrumNUM_BINS; ucBin++ )
+    {
+        ulHostSink += usSpectrumAmplitude( 0, ucBin );
+    }
+    hostCHECK( ulMulCalls == spectrumNUM_BINS * ( spectrumBLOCK_LENGTH + 1UL ), "%lu multiplier calls",
+               ( unsigned long ) ulMulCalls );
+    hostCHECK( ulReads == spectrumNUM_BINS * 2UL * spectrumBLOCK_LENGTH, "%lu capture reads",
+               ( unsigned long ) ulReads );
+    printf( "  %u bins of %u sets: %lu multiplier calls, %lu capture reads\n", spectrumNUM_BINS,
+            spectrumBLOCK_LENGTH, ( unsigned long ) ulMulCalls, ( unsigned long ) ulReads );
+
+    /* Lowest bin and closest pair set the resolution the block needs */
+    for( ucBin = 1; ucBin < spectrumNUM_BINS; ucBin++ )
+    {
+        if( pusBinHz[ ucBin ] - pusBinHz[ ucBin - 1 ] < usSpacing )
+        {
+            usSpacing = pusBinHz[ ucBin ] - pusBinHz[ ucBin - 1 ];
+        }
+    }
+    printf( "  %-34s %6s %7s %9s %9s\n", "per set and bin, MSP430X estimate", "calls", "cycles", "ms/block",
+            "FFT mul" );
+    for( ucLog2 = 1; ( 1UL << ucLog2 ) * appNUM_EXTERNAL * 2UL <= appCAPTURE_RAM_BUDGET; ucLog2++ )
+    {
+        usLength = 1U << ucLog2;
+        if( ( unsigned long ) usSpacing * usLength < appSPECTRUM_RATE_HZ )
+        {
+            continue;
+        }
+        snprintf( pcLabel, sizeof( pcLabel ), "appSPECTRUM_BLOCK_LOG2 %u, %u sets", ucLog2, usLength );
+        printf( "  %-34s %6.3f %7.1f %9.1f %9.1f\n", pcLabel, ( usLength + 1.0 ) / usLength,
+                testMEAN_CYCLES + testRESONATOR_CYCLES + ( double ) testBIN_CYCLES / usLength,
+                ( ( double ) ( testMEAN_CYCLES + testRESONATOR_CYCLES ) * usLength + testBIN_CYCLES ) *
+                spectrumNUM_BINS * appNUM_EXTERNAL * 1000.0 / configCPU_CLOCK_HZ,
+                2.0 * ucLog2 / spectrumNUM_BINS );
+    }
+    printf( "  ms/block: all bins of all %u channels at %lu MHz; of the cycles %u are the shifts in a call\n",
+            appNUM_EXTERNAL, ( unsigned long ) ( configCPU_CLOCK_HZ / 1000000UL ),
+            ( unsigned ) ( ( 9 + 6 * 14 ) + ( 9 + 6 * 18 ) ) );
+}
+
+int main( void )
+{
+    prvCheckCoefficients();
+    printf( "  Q14 coefficients equal lround( 2^15 cos( 2 pi f / fs ) ) for f = 1 .. %lu Hz\n",
+            ( unsigned long ) appSPECTRUM_RATE_HZ / 2 );
+    prvCheckAmplitudes();
+    prvCost();
+    prvTime();
+    return 0;
+}
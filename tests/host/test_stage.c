@@ -0,0 +1,253 @@
+/**
+ * @file test_stage.c
+ * @brief Stage policies under saturation: exact drop counts, whole groups
+ *
+ * Sources: stage.c
+ *
+ * The FreeRTOS queue calls stage.c makes are replaced by a ring buffer.
+ * Groups of 1 to 4 items, tagged with a group number and their position,
+ * are sent three times faster than a consumer takes them, through every
+ * policy, from task and ISR context. Received plus dropped items must equal
+ * sent items exactly, every item must arrive in order, and with a group key
+ * STAGE_DROP_OLDEST must never leave the tail of an evicted group behind:
+ * a group reaches the consumer complete, or as a prefix when the consumer
+ * had started it before the rest was evicted. A consumer that would preempt
+ * the producer in the middle of an eviction is simulated as well; the
+ * scheduler lock of uxStageSend() must keep it out.
+ */
+
+#include <string.h>
+
+#include "host_test.h"
+#include "stage.h"
+
+#define testQUEUE_LENGTH        ( 10 )
+#define testGROUPS              ( 200000UL )
+
+typedef struct{
+    uint32_t ulGroup;
+    uint8_t  ucIndex;
+    uint8_t  ucCount;
+}Item_t;
+
+struct QueueDefinition{
+    Item_t      pxItems[ testQUEUE_LENGTH ];
+    UBaseType_t uxHead;
+    UBaseType_t uxWaiting;
+};
+
+volatile uint16_t usCriticalNesting;
+
+static struct QueueDefinition xQueue;
+/* Simulated preemption: the consumer runs inside a peek unless the
+scheduler is suspended */
+static BaseType_t xPreemptOnPeek;
+static UBaseType_t uxSuspended;
+static uint32_t ulReceived;
+static Item_t xLast;
+
+static uint32_t ulSeed = 9;
+
+static uint32_t prvRandom32( void )
+{
+    ulSeed ^= ulSeed << 13;
+    ulSeed ^= ulSeed >> 17;
+    ulSeed ^= ulSeed << 5;
+    return ulSeed;
+}
+
+static BaseType_t prvPop( Item_t *pxItem )
+{
+    if( xQueue.uxWaiting == 0 )
+    {
+        return pdFAIL;
+    }
+    *pxItem = xQueue.pxItems[ xQueue.uxHead ];
+    xQueue.uxHead = ( xQueue.uxHead + 1 ) % testQUEUE_LENGTH;
+    xQueue.uxWaiting--;
+    return pdPASS;
+}
+
+/* The consumer: checks order and that no group arrives without its head */
+static BaseType_t prvConsume( void )
+{
+    Item_t xItem;
+
+    if( prvPop( &xItem ) != pdPASS )
+    {
+        return pdFAIL;
+    }
+    if( xItem.ucIndex > 0 )
+    {
+        hostCHECK( xLast.ulGroup == xItem.ulGroup && xLast.ucIndex + 1 == xItem.ucIndex,
+                   "group %lu arrived from item %u", ( unsigned long ) xItem.ulGroup, xItem.ucIndex );
+    }
+    else
+    {
+        hostCHECK( ulReceived == 0 || xItem.ulGroup > xLast.ulGroup, "order" );
+    }
+    xLast = xItem;
+    ulReceived++;
+    return pdPASS;
+}
+
+void vTaskSuspendAll( void )
+{
+    uxSuspended++;
+}
+
+BaseType_t xTaskResumeAll( void )
+{
+    uxSuspended--;
+    return pdFALSE;
+}
+
+UBaseType_t uxQueueMessagesWaiting( const QueueHandle_t xHandle )
+{
+    return xHandle->uxWaiting;
+}
+
+UBaseType_t uxQueueMessagesWaitingFromISR( const QueueHandle_t xHandle )
+{
+    return xHandle->uxWaiting;
+}
+
+BaseType_t xQueueReceive( QueueHandle_t xHandle, void * const pvBuffer, TickType_t xTicksToWait )
+{
+    ( void ) xHandle;
+    ( void ) xTicksToWait;
+    return prvPop( ( Item_t * ) pvBuffer );
+}
+
+BaseType_t xQueueReceiveFromISR( QueueHandle_t xHandle, void * const pvBuffer, BaseType_t * const pxWoken )
+{
+    ( void ) pxWoken;
+    return xQueueReceive( xHandle, pvBuffer, 0 );
+}
+
+BaseType_t xQueuePeek( QueueHandle_t xHandle, void * const pvBuffer, TickType_t xTicksToWait )
+{
+    ( void ) xTicksToWait;
+    if( xHandle->uxWaiting == 0 )
+    {
+        return pdFAIL;
+    }
+    memcpy( pvBuffer, &xHandle->pxItems[ xHandle->uxHead ], sizeof( Item_t ) );
+    if( xPreemptOnPeek && ( uxSuspended == 0 ) && ( prvRandom32() & 1 ) )
+    {
+        prvConsume();
+    }
+    return pdPASS;
+}
+
+BaseType_t xQueuePeekFromISR( QueueHandle_t xHandle, void * const pvBuffer )
+{
+    if( xHandle->uxWaiting == 0 )
+    {
+        return pdFAIL;
+    }
+    memcpy( pvBuffer, &xHandle->pxItems[ xHandle->uxHead ], sizeof( Item_t ) );
+    return pdPASS;
+}
+
+BaseType_t xQueueGenericSend( QueueHandle_t xHandle, const void * const pvItem,
+                              TickType_t xTicksToWait, const BaseType_t xCopyPosition )
+{
+    ( void ) xCopyPosition;
+    /* STAGE_BLOCK: the consumer frees room while the producer waits */
+    while( xHandle->uxWaiting == testQUEUE_LENGTH && xTicksToWait > 0 )
+    {
+        prvConsume();
+    }
+    if( xHandle->uxWaiting == testQUEUE_LENGTH )
+    {
+        return errQUEUE_FULL;
+    }
+    memcpy( &xHandle->pxItems[ ( xHandle->uxHead + xHandle->uxWaiting ) % testQUEUE_LENGTH ],
+            pvItem, sizeof( Item_t ) );
+    xHandle->uxWaiting++;
+    return pdPASS;
+}
+
+BaseType_t xQueueGenericSendFromISR( QueueHandle_t xHandle, const void * const pvItem,
+                                     BaseType_t * const pxWoken, const BaseType_t xCopyPosition )
+{
+    ( void ) pxWoken;
+    return xQueueGenericSend( xHandle, pvItem, 0, xCopyPosition );
+}
+
+static void prvRun( StagePolicy_t xPolicy, BaseType_t xFromISR, BaseType_t xKeyed, BaseType_t xPreempt )
+{
+    static const char * const pcPolicies[] = { "BLOCK", "DROP_NEWEST", "DROP_OLDEST", "DECIMATE" };
+    Stage_t xStage;
+    Item_t pxGroup[ 4 ];
+    BaseType_t xWoken = pdFALSE;
+    uint32_t ulSent = 0;
+    uint32_t ulDropped;
+    UBaseType_t uxHighWater;
+    uint32_t ulGroup;
+    uint8_t ucCount;
+    uint8_t ucIndex;
+
+    memset( &xQueue, 0, sizeof( xQueue ) );
+    memset( &xLast, 0, sizeof( xLast ) );
+    ulReceived = 0;
+    xPreemptOnPeek = xPreempt;
+    vStageInit( &xStage, &xQueue, testQUEUE_LENGTH, sizeof( Item_t ), xPolicy, 3 );
+    if( xKeyed )
+    {
+        vStageSetGroupKey( &xStage, 0, sizeof( uint32_t ) );
+    }
+
+    for( ulGroup = 1; ulGroup <= testGROUPS; ulGroup++ )
+    {
+        ucCount = ( uint8_t ) ( 1 + prvRandom32() % 4 );
+        for( ucIndex = 0; ucIndex < ucCount; ucIndex++ )
+        {
+            pxGroup[ ucIndex ].ulGroup = ulGroup;
+            pxGroup[ ucIndex ].ucIndex = ucIndex;
+            pxGroup[ ucIndex ].ucCount = ucCount;
+        }
+        if( xFromISR )
+        {
+            ( void ) uxStageSendFromISR( &xStage, pxGroup, ucCount, &xWoken );
+        }
+        else
+        {
+            ( void ) uxStageSend( &xStage, pxGroup, ucCount );
+        }
+        ulSent += ucCount;
+
+        /* On average one item taken per 2.5 items sent */
+        for( ucIndex = ( uint8_t ) ( prvRandom32() % 3 ); ucIndex > 0; ucIndex-- )
+        {
+            prvConsume();
+        }
+    }
+    while( prvConsume() == pdPASS )
+    {
+    }
+
+    vStageGetCounters( &xStage, &ulDropped, &uxHighWater );
+    hostCHECK( ulReceived + ulDropped == ulSent, "%s: sent %lu, received %lu, dropped %lu",
+               pcPolicies[ xPolicy ], ( unsigned long ) ulSent, ( unsigned long ) ulReceived,
+               ( unsigned long ) ulDropped );
+    hostCHECK( uxHighWater <= testQUEUE_LENGTH, "high water %lu", ( unsigned long ) uxHighWater );
+    printf( "  %-11s %-4s %-5s %-9s sent %7lu received %7lu dropped %7lu, high water %lu\n",
+            pcPolicies[ xPolicy ], xFromISR ? "ISR" : "task", xKeyed ? "keyed" : "",
+            xPreempt ? "preempted" : "", ( unsigned long ) ulSent, ( unsigned long ) ulReceived,
+            ( unsigned long ) ulDropped, ( unsigned long ) uxHighWater );
+}
+
+int main( void )
+{
+    prvRun( STAGE_BLOCK, pdFALSE, pdFALSE, pdFALSE );
+    prvRun( STAGE_DROP_NEWEST, pdFALSE, pdFALSE, pdFALSE );
+    prvRun( STAGE_DROP_NEWEST, pdTRUE, pdFALSE, pdFALSE );
+    prvRun( STAGE_DECIMATE, pdFALSE, pdFALSE, pdFALSE );
+    prvRun( STAGE_DECIMATE, pdTRUE, pdFALSE, pdFALSE );
+    prvRun( STAGE_DROP_OLDEST, pdFALSE, pdTRUE, pdFALSE );
+    prvRun( STAGE_DROP_OLDEST, pdTRUE, pdTRUE, pdFALSE );
+    prvRun( STAGE_DROP_OLDEST, pdFALSE, pdTRUE, pdTRUE );
+    return 0;
+}
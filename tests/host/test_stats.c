@@ -0,0 +1,106 @@
+/**
+ * @file test_stats.c
+ * @brief Windowed statistics against a double reference, and their cost
+ *
+ * Sources: stats.c ETF5529_HAL/hal_mpy.c
+ *
+ * Random 12-bit and 16-bit windows of every allowed length are summarised
+ * by stats.c and by a double precision reference; min, max and mean must
+ * match exactly, RMS to within the truncation of the integer root. The
+ * cost is reported as host nanoseconds per sample, window end included;
+ * the MPY32 register accesses per sample are reported by test_mpy.
+ */
+
+#include <math.h>
+
+#include "host_test.h"
+#include "stats.h"
+
+#define testWINDOWS             ( 2000 )
+#define testTIMED_SAMPLES       ( 20000000UL )
+
+static uint32_t ulSeed = 11;
+
+static uint32_t prvRandom32( void )
+{
+    ulSeed ^= ulSeed << 13;
+    ulSeed ^= ulSeed >> 17;
+    ulSeed ^= ulSeed << 5;
+    return ulSeed;
+}
+
+static void prvCheckWindows( uint16_t usSampleMask )
+{
+    StatsWindow_t xWindow;
+    StatsSummary_t xSummary;
+    uint8_t ucLog2;
+    uint16_t usCount;
+    uint16_t usSample;
+    uint16_t usMin;
+    uint16_t usMax;
+    double dSum;
+    double dSquares;
+    double dRms;
+    int iWindow;
+
+    for( ucLog2 = 0; ucLog2 <= statsMAX_WINDOW_LOG2; ucLog2++ )
+    {
+        vStatsInit( &xWindow, ucLog2 );
+        for( iWindow = 0; iWindow < testWINDOWS; iWindow++ )
+        {
+            dSum = 0;
+            dSquares = 0;
+            usMin = 0xFFFF;
+            usMax = 0;
+            for( usCount = 0; usCount < ( 1U << ucLog2 ); usCount++ )
+            {
+                usSample = ( uint16_t ) prvRandom32() & usSampleMask;
+                usMin = ( usSample < usMin ) ? usSample : usMin;
+                usMax = ( usSample > usMax ) ? usSample : usMax;
+                dSum += usSample;
+                dSquares += ( double ) usSample * usSample;
+                xStatsAdd( &xWindow, usSample, &xSummary );
+            }
+            dRms = sqrt( dSquares / ( 1U << ucLog2 ) );
+            hostCHECK( xSummary.usMin == usMin && xSummary.usMax == usMax, "min/max" );
+            hostCHECK( xSummary.usMean == ( uint16_t ) floor( dSum / ( 1U << ucLog2 ) ), "mean" );
+            /* The mean square is truncated before the integer root */
+            hostCHECK( xSummary.usRms <= dRms && xSummary.usRms > dRms - 1.0,
+                       "rms %u, reference %.3f", xSummary.usRms, dRms );
+        }
+    }
+}
+
+static void prvTime( void )
+{
+    StatsWindow_t xWindow;
+    StatsSummary_t xSummary;
+    uint32_t ulIndex;
+    uint32_t ulSum = 0;
+    uint64_t ullStats;
+    uint64_t ullStart;
+
+    vStatsInit( &xWindow, 6 );
+    ullStart = ullHostNowNs();
+    for( ulIndex = 0; ulIndex < testTIMED_SAMPLES; ulIndex++ )
+    {
+        if( xStatsAdd( &xWindow, ( uint16_t ) ( ulIndex * 2654435761UL >> 20 ), &xSummary ) )
+        {
+            ulSum += xSummary.usRms;
+        }
+    }
+    ullStats = ullHostNowNs() - ullStart;
+    ulHostSink = ulSum;
+
+    printf( "  host ns per sample, window 64: xStatsAdd %.2f\n",
+            ( double ) ullStats / testTIMED_SAMPLES );
+}
+
+int main( void )
+{
+    prvCheckWindows( 0x0FFF );
+    prvCheckWindows( 0xFFFF );
+    printf( "  stats match the double reference for 12/16-bit windows of 1..256 samples\n" );
+    prvTime();
+    return 0;
+}
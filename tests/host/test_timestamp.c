@@ -0,0 +1,187 @@
+/**
+ * @file test_timestamp.c
+ * @brief Timestamps against the tick timer at every counter phase
+ *
+ * Sources: timestamp.c
+ * Flags: -DHOST_TA0_MODEL
+ *
+ * TA0 counts 0 .. TA0CCR0 in the register model of stub/registers.c and
+ * the tick interrupt is taken at the first step with interrupts enabled.
+ * A walk over three ticks takes one timestamp per ACLK period while
+ * interrupts are disabled for a window starting at every phase, so the
+ * counter is read at TA0CCR0 and at every other value, with the tick
+ * interrupt taken and pending. The ACLK edge falls between the timestamps
+ * or during any access to TA0 of ulTimestampFromISR(): a counter read
+ * during the edge returns a value that is neither count.
+ *
+ * Every timestamp must be the one of the instant the counter was read:
+ * the tick count, the ticks since the first timestamp and the sub-tick.
+ * With the edge between the reads, successive timestamps must be exactly
+ * one sub-tick apart (strictly increasing, resolution one sub-tick), also
+ * across the wrap of the 16-bit tick count. The walk is run with windows
+ * of up to timestampMAX_LOCKED sub-ticks, the longest the pending tick
+ * correction covers, and must fail with one sub-tick more.
+ */
+
+#include "host_test.h"
+#include "timestamp.h"
+#include "msp430.h"
+
+#define testTICKS               ( 3 )
+/* Last access of ulTimestampFromISR() the edge may fall on, and one beyond */
+#define testEDGE_ACCESSES       ( 5 )
+
+volatile uint16_t usCriticalNesting;
+
+static uint16_t usTicks;
+/* Tick count and number of sub-ticks of the instant the counter shows */
+static uint16_t usTrueTicks;
+static uint32_t ulTrueSubTicks;
+
+TickType_t xTaskGetTickCountFromISR( void )
+{
+    return usTicks;
+}
+
+static void prvTickISR( void )
+{
+    if( usHostTA0CCTL0 & CCIFG )
+    {
+        usHostTA0CCTL0 &= ~CCIFG;
+        usTicks++;
+    }
+}
+
+static uint32_t prvTrue( void )
+{
+    return ( ( uint32_t ) usTrueTicks << 16 ) | ( ( usHostTA0R == TA0CCR0 ) ? 0U : usHostTA0R + 1U );
+}
+
+static void prvEdge( bool xTaken )
+{
+    if( xTaken == false )
+    {
+        vHostTA0Edge();
+    }
+    usTrueTicks += ( usHostTA0R == TA0CCR0 );
+    ulTrueSubTicks++;
+}
+
+/*
+ * Timestamps at every sub-tick of testTICKS ticks from usStart, interrupts
+ * disabled from sub-tick usOff on for usLength steps, the edge on access
+ * ulEdgeAt. Returns false at the first wrong timestamp.
+ */
+static bool prvWalk( uint16_t usStart, uint16_t usOff, uint16_t usLength, uint32_t ulEdgeAt, uint32_t *pulStamps )
+{
+    uint32_t ulFirst = 0;
+    uint32_t ulLast = 0;
+    uint32_t ulBefore;
+    uint32_t ulStamp;
+    uint16_t usStep;
+    bool xDuring;
+
+    TA0CCR0 = timestampSUBTICKS - 1;
+    usHostTA0R = TA0CCR0;
+    usHostTA0CCTL0 = 0;
+    usTicks = usStart;
+    usTrueTicks = usStart;
+    ulTrueSubTicks = 0;
+
+    for( usStep = 0; usStep < testTICKS * timestampSUBTICKS; usStep++ )
+    {
+        if( usStep < usOff || usStep >= usOff + usLength )
+        {
+            prvTickISR();
+        }
+        ulBefore = prvTrue();
+        ulFirst = ( usStep == 0 ) ? ulBefore : ulFirst;
+        ulHostTA0EdgeAt = ulEdgeAt;
+        ulStamp = ulTimestampFromISR();
+        xDuring = ( ulEdgeAt != 0 && ulHostTA0EdgeAt == 0 );
+        ulHostTA0EdgeAt = 0;
+
+        if( ulStamp != ulBefore )
+        {
+            /* Read before the edge, taken during the call */
+            if( xDuring == false )
+            {
+                return false;
+            }
+            prvEdge( true );
+            if( ulStamp != prvTrue() )
+            {
+                return false;
+            }
+        }
+        else if( xDuring )
+        {
+            prvEdge( true );
+        }
+
+        if( usStep > 0 && ulEdgeAt == 0 && ulTimestampElapsed( ulLast, ulStamp ) != 1 )
+        {
+            return false;
+        }
+        if( ulTimestampElapsed( ulFirst, ulStamp ) != ulTrueSubTicks - ( ulStamp == ulBefore && xDuring ) )
+        {
+            return false;
+        }
+        ulLast = ulStamp;
+        ( *pulStamps )++;
+
+        if( xDuring == false )
+        {
+            prvEdge( false );
+        }
+    }
+    return true;
+}
+
+/* Every window start and edge access from both tick counts; true if all are right */
+static bool prvSweep( uint16_t usLength, uint32_t *pulStamps )
+{
+    static const uint16_t pusStart[] = { 0x0000, 0x7FFF, 0xFFFE };
+    uint32_t ulEdgeAt;
+    uint16_t usOff;
+    uint8_t ucStart;
+
+    for( ucStart = 0; ucStart < sizeof( pusStart ) / sizeof( pusStart[ 0 ] ); ucStart++ )
+    {
+        for( usOff = 0; usOff < ( testTICKS - 1 ) * timestampSUBTICKS; usOff++ )
+        {
+            for( ulEdgeAt = 0; ulEdgeAt <= testEDGE_ACCESSES; ulEdgeAt++ )
+            {
+                if( prvWalk( pusStart[ ucStart ], usOff, usLength, ulEdgeAt, pulStamps ) == false )
+                {
+                    printf( "  ticks from 0x%04x, interrupts off at step %u for %u, edge on access %lu: "
+                            "timestamp wrong at %lu sub-ticks\n", pusStart[ ucStart ], usOff, usLength,
+                            ( unsigned long ) ulEdgeAt, ( unsigned long ) ulTrueSubTicks );
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+int main( void )
+{
+    uint32_t ulStamps = 0;
+    uint16_t usLength;
+
+    for( usLength = 0; usLength <= timestampMAX_LOCKED; usLength++ )
+    {
+        hostCHECK( prvSweep( usLength, &ulStamps ), "wrong timestamp, interrupts off for %u sub-ticks", usLength );
+    }
+    printf( "  %lu timestamps exact at every phase, edge during every access, interrupts off up to "
+            "%u sub-ticks (%.0f us)\n", ( unsigned long ) ulStamps, ( unsigned ) timestampMAX_LOCKED,
+            timestampMAX_LOCKED * 1e6 / configLFXT_CLOCK_HZ );
+    printf( "  resolution one sub-tick, %.1f us; %u sub-ticks per tick\n", 1e6 / configLFXT_CLOCK_HZ,
+            ( unsigned ) timestampSUBTICKS );
+
+    printf( "  one sub-tick longer:\n" );
+    hostCHECK( prvSweep( timestampMAX_LOCKED + 1, &ulStamps ) == false,
+               "interrupts off for %u sub-ticks went unnoticed", ( unsigned ) timestampMAX_LOCKED + 1 );
+    return 0;
+}